@@ -50,6 +50,7 @@ glibcxx_debug=false
 build_dir_debug=".build_debug"
 build_dir_release=".build_release"
 use_vcpkg=false
+use_mpi=false
 link_dynamic=false
 
 # Process command line arguments.
@@ -63,6 +64,8 @@ do
         glibcxx_debug=true
     elif [ ${!i} = "--vcpkg" ]; then
         use_vcpkg=true
+    elif [ ${!i} = "--use-mpi" ]; then
+        use_mpi=true
     elif [ ${!i} = "--link-static" ]; then
         link_dynamic=false
     elif [ ${!i} = "--link-dynamic" ]; then
@@ -191,9 +194,6 @@ elif $use_macos && command -v brew &> /dev/null && [ ! -d $build_dir_debug ] &&
     if ! is_installed_brew "llvm"; then
         brew install llvm
     fi
-    if ! is_installed_brew "libomp"; then
-        brew install libomp
-    fi
 
     # Dependencies of the application.
     if [ $use_vcpkg = false ]; then
@@ -304,6 +304,10 @@ if $glibcxx_debug; then
     params+=(-DUSE_GLIBCXX_DEBUG=On)
 fi
 
+if $use_mpi; then
+    params+=(-DUSE_MPI=On)
+fi
+
 if [ $use_vcpkg = true ] && [ ! -d "./vcpkg" ]; then
     echo "------------------------"
     echo "    fetching vcpkg      "
@@ -0,0 +1,297 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Utils/StringUtils.hpp"
+#include "Utils/Convert.hpp"
+#include "Utils/JsonUtils.hpp"
+#include "Dataset.hpp"
+#include "ConversionServer.hpp"
+
+namespace ncconv {
+
+/// The keys a job may contain. Other keys are rejected instead of being ignored silently.
+static const char* const JOB_KEYS[] = {
+        "id", "command", "input", "output", "max_memory", "spill_dir", "layout", "coarsen", "regrid", "derive",
+        "output_type", "aggregate_time", "ensemble_stats", "drop_members", "chunks", "access_pattern", "chunk_size",
+        "deflate", "shuffle", "direct_chunk_write", "collapse_static", "slab_hashes", "big_endian", "cdf5"
+};
+
+ConversionServer::ConversionServer(size_t maxCachedDatasets) : maxCachedDatasets(maxCachedDatasets) {
+}
+
+ConversionServer::~ConversionServer() = default;
+
+Dataset& ConversionServer::getDataset(const std::string& filePath, bool& isCached) {
+    std::time_t modificationTime = boost::filesystem::last_write_time(filePath);
+    useCounter++;
+    auto it = datasetCache.find(filePath);
+    if (it != datasetCache.end() && it->second.modificationTime == modificationTime) {
+        isCached = true;
+        it->second.lastUseIdx = useCounter;
+        return *it->second.dataset;
+    }
+    isCached = false;
+    if (it != datasetCache.end()) {
+        datasetCache.erase(it);
+    }
+
+    // Evict the least recently used data set if the cache is full.
+    if (datasetCache.size() >= maxCachedDatasets && !datasetCache.empty()) {
+        auto lruIt = datasetCache.begin();
+        for (auto cacheIt = datasetCache.begin(); cacheIt != datasetCache.end(); cacheIt++) {
+            if (cacheIt->second.lastUseIdx < lruIt->second.lastUseIdx) {
+                lruIt = cacheIt;
+            }
+        }
+        datasetCache.erase(lruIt);
+    }
+
+    CacheEntry entry;
+    entry.dataset = std::make_unique<Dataset>(filePath);
+    entry.dataset->setIsVerbose(false);
+    entry.modificationTime = modificationTime;
+    entry.lastUseIdx = useCounter;
+    auto& dataset = *entry.dataset;
+    datasetCache.insert(std::make_pair(filePath, std::move(entry)));
+    return dataset;
+}
+
+std::string ConversionServer::processJob(const std::string& jobLine) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::map<std::string, std::string> job;
+    std::string errorMessage;
+    std::string status = "ok";
+    bool isCached = false;
+    bool isConversionJob = false;
+
+    if (!sgl::parseFlatJsonObject(jobLine, job, errorMessage)) {
+        status = "error";
+        errorMessage = "Invalid job: " + errorMessage;
+    } else if (job["command"] == "shutdown") {
+        shouldStop = true;
+    } else {
+        isConversionJob = true;
+        try {
+            for (const auto& entry : job) {
+                if (std::find(std::begin(JOB_KEYS), std::end(JOB_KEYS), entry.first) == std::end(JOB_KEYS)) {
+                    throw std::runtime_error("Unknown job key \"" + entry.first + "\".");
+                }
+            }
+            // All options are set for every job, as the cached data sets keep the options of the previous job.
+            const std::string& inputFile = job["input"];
+            const std::string& outputFile = job["output"];
+            if (inputFile.empty() || outputFile.empty()) {
+                throw std::runtime_error("Job is missing the \"input\" or \"output\" key.");
+            }
+            Dataset& dataset = getDataset(inputFile, isCached);
+            auto maxMemoryIt = job.find("max_memory");
+            dataset.setMaxMemory(maxMemoryIt != job.end() ? sgl::parseMemorySize(maxMemoryIt->second) : 0);
+            dataset.setSpillDirectory(job["spill_dir"]);
+            auto layoutIt = job.find("layout");
+            dataset.setOutputLayout(
+                    layoutIt != job.end() ? parseOutputLayout(layoutIt->second) : OutputLayout::MAPS);
+            std::vector<int> coarseningFactors;
+            auto coarsenIt = job.find("coarsen");
+            if (coarsenIt != job.end()) {
+                sgl::splitStringTyped<int>(coarsenIt->second, ',', coarseningFactors);
+            }
+            if (coarseningFactors.size() == 1) {
+                coarseningFactors.push_back(coarseningFactors.front());
+            }
+            auto regridIt = job.find("regrid");
+            if (regridIt != job.end()) {
+                std::vector<double> targetResolution;
+                sgl::splitStringTyped<double>(regridIt->second, ',', targetResolution);
+                if (targetResolution.size() == 1) {
+                    targetResolution.push_back(targetResolution.front());
+                }
+                if (targetResolution.size() != 2) {
+                    throw std::runtime_error("Invalid value of the \"regrid\" key.");
+                }
+                dataset.setTargetResolution(targetResolution.at(0), targetResolution.at(1));
+            } else if (coarseningFactors.size() == 2) {
+                dataset.setCoarseningFactors(coarseningFactors.at(0), coarseningFactors.at(1));
+            } else if (coarseningFactors.empty()) {
+                dataset.setCoarseningFactors(1, 1);
+            } else {
+                throw std::runtime_error("Invalid value of the \"coarsen\" key.");
+            }
+            std::vector<std::string> derivedFieldDefinitions;
+            auto deriveIt = job.find("derive");
+            if (deriveIt != job.end()) {
+                sgl::splitString(deriveIt->second, ';', derivedFieldDefinitions);
+            }
+            dataset.setDerivedFields(derivedFieldDefinitions);
+            auto outputTypeIt = job.find("output_type");
+            dataset.setOutputFloatType(
+                    outputTypeIt != job.end() ? parseOutputFloatType(outputTypeIt->second) : OutputFloatType::NATIVE);
+            auto aggregateTimeIt = job.find("aggregate_time");
+            dataset.setTimeAggregation(
+                    aggregateTimeIt != job.end() ? parseTimeAggregation(aggregateTimeIt->second) : TimeAggregation());
+            auto ensembleStatsIt = job.find("ensemble_stats");
+            dataset.setEnsembleStatistics(
+                    ensembleStatsIt != job.end() ? parseEnsembleStatistics(ensembleStatsIt->second)
+                                                 : std::vector<EnsembleStatistic>());
+            dataset.setWriteEnsembleMembers(job["drop_members"] != "true");
+            std::vector<size_t> chunkShape;
+            auto chunksIt = job.find("chunks");
+            if (chunksIt != job.end()) {
+                sgl::splitStringTyped<size_t>(chunksIt->second, ',', chunkShape);
+            }
+            dataset.setChunkShape(chunkShape);
+            auto accessPatternIt = job.find("access_pattern");
+            dataset.setAccessPattern(
+                    accessPatternIt != job.end() ? parseAccessPattern(accessPatternIt->second) : AccessPattern::DEFAULT);
+            auto chunkSizeIt = job.find("chunk_size");
+            dataset.setChunkTargetSize(
+                    chunkSizeIt != job.end() ? sgl::parseMemorySize(chunkSizeIt->second) : size_t(1) << 20);
+            auto deflateIt = job.find("deflate");
+            dataset.setDeflateLevel(deflateIt != job.end() ? sgl::fromString<int>(deflateIt->second) : 0);
+            dataset.setUseShuffleFilter(job["shuffle"] == "true");
+            dataset.setUseDirectChunkWrite(job["direct_chunk_write"] != "false");
+            dataset.setCollapseTimeInvariantFields(job["collapse_static"] == "true");
+            dataset.setRecordSlabHashes(job["slab_hashes"] != "false");
+            if (sgl::endsWith(outputFile, ".ctl")) {
+                dataset.writeToCtlFile(outputFile, job["big_endian"] == "true");
+            } else if (sgl::endsWith(outputFile, ".json")) {
+                dataset.writeToReferenceIndex(outputFile);
+            } else if (sgl::endsWith(outputFile, ".zarr")) {
+                dataset.writeToZarrStore(outputFile);
+            } else if (job["cdf5"] == "true") {
+                dataset.writeToCdf5File(outputFile);
+            } else {
+                dataset.writeToNcFile(outputFile);
+            }
+        } catch (const std::exception& e) {
+            status = "error";
+            errorMessage = e.what();
+        }
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    double latencyMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    std::string response = "{";
+    auto idIt = job.find("id");
+    if (idIt != job.end()) {
+        response += "\"id\": \"" + sgl::escapeJsonString(idIt->second) + "\", ";
+    }
+    response += "\"status\": \"" + status + "\"";
+    if (status == "ok" && isConversionJob) {
+        response += std::string() + ", \"cached\": " + (isCached ? "true" : "false");
+    } else {
+        response += ", \"error\": \"" + sgl::escapeJsonString(errorMessage) + "\"";
+    }
+    response += ", \"latency_ms\": " + sgl::toString(latencyMs, 3) + "}";
+    return response;
+}
+
+void ConversionServer::run(std::istream& input, std::ostream& output) {
+    std::string jobLine;
+    while (!shouldStop && std::getline(input, jobLine)) {
+        if (jobLine.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        output << processJob(jobLine) << std::endl;
+    }
+}
+
+void ConversionServer::runUnixSocket(const std::string& socketPath) {
+#ifdef _WIN32
+    throw std::runtime_error("Error in ConversionServer::runUnixSocket: Unix sockets are not supported on Windows.");
+#else
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Error in ConversionServer::runUnixSocket: Socket path is too long.");
+    }
+    int serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (serverSocket < 0) {
+        throw std::runtime_error("Error in ConversionServer::runUnixSocket: Could not create socket.");
+    }
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(serverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || listen(serverSocket, 16) != 0) {
+        close(serverSocket);
+        throw std::runtime_error(
+                "Error in ConversionServer::runUnixSocket: Could not listen on \"" + socketPath + "\".");
+    }
+
+    std::string lineBuffer;
+    char readBuffer[4096];
+    while (!shouldStop) {
+        int clientSocket = accept(serverSocket, nullptr, nullptr);
+        if (clientSocket < 0) {
+            continue;
+        }
+        lineBuffer.clear();
+        ssize_t numBytesRead;
+        while (!shouldStop && (numBytesRead = read(clientSocket, readBuffer, sizeof(readBuffer))) > 0) {
+            lineBuffer.append(readBuffer, size_t(numBytesRead));
+            size_t newlinePos;
+            while (!shouldStop && (newlinePos = lineBuffer.find('\n')) != std::string::npos) {
+                std::string jobLine = lineBuffer.substr(0, newlinePos);
+                lineBuffer.erase(0, newlinePos + 1);
+                if (jobLine.find_first_not_of(" \t\r") == std::string::npos) {
+                    continue;
+                }
+                std::string response = processJob(jobLine) + "\n";
+                size_t numBytesWritten = 0;
+                while (numBytesWritten < response.size()) {
+                    ssize_t ret = write(
+                            clientSocket, response.data() + numBytesWritten, response.size() - numBytesWritten);
+                    if (ret <= 0) {
+                        break;
+                    }
+                    numBytesWritten += size_t(ret);
+                }
+            }
+        }
+        close(clientSocket);
+    }
+    close(serverSocket);
+    unlink(socketPath.c_str());
+#endif
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef NCCONV_CONVERSIONSERVER_HPP
+#define NCCONV_CONVERSIONSERVER_HPP
+
+#include <memory>
+#include <string>
+#include <iostream>
+#include <unordered_map>
+#include <cstdint>
+#include <ctime>
+
+namespace ncconv {
+
+class Dataset;
+
+/**
+ * Long-lived conversion server processing newline-delimited JSON jobs, e.g.:
+ * {"id": "job1", "input": "/data/run.ctl", "output": "/tmp/run.nc", "max_memory": "1G",
+ * "layout": "timeseries", "chunks": "1,256,256", "deflate": 4, "shuffle": true}
+ * Instead of "chunks", "access_pattern" (e.g., "profiles") and optionally "chunk_size" (e.g., "4M") may be passed.
+ * "collapse_static": true writes time-invariant variables without the time dimension.
+ * "coarsen": "4" (or "4,2" for x,y) or "regrid": "1.0" (grid spacing in degrees) coarsens the horizontal grid.
+ * "derive": "ws=sqrt(u^2+v^2);tc=t-273.15" adds variables computed from other variables.
+ * "output_type": "float16" or "bfloat16" stores floating point variables as 16-bit floats.
+ * "aggregate_time": "24", "daily" or "monthly" also writes the mean, minimum, maximum and count over periods of time.
+ * "ensemble_stats": "mean,std,p10,p50,p90" writes statistics over the ensemble members, and "drop_members": true only
+ * writes these statistics.
+ * "cdf5": true writes an uncompressed classic NetCDF file in the CDF-5 format (see Cdf5Writer).
+ * "spill_dir" sets the directory for temporary files of the time series layout, "slab_hashes": false disables the
+ * slab hashes, "direct_chunk_write": false lets HDF5 compress the chunks, and "big_endian": true writes big endian
+ * GrADS data. Options missing from a job use their defaults, and jobs with unknown keys are rejected.
+ * For each job, one JSON line with the status and the latency of the job is returned:
+ * {"id": "job1", "status": "ok", "cached": true, "latency_ms": 12.345}
+ * Parsed descriptors and open data file handles are kept alive across jobs, so repeated jobs on the same data set
+ * skip the descriptor parsing. A cached data set is reopened if the modification time of its descriptor changes.
+ * The job {"command": "shutdown"} stops the server.
+ */
+class ConversionServer {
+public:
+    explicit ConversionServer(size_t maxCachedDatasets = 16);
+    ~ConversionServer();
+
+    /// Processes jobs from the input stream (e.g., stdin) until the end of the stream or a shutdown job.
+    void run(std::istream& input, std::ostream& output);
+    /// Listens on a Unix domain socket. Each connection may send multiple jobs. Not supported on Windows.
+    void runUnixSocket(const std::string& socketPath);
+    /// Processes a single job and returns the JSON response (without trailing newline).
+    std::string processJob(const std::string& jobLine);
+    [[nodiscard]] bool getShouldStop() const { return shouldStop; }
+
+private:
+    Dataset& getDataset(const std::string& filePath, bool& isCached);
+
+    struct CacheEntry {
+        std::unique_ptr<Dataset> dataset;
+        std::time_t modificationTime = 0;
+        uint64_t lastUseIdx = 0;
+    };
+    std::unordered_map<std::string, CacheEntry> datasetCache;
+    size_t maxCachedDatasets;
+    uint64_t useCounter = 0;
+    bool shouldStop = false;
+};
+
+}
+
+#endif //NCCONV_CONVERSIONSERVER_HPP
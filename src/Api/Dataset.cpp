@@ -0,0 +1,360 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+#include <netcdf.h>
+
+#include "Utils/StringUtils.hpp"
+#include "Utils/TaskScheduler.hpp"
+#include "Loaders/CtlLoader.hpp"
+#include "Loaders/NetCdfLoader.hpp"
+#include "Loaders/CoarseningLoader.hpp"
+#include "Loaders/DerivedFieldLoader.hpp"
+#include "Volume/VolumeData.hpp"
+#include "Volume/CtlWriter.hpp"
+#include "Volume/Cdf5Writer.hpp"
+#include "Volume/ReferenceIndexWriter.hpp"
+#include "Volume/ZarrWriter.hpp"
+#include "Volume/ConversionEstimator.hpp"
+#include "Dataset.hpp"
+
+namespace ncconv {
+
+static bool getHasExtension(const std::string& filePath, const std::vector<std::string>& extensions) {
+    for (const std::string& extension : extensions) {
+        if (sgl::endsWith(filePath, "." + extension)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SlabIterator::SlabIterator(VolumeData* volumeData, std::string _fieldName)
+        : volumeData(volumeData), fieldName(std::move(_fieldName)) {
+    VolumeLoader* loader = volumeData->getLoader();
+    size_t varXs = 0, varYs = 0, varZs = 0;
+    loader->getFieldExtent(fieldName, varXs, varYs, varZs);
+    varZs = std::max(varZs, size_t(1));
+    view.xs = varXs;
+    view.dataType = loader->getFieldDataType(fieldName);
+    size_t entrySize = getFieldDataTypeSize(view.dataType);
+    slabs = volumeData->computeFieldSlabs(varXs, varYs, varZs, entrySize, 1, 1);
+    size_t maxSlabSize = 0;
+    for (const FieldSlab& slab : slabs) {
+        maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varXs);
+    }
+    slabBuffer.resize(maxSlabSize * entrySize);
+    numItems =
+            std::max(volumeData->getEnsembleMemberCount(), size_t(1))
+            * std::max(volumeData->getNumTimeSteps(), size_t(1)) * slabs.size();
+}
+
+bool SlabIterator::next() {
+    if (itemIdx >= numItems) {
+        return false;
+    }
+    size_t numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    view.slab = slabs.at(itemIdx % slabs.size());
+    view.timestepIdx = (itemIdx / slabs.size()) % numTimeSteps;
+    view.memberIdx = itemIdx / (slabs.size() * numTimeSteps);
+    volumeData->getLoader()->getFieldSlabNative(
+            volumeData, fieldName, view.timestepIdx, view.memberIdx, view.slab, slabBuffer.data());
+    view.data = slabBuffer.data();
+    itemIdx++;
+    return true;
+}
+
+
+NcMemoryBuffer::~NcMemoryBuffer() {
+    // The memory was allocated by libnetcdf using malloc.
+    free(memory);
+}
+
+NcMemoryBuffer::NcMemoryBuffer(NcMemoryBuffer&& other) noexcept
+        : memory(std::exchange(other.memory, nullptr)), size(std::exchange(other.size, 0)) {
+}
+
+NcMemoryBuffer& NcMemoryBuffer::operator=(NcMemoryBuffer&& other) noexcept {
+    if (this != &other) {
+        free(memory);
+        memory = std::exchange(other.memory, nullptr);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+
+Dataset::Dataset(const std::string& filePath, const DataSetInformation& dataSetInformation) {
+    if (getHasExtension(filePath, CtlLoader::getSupportedExtensions())) {
+        loader = std::make_unique<CtlLoader>();
+    } else if (getHasExtension(filePath, NetCdfLoader::getSupportedExtensions())) {
+        loader = std::make_unique<NetCdfLoader>();
+    } else {
+        throw std::runtime_error("Error in Dataset::Dataset: Unsupported file extension of \"" + filePath + "\".");
+    }
+    volumeData = std::make_unique<VolumeData>();
+    if (!loader->setInputFiles(volumeData.get(), filePath, dataSetInformation)) {
+        throw std::runtime_error("Error in Dataset::Dataset: Parsing file \"" + filePath + "\" failed.");
+    }
+    volumeData->setLoader(loader.get());
+    inputFieldNames = volumeData->getFieldNames();
+}
+
+Dataset::~Dataset() {
+    // The volume data references the loader, so it is destroyed first.
+    volumeData.reset();
+    derivedFieldLoader.reset();
+    coarseningLoader.reset();
+    loader.reset();
+}
+
+Dataset::Dataset(Dataset&&) noexcept = default;
+Dataset& Dataset::operator=(Dataset&&) noexcept = default;
+
+bool Dataset::getIsFileSupported(const std::string& filePath) {
+    return getHasExtension(filePath, CtlLoader::getSupportedExtensions())
+            || getHasExtension(filePath, NetCdfLoader::getSupportedExtensions());
+}
+
+void Dataset::setNumThreads(size_t numThreads, size_t numIoThreads) {
+    sgl::setNumThreads(numThreads, numIoThreads);
+}
+
+const std::vector<std::string>& Dataset::getFieldNames() const {
+    return volumeData->getFieldNames();
+}
+
+void Dataset::setMaxMemory(size_t maxMemory) {
+    volumeData->setMaxMemory(maxMemory);
+}
+
+void Dataset::setIsVerbose(bool isVerbose) {
+    volumeData->setIsVerbose(isVerbose);
+}
+
+void Dataset::setOutputLayout(OutputLayout outputLayout) {
+    volumeData->setOutputLayout(outputLayout);
+}
+
+void Dataset::setOutputFloatType(OutputFloatType outputFloatType) {
+    volumeData->setOutputFloatType(outputFloatType);
+}
+
+void Dataset::setTimeAggregation(const TimeAggregation& timeAggregation) {
+    volumeData->setTimeAggregation(timeAggregation);
+}
+
+void Dataset::setEnsembleStatistics(const std::vector<EnsembleStatistic>& ensembleStatistics) {
+    volumeData->setEnsembleStatistics(ensembleStatistics);
+}
+
+void Dataset::setWriteEnsembleMembers(bool writeEnsembleMembers) {
+    volumeData->setWriteEnsembleMembers(writeEnsembleMembers);
+}
+
+void Dataset::setCoarseningFactors(int factorX, int factorY) {
+    if (coarseningLoader) {
+        coarseningLoader->restoreGrid(volumeData.get());
+        volumeData->setLoader(loader.get());
+        derivedFieldLoader.reset();
+        coarseningLoader.reset();
+    }
+    if (factorX > 1 || factorY > 1) {
+        coarseningLoader = std::make_unique<CoarseningLoader>(loader.get(), factorX, factorY);
+        coarseningLoader->applyGrid(volumeData.get());
+    }
+    updateLoaderChain();
+}
+
+void Dataset::setTargetResolution(double spacingX, double spacingY) {
+    setCoarseningFactors(1, 1);
+    int factorX = CoarseningLoader::computeFactorForSpacing(
+            volumeData->getLon1d(), volumeData->getGridSizeX(), spacingX);
+    int factorY = CoarseningLoader::computeFactorForSpacing(
+            volumeData->getLat1d(), volumeData->getGridSizeY(), spacingY);
+    setCoarseningFactors(factorX, factorY);
+}
+
+void Dataset::setDerivedFields(const std::vector<std::string>& definitions) {
+    std::vector<std::string> previousDefinitions = std::move(derivedFieldDefinitions);
+    derivedFieldDefinitions = definitions;
+    try {
+        updateLoaderChain();
+    } catch (...) {
+        derivedFieldDefinitions = std::move(previousDefinitions);
+        throw;
+    }
+}
+
+void Dataset::updateLoaderChain() {
+    VolumeLoader* activeLoader = coarseningLoader ? static_cast<VolumeLoader*>(coarseningLoader.get()) : loader.get();
+    std::vector<std::string> fieldNames = inputFieldNames;
+    std::unique_ptr<DerivedFieldLoader> newDerivedFieldLoader;
+    if (!derivedFieldDefinitions.empty()) {
+        newDerivedFieldLoader = std::make_unique<DerivedFieldLoader>(activeLoader);
+        for (const std::string& definition : derivedFieldDefinitions) {
+            std::string fieldName, expression;
+            parseDerivedFieldDefinition(definition, fieldName, expression);
+            newDerivedFieldLoader->addDerivedField(fieldName, expression, fieldNames);
+            fieldNames.push_back(fieldName);
+        }
+        activeLoader = newDerivedFieldLoader.get();
+    }
+    volumeData->setLoader(activeLoader);
+    volumeData->setFieldNames(fieldNames);
+    derivedFieldLoader = std::move(newDerivedFieldLoader);
+}
+
+void Dataset::setSpillDirectory(const std::string& spillDirectory) {
+    volumeData->setSpillDirectory(spillDirectory);
+}
+
+void Dataset::setChunkShape(const std::vector<size_t>& chunkShape) {
+    volumeData->setChunkShape(chunkShape);
+}
+
+void Dataset::setAccessPattern(AccessPattern accessPattern) {
+    volumeData->setAccessPattern(accessPattern);
+}
+
+void Dataset::setChunkTargetSize(size_t chunkTargetSize) {
+    volumeData->setChunkTargetSize(chunkTargetSize);
+}
+
+void Dataset::setDeflateLevel(int deflateLevel) {
+    volumeData->setDeflateLevel(deflateLevel);
+}
+
+void Dataset::setUseShuffleFilter(bool useShuffleFilter) {
+    volumeData->setUseShuffleFilter(useShuffleFilter);
+}
+
+void Dataset::setRecordSlabHashes(bool recordSlabHashes) {
+    volumeData->setRecordSlabHashes(recordSlabHashes);
+}
+
+void Dataset::setCollapseTimeInvariantFields(bool collapseTimeInvariantFields) {
+    volumeData->setCollapseTimeInvariantFields(collapseTimeInvariantFields);
+}
+
+void Dataset::setUseDirectChunkWrite(bool useDirectChunkWrite) {
+    volumeData->setUseDirectChunkWrite(useDirectChunkWrite);
+}
+
+SlabIterator Dataset::iterateSlabs(const std::string& fieldName) {
+    return { volumeData.get(), fieldName };
+}
+
+void Dataset::writeToCtlFile(const std::string& filePath, bool isBigEndian) {
+    if (volumeData->getOutputFloatType() != OutputFloatType::NATIVE) {
+        throw std::runtime_error(
+                "Error in Dataset::writeToCtlFile: 16-bit floating point output is only supported for NetCDF files.");
+    }
+    if (volumeData->getTimeAggregation().type != TimeAggregationType::NONE) {
+        throw std::runtime_error(
+                "Error in Dataset::writeToCtlFile: Temporal aggregation is only supported for NetCDF files.");
+    }
+    if (!volumeData->getEnsembleStatistics().empty() || !volumeData->getWriteEnsembleMembers()) {
+        throw std::runtime_error(
+                "Error in Dataset::writeToCtlFile: Ensemble statistics are only supported for NetCDF files.");
+    }
+    CtlWriter ctlWriter(volumeData.get());
+    ctlWriter.setIsBigEndian(isBigEndian);
+    ctlWriter.writeToFile(filePath);
+}
+
+void Dataset::writeToCdf5File(const std::string& filePath) {
+    Cdf5Writer cdf5Writer(volumeData.get());
+    cdf5Writer.writeToFile(filePath);
+}
+
+void Dataset::writeToReferenceIndex(const std::string& filePath) {
+    if (volumeData->getLoader()->getRequiresSequentialReads()) {
+        throw std::runtime_error(
+                "Error in Dataset::writeToReferenceIndex: Data read from a stream cannot be referenced.");
+    }
+    ReferenceIndexWriter referenceIndexWriter(volumeData.get());
+    referenceIndexWriter.writeToFile(filePath);
+}
+
+void Dataset::writeToZarrStore(const std::string& storePath) {
+    ZarrWriter zarrWriter(volumeData.get());
+    zarrWriter.writeToFile(storePath);
+}
+
+void Dataset::writeToNcFile(const std::string& filePath) {
+    volumeData->writeToNcFile(filePath);
+}
+
+void Dataset::writeToNcHandle(int ncid) {
+    volumeData->writeToNcHandle(ncid);
+}
+
+NcMemoryBuffer Dataset::writeToNcMemory(size_t initialSize) {
+    int ncid = -1;
+    int status = nc_create_mem("ncconv", NC_NETCDF4, initialSize, &ncid);
+    if (status != NC_NOERR) {
+        throw std::runtime_error(
+                std::string() + "Error in Dataset::writeToNcMemory: nc_create_mem failed: " + nc_strerror(status));
+    }
+    try {
+        volumeData->writeToNcHandle(ncid);
+    } catch (...) {
+        nc_close(ncid);
+        throw;
+    }
+    NC_memio memio{};
+    status = nc_close_memio(ncid, &memio);
+    if (status != NC_NOERR) {
+        throw std::runtime_error(
+                std::string() + "Error in Dataset::writeToNcMemory: nc_close_memio failed: " + nc_strerror(status));
+    }
+    return { memio.memory, memio.size };
+}
+
+bool Dataset::verifyNcFile(const std::string& filePath, bool useRecordedHashesOnly) {
+    return volumeData->verifyNcFile(filePath, useRecordedHashesOnly);
+}
+
+std::vector<ReadBenchmarkResult> Dataset::benchmarkNcFileReads(const std::string& filePath, int numReads) {
+    return ::benchmarkNcFileReads(filePath, "", numReads);
+}
+
+ConversionEstimate Dataset::estimateConversion(
+        const std::string& filePath, bool isCdf5Output, bool probeWriteBandwidth) {
+    ConversionEstimator estimator(volumeData.get());
+    estimator.setIsCdf5Output(isCdf5Output);
+    estimator.setProbeWriteBandwidth(probeWriteBandwidth);
+    return estimator.estimate(filePath);
+}
+
+}
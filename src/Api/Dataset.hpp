@@ -0,0 +1,241 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef NCCONV_DATASET_HPP
+#define NCCONV_DATASET_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Volume/FieldType.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "Volume/VolumeData.hpp"
+#include "Volume/ConversionEstimator.hpp"
+#include "Volume/ReadBenchmark.hpp"
+
+class CoarseningLoader;
+class DerivedFieldLoader;
+
+/**
+ * Public API of libncconv for embedding the conversion into other programs.
+ *
+ * Example usage:
+ * ncconv::Dataset dataset("data.ctl");
+ * for (auto it = dataset.iterateSlabs("u"); it.next(); ) {
+ *     const ncconv::SlabView& view = it.get();
+ *     // Do something with view.data.
+ * }
+ * dataset.writeToNcFile("data.nc");
+ */
+namespace ncconv {
+
+/**
+ * Non-owning view of one slab of a field as decoded by the loader. The data is not copied again after decoding.
+ * The view is only valid until the next call of SlabIterator::next or until the iterator is destroyed.
+ */
+struct SlabView {
+    size_t timestepIdx = 0;
+    size_t memberIdx = 0;
+    FieldSlab slab;
+    size_t xs = 0;
+    FieldDataType dataType = FieldDataType::FLOAT32;
+    const uint8_t* data = nullptr;
+
+    [[nodiscard]] size_t getNumEntries() const {
+        return slab.zCount * slab.yCount * xs;
+    }
+    template<class T>
+    [[nodiscard]] const T* getData() const { return reinterpret_cast<const T*>(data); }
+};
+
+/**
+ * Iterates over all slabs of a field (all members, time steps and slabs fitting into the memory budget).
+ * The slab buffer is allocated once and reused for all slabs.
+ */
+class SlabIterator {
+public:
+    SlabIterator(VolumeData* volumeData, std::string fieldName);
+    /// Loads the next slab. Returns false if all slabs have been visited.
+    bool next();
+    [[nodiscard]] const SlabView& get() const { return view; }
+
+private:
+    VolumeData* volumeData;
+    std::string fieldName;
+    std::vector<FieldSlab> slabs;
+    std::vector<uint8_t> slabBuffer;
+    size_t itemIdx = 0;
+    size_t numItems = 0;
+    SlabView view;
+};
+
+/// Memory returned by Dataset::writeToNcMemory. The memory is freed when the object is destroyed.
+class NcMemoryBuffer {
+public:
+    NcMemoryBuffer(void* memory, size_t size) : memory(memory), size(size) {}
+    ~NcMemoryBuffer();
+    NcMemoryBuffer(const NcMemoryBuffer&) = delete;
+    NcMemoryBuffer& operator=(const NcMemoryBuffer&) = delete;
+    NcMemoryBuffer(NcMemoryBuffer&& other) noexcept;
+    NcMemoryBuffer& operator=(NcMemoryBuffer&& other) noexcept;
+    [[nodiscard]] const uint8_t* getData() const { return static_cast<const uint8_t*>(memory); }
+    [[nodiscard]] size_t getSize() const { return size; }
+
+private:
+    void* memory = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * An opened input data set. The descriptor is parsed once when the object is created, and the data file stays open
+ * until the object is destroyed, so the data set can be converted or read from repeatedly without reparsing.
+ */
+class Dataset {
+public:
+    /**
+     * Opens the passed data set. The loader is chosen based on the file extension.
+     * @param dataSetInformation Optional overrides, e.g., reading the data of a GrADS data set from stdin.
+     */
+    explicit Dataset(const std::string& filePath, const DataSetInformation& dataSetInformation = {});
+    ~Dataset();
+    Dataset(const Dataset&) = delete;
+    Dataset& operator=(const Dataset&) = delete;
+    Dataset(Dataset&&) noexcept;
+    Dataset& operator=(Dataset&&) noexcept;
+
+    /// Returns whether the passed file path has an extension supported by one of the loaders.
+    static bool getIsFileSupported(const std::string& filePath);
+    /**
+     * Sets the number of threads shared by all data sets for decoding, hashing and compression (0 selects the number
+     * of hardware threads), and the number of threads reading ahead while writing. Must not be called while a
+     * conversion is running.
+     */
+    static void setNumThreads(size_t numThreads, size_t numIoThreads = 1);
+
+    [[nodiscard]] const std::vector<std::string>& getFieldNames() const;
+    [[nodiscard]] VolumeData* getVolumeData() { return volumeData.get(); }
+    /// Returns the loader the data set is read with (the coarsening loader if the grid is coarsened).
+    [[nodiscard]] VolumeLoader* getLoader() { return volumeData->getLoader(); }
+    /// Maximum number of bytes used for buffering field data (0 means no limit).
+    void setMaxMemory(size_t maxMemory);
+    /// Whether to print progress information to stdout while writing (default: true).
+    void setIsVerbose(bool isVerbose);
+    /// Dimension order of time-dependent variables (default: OutputLayout::MAPS).
+    void setOutputLayout(OutputLayout outputLayout);
+    /// Storage type of floating point fields in NetCDF output files (default: OutputFloatType::NATIVE).
+    void setOutputFloatType(OutputFloatType outputFloatType);
+    /**
+     * Writes the mean, minimum, maximum and number of valid entries of each time-dependent variable over periods of
+     * time steps in addition to the variables themselves (default: none, see VolumeData::setTimeAggregation).
+     */
+    void setTimeAggregation(const TimeAggregation& timeAggregation);
+    /**
+     * Writes statistics over the members of ensemble data sets as the variables <name>_ens_<statistic> (default: none,
+     * see VolumeData::setEnsembleStatistics).
+     */
+    void setEnsembleStatistics(const std::vector<EnsembleStatistic>& ensembleStatistics);
+    /// Whether to write the members of ensemble data sets, or only their statistics (default: true).
+    void setWriteEnsembleMembers(bool writeEnsembleMembers);
+    /**
+     * Averages blocks of factorX x factorY horizontal grid points while reading (see CoarseningLoader), so that the
+     * data set is read and written on the coarse grid. Factors of 1 restore the input grid.
+     */
+    void setCoarseningFactors(int factorX, int factorY);
+    /**
+     * Coarsens the grid to the passed spacing in degrees (see setCoarseningFactors). Throws an exception if the
+     * spacing is not an integer multiple of the spacing of the input grid.
+     */
+    void setTargetResolution(double spacingX, double spacingY);
+    /**
+     * Adds variables computed from other variables while writing, each defined as "name=expression", e.g.,
+     * "ws=sqrt(u^2+v^2)" (see FieldExpression). Replaces previously set definitions.
+     */
+    void setDerivedFields(const std::vector<std::string>& definitions);
+    /// Directory for temporary files of out-of-core transposes (default: the system temporary directory).
+    void setSpillDirectory(const std::string& spillDirectory);
+    /// Chunk shape (z, y, x) of the output variables (default: chosen by the NetCDF library).
+    void setChunkShape(const std::vector<size_t>& chunkShape);
+    /// Expected read access pattern of the output file, used for choosing the chunk shape (see VolumeData).
+    void setAccessPattern(AccessPattern accessPattern);
+    /// Target size in bytes of the chunks chosen for an access pattern (default: 1 MiB).
+    void setChunkTargetSize(size_t chunkTargetSize);
+    /// Deflate compression level (1-9) of the output variables, or 0 for no compression (default).
+    void setDeflateLevel(int deflateLevel);
+    void setUseShuffleFilter(bool useShuffleFilter);
+    /// Whether to record per-slab XXH64 hashes as variable attributes for later verification (default: true).
+    void setRecordSlabHashes(bool recordSlabHashes);
+    /// Whether to write time-invariant variables once without the time dimension (default: false).
+    void setCollapseTimeInvariantFields(bool collapseTimeInvariantFields);
+    /// Whether to compress chunks on multiple threads with HDF5 direct chunk writes if built with support for it.
+    void setUseDirectChunkWrite(bool useDirectChunkWrite);
+
+    [[nodiscard]] SlabIterator iterateSlabs(const std::string& fieldName);
+
+    void writeToNcFile(const std::string& filePath);
+    /// Exports the data set as a GrADS .ctl descriptor and a .dat binary file next to it.
+    void writeToCtlFile(const std::string& filePath, bool isBigEndian = false);
+    /// Writes an uncompressed classic NetCDF file in the CDF-5 format without the NetCDF library (see Cdf5Writer).
+    void writeToCdf5File(const std::string& filePath);
+    /// Writes a JSON reference index pointing into the input file instead of copying the data.
+    void writeToReferenceIndex(const std::string& filePath);
+    /// Writes a Zarr (version 2) directory store with chunks compressed and written in parallel (see ZarrWriter).
+    void writeToZarrStore(const std::string& storePath);
+    /// Writes to a NetCDF-4 file created by the caller (in define mode). The file is not closed.
+    void writeToNcHandle(int ncid);
+    /// Writes the NetCDF-4 file to memory (using nc_create_mem) instead of to disk.
+    [[nodiscard]] NcMemoryBuffer writeToNcMemory(size_t initialSize = 0);
+    /// Compares a written NetCDF file against the input data set (see VolumeData::verifyNcFile).
+    bool verifyNcFile(const std::string& filePath, bool useRecordedHashesOnly = false);
+    /// Benchmarks reading a written NetCDF file with different access patterns (see benchmarkNcFileReads).
+    std::vector<ReadBenchmarkResult> benchmarkNcFileReads(const std::string& filePath, int numReads = 16);
+    /**
+     * Predicts the output size, peak memory and wall time of a conversion to the passed file without converting.
+     * @param isCdf5Output Whether .nc files are written with @see writeToCdf5File.
+     * @param probeWriteBandwidth Whether to measure the write bandwidth with a 32 MiB file in the output directory.
+     */
+    ConversionEstimate estimateConversion(
+            const std::string& filePath, bool isCdf5Output = false, bool probeWriteBandwidth = false);
+
+private:
+    /// Sets the loader of the volume data to the last wrapper around the input loader, and updates the field names.
+    void updateLoaderChain();
+
+    std::unique_ptr<VolumeLoader> loader;
+    std::unique_ptr<CoarseningLoader> coarseningLoader;
+    std::unique_ptr<DerivedFieldLoader> derivedFieldLoader;
+    std::unique_ptr<VolumeData> volumeData;
+    std::vector<std::string> inputFieldNames;
+    std::vector<std::string> derivedFieldDefinitions;
+};
+
+}
+
+#endif //NCCONV_DATASET_HPP
@@ -0,0 +1,316 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "Utils/TaskScheduler.hpp"
+#include "Volume/VolumeData.hpp"
+#include "DecodeKernels.hpp"
+#include "CoarseningLoader.hpp"
+
+/// Maximum size of the input rows read from the wrapped loader at once.
+static const size_t MAX_BAND_SIZE = size_t(16) << 20;
+
+/**
+ * Averages the valid entries of numFineRows input rows, weighted per row, in blocks of factorX columns. The column
+ * sums are accumulated first, as this loop is contiguous and branchless and thus vectorized by the compiler.
+ */
+template<class T>
+static void coarsenRowBlock(
+        const T* fineRows, const float* weights, size_t numFineRows, size_t fineXs, size_t factorX,
+        T* dstRow, size_t coarseXs, T* columnSums, T* columnWeights) {
+    for (size_t x = 0; x < fineXs; x++) {
+        columnSums[x] = T(0);
+        columnWeights[x] = T(0);
+    }
+    for (size_t r = 0; r < numFineRows; r++) {
+        const T* row = fineRows + r * fineXs;
+        T weight = T(weights[r]);
+        for (size_t x = 0; x < fineXs; x++) {
+            T value = row[x];
+            // Plain selects, so that the compiler can if-convert and vectorize the loop.
+            bool isValid = value == value;
+            T validValue = isValid ? value : T(0);
+            T validWeight = isValid ? weight : T(0);
+            columnSums[x] = columnSums[x] + weight * validValue;
+            columnWeights[x] = columnWeights[x] + validWeight;
+        }
+    }
+    for (size_t xc = 0; xc < coarseXs; xc++) {
+        size_t xStart = xc * factorX;
+        size_t xEnd = std::min(xStart + factorX, fineXs);
+        T sum = T(0), weightSum = T(0);
+        for (size_t x = xStart; x < xEnd; x++) {
+            sum += columnSums[x];
+            weightSum += columnWeights[x];
+        }
+        dstRow[xc] = weightSum > T(0) ? sum / weightSum : std::numeric_limits<T>::quiet_NaN();
+    }
+}
+
+template<class T>
+static void coarsenRowsTyped(
+        const T* fineData, const float* weights, size_t fineXs, size_t fineYCount, size_t factorX, size_t factorY,
+        T* dstData, size_t coarseXs, size_t coarseYCount) {
+    sgl::parallelFor(0, coarseYCount, 1, [&](size_t begin, size_t end) {
+        std::vector<T> columnSums(fineXs), columnWeights(fineXs);
+        for (size_t yc = begin; yc < end; yc++) {
+            size_t rowStart = yc * factorY;
+            size_t numRows = std::min(factorY, fineYCount - rowStart);
+            coarsenRowBlock(
+                    fineData + rowStart * fineXs, weights + rowStart, numRows, fineXs, factorX,
+                    dstData + yc * coarseXs, coarseXs, columnSums.data(), columnWeights.data());
+        }
+    });
+}
+
+static size_t getNumBlocks(size_t size, size_t factor) {
+    return (size + factor - 1) / factor;
+}
+
+/// Averages the coordinates of each block, or returns nullptr if the coordinates are not available.
+static float* coarsenCoordinates(const std::vector<float>& coords, size_t factor) {
+    if (coords.empty()) {
+        return nullptr;
+    }
+    size_t size = coords.size();
+    size_t numBlocks = getNumBlocks(size, factor);
+    auto* coarseCoords = new float[numBlocks];
+    for (size_t i = 0; i < numBlocks; i++) {
+        size_t start = i * factor;
+        size_t end = std::min(start + factor, size);
+        double sum = 0.0;
+        for (size_t j = start; j < end; j++) {
+            sum += double(coords[j]);
+        }
+        coarseCoords[i] = float(sum / double(end - start));
+    }
+    return coarseCoords;
+}
+
+static float* copyCoordinates(const std::vector<float>& coords) {
+    if (coords.empty()) {
+        return nullptr;
+    }
+    auto* copy = new float[coords.size()];
+    std::copy(coords.begin(), coords.end(), copy);
+    return copy;
+}
+
+static std::vector<float> getCoordinates(const float* coords, size_t size) {
+    if (!coords || size == 0) {
+        return {};
+    }
+    return { coords, coords + size };
+}
+
+CoarseningLoader::CoarseningLoader(VolumeLoader* baseLoader, int factorX, int factorY)
+        : baseLoader(baseLoader) {
+    if (factorX < 1 || factorY < 1) {
+        throw std::runtime_error("Error in CoarseningLoader::CoarseningLoader: The factors need to be at least 1.");
+    }
+    this->factorX = size_t(factorX);
+    this->factorY = size_t(factorY);
+}
+
+void CoarseningLoader::applyGrid(VolumeData* volumeData) {
+    fineXs = volumeData->getGridSizeX();
+    fineYs = volumeData->getGridSizeY();
+    zs = volumeData->getGridSizeZ();
+    fineLon1d = getCoordinates(volumeData->getLon1d(), fineXs);
+    fineLat1d = getCoordinates(volumeData->getLat1d(), fineYs);
+    lev1d = getCoordinates(volumeData->getLev1d(), zs);
+
+    const double degreesToRadians = 3.14159265358979323846 / 180.0;
+    rowWeights.resize(fineYs);
+    for (size_t y = 0; y < fineYs; y++) {
+        double weight = 1.0;
+        if (!fineLat1d.empty()) {
+            weight = std::max(std::cos(double(fineLat1d[y]) * degreesToRadians), 0.0);
+        }
+        rowWeights[y] = float(weight);
+    }
+
+    volumeData->setGridExtent(
+            getNumBlocks(fineXs, factorX), getNumBlocks(fineYs, factorY), zs,
+            coarsenCoordinates(fineLon1d, factorX), coarsenCoordinates(fineLat1d, factorY), copyCoordinates(lev1d));
+}
+
+void CoarseningLoader::restoreGrid(VolumeData* volumeData) {
+    volumeData->setGridExtent(
+            fineXs, fineYs, zs, copyCoordinates(fineLon1d), copyCoordinates(fineLat1d), copyCoordinates(lev1d));
+}
+
+int CoarseningLoader::computeFactorForSpacing(const float* coords, size_t numCoords, double targetSpacing) {
+    if (!coords || numCoords < 2) {
+        throw std::runtime_error(
+                "Error in CoarseningLoader::computeFactorForSpacing: The grid spacing of the data set is unknown.");
+    }
+    double spacing = std::abs(double(coords[numCoords - 1]) - double(coords[0])) / double(numCoords - 1);
+    auto factor = int(std::lround(targetSpacing / spacing));
+    if (factor < 1 || std::abs(double(factor) * spacing - targetSpacing) > 1e-3 * targetSpacing) {
+        throw std::runtime_error(
+                "Error in CoarseningLoader::computeFactorForSpacing: The target spacing "
+                + std::to_string(targetSpacing) + " is not an integer multiple of the grid spacing "
+                + std::to_string(spacing) + ".");
+    }
+    return factor;
+}
+
+bool CoarseningLoader::setInputFiles(VolumeData*, const std::string&, const DataSetInformation&) {
+    throw std::runtime_error("Error in CoarseningLoader::setInputFiles: The wrapped loader needs to be used instead.");
+}
+
+FieldDataType CoarseningLoader::getFieldDataType(const std::string& fieldName) {
+    FieldDataType dataType = baseLoader->getFieldDataType(fieldName);
+    return dataType == FieldDataType::FLOAT64 ? FieldDataType::FLOAT64 : FieldDataType::FLOAT32;
+}
+
+bool CoarseningLoader::getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) {
+    if (!baseLoader->getFieldExtent(fieldName, varXs, varYs, varZs)) {
+        return false;
+    }
+    varXs = getNumBlocks(varXs, factorX);
+    varYs = getNumBlocks(varYs, factorY);
+    return true;
+}
+
+bool CoarseningLoader::getFieldEntryNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    if (!getFieldExtent(fieldName, varXs, varYs, varZs)) {
+        return false;
+    }
+    FieldSlab slab;
+    slab.zCount = std::max(varZs, size_t(1));
+    slab.yCount = varYs;
+    size_t entrySize = getFieldDataTypeSize(getFieldDataType(fieldName));
+    fieldEntry = new uint8_t[varXs * varYs * slab.zCount * entrySize];
+    if (!getFieldSlabNative(volumeData, fieldName, timestepIdx, memberIdx, slab, fieldEntry)) {
+        delete[] fieldEntry;
+        fieldEntry = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool CoarseningLoader::getFieldEntry(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, float*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    uint8_t* data = nullptr;
+    if (!getFieldEntryNative(volumeData, fieldName, timestepIdx, memberIdx, data, varXs, varYs, varZs)) {
+        return false;
+    }
+    size_t numEntries = varXs * varYs * std::max(varZs, size_t(1));
+    fieldEntry = new float[numEntries];
+    decodeFieldEntries(
+            data, getFieldDataType(fieldName), fieldEntry, FieldDataType::FLOAT32, numEntries, false,
+            std::numeric_limits<double>::quiet_NaN());
+    delete[] data;
+    return true;
+}
+
+bool CoarseningLoader::getFieldSlabNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) {
+    size_t varXs = 0, varYs = 0, varZs = 0;
+    if (!baseLoader->getFieldExtent(fieldName, varXs, varYs, varZs)) {
+        return false;
+    }
+    varZs = std::max(varZs, size_t(1));
+    size_t coarseXs = getNumBlocks(varXs, factorX);
+    size_t coarseYs = getNumBlocks(varYs, factorY);
+    if (varYs != fineYs || slab.zCount < 1 || slab.zOffset + slab.zCount > varZs
+            || slab.yCount < 1 || slab.yOffset + slab.yCount > coarseYs
+            || (slab.zCount > 1 && slab.yCount != coarseYs)) {
+        throw std::runtime_error(
+                "Error in CoarseningLoader::getFieldSlabNative: Invalid slab for variable \"" + fieldName + "\".");
+    }
+
+    FieldDataType srcType = baseLoader->getFieldDataType(fieldName);
+    FieldDataType dstType = getFieldDataType(fieldName);
+    bool isIntegerField = !getIsFieldDataTypeFloat(srcType);
+    double fillValue = std::numeric_limits<double>::quiet_NaN();
+    if (isIntegerField && !baseLoader->getFieldFillValue(fieldName, fillValue)) {
+        fillValue = std::numeric_limits<double>::quiet_NaN();
+    }
+    size_t srcEntrySize = getFieldDataTypeSize(srcType);
+    size_t dstEntrySize = getFieldDataTypeSize(dstType);
+    size_t bandRowSize = factorY * varXs * (srcEntrySize + (isIntegerField ? sizeof(float) : 0));
+    size_t maxBandRows = std::max(MAX_BAND_SIZE / bandRowSize, size_t(1));
+
+    for (size_t z = slab.zOffset; z < slab.zOffset + slab.zCount; z++) {
+        for (size_t ycStart = slab.yOffset; ycStart < slab.yOffset + slab.yCount; ycStart += maxBandRows) {
+            size_t numCoarseRows = std::min(maxBandRows, slab.yOffset + slab.yCount - ycStart);
+            FieldSlab fineSlab;
+            fineSlab.zOffset = z;
+            fineSlab.yOffset = ycStart * factorY;
+            fineSlab.yCount = std::min(numCoarseRows * factorY, varYs - fineSlab.yOffset);
+            size_t numFineEntries = fineSlab.yCount * varXs;
+            fineBuffer.resize(numFineEntries * srcEntrySize);
+            if (!baseLoader->getFieldSlabNative(
+                    volumeData, fieldName, timestepIdx, memberIdx, fineSlab, fineBuffer.data())) {
+                return false;
+            }
+            const uint8_t* fineData = fineBuffer.data();
+            if (isIntegerField) {
+                decodedBuffer.resize(numFineEntries * sizeof(float));
+                decodeFieldEntries(
+                        fineBuffer.data(), srcType, decodedBuffer.data(), FieldDataType::FLOAT32, numFineEntries,
+                        false, fillValue);
+                fineData = decodedBuffer.data();
+            }
+            size_t dstOffset =
+                    ((z - slab.zOffset) * slab.yCount + (ycStart - slab.yOffset)) * coarseXs * dstEntrySize;
+            coarsenRows(
+                    fineData, dstType, varXs, fineSlab.yOffset, fineSlab.yCount, slabData + dstOffset,
+                    numCoarseRows);
+        }
+    }
+    return true;
+}
+
+void CoarseningLoader::coarsenRows(
+        const void* fineData, FieldDataType dataType, size_t varXs, size_t fineYOffset, size_t fineYCount,
+        uint8_t* dstData, size_t coarseYCount) {
+    size_t coarseXs = getNumBlocks(varXs, factorX);
+    const float* weights = rowWeights.data() + fineYOffset;
+    if (dataType == FieldDataType::FLOAT64) {
+        coarsenRowsTyped(
+                static_cast<const double*>(fineData), weights, varXs, fineYCount, factorX, factorY,
+                reinterpret_cast<double*>(dstData), coarseXs, coarseYCount);
+    } else {
+        coarsenRowsTyped(
+                static_cast<const float*>(fineData), weights, varXs, fineYCount, factorX, factorY,
+                reinterpret_cast<float*>(dstData), coarseXs, coarseYCount);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CORRERENDER_COARSENINGLOADER_HPP
+#define CORRERENDER_COARSENINGLOADER_HPP
+
+#include <vector>
+#include <cstdint>
+#include "VolumeLoader.hpp"
+
+/**
+ * Wraps another loader and coarsens the horizontal grid while reading, e.g., for writing a 0.25° data set on a 1°
+ * grid without writing the full resolution data first. Each output grid point is the area-weighted average of a block
+ * of factorX x factorY input grid points, with the cosine of the latitude as the weight of each input row. Missing
+ * entries (NaN, or the fill value of integer fields) are excluded from the average, and blocks without any valid entry
+ * are missing in the output. Blocks at the eastern and northern edge may be smaller if the grid size is not divisible
+ * by the factor.
+ * The rows of each requested slab are read from the wrapped loader in bands fitting into a fixed budget and reduced by
+ * a branchless kernel: the valid entries of the block rows are first accumulated per column (contiguous, so the
+ * compiler vectorizes it), and the column sums are then reduced per block. Integer fields are returned as float32 and
+ * float64 fields stay float64.
+ */
+class CoarseningLoader : public VolumeLoader {
+public:
+    /**
+     * @param baseLoader The loader of the input data set. It must outlive this loader.
+     * @param factorX The number of input grid points averaged along the x axis (longitude).
+     * @param factorY The number of input grid points averaged along the y axis (latitude).
+     */
+    CoarseningLoader(VolumeLoader* baseLoader, int factorX, int factorY);
+    /// Replaces the grid of the volume data by the coarse grid. The input grid is kept for @see restoreGrid.
+    void applyGrid(VolumeData* volumeData);
+    /// Restores the input grid of the volume data replaced by @see applyGrid.
+    void restoreGrid(VolumeData* volumeData);
+    /**
+     * Returns the coarsening factor matching a target grid spacing, or throws an exception if the spacing is not an
+     * integer multiple of the (regular) spacing of the coordinates.
+     */
+    static int computeFactorForSpacing(const float* coords, size_t numCoords, double targetSpacing);
+
+    /// Not supported; the wrapped loader needs to be initialized already.
+    bool setInputFiles(
+            VolumeData* volumeData, const std::string& filePath, const DataSetInformation& dataSetInformation) override;
+    bool getFieldEntry(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, float*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    FieldDataType getFieldDataType(const std::string& fieldName) override;
+    bool getFieldInputFillValue(const std::string& fieldName, double& fillValue) override {
+        return baseLoader->getFieldInputFillValue(fieldName, fillValue);
+    }
+    bool getFieldEntryNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldSlabNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) override;
+    bool getSupportsAsyncReads() override { return baseLoader->getSupportsAsyncReads(); }
+    bool getRequiresSequentialReads() override { return baseLoader->getRequiresSequentialReads(); }
+    bool getHasDerivedFields() override { return baseLoader->getHasDerivedFields(); }
+
+private:
+    void coarsenRows(
+            const void* fineData, FieldDataType dataType, size_t varXs, size_t fineYOffset, size_t fineYCount,
+            uint8_t* dstData, size_t coarseYCount);
+
+    VolumeLoader* baseLoader;
+    size_t factorX = 1, factorY = 1;
+    size_t fineXs = 0, fineYs = 0, zs = 0;
+    std::vector<float> fineLon1d, fineLat1d, lev1d;
+    std::vector<float> rowWeights; ///< Cosine of the latitude of each input row.
+    std::vector<uint8_t> fineBuffer, decodedBuffer; ///< Only one slab is read at a time (see VolumeLoader).
+};
+
+#endif //CORRERENDER_COARSENINGLOADER_HPP
@@ -31,15 +31,56 @@
 
 #include <iostream>
 #include <cstring>
+#include <cmath>
 #include <boost/algorithm/string/case_conv.hpp>
 
 #include "Utils/StringUtils.hpp"
 #include "Utils/FileUtils.hpp"
+#include <boost/filesystem.hpp>
 
 #include "Volume/VolumeData.hpp"
 #include "LoadersUtil.hpp"
+#include "DecodeKernels.hpp"
+#include "ForwardStreamReader.hpp"
 #include "CtlLoader.hpp"
 
+/**
+ * For binary data, GrADS encodes the data type in the units field of the variable records.
+ * - "-1,40,1": 1-byte unsigned integers.
+ * - "-1,40,2": 2-byte unsigned integers.
+ * - "-1,40,2,-1": 2-byte signed integers.
+ * - "-1,40,4": 4-byte signed integers.
+ * As an extension, "-1,40,1,-1" denotes 1-byte signed integers and "-1,40,8" 8-byte floating point numbers.
+ * All other values denote 4-byte floating point numbers (the GrADS default).
+ */
+static FieldDataType parseVarDataType(const std::string& units) {
+    std::vector<std::string> unitsParts;
+    sgl::splitString(units, ',', unitsParts);
+    if (unitsParts.size() < 3 || unitsParts.at(0) != "-1" || unitsParts.at(1) != "40") {
+        return FieldDataType::FLOAT32;
+    }
+    bool isSigned = unitsParts.size() >= 4 && unitsParts.at(3) == "-1";
+    int numBytes = sgl::fromString<int>(unitsParts.at(2));
+    if (numBytes == 1) {
+        return isSigned ? FieldDataType::INT8 : FieldDataType::UINT8;
+    } else if (numBytes == 2) {
+        return isSigned ? FieldDataType::INT16 : FieldDataType::UINT16;
+    } else if (numBytes == 4) {
+        return FieldDataType::INT32;
+    } else if (numBytes == 8) {
+        return FieldDataType::FLOAT64;
+    }
+    throw std::runtime_error("Error in CtlLoader::load: Unsupported data type \"" + units + "\".");
+}
+
+/**
+ * Parses the length of a dimension (or the number of levels of a variable). The string is parsed as a 64-bit integer,
+ * as parsing it as int would silently saturate lengths of 2^31 and more.
+ */
+static ptrdiff_t parseDimensionLength(const std::string& str, const std::string& dimensionName) {
+    return checkDimensionLength(sgl::fromString<int64_t>(str), "CtlLoader::load", dimensionName);
+}
+
 CtlLoader::CtlLoader() = default;
 
 CtlLoader::~CtlLoader() {
@@ -118,8 +159,11 @@ bool CtlLoader::setInputFiles(
                 std::string variableId = splitLineString.at(0);
                 CtlVarDesc varDesc;
                 varDesc.name = variableId;
-                varDesc.numLevels = sgl::fromString<int>(splitLineString.at(1));
+                varDesc.numLevels = parseDimensionLength(splitLineString.at(1), variableId);
                 varDesc.numLevels = std::max(varDesc.numLevels, ptrdiff_t(1));
+                if (splitLineString.size() >= 3) {
+                    varDesc.dataType = parseVarDataType(splitLineString.at(2));
+                }
                 variableNameMap.insert(std::make_pair(variableId, int(variableDescriptors.size())));
                 variableDescriptors.push_back(varDesc);
                 fieldNameMap.push_back(variableId);
@@ -137,6 +181,10 @@ bool CtlLoader::setInputFiles(
             if (!isAbsolutePath) {
                 dataFileName = sgl::getPathToFile(_filePath) + dataFileName;
             }
+            if (!dataSetInformation.dataFilePath.empty()) {
+                dataFileName = dataSetInformation.dataFilePath;
+            }
+            dataFilePath = dataFileName;
             openDataFile(dataFileName);
         } else if (key == "options") {
             std::string optionName = splitLineString.at(1);
@@ -153,29 +201,43 @@ bool CtlLoader::setInputFiles(
                 return false;
             }
         } else if (key == "undef") {
-            info.fillValue = sgl::fromString<float>(splitLineString.at(1));
+            info.fillValue = sgl::fromString<double>(splitLineString.at(1));
         } else if (key == "xdef") {
-            info.xs = sgl::fromString<int>(splitLineString.at(1));
+            info.xs = parseDimensionLength(splitLineString.at(1), "xdef");
             if (!parseDef(fileBuffer, charPtr, lengthCtl, lineBuffer, splitLineString)) {
                 return false;
             }
         } else if (key == "ydef") {
-            info.ys = sgl::fromString<int>(splitLineString.at(1));
+            info.ys = parseDimensionLength(splitLineString.at(1), "ydef");
             if (!parseDef(fileBuffer, charPtr, lengthCtl, lineBuffer, splitLineString)) {
                 return false;
             }
         } else if (key == "zdef") {
-            info.zs = sgl::fromString<int>(splitLineString.at(1));
+            info.zs = parseDimensionLength(splitLineString.at(1), "zdef");
             if (!parseDef(fileBuffer, charPtr, lengthCtl, lineBuffer, splitLineString)) {
                 return false;
             }
         } else if (key == "tdef") {
-            info.ts = sgl::fromString<int>(splitLineString.at(1));
+            info.ts = parseDimensionLength(splitLineString.at(1), "tdef");
             if (!parseDef(fileBuffer, charPtr, lengthCtl, lineBuffer, splitLineString)) {
                 return false;
             }
+            // The start time and increment are only needed for the time coordinate and for daily and monthly
+            // temporal aggregates, so time formats that cannot be parsed leave the data set without a time axis
+            // instead of failing to load it.
+            try {
+                volumeData->setTimeAxis(parseGradsTimeAxis(splitLineString.at(3), splitLineString.at(4)));
+            } catch (const std::exception& e) {
+                std::string tdefLine;
+                for (const std::string& token : splitLineString) {
+                    tdefLine += (tdefLine.empty() ? "" : " ") + token;
+                }
+                std::cerr << "Warning in CtlLoader::load: Could not parse the time axis of \"" << tdefLine
+                          << "\" in file \"" << _filePath << "\" (" << e.what()
+                          << "). The output will have no time coordinate." << std::endl;
+            }
         } else if (key == "edef") {
-            info.es = sgl::fromString<int>(splitLineString.at(1));
+            info.es = parseDimensionLength(splitLineString.at(1), "edef");
             if (!parseDef(fileBuffer, charPtr, lengthCtl, lineBuffer, splitLineString)) {
                 return false;
             }
@@ -194,16 +256,17 @@ bool CtlLoader::setInputFiles(
     ptrdiff_t offset = 0;
     for (CtlVarDesc& varDesc : variableDescriptors) {
         varDesc.offset = offset;
-        varDesc.size3d = varDesc.numLevels * info.xs * info.ys * ptrdiff_t(sizeof(float));
+        varDesc.size3d =
+                varDesc.numLevels * info.xs * info.ys * ptrdiff_t(getFieldDataTypeSize(varDesc.dataType));
         offset += varDesc.size3d;
         info.sizeAllVars3d += varDesc.size3d;
     }
 
     if (info.ts > 1) {
-        volumeData->setNumTimeSteps(info.ts);
+        volumeData->setNumTimeSteps(size_t(info.ts));
     }
     if (info.es > 1) {
-        volumeData->setEnsembleMemberCount(info.es);
+        volumeData->setEnsembleMemberCount(size_t(info.es));
     }
 
     bool isLatLonData = true;
@@ -216,7 +279,7 @@ bool CtlLoader::setInputFiles(
         dyCoords = info.ys > 1 ? (lat1d[info.ys - 1] - lat1d[0]) / float(info.ys - 1) : 1.0f;
         dxCoords = info.xs > 1 ? (lon1d[info.xs - 1] - lon1d[0]) / float(info.xs - 1) : 1.0f;
     }
-    volumeData->setGridExtent(int(info.xs), int(info.ys), int(info.zs), lon1d, lat1d, lev1d);
+    volumeData->setGridExtent(size_t(info.xs), size_t(info.ys), size_t(info.zs), lon1d, lat1d, lev1d);
     volumeData->setFieldNames(fieldNameMap);
 
     // Copy longitude and latitude to 2D array.
@@ -256,7 +319,7 @@ bool CtlLoader::parseDef(
 
     auto defType = splitLineString.at(0);
     boost::to_lower(defType);
-    auto dimLen = ptrdiff_t(sgl::fromString<int>(splitLineString.at(1)));
+    ptrdiff_t dimLen = parseDimensionLength(splitLineString.at(1), defType);
     std::string dimType = splitLineString.at(2);
     boost::to_lower(dimType);
 
@@ -310,6 +373,15 @@ bool CtlLoader::parseDef(
             throw std::runtime_error("Error in CtlLoader::parseDef: Too few entries.");
             return false;
         }
+    } else if (dimType == "names" && defType == "edef") {
+        // Only the number of ensemble members is relevant; the names are not stored.
+        if (splitLineString.size() != size_t(dimLen) + 3) {
+            throw std::runtime_error("Error in CtlLoader::parseDef: Invalid number of ensemble names.");
+            return false;
+        }
+        for (ptrdiff_t i = 0; i < dimLen; i++) {
+            levelsArray.push_back(float(i));
+        }
     } else {
         throw std::runtime_error("Error in CtlLoader::parseDef: Unknown type.");
         return false;
@@ -347,30 +419,67 @@ bool CtlLoader::parseDef(
     return true;
 }
 
-bool CtlLoader::getFieldEntry(
-        VolumeData* volumeData, const std::string& fieldName,
-        int timestepIdx, int memberIdx, float*& fieldEntry, int& varXs, int& varYs, int& varZs) {
+const CtlVarDesc& CtlLoader::getVariableDescriptor(const std::string& fieldName) {
     auto it = variableNameMap.find(fieldName);
     if (it == variableNameMap.end()) {
         throw std::runtime_error(
                 "Error in CtlLoader::getFieldEntry: Unknown field name \"" + fieldName + "\".");
-        return false;
     }
+    return variableDescriptors.at(it->second);
+}
 
-    auto& varDesc = variableDescriptors.at(it->second);
-    ptrdiff_t readOffset = (memberIdx * info.ts + timestepIdx) * info.sizeAllVars3d + varDesc.offset;
-    ptrdiff_t numEntries = varDesc.size3d / ptrdiff_t(sizeof(float));
-    auto* data = new float[numEntries];
-    loadDataFromFile(reinterpret_cast<uint8_t*>(data), readOffset, varDesc.size3d);
+bool CtlLoader::getHasFloat32Data() {
+    for (const CtlVarDesc& varDesc : variableDescriptors) {
+        if (varDesc.dataType != FieldDataType::FLOAT32) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (info.isBigEndian) {
-        swapEndianness(data, int(numEntries));
+FieldDataType CtlLoader::getFieldDataType(const std::string& fieldName) {
+    return getVariableDescriptor(fieldName).dataType;
+}
+
+bool CtlLoader::getFieldFillValue(const std::string& fieldName, double& fillValue) {
+    // Integer fields only have a fill value if the undef value can be stored in their data type.
+    FieldDataType dataType = getVariableDescriptor(fieldName).dataType;
+    if (getIsFieldDataTypeFloat(dataType) || !getIsFillValueRepresentable(dataType, info.fillValue)) {
+        return false;
     }
+    fillValue = info.fillValue;
+    return true;
+}
 
-    for (ptrdiff_t i = 0; i < numEntries; i++) {
-        if (data[i] == info.fillValue) {
-            data[i] = std::numeric_limits<float>::quiet_NaN();
-        }
+bool CtlLoader::getFieldInputFillValue(const std::string& fieldName, double& fillValue) {
+    if (!getIsFillValueRepresentable(getVariableDescriptor(fieldName).dataType, info.fillValue)) {
+        return false;
+    }
+    fillValue = info.fillValue;
+    return true;
+}
+
+bool CtlLoader::getFieldEntry(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, float*& fieldEntry,
+        size_t& varXs, size_t& varYs, size_t& varZs) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    ptrdiff_t readOffset =
+            (ptrdiff_t(memberIdx) * info.ts + ptrdiff_t(timestepIdx)) * info.sizeAllVars3d + varDesc.offset;
+    ptrdiff_t numEntries = varDesc.size3d / ptrdiff_t(getFieldDataTypeSize(varDesc.dataType));
+    auto* data = new float[numEntries];
+    if (varDesc.dataType == FieldDataType::FLOAT32) {
+        loadDataFromFile(reinterpret_cast<uint8_t*>(data), readOffset, varDesc.size3d);
+        decodeFieldEntries(
+                reinterpret_cast<uint8_t*>(data), varDesc.dataType, data, FieldDataType::FLOAT32,
+                size_t(numEntries), info.isBigEndian, info.fillValue);
+    } else {
+        auto* rawData = new uint8_t[varDesc.size3d];
+        loadDataFromFile(rawData, readOffset, varDesc.size3d);
+        decodeFieldEntries(
+                rawData, varDesc.dataType, data, FieldDataType::FLOAT32,
+                size_t(numEntries), info.isBigEndian, info.fillValue);
+        delete[] rawData;
     }
 
     if (varDesc.numLevels != info.zs) {
@@ -383,7 +492,7 @@ bool CtlLoader::getFieldEntry(
         auto* data2d = data;
         data = new float[numEntries * varDesc.numLevels];
         for (ptrdiff_t z = 0; z < varDesc.numLevels; z++) {
-            memcpy(data + z * numEntries, data2d, varDesc.size3d);
+            memcpy(data + z * numEntries, data2d, numEntries * sizeof(float));
         }
         delete[] data2d;
     }
@@ -391,14 +500,94 @@ bool CtlLoader::getFieldEntry(
     // TODO
     //fieldEntry = new HostCacheEntryType(info.xs * info.ys * info.zs, data);
     fieldEntry = data;
-    varXs = info.xs;
-    varYs = info.ys;
-    varZs = varDesc.numLevels;
+    varXs = size_t(info.xs);
+    varYs = size_t(info.ys);
+    varZs = size_t(varDesc.numLevels);
+
+    return true;
+}
+
+bool CtlLoader::getFieldEntryNative(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry,
+        size_t& varXs, size_t& varYs, size_t& varZs) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    ptrdiff_t readOffset =
+            (ptrdiff_t(memberIdx) * info.ts + ptrdiff_t(timestepIdx)) * info.sizeAllVars3d + varDesc.offset;
+    ptrdiff_t numEntries = varDesc.size3d / ptrdiff_t(getFieldDataTypeSize(varDesc.dataType));
+
+    // The native type has the same size as the file type, so the data can be decoded in-place.
+    auto* data = new uint8_t[varDesc.size3d];
+    loadDataFromFile(data, readOffset, varDesc.size3d);
+    decodeFieldEntries(
+            data, varDesc.dataType, data, varDesc.dataType, size_t(numEntries), info.isBigEndian, info.fillValue);
+
+    fieldEntry = data;
+    varXs = size_t(info.xs);
+    varYs = size_t(info.ys);
+    varZs = size_t(varDesc.numLevels);
+
+    return true;
+}
+
+bool CtlLoader::getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    varXs = size_t(info.xs);
+    varYs = size_t(info.ys);
+    varZs = size_t(varDesc.numLevels);
+    return true;
+}
+
+bool CtlLoader::getFieldSlabNative(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    if (slab.zCount < 1 || slab.zOffset + slab.zCount > size_t(varDesc.numLevels)
+            || slab.yCount < 1 || slab.yOffset + slab.yCount > size_t(info.ys)
+            || (slab.zCount > 1 && slab.yCount != size_t(info.ys))) {
+        throw std::runtime_error(
+                "Error in CtlLoader::getFieldSlabNative: Invalid slab for variable \"" + fieldName + "\".");
+    }
+
+    // The slab is contiguous in the file, as it either spans whole z-levels or rows within one z-level.
+    auto entrySize = ptrdiff_t(getFieldDataTypeSize(varDesc.dataType));
+    ptrdiff_t numEntries = ptrdiff_t(slab.zCount) * ptrdiff_t(slab.yCount) * info.xs;
+    ptrdiff_t slabOffset = (ptrdiff_t(slab.zOffset) * info.ys + ptrdiff_t(slab.yOffset)) * info.xs * entrySize;
+    ptrdiff_t fieldOffset = (ptrdiff_t(memberIdx) * info.ts + ptrdiff_t(timestepIdx)) * info.sizeAllVars3d;
+    ptrdiff_t readOffset = fieldOffset + varDesc.offset + slabOffset;
+    loadDataFromFile(slabData, readOffset, numEntries * entrySize);
+    decodeFieldEntries(
+            slabData, varDesc.dataType, slabData, varDesc.dataType, size_t(numEntries),
+            info.isBigEndian, info.fillValue);
+
+    return true;
+}
 
+bool CtlLoader::getFieldFileRange(
+        const std::string& fieldName, size_t timestepIdx, size_t memberIdx, FieldFileRange& range) {
+    if (streamReader) {
+        return false;
+    }
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    range.filePath = dataFilePath;
+    range.offset = uint64_t((ptrdiff_t(memberIdx) * info.ts + ptrdiff_t(timestepIdx)) * info.sizeAllVars3d)
+            + uint64_t(varDesc.offset);
+    range.size = uint64_t(varDesc.size3d);
+    range.isBigEndian = info.isBigEndian;
+    range.hasFillValue = getIsFillValueRepresentable(varDesc.dataType, info.fillValue);
+    range.fillValue = range.hasFillValue ? info.fillValue : 0.0;
     return true;
 }
 
 bool CtlLoader::openDataFile(const std::string& dataFileName) {
+    if (dataFileName == "-") {
+        file = stdin;
+        streamReader = std::make_unique<ForwardStreamReader>(file, "stdin");
+        return true;
+    }
+    // Named pipes and character devices cannot be seeked in, so they are read like stdin.
+    bool isStream =
+            boost::filesystem::exists(dataFileName) && !boost::filesystem::is_regular_file(dataFileName);
 #if defined(__linux__) || defined(__MINGW32__) // __GNUC__? Does GCC generally work on non-POSIX systems?
     file = fopen64(dataFileName.c_str(), "rb");
 #else
@@ -409,15 +598,27 @@ bool CtlLoader::openDataFile(const std::string& dataFileName) {
         return false;
     }
 
+    if (isStream) {
+        streamReader = std::make_unique<ForwardStreamReader>(file, dataFileName);
+    }
+
     return true;
 }
 
 void CtlLoader::closeDataFile() {
-    fclose(file);
+    // The read thread of the stream reader is stopped before the file is closed.
+    streamReader.reset();
+    if (file != stdin) {
+        fclose(file);
+    }
     file = nullptr;
 }
 
 void CtlLoader::loadDataFromFile(uint8_t* destBuffer, ptrdiff_t offset, ptrdiff_t size) {
+    if (streamReader) {
+        streamReader->read(uint64_t(offset), destBuffer, size_t(size));
+        return;
+    }
 #if defined(_WIN32) && !defined(__MINGW32__)
     int ret = _fseeki64(file, offset, SEEK_SET);
 #else
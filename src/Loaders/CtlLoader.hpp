@@ -33,13 +33,17 @@
 #include <unordered_map>
 #include <limits>
 #include <cstdint>
+#include <memory>
 #include "VolumeLoader.hpp"
 
+class ForwardStreamReader;
+
 struct CtlVarDesc {
     std::string name;
     ptrdiff_t offset = 0; //< Offset within one time step.
     ptrdiff_t numLevels = 0;
     ptrdiff_t size3d = 0; //< Size in 3D.
+    FieldDataType dataType = FieldDataType::FLOAT32; //< Data type of the entries in the data file.
 };
 
 struct CtlInfo {
@@ -47,7 +51,7 @@ struct CtlInfo {
     ptrdiff_t sizeAllVars3d = 0; //< Order in memory: es > ts > var > zs > ys > xs
     bool isBigEndian = false;
     bool isSequential = false; //< FORTRAN sequential data with header? (not supported so far)
-    float fillValue = std::numeric_limits<float>::quiet_NaN();
+    double fillValue = std::numeric_limits<double>::quiet_NaN();
 };
 
 /**
@@ -67,7 +71,26 @@ public:
             VolumeData* volumeData, const std::string& filePath, const DataSetInformation& dataSetInformation) override;
     bool getFieldEntry(
             VolumeData* volumeData, const std::string& fieldName,
-            int timestepIdx, int memberIdx, float*& fieldEntry, int& varXs, int& varYs, int& varZs) override;
+            size_t timestepIdx, size_t memberIdx, float*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getHasFloat32Data() override;
+    FieldDataType getFieldDataType(const std::string& fieldName) override;
+    bool getFieldFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldInputFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldEntryNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldSlabNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) override;
+    /// The data file is read with stdio, so slabs can be read on an I/O thread while the NetCDF output is written.
+    bool getSupportsAsyncReads() override { return true; }
+    bool getFieldFileRange(
+            const std::string& fieldName, size_t timestepIdx, size_t memberIdx, FieldFileRange& range) override;
+    /// Data read from stdin ("-") or from a named pipe can only be read front to back.
+    bool getRequiresSequentialReads() override { return streamReader != nullptr; }
 
 private:
     DataSetInformation dataSetInformation;
@@ -78,6 +101,7 @@ private:
     float* lat1d = nullptr;
     float* lev1d = nullptr;
 
+    const CtlVarDesc& getVariableDescriptor(const std::string& fieldName);
     bool parseDef(
             char*& fileBuffer, size_t& charPtr, size_t& lengthCtl,
             std::string& lineBuffer, std::vector<std::string>& splitLineString);
@@ -86,7 +110,10 @@ private:
     void loadDataFromFile(uint8_t* destBuffer, ptrdiff_t offset, ptrdiff_t size);
     bool openDataFile(const std::string& dataFileName);
     void closeDataFile();
+    std::string dataFilePath;
     FILE* file = nullptr;
+    /// Reads the data file if it is not seekable, i.e., stdin or a named pipe.
+    std::unique_ptr<ForwardStreamReader> streamReader;
 };
 
 #endif //CORRERENDER_CTLLOADER_HPP
@@ -0,0 +1,394 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NCCONV_USE_F16C_KERNEL
+#endif
+
+#include "Utils/TaskScheduler.hpp"
+#include "DecodeKernels.hpp"
+
+/// Number of entries processed per task by the kernels. Smaller arrays are processed on the calling thread.
+static const size_t KERNEL_GRAIN_SIZE = size_t(1) << 18;
+
+template<class SrcT, class DstT>
+static void decodeEntriesDispatch(
+        const uint8_t* src, DstT* dst, size_t n, bool swapBytes, bool hasFill, SrcT fillValue) {
+    if (!swapBytes && !hasFill && static_cast<const void*>(src) == static_cast<const void*>(dst)
+            && std::is_same<SrcT, DstT>::value) {
+        return;
+    }
+    // In-place decoding only requires equal entry sizes, so ranges of entries can be decoded independently.
+    sgl::parallelFor(0, n, KERNEL_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        const uint8_t* rangeSrc = src + begin * sizeof(SrcT);
+        if (swapBytes && hasFill) {
+            decodeEntries<SrcT, DstT, true, true>(rangeSrc, dst + begin, end - begin, fillValue);
+        } else if (swapBytes) {
+            decodeEntries<SrcT, DstT, true, false>(rangeSrc, dst + begin, end - begin, fillValue);
+        } else if (hasFill) {
+            decodeEntries<SrcT, DstT, false, true>(rangeSrc, dst + begin, end - begin, fillValue);
+        } else {
+            decodeEntries<SrcT, DstT, false, false>(rangeSrc, dst + begin, end - begin, fillValue);
+        }
+    });
+}
+
+template<class SrcT>
+static void decodeFieldEntriesTyped(
+        const uint8_t* src, void* dst, FieldDataType srcType, FieldDataType dstType, size_t n,
+        bool swapBytes, double fillValue) {
+    // Integer fill values that are not representable by the source type can never match an entry.
+    bool hasFill = getIsFieldDataTypeFloat(dstType) && getIsValueRepresentable<SrcT>(fillValue);
+    auto srcFillValue = hasFill ? SrcT(fillValue) : SrcT(0);
+
+    if (dstType == FieldDataType::FLOAT32) {
+        decodeEntriesDispatch<SrcT, float>(src, static_cast<float*>(dst), n, swapBytes, hasFill, srcFillValue);
+    } else if (dstType == FieldDataType::FLOAT64) {
+        decodeEntriesDispatch<SrcT, double>(src, static_cast<double*>(dst), n, swapBytes, hasFill, srcFillValue);
+    } else if (dstType == srcType) {
+        decodeEntriesDispatch<SrcT, SrcT>(src, static_cast<SrcT*>(dst), n, swapBytes, false, srcFillValue);
+    } else {
+        throw std::runtime_error(
+                std::string() + "Error in decodeFieldEntries: Unsupported conversion from "
+                + getFieldDataTypeName(srcType) + " to " + getFieldDataTypeName(dstType) + ".");
+    }
+}
+
+void decodeFieldEntries(
+        const uint8_t* src, FieldDataType srcType, void* dst, FieldDataType dstType, size_t n,
+        bool swapBytes, double fillValue) {
+    if (src == dst && getFieldDataTypeSize(srcType) != getFieldDataTypeSize(dstType)) {
+        throw std::runtime_error("Error in decodeFieldEntries: In-place decoding requires types of equal size.");
+    }
+    switch (srcType) {
+        case FieldDataType::INT8:
+            decodeFieldEntriesTyped<int8_t>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::UINT8:
+            decodeFieldEntriesTyped<uint8_t>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::INT16:
+            decodeFieldEntriesTyped<int16_t>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::UINT16:
+            decodeFieldEntriesTyped<uint16_t>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::INT32:
+            decodeFieldEntriesTyped<int32_t>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::FLOAT32:
+            decodeFieldEntriesTyped<float>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::FLOAT64:
+            decodeFieldEntriesTyped<double>(src, dst, srcType, dstType, n, swapBytes, fillValue);
+            break;
+    }
+}
+
+template<class T>
+static void encodeFieldEntriesTyped(const T* src, uint8_t* dst, size_t n, bool swapBytes, double fillValue) {
+    bool hasFill = std::is_floating_point<T>::value && !std::isnan(fillValue);
+    auto dstFillValue = T(fillValue);
+    if (!swapBytes && !hasFill && static_cast<const void*>(src) == static_cast<const void*>(dst)) {
+        return;
+    }
+    sgl::parallelFor(0, n, KERNEL_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        uint8_t* rangeDst = dst + begin * sizeof(T);
+        if (swapBytes && hasFill) {
+            encodeEntries<T, true, true>(src + begin, rangeDst, end - begin, dstFillValue);
+        } else if (swapBytes) {
+            encodeEntries<T, true, false>(src + begin, rangeDst, end - begin, dstFillValue);
+        } else if (hasFill) {
+            encodeEntries<T, false, true>(src + begin, rangeDst, end - begin, dstFillValue);
+        } else {
+            memcpy(rangeDst, src + begin, (end - begin) * sizeof(T));
+        }
+    });
+}
+
+void encodeFieldEntries(
+        const void* src, FieldDataType dataType, uint8_t* dst, size_t n, bool swapBytes, double fillValue) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+            encodeFieldEntriesTyped(static_cast<const int8_t*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::UINT8:
+            encodeFieldEntriesTyped(static_cast<const uint8_t*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::INT16:
+            encodeFieldEntriesTyped(static_cast<const int16_t*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::UINT16:
+            encodeFieldEntriesTyped(static_cast<const uint16_t*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::INT32:
+            encodeFieldEntriesTyped(static_cast<const int32_t*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::FLOAT32:
+            encodeFieldEntriesTyped(static_cast<const float*>(src), dst, n, swapBytes, fillValue);
+            break;
+        case FieldDataType::FLOAT64:
+            encodeFieldEntriesTyped(static_cast<const double*>(src), dst, n, swapBytes, fillValue);
+            break;
+    }
+}
+
+template<class T>
+static void canonicalizeNaNsTyped(T* data, size_t n) {
+    const T canonicalNaN = std::numeric_limits<T>::quiet_NaN();
+    sgl::parallelFor(0, n, KERNEL_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (data[i] != data[i]) {
+                data[i] = canonicalNaN;
+            }
+        }
+    });
+}
+
+void canonicalizeNaNs(void* data, FieldDataType dataType, size_t n) {
+    if (dataType == FieldDataType::FLOAT32) {
+        canonicalizeNaNsTyped(static_cast<float*>(data), n);
+    } else if (dataType == FieldDataType::FLOAT64) {
+        canonicalizeNaNsTyped(static_cast<double*>(data), n);
+    }
+}
+
+template<class T>
+static bool getAreEntriesMissingTyped(const T* data, size_t n, T fillValue) {
+    for (size_t i = 0; i < n; i++) {
+        if (data[i] != fillValue) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class T>
+static bool getAreEntriesNaNTyped(const T* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (data[i] == data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool getAreEntriesMissing(const void* data, FieldDataType dataType, size_t n, bool hasFillValue, double fillValue) {
+    switch (dataType) {
+        case FieldDataType::FLOAT32:
+            return getAreEntriesNaNTyped(static_cast<const float*>(data), n);
+        case FieldDataType::FLOAT64:
+            return getAreEntriesNaNTyped(static_cast<const double*>(data), n);
+        default:
+            break;
+    }
+    if (!hasFillValue || !getIsFillValueRepresentable(dataType, fillValue)) {
+        return false;
+    }
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return getAreEntriesMissingTyped(static_cast<const int8_t*>(data), n, static_cast<int8_t>(fillValue));
+        case FieldDataType::UINT8:
+            return getAreEntriesMissingTyped(static_cast<const uint8_t*>(data), n, static_cast<uint8_t>(fillValue));
+        case FieldDataType::INT16:
+            return getAreEntriesMissingTyped(static_cast<const int16_t*>(data), n, static_cast<int16_t>(fillValue));
+        case FieldDataType::UINT16:
+            return getAreEntriesMissingTyped(
+                    static_cast<const uint16_t*>(data), n, static_cast<uint16_t>(fillValue));
+        case FieldDataType::INT32:
+            return getAreEntriesMissingTyped(static_cast<const int32_t*>(data), n, static_cast<int32_t>(fillValue));
+        default:
+            return false;
+    }
+}
+
+void HalfFloatStats::add(const HalfFloatStats& other) {
+    numEntries += other.numEntries;
+    numMissing += other.numMissing;
+    numOverflows += other.numOverflows;
+    numUnderflows += other.numUnderflows;
+    numSubnormals += other.numSubnormals;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+/**
+ * Converts a float to float16 with round-to-nearest-even (see F. Giesen, "float->half variants"). Subnormal results
+ * are rounded by the floating point addition of a magic number, which relies on the default rounding mode.
+ */
+static inline uint16_t convertFloatToHalf(float value) {
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Overflow = (127u + 16u) << 23;
+    const uint32_t denormMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    if (bits > f32Infinity) {
+        return 0x7E00u;
+    }
+    uint32_t result;
+    if (bits >= f16Overflow) {
+        result = 0x7C00u;
+    } else if (bits < (113u << 23)) {
+        float denormMagic, magnitude;
+        memcpy(&denormMagic, &denormMagicBits, sizeof(float));
+        memcpy(&magnitude, &bits, sizeof(float));
+        magnitude += denormMagic;
+        memcpy(&result, &magnitude, sizeof(uint32_t));
+        result -= denormMagicBits;
+    } else {
+        uint32_t isMantissaOdd = (bits >> 13) & 1u;
+        bits += (uint32_t(15 - 127) << 23) + 0xFFFu + isMantissaOdd;
+        result = bits >> 13;
+    }
+    return uint16_t(result | (sign >> 16));
+}
+
+/// Converts a float to bfloat16 (i.e., the upper 16 bits of the float) with round-to-nearest-even.
+static inline uint16_t convertFloatToBfloat16(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return 0x7FC0u;
+    }
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return uint16_t(bits >> 16);
+}
+
+#ifdef NCCONV_USE_F16C_KERNEL
+__attribute__((target("avx,f16c")))
+static void convertFloatsToHalfF16C(const float* src, uint16_t* dst, size_t n) {
+    // NaN payloads are preserved by vcvtps2ph, so NaN entries are replaced by the canonical NaN beforehand.
+    const __m256 canonicalNaN = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FC00000));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 values = _mm256_loadu_ps(src + i);
+        values = _mm256_blendv_ps(values, canonicalNaN, _mm256_cmp_ps(values, values, _CMP_UNORD_Q));
+        __m128i halfValues = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halfValues);
+    }
+    for (; i < n; i++) {
+        dst[i] = convertFloatToHalf(src[i]);
+    }
+}
+
+static bool getIsF16CSupported() {
+    static const bool isSupported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return isSupported;
+}
+#endif
+
+static void convertFloatsToHalf(const float* src, uint16_t* dst, size_t n, OutputFloatType outputFloatType) {
+    if (outputFloatType == OutputFloatType::BFLOAT16) {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = convertFloatToBfloat16(src[i]);
+        }
+        return;
+    }
+#ifdef NCCONV_USE_F16C_KERNEL
+    if (getIsF16CSupported()) {
+        convertFloatsToHalfF16C(src, dst, n);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = convertFloatToHalf(src[i]);
+    }
+}
+
+static void addHalfFloatStats(
+        const float* src, const uint16_t* dst, size_t n, OutputFloatType outputFloatType, HalfFloatStats& stats) {
+    const uint16_t exponentMask = outputFloatType == OutputFloatType::BFLOAT16 ? 0x7F80u : 0x7C00u;
+    float minValue = std::numeric_limits<float>::infinity();
+    float maxValue = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < n; i++) {
+        float value = src[i];
+        auto magnitude = uint16_t(dst[i] & 0x7FFFu);
+        if (value != value) {
+            stats.numMissing++;
+            continue;
+        }
+        if (std::isfinite(value)) {
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            if (magnitude == exponentMask) {
+                stats.numOverflows++;
+            }
+        }
+        if (magnitude == 0 && value != 0.0f) {
+            stats.numUnderflows++;
+        } else if (magnitude != 0 && (magnitude & exponentMask) == 0) {
+            stats.numSubnormals++;
+        }
+    }
+    stats.numEntries += n;
+    stats.minValue = std::min(stats.minValue, double(minValue));
+    stats.maxValue = std::max(stats.maxValue, double(maxValue));
+}
+
+void encodeHalfFloats(
+        const void* src, FieldDataType srcType, uint16_t* dst, size_t n, OutputFloatType outputFloatType,
+        HalfFloatStats& stats) {
+    if (!getIsFieldDataTypeFloat(srcType) || outputFloatType == OutputFloatType::NATIVE) {
+        throw std::runtime_error(
+                std::string() + "Error in encodeHalfFloats: Unsupported conversion from "
+                + getFieldDataTypeName(srcType) + " to " + getOutputFloatTypeName(outputFloatType) + ".");
+    }
+    std::mutex statsMutex;
+    sgl::parallelFor(0, n, KERNEL_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        // float64 entries are converted to float32 in blocks small enough to stay in the L1 cache.
+        const size_t blockSize = 1024;
+        float floatBlock[blockSize];
+        HalfFloatStats rangeStats;
+        for (size_t blockBegin = begin; blockBegin < end; blockBegin += blockSize) {
+            size_t blockCount = std::min(blockSize, end - blockBegin);
+            const float* floatValues = floatBlock;
+            if (srcType == FieldDataType::FLOAT32) {
+                floatValues = static_cast<const float*>(src) + blockBegin;
+            } else {
+                const double* doubleValues = static_cast<const double*>(src) + blockBegin;
+                for (size_t i = 0; i < blockCount; i++) {
+                    floatBlock[i] = float(doubleValues[i]);
+                }
+            }
+            convertFloatsToHalf(floatValues, dst + blockBegin, blockCount, outputFloatType);
+            addHalfFloatStats(floatValues, dst + blockBegin, blockCount, outputFloatType, rangeStats);
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.add(rangeStats);
+    });
+}
@@ -0,0 +1,167 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef NCCONV_DECODEKERNELS_HPP
+#define NCCONV_DECODEKERNELS_HPP
+
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+#include "Volume/FieldType.hpp"
+
+/**
+ * Reverses the byte order of a single value. Compilers map this to a single bswap instruction (or a no-op for bytes).
+ */
+template<class T>
+inline T byteSwapValue(T value) {
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (size_t j = 0; j < sizeof(T) / 2; j++) {
+        uint8_t tmp = bytes[j];
+        bytes[j] = bytes[sizeof(T) - j - 1];
+        bytes[sizeof(T) - j - 1] = tmp;
+    }
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+/**
+ * Decodes entries stored in a data file in one pass (byte swapping, fill value mapping and type conversion).
+ * The kernel is instantiated for every (type, endianness, fill) combination, so no per-entry branches remain except
+ * for the fill value comparison. Decoding in-place (src == dst) is supported if sizeof(SrcT) == sizeof(DstT).
+ * @tparam SrcT The data type of the entries in the file.
+ * @tparam DstT The data type of the decoded entries.
+ * @tparam SwapBytes Whether the byte order of the file differs from the host byte order.
+ * @tparam HasFill Whether entries equal to fillValue should be mapped to NaN (only valid for floating point DstT).
+ * @param src The raw bytes read from the file.
+ * @param dst The destination array.
+ * @param n The number of entries.
+ * @param fillValue The fill value (i.e., "undef" in GrADS) of the data in the file.
+ */
+template<class SrcT, class DstT, bool SwapBytes, bool HasFill>
+void decodeEntries(const uint8_t* src, DstT* dst, size_t n, SrcT fillValue) {
+    for (size_t i = 0; i < n; i++) {
+        SrcT value;
+        memcpy(&value, src + i * sizeof(SrcT), sizeof(SrcT));
+        if (SwapBytes) {
+            value = byteSwapValue(value);
+        }
+        if (HasFill && value == fillValue) {
+            dst[i] = std::numeric_limits<DstT>::quiet_NaN();
+        } else {
+            dst[i] = DstT(value);
+        }
+    }
+}
+
+/**
+ * Inverse of @see decodeEntries for writing entries to a data file in one pass (NaN to fill value mapping and byte
+ * swapping). Encoding in-place (src == dst) is supported.
+ * @tparam T The data type of the entries.
+ * @tparam SwapBytes Whether the byte order of the file differs from the host byte order.
+ * @tparam HasFill Whether NaN entries should be replaced by fillValue (only valid for floating point T).
+ */
+template<class T, bool SwapBytes, bool HasFill>
+void encodeEntries(const T* src, uint8_t* dst, size_t n, T fillValue) {
+    for (size_t i = 0; i < n; i++) {
+        T value = src[i];
+        if (HasFill && value != value) {
+            value = fillValue;
+        }
+        if (SwapBytes) {
+            value = byteSwapValue(value);
+        }
+        memcpy(dst + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+/**
+ * Runtime dispatch to the matching decodeEntries kernel.
+ * @param src The raw bytes read from the file.
+ * @param srcType The data type of the entries in the file.
+ * @param dst The destination array. May be equal to src if the source and destination type have the same size.
+ * @param dstType The data type of the destination array. Must be either equal to srcType or a floating point type.
+ * @param n The number of entries.
+ * @param swapBytes Whether the byte order of the file differs from the host byte order.
+ * @param fillValue The fill value of the file data. Only mapped to NaN if dstType is a floating point type.
+ */
+void decodeFieldEntries(
+        const uint8_t* src, FieldDataType srcType, void* dst, FieldDataType dstType, size_t n,
+        bool swapBytes, double fillValue);
+
+/**
+ * Runtime dispatch to the matching encodeEntries kernel.
+ * @param src The entries in host byte order.
+ * @param dataType The data type of the entries.
+ * @param dst The destination byte array. May be equal to src.
+ * @param n The number of entries.
+ * @param swapBytes Whether the byte order of the file differs from the host byte order.
+ * @param fillValue The value NaN entries of floating point fields are replaced with (ignored if NaN).
+ */
+void encodeFieldEntries(
+        const void* src, FieldDataType dataType, uint8_t* dst, size_t n, bool swapBytes, double fillValue);
+
+/**
+ * Replaces all NaN entries of a floating point field by the default quiet NaN, so that fields with equal values (but
+ * different NaN payloads) have equal bytes, e.g., for hashing. Integer fields are left unchanged.
+ */
+void canonicalizeNaNs(void* data, FieldDataType dataType, size_t n);
+
+/**
+ * Returns whether all n entries are missing, i.e., NaN for floating point fields or equal to the fill value for
+ * integer fields. Integer fields without a fill value (hasFillValue == false) never have missing entries.
+ */
+bool getAreEntriesMissing(const void* data, FieldDataType dataType, size_t n, bool hasFillValue, double fillValue);
+
+/// Range statistics of the conversion of floating point entries to a 16-bit float type.
+struct HalfFloatStats {
+    size_t numEntries = 0;
+    size_t numMissing = 0; ///< NaN entries.
+    size_t numOverflows = 0; ///< Finite entries rounded to infinity.
+    size_t numUnderflows = 0; ///< Non-zero entries rounded to zero.
+    size_t numSubnormals = 0; ///< Entries rounded to subnormal values, i.e., with reduced precision.
+    double minValue = std::numeric_limits<double>::infinity(); ///< Minimum of the finite entries before rounding.
+    double maxValue = -std::numeric_limits<double>::infinity(); ///< Maximum of the finite entries before rounding.
+
+    void add(const HalfFloatStats& other);
+};
+
+/**
+ * Converts floating point entries (with missing values mapped to NaN, i.e., after decoding) to float16 or bfloat16
+ * with round-to-nearest-even. NaN entries become the canonical NaN of the output type (@see getOutputFloatTypeNaN).
+ * float16 conversion uses F16C instructions if supported by the CPU. The result is bit-identical to the scalar path,
+ * so hashes of converted data do not depend on the machine. float64 entries are rounded to float32 first.
+ * @param stats The range statistics of the entries are added to these statistics.
+ */
+void encodeHalfFloats(
+        const void* src, FieldDataType srcType, uint16_t* dst, size_t n, OutputFloatType outputFloatType,
+        HalfFloatStats& stats);
+
+#endif //NCCONV_DECODEKERNELS_HPP
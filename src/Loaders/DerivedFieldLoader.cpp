@@ -0,0 +1,215 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+#include "DecodeKernels.hpp"
+#include "DerivedFieldLoader.hpp"
+
+DerivedFieldLoader::DerivedFieldLoader(VolumeLoader* baseLoader) : baseLoader(baseLoader) {
+}
+
+void DerivedFieldLoader::addDerivedField(
+        const std::string& fieldName, const std::string& expression,
+        const std::vector<std::string>& availableFieldNames) {
+    if (std::find(availableFieldNames.begin(), availableFieldNames.end(), fieldName) != availableFieldNames.end()) {
+        throw std::runtime_error(
+                "Error in DerivedFieldLoader::addDerivedField: A variable named \"" + fieldName + "\" already exists.");
+    }
+    DerivedField derivedField{ fieldName, FieldExpression(expression) };
+    const std::vector<std::string>& inputFieldNames = derivedField.expression.getVariableNames();
+    if (inputFieldNames.empty()) {
+        throw std::runtime_error(
+                "Error in DerivedFieldLoader::addDerivedField: The expression of \"" + fieldName
+                + "\" does not use any variable.");
+    }
+    size_t xs0 = 0, ys0 = 0, zs0 = 0;
+    for (size_t i = 0; i < inputFieldNames.size(); i++) {
+        const std::string& inputFieldName = inputFieldNames.at(i);
+        if (std::find(availableFieldNames.begin(), availableFieldNames.end(), inputFieldName)
+                == availableFieldNames.end()) {
+            throw std::runtime_error(
+                    "Error in DerivedFieldLoader::addDerivedField: Unknown variable \"" + inputFieldName
+                    + "\" in the expression of \"" + fieldName + "\".");
+        }
+        size_t varXs = 0, varYs = 0, varZs = 0;
+        getFieldExtent(inputFieldName, varXs, varYs, varZs);
+        varZs = std::max(varZs, size_t(1));
+        if (i == 0) {
+            xs0 = varXs;
+            ys0 = varYs;
+            zs0 = varZs;
+        } else if (varXs != xs0 || varYs != ys0 || varZs != zs0) {
+            throw std::runtime_error(
+                    "Error in DerivedFieldLoader::addDerivedField: The variables in the expression of \"" + fieldName
+                    + "\" have different extents.");
+        }
+    }
+    derivedFields.push_back(std::move(derivedField));
+}
+
+const DerivedFieldLoader::DerivedField* DerivedFieldLoader::findDerivedField(const std::string& fieldName) const {
+    for (const DerivedField& derivedField : derivedFields) {
+        if (derivedField.name == fieldName) {
+            return &derivedField;
+        }
+    }
+    return nullptr;
+}
+
+bool DerivedFieldLoader::setInputFiles(VolumeData*, const std::string&, const DataSetInformation&) {
+    throw std::runtime_error(
+            "Error in DerivedFieldLoader::setInputFiles: The wrapped loader needs to be used instead.");
+}
+
+FieldDataType DerivedFieldLoader::getFieldDataType(const std::string& fieldName) {
+    if (findDerivedField(fieldName)) {
+        return FieldDataType::FLOAT32;
+    }
+    return baseLoader->getFieldDataType(fieldName);
+}
+
+bool DerivedFieldLoader::getFieldFillValue(const std::string& fieldName, double& fillValue) {
+    if (findDerivedField(fieldName)) {
+        return false;
+    }
+    return baseLoader->getFieldFillValue(fieldName, fillValue);
+}
+
+bool DerivedFieldLoader::getFieldInputFillValue(const std::string& fieldName, double& fillValue) {
+    if (findDerivedField(fieldName)) {
+        return false;
+    }
+    return baseLoader->getFieldInputFillValue(fieldName, fillValue);
+}
+
+bool DerivedFieldLoader::getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) {
+    const DerivedField* derivedField = findDerivedField(fieldName);
+    if (derivedField) {
+        return getFieldExtent(derivedField->expression.getVariableNames().front(), varXs, varYs, varZs);
+    }
+    return baseLoader->getFieldExtent(fieldName, varXs, varYs, varZs);
+}
+
+bool DerivedFieldLoader::getFieldInputChunking(
+        const std::string& fieldName, size_t& chunkT, size_t& chunkZ, size_t& chunkY) {
+    const DerivedField* derivedField = findDerivedField(fieldName);
+    if (derivedField) {
+        return getFieldInputChunking(derivedField->expression.getVariableNames().front(), chunkT, chunkZ, chunkY);
+    }
+    return baseLoader->getFieldInputChunking(fieldName, chunkT, chunkZ, chunkY);
+}
+
+bool DerivedFieldLoader::getFieldFileRange(
+        const std::string& fieldName, size_t timestepIdx, size_t memberIdx, FieldFileRange& range) {
+    // Derived fields are computed on the fly and are not stored in any file.
+    if (findDerivedField(fieldName)) {
+        return false;
+    }
+    return baseLoader->getFieldFileRange(fieldName, timestepIdx, memberIdx, range);
+}
+
+bool DerivedFieldLoader::getFieldEntryNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    if (!findDerivedField(fieldName)) {
+        return baseLoader->getFieldEntryNative(
+                volumeData, fieldName, timestepIdx, memberIdx, fieldEntry, varXs, varYs, varZs);
+    }
+    getFieldExtent(fieldName, varXs, varYs, varZs);
+    FieldSlab slab;
+    slab.zCount = std::max(varZs, size_t(1));
+    slab.yCount = varYs;
+    fieldEntry = new uint8_t[varXs * varYs * slab.zCount * sizeof(float)];
+    if (!getFieldSlabNative(volumeData, fieldName, timestepIdx, memberIdx, slab, fieldEntry)) {
+        delete[] fieldEntry;
+        fieldEntry = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool DerivedFieldLoader::getFieldEntry(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, float*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    if (!findDerivedField(fieldName)) {
+        return baseLoader->getFieldEntry(
+                volumeData, fieldName, timestepIdx, memberIdx, fieldEntry, varXs, varYs, varZs);
+    }
+    uint8_t* data = nullptr;
+    if (!getFieldEntryNative(volumeData, fieldName, timestepIdx, memberIdx, data, varXs, varYs, varZs)) {
+        return false;
+    }
+    fieldEntry = reinterpret_cast<float*>(data);
+    return true;
+}
+
+bool DerivedFieldLoader::getFieldSlabNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) {
+    const DerivedField* derivedField = findDerivedField(fieldName);
+    if (!derivedField) {
+        return baseLoader->getFieldSlabNative(volumeData, fieldName, timestepIdx, memberIdx, slab, slabData);
+    }
+
+    size_t varXs = 0, varYs = 0, varZs = 0;
+    getFieldExtent(fieldName, varXs, varYs, varZs);
+    size_t numEntries = slab.zCount * slab.yCount * varXs;
+    const std::vector<std::string>& inputFieldNames = derivedField->expression.getVariableNames();
+    // The buffers are local, as the input fields may be derived fields themselves.
+    std::vector<std::vector<float>> inputBuffers(inputFieldNames.size());
+    std::vector<const float*> inputs(inputFieldNames.size());
+    std::vector<uint8_t> nativeBuffer;
+    for (size_t i = 0; i < inputFieldNames.size(); i++) {
+        const std::string& inputFieldName = inputFieldNames.at(i);
+        FieldDataType inputDataType = getFieldDataType(inputFieldName);
+        inputBuffers.at(i).resize(numEntries);
+        auto* inputData = reinterpret_cast<uint8_t*>(inputBuffers.at(i).data());
+        if (inputDataType != FieldDataType::FLOAT32) {
+            nativeBuffer.resize(numEntries * getFieldDataTypeSize(inputDataType));
+            inputData = nativeBuffer.data();
+        }
+        if (!getFieldSlabNative(volumeData, inputFieldName, timestepIdx, memberIdx, slab, inputData)) {
+            return false;
+        }
+        if (inputDataType != FieldDataType::FLOAT32) {
+            double fillValue = std::numeric_limits<double>::quiet_NaN();
+            if (!getFieldFillValue(inputFieldName, fillValue)) {
+                fillValue = std::numeric_limits<double>::quiet_NaN();
+            }
+            decodeFieldEntries(
+                    nativeBuffer.data(), inputDataType, inputBuffers.at(i).data(), FieldDataType::FLOAT32,
+                    numEntries, false, fillValue);
+        }
+        inputs.at(i) = inputBuffers.at(i).data();
+    }
+    derivedField->expression.evaluate(inputs.data(), reinterpret_cast<float*>(slabData), numEntries);
+    return true;
+}
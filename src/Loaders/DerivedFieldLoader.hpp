@@ -0,0 +1,95 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CORRERENDER_DERIVEDFIELDLOADER_HPP
+#define CORRERENDER_DERIVEDFIELDLOADER_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Volume/FieldExpression.hpp"
+#include "VolumeLoader.hpp"
+
+/**
+ * Wraps another loader and adds derived fields computed from other fields by an expression, e.g., the wind speed
+ * "ws=sqrt(u^2+v^2)" or unit conversions like "tc=t-273.15". The slabs of a derived field are computed from the
+ * slabs of its input fields at the same position when the slab is requested, so derived fields are written in the
+ * same pass as the other fields without reading back the output file. Derived fields may use other derived fields.
+ * All input fields of an expression need to have the same extent. Derived fields are float32; integer inputs are
+ * converted with their fill value mapped to NaN, which propagates to the result.
+ */
+class DerivedFieldLoader : public VolumeLoader {
+public:
+    /// @param baseLoader The loader of the input data set. It must outlive this loader.
+    explicit DerivedFieldLoader(VolumeLoader* baseLoader);
+    /**
+     * Adds a derived field. Throws an exception if the expression is invalid or uses fields that are not contained in
+     * availableFieldNames, or fields with different extents.
+     */
+    void addDerivedField(
+            const std::string& fieldName, const std::string& expression,
+            const std::vector<std::string>& availableFieldNames);
+
+    /// Not supported; the wrapped loader needs to be initialized already.
+    bool setInputFiles(
+            VolumeData* volumeData, const std::string& filePath, const DataSetInformation& dataSetInformation) override;
+    bool getFieldEntry(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, float*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    FieldDataType getFieldDataType(const std::string& fieldName) override;
+    bool getFieldFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldInputFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldEntryNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldSlabNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) override;
+    bool getFieldInputChunking(
+            const std::string& fieldName, size_t& chunkT, size_t& chunkZ, size_t& chunkY) override;
+    bool getSupportsAsyncReads() override { return baseLoader->getSupportsAsyncReads(); }
+    bool getFieldFileRange(
+            const std::string& fieldName, size_t timestepIdx, size_t memberIdx, FieldFileRange& range) override;
+    bool getRequiresSequentialReads() override { return baseLoader->getRequiresSequentialReads(); }
+    bool getHasDerivedFields() override { return !derivedFields.empty() || baseLoader->getHasDerivedFields(); }
+
+private:
+    struct DerivedField {
+        std::string name;
+        FieldExpression expression;
+    };
+    const DerivedField* findDerivedField(const std::string& fieldName) const;
+
+    VolumeLoader* baseLoader;
+    std::vector<DerivedField> derivedFields;
+};
+
+#endif //CORRERENDER_DERIVEDFIELDLOADER_HPP
@@ -0,0 +1,127 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+#include "ForwardStreamReader.hpp"
+
+ForwardStreamReader::ForwardStreamReader(FILE* file, std::string streamName, size_t blockSize)
+        : file(file), streamName(std::move(streamName)), blockSize(blockSize) {
+    for (Block& block : blocks) {
+        block.data.resize(blockSize);
+    }
+}
+
+ForwardStreamReader::~ForwardStreamReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopped = true;
+    }
+    blockCondition.notify_all();
+    if (readThread.joinable()) {
+        readThread.join();
+    }
+}
+
+void ForwardStreamReader::readBlocks() {
+    for (size_t blockIdx = 0; ; blockIdx ^= 1) {
+        Block& block = blocks[blockIdx];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            blockCondition.wait(lock, [&]() { return !block.isFilled || isStopped; });
+            if (isStopped) {
+                return;
+            }
+        }
+        // fread only returns less than the block size at the end of the stream or on errors, also for pipes.
+        size_t numBytesRead = fread(block.data.data(), 1, blockSize, file);
+        bool isEndOfStream = numBytesRead < blockSize;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            block.size = numBytesRead;
+            block.isFilled = true;
+            hasReadError = isEndOfStream && ferror(file);
+        }
+        blockCondition.notify_all();
+        if (isEndOfStream) {
+            return;
+        }
+    }
+}
+
+void ForwardStreamReader::read(uint64_t offset, uint8_t* destBuffer, size_t size) {
+    // The stream is only read once data is requested, so opening a data set does not consume it.
+    if (!readThread.joinable()) {
+        readThread = std::thread(&ForwardStreamReader::readBlocks, this);
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    if (offset < position) {
+        throw std::runtime_error(
+                "Error in ForwardStreamReader::read: The input data is read from the stream \"" + streamName
+                + "\", which can only be read front to back (offset " + std::to_string(offset)
+                + " was requested after reading up to offset " + std::to_string(position) + "). The output needs "
+                "random access to the input in this configuration; store the data in a file first.");
+    }
+    consume(nullptr, size_t(offset - position), lock);
+    consume(destBuffer, size, lock);
+}
+
+void ForwardStreamReader::consume(uint8_t* destBuffer, size_t size, std::unique_lock<std::mutex>& lock) {
+    while (size > 0) {
+        Block& block = blocks[consumeBlockIdx];
+        blockCondition.wait(lock, [&]() { return block.isFilled; });
+        if (consumeOffset == block.size) {
+            if (hasReadError) {
+                throw std::runtime_error(
+                        "Error in ForwardStreamReader::consume: Reading from the stream \"" + streamName
+                        + "\" failed.");
+            }
+            throw std::runtime_error(
+                    "Error in ForwardStreamReader::consume: The stream \"" + streamName + "\" ended after "
+                    + std::to_string(position) + " bytes, before all data was read.");
+        }
+        size_t numBytes = std::min(size, block.size - consumeOffset);
+        if (destBuffer) {
+            memcpy(destBuffer, block.data.data() + consumeOffset, numBytes);
+            destBuffer += numBytes;
+        }
+        consumeOffset += numBytes;
+        position += numBytes;
+        size -= numBytes;
+        // Full blocks are handed back to the read thread once consumed. The last block of the stream is kept.
+        if (consumeOffset == blockSize) {
+            block.isFilled = false;
+            consumeOffset = 0;
+            consumeBlockIdx ^= 1;
+            blockCondition.notify_all();
+        }
+    }
+}
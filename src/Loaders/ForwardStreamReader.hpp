@@ -0,0 +1,87 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CORRERENDER_FORWARDSTREAMREADER_HPP
+#define CORRERENDER_FORWARDSTREAMREADER_HPP
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Reads a non-seekable stream (e.g., stdin or a named pipe) front to back with double buffering: once data is
+ * requested, a background thread reads the next block of the stream while the previous one is consumed by
+ * @see read. Data in front of the requested range is skipped, but data that was already passed cannot be read again.
+ * Requesting such a range throws an exception, as the order in which the data is requested needs random access.
+ * Only one thread may call @see read at a time.
+ */
+class ForwardStreamReader {
+public:
+    /**
+     * @param file The stream to read from. It is not closed by the reader and must outlive it.
+     * @param streamName The name of the stream used in error messages.
+     * @param blockSize The size of each of the two blocks in bytes.
+     */
+    ForwardStreamReader(FILE* file, std::string streamName, size_t blockSize = size_t(8) << 20);
+    /// Waits for the read of the current block to finish. This blocks until the writer of the stream provides data.
+    ~ForwardStreamReader();
+    ForwardStreamReader(const ForwardStreamReader&) = delete;
+    ForwardStreamReader& operator=(const ForwardStreamReader&) = delete;
+
+    /// Reads the passed range of the stream. The offset must not lie before the end of the previously read range.
+    void read(uint64_t offset, uint8_t* destBuffer, size_t size);
+
+private:
+    struct Block {
+        std::vector<uint8_t> data;
+        size_t size = 0; ///< Number of bytes read; smaller than the block size only for the last block of the stream.
+        bool isFilled = false;
+    };
+    void readBlocks();
+    /// Consumes size bytes from the blocks. If destBuffer is nullptr, the bytes are skipped.
+    void consume(uint8_t* destBuffer, size_t size, std::unique_lock<std::mutex>& lock);
+
+    FILE* file;
+    std::string streamName;
+    size_t blockSize;
+    Block blocks[2];
+    size_t consumeBlockIdx = 0;
+    size_t consumeOffset = 0; ///< Offset within the block being consumed.
+    uint64_t position = 0; ///< Offset of the next byte to be consumed within the stream.
+    bool hasReadError = false;
+    bool isStopped = false;
+    std::mutex mutex;
+    std::condition_variable blockCondition;
+    std::thread readThread;
+};
+
+#endif //CORRERENDER_FORWARDSTREAMREADER_HPP
@@ -26,13 +26,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <limits>
 #include <stdexcept>
 
-#ifdef USE_TBB
-#include <tbb/parallel_for.h>
-#include <tbb/blocked_range.h>
-#endif
-
+#include "Utils/TaskScheduler.hpp"
 #include "LoadersUtil.hpp"
 
 void swapEndianness(uint8_t* byteArray, size_t sizeInBytes, size_t bytesPerEntry) {
@@ -46,23 +43,25 @@ void swapEndianness(uint8_t* byteArray, size_t sizeInBytes, size_t bytesPerEntry
         throw std::runtime_error("Error in swapEndianness: sizeInBytes is larger than 8.");
         return;
     }
-#ifdef USE_TBB
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, sizeInBytes, bytesPerEntry), [&byteArray, bytesPerEntry](auto const& r) {
+    const size_t grainSize = size_t(1) << 18;
+    sgl::parallelFor(0, sizeInBytes / bytesPerEntry, grainSize, [&](size_t entryBegin, size_t entryEnd) {
         uint8_t swappedEntry[8];
-        for (auto i = r.begin(); i != r.end(); i += r.grainsize()) {
-#else
-    uint8_t swappedEntry[8];
-    #pragma omp parallel for shared(byteArray, sizeInBytes, bytesPerEntry) private(swappedEntry) default(none)
-    for (size_t i = 0; i < sizeInBytes; i += bytesPerEntry) {
-#endif
-        for (size_t j = 0; j < bytesPerEntry; j++) {
-            swappedEntry[j] = byteArray[i + bytesPerEntry - j - 1];
-        }
-        for (size_t j = 0; j < bytesPerEntry; j++) {
-            byteArray[i + j] = swappedEntry[j];
+        for (size_t i = entryBegin * bytesPerEntry; i < entryEnd * bytesPerEntry; i += bytesPerEntry) {
+            for (size_t j = 0; j < bytesPerEntry; j++) {
+                swappedEntry[j] = byteArray[i + bytesPerEntry - j - 1];
+            }
+            for (size_t j = 0; j < bytesPerEntry; j++) {
+                byteArray[i + j] = swappedEntry[j];
+            }
         }
-    }
-#ifdef USE_TBB
     });
-#endif
+}
+
+ptrdiff_t checkDimensionLength(int64_t length, const char* functionName, const std::string& dimensionName) {
+    if (length < 0 || length > int64_t(std::numeric_limits<ptrdiff_t>::max())) {
+        throw std::runtime_error(
+                std::string() + "Error in " + functionName + ": The length " + std::to_string(length)
+                + " of the dimension \"" + dimensionName + "\" is out of range.");
+    }
+    return ptrdiff_t(length);
 }
@@ -30,6 +30,8 @@
 #define CORRERENDER_LOADERSUTIL_HPP
 
 #include <cstdint>
+#include <cstddef>
+#include <string>
 
 /**
  * Swaps the endianness of the passed array.
@@ -46,25 +48,18 @@ void swapEndianness(uint8_t* byteArray, size_t sizeInBytes, size_t bytesPerEntry
  * @param n The number of entries of byte size sizeof(T) in the array.
  */
 template <typename T>
-void swapEndianness(T* values, int n) {
-    swapEndianness((uint8_t*)values, size_t(n) * sizeof(T), sizeof(T));
-    /*auto* byteArray = (uint8_t*)values;
-#ifdef USE_TBB
-    tbb::parallel_for(tbb::blocked_range<int>(0, n), [&values, &byteArray](auto const& r) {
-        for (auto i = r.begin(); i != r.end(); i++) {
-#else
-    #pragma omp parallel for shared(byteArray, values, n) default(none)
-    for (int i = 0; i < n; i++) {
-#endif
-        uint8_t swappedEntry[sizeof(T)];
-        for (size_t j = 0; j < sizeof(T); j++) {
-            swappedEntry[j] = byteArray[i * sizeof(T) + sizeof(T) - j - 1];
-        }
-        values[i] = *((T*)&swappedEntry);
-    }
-#ifdef USE_TBB
-    });
-#endif*/
+void swapEndianness(T* values, size_t n) {
+    swapEndianness((uint8_t*)values, n * sizeof(T), sizeof(T));
 }
 
+/**
+ * Checks that a dimension length parsed from a text descriptor is not negative. Lengths are parsed as 64-bit integers,
+ * as parsing them as int would silently saturate lengths of 2^31 and more.
+ * @param length The length of the dimension as read from the file.
+ * @param functionName The name of the calling function used in the error message.
+ * @param dimensionName The name of the dimension used in the error message.
+ * @return The length as a signed size, which the offset computations of the loaders use.
+ */
+ptrdiff_t checkDimensionLength(int64_t length, const char* functionName, const std::string& dimensionName);
+
 #endif //CORRERENDER_LOADERSUTIL_HPP
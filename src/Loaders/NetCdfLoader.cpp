@@ -0,0 +1,450 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <netcdf.h>
+
+#include "Volume/VolumeData.hpp"
+#include "DecodeKernels.hpp"
+#include "NetCdfLoader.hpp"
+
+static bool getFieldDataTypeFromNcType(nc_type type, FieldDataType& dataType) {
+    switch (type) {
+        case NC_BYTE:
+            dataType = FieldDataType::INT8;
+            return true;
+        case NC_UBYTE:
+            dataType = FieldDataType::UINT8;
+            return true;
+        case NC_SHORT:
+            dataType = FieldDataType::INT16;
+            return true;
+        case NC_USHORT:
+            dataType = FieldDataType::UINT16;
+            return true;
+        case NC_INT:
+            dataType = FieldDataType::INT32;
+            return true;
+        case NC_FLOAT:
+            dataType = FieldDataType::FLOAT32;
+            return true;
+        case NC_DOUBLE:
+            dataType = FieldDataType::FLOAT64;
+            return true;
+        default:
+            return false;
+    }
+}
+
+enum class DimensionRole {
+    MEMBER, TIME, LEVEL
+};
+
+static DimensionRole classifyDimension(int ncid, int dimid, int unlimitedDimId) {
+    char dimNameRaw[NC_MAX_NAME + 1];
+    nc_inq_dimname(ncid, dimid, dimNameRaw);
+    std::string dimName = dimNameRaw;
+    boost::to_lower(dimName);
+    if (dimid == unlimitedDimId || dimName == "time" || dimName == "t" || dimName == "times"
+            || dimName == "valid_time") {
+        return DimensionRole::TIME;
+    }
+    if (dimName == "member" || dimName == "members" || dimName == "ens" || dimName == "ensemble"
+            || dimName == "realization" || dimName == "number") {
+        return DimensionRole::MEMBER;
+    }
+    return DimensionRole::LEVEL;
+}
+
+NetCdfLoader::NetCdfLoader() = default;
+
+NetCdfLoader::~NetCdfLoader() {
+    if (ncid >= 0) {
+        nc_close(ncid);
+        ncid = -1;
+    }
+}
+
+bool NetCdfLoader::setInputFiles(
+        VolumeData* volumeData, const std::string& _filePath, const DataSetInformation& _dataSetInformation) {
+    filePath = _filePath;
+    dataSetInformation = _dataSetInformation;
+
+    int status = nc_open(filePath.c_str(), NC_NOWRITE, &ncid);
+    if (status != NC_NOERR) {
+        ncid = -1;
+        throw std::runtime_error(
+                "Error in NetCdfLoader::load: Couldn't open file \"" + filePath + "\": " + nc_strerror(status));
+    }
+
+    int numVars = 0;
+    int unlimitedDimId = -1;
+    nc_inq_nvars(ncid, &numVars);
+    nc_inq_unlimdim(ncid, &unlimitedDimId);
+
+    int xDimId = -1, yDimId = -1, zDimId = -1, tDimId = -1, eDimId = -1;
+    std::vector<std::string> fieldNames;
+    for (int varid = 0; varid < numVars; varid++) {
+        char varNameRaw[NC_MAX_NAME + 1];
+        nc_type varType{};
+        int numDims = 0;
+        int dimids[NC_MAX_VAR_DIMS];
+        nc_inq_var(ncid, varid, varNameRaw, &varType, &numDims, dimids, nullptr);
+        std::string varName = varNameRaw;
+        if (numDims < 2) {
+            // Coordinate variables and scalars are not fields.
+            continue;
+        }
+
+        NetCdfVarDesc varDesc;
+        varDesc.name = varName;
+        varDesc.varid = varid;
+        varDesc.numDims = numDims;
+        if (!getFieldDataTypeFromNcType(varType, varDesc.fileDataType)) {
+            std::cerr << "Warning in NetCdfLoader::load: Skipping variable \"" << varName
+                      << "\" with unsupported data type." << std::endl;
+            continue;
+        }
+        if (varName == "x" || varName == "y" || varName == "z" || varName == "lon" || varName == "lat") {
+            std::cerr << "Warning in NetCdfLoader::load: Skipping variable \"" << varName
+                      << "\", as its name clashes with the coordinate variables of the output file." << std::endl;
+            continue;
+        }
+        if (xDimId < 0) {
+            xDimId = dimids[numDims - 1];
+            yDimId = dimids[numDims - 2];
+        } else if (dimids[numDims - 1] != xDimId || dimids[numDims - 2] != yDimId) {
+            std::cerr << "Warning in NetCdfLoader::load: Skipping variable \"" << varName
+                      << "\" defined on a different horizontal grid." << std::endl;
+            continue;
+        }
+
+        // Classify the leading dimensions. Each variable may have at most one dimension per role.
+        bool isValid = true;
+        for (int dimIdx = 0; dimIdx < numDims - 2 && isValid; dimIdx++) {
+            int dimid = dimids[dimIdx];
+            DimensionRole role = classifyDimension(ncid, dimid, unlimitedDimId);
+            int& globalDimId = role == DimensionRole::TIME ? tDimId : role == DimensionRole::MEMBER ? eDimId : zDimId;
+            int& varDimIdx =
+                    role == DimensionRole::TIME ? varDesc.timeDimIdx
+                    : role == DimensionRole::MEMBER ? varDesc.memberDimIdx : varDesc.zDimIdx;
+            if (globalDimId < 0) {
+                globalDimId = dimid;
+            }
+            if (globalDimId != dimid || varDimIdx >= 0) {
+                isValid = false;
+            }
+            varDimIdx = dimIdx;
+        }
+        if (!isValid) {
+            std::cerr << "Warning in NetCdfLoader::load: Skipping variable \"" << varName
+                      << "\" with unsupported dimensions." << std::endl;
+            continue;
+        }
+        if (varDesc.zDimIdx >= 0) {
+            size_t numLevels = 0;
+            nc_inq_dimlen(ncid, zDimId, &numLevels);
+            varDesc.numLevels = numLevels;
+        }
+
+        varDesc.dataType = varDesc.fileDataType;
+        double fillValue = 0.0;
+        if (nc_get_att_double(ncid, varid, "_FillValue", &fillValue) == NC_NOERR
+                || nc_get_att_double(ncid, varid, "missing_value", &fillValue) == NC_NOERR) {
+            varDesc.hasFillValue = true;
+            varDesc.fillValue = fillValue;
+        }
+        // The writer does not copy attributes, so packed data is unpacked to keep its meaning.
+        bool hasScaleFactor = nc_get_att_double(ncid, varid, "scale_factor", &varDesc.scaleFactor) == NC_NOERR;
+        bool hasAddOffset = nc_get_att_double(ncid, varid, "add_offset", &varDesc.addOffset) == NC_NOERR;
+        if (hasScaleFactor || hasAddOffset) {
+            varDesc.isPacked = true;
+            varDesc.dataType = FieldDataType::FLOAT32;
+        }
+
+        int storage = NC_CONTIGUOUS;
+        varDesc.chunkSizes.resize(numDims);
+        if (nc_inq_var_chunking(ncid, varid, &storage, varDesc.chunkSizes.data()) != NC_NOERR
+                || storage != NC_CHUNKED) {
+            varDesc.chunkSizes.clear();
+        }
+
+        variableNameMap.insert(std::make_pair(varName, int(variableDescriptors.size())));
+        variableDescriptors.push_back(varDesc);
+        fieldNames.push_back(varName);
+    }
+
+    if (variableDescriptors.empty()) {
+        throw std::runtime_error(
+                "Error in NetCdfLoader::load: File \"" + filePath + "\" contains no variables with the dimensions "
+                "([member], [time], [z], y, x).");
+    }
+
+    auto getDimensionLength = [this](int dimid) {
+        size_t dimLen = 0;
+        nc_inq_dimlen(ncid, dimid, &dimLen);
+        return dimLen;
+    };
+    xs = getDimensionLength(xDimId);
+    ys = getDimensionLength(yDimId);
+    if (zDimId >= 0) {
+        zs = getDimensionLength(zDimId);
+    }
+    if (tDimId >= 0) {
+        ts = getDimensionLength(tDimId);
+    }
+    if (eDimId >= 0) {
+        es = getDimensionLength(eDimId);
+    }
+
+    float* lon1d = loadCoordinateArray(xDimId, xs);
+    float* lat1d = loadCoordinateArray(yDimId, ys);
+    float* lev1d = loadCoordinateArray(zDimId, zs);
+
+    if (ts > 1) {
+        volumeData->setNumTimeSteps(ts);
+    }
+    if (es > 1) {
+        volumeData->setEnsembleMemberCount(es);
+    }
+    volumeData->setGridExtent(xs, ys, zs, lon1d, lat1d, lev1d);
+    volumeData->setFieldNames(fieldNames);
+
+    return true;
+}
+
+float* NetCdfLoader::loadCoordinateArray(int dimid, size_t dimLen) {
+    auto* coords = new float[dimLen];
+    int varid = -1, numDims = 0;
+    char dimName[NC_MAX_NAME + 1];
+    if (dimid >= 0 && nc_inq_dimname(ncid, dimid, dimName) == NC_NOERR
+            && nc_inq_varid(ncid, dimName, &varid) == NC_NOERR
+            && nc_inq_varndims(ncid, varid, &numDims) == NC_NOERR && numDims == 1
+            && nc_get_var_float(ncid, varid, coords) == NC_NOERR) {
+        return coords;
+    }
+    // No coordinate variable; fall back to the indices.
+    for (size_t i = 0; i < dimLen; i++) {
+        coords[i] = float(i);
+    }
+    return coords;
+}
+
+NetCdfVarDesc& NetCdfLoader::getVariableDescriptor(const std::string& fieldName) {
+    auto it = variableNameMap.find(fieldName);
+    if (it == variableNameMap.end()) {
+        throw std::runtime_error(
+                "Error in NetCdfLoader::getFieldEntry: Unknown field name \"" + fieldName + "\".");
+    }
+    return variableDescriptors.at(it->second);
+}
+
+bool NetCdfLoader::getHasFloat32Data() {
+    for (const NetCdfVarDesc& varDesc : variableDescriptors) {
+        if (varDesc.dataType != FieldDataType::FLOAT32) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FieldDataType NetCdfLoader::getFieldDataType(const std::string& fieldName) {
+    return getVariableDescriptor(fieldName).dataType;
+}
+
+bool NetCdfLoader::getFieldFillValue(const std::string& fieldName, double& fillValue) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    if (getIsFieldDataTypeFloat(varDesc.dataType) || !varDesc.hasFillValue) {
+        return false;
+    }
+    fillValue = varDesc.fillValue;
+    return true;
+}
+
+bool NetCdfLoader::getFieldInputFillValue(const std::string& fieldName, double& fillValue) {
+    // The fill value of packed variables is a packed value, which has no meaning after unpacking.
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    if (!varDesc.hasFillValue || varDesc.isPacked) {
+        return false;
+    }
+    fillValue = varDesc.fillValue;
+    return true;
+}
+
+bool NetCdfLoader::getFieldInputChunking(
+        const std::string& fieldName, size_t& chunkT, size_t& chunkZ, size_t& chunkY) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    if (varDesc.chunkSizes.empty()) {
+        return false;
+    }
+    chunkT = varDesc.timeDimIdx >= 0 ? varDesc.chunkSizes.at(varDesc.timeDimIdx) : 1;
+    chunkZ = varDesc.zDimIdx >= 0 ? varDesc.chunkSizes.at(varDesc.zDimIdx) : 1;
+    chunkY = varDesc.chunkSizes.at(varDesc.numDims - 2);
+    return true;
+}
+
+void NetCdfLoader::readSlab(
+        NetCdfVarDesc& varDesc, size_t timestepIdx, size_t memberIdx, const FieldSlab& slab,
+        void* dst, FieldDataType dstType) {
+    if (slab.zCount < 1 || slab.zOffset + slab.zCount > varDesc.numLevels
+            || slab.yCount < 1 || slab.yOffset + slab.yCount > ys) {
+        throw std::runtime_error(
+                "Error in NetCdfLoader::readSlab: Invalid slab for variable \"" + varDesc.name + "\".");
+    }
+
+    std::vector<size_t> start(varDesc.numDims, 0);
+    std::vector<size_t> count(varDesc.numDims, 1);
+    if (varDesc.memberDimIdx >= 0) {
+        start.at(varDesc.memberDimIdx) = size_t(memberIdx);
+    }
+    if (varDesc.timeDimIdx >= 0) {
+        start.at(varDesc.timeDimIdx) = size_t(timestepIdx);
+    }
+    if (varDesc.zDimIdx >= 0) {
+        start.at(varDesc.zDimIdx) = slab.zOffset;
+        count.at(varDesc.zDimIdx) = slab.zCount;
+    }
+    start.at(varDesc.numDims - 2) = slab.yOffset;
+    count.at(varDesc.numDims - 2) = slab.yCount;
+    count.at(varDesc.numDims - 1) = xs;
+
+    // Grow the chunk cache until it holds all input chunks intersecting the slab. Otherwise, chunks shared by
+    // multiple rows or time steps would be decompressed again for each nc_get_vara call.
+    auto fileEntrySize = getFieldDataTypeSize(varDesc.fileDataType);
+    if (!varDesc.chunkSizes.empty()) {
+        size_t cacheSize = fileEntrySize;
+        size_t numChunks = 1;
+        for (int dimIdx = 0; dimIdx < varDesc.numDims; dimIdx++) {
+            size_t chunkSize = varDesc.chunkSizes.at(dimIdx);
+            size_t numDimChunks =
+                    (start.at(dimIdx) + count.at(dimIdx) - 1) / chunkSize - start.at(dimIdx) / chunkSize + 1;
+            numChunks *= numDimChunks;
+            cacheSize *= numDimChunks * chunkSize;
+        }
+        if (cacheSize > varDesc.chunkCacheSize) {
+            nc_set_var_chunk_cache(ncid, varDesc.varid, cacheSize, numChunks * 10 + 1, 0.75f);
+            varDesc.chunkCacheSize = cacheSize;
+        }
+    }
+
+    size_t numEntries = slab.zCount * slab.yCount * xs;
+    double fillValue = varDesc.hasFillValue ? varDesc.fillValue : std::numeric_limits<double>::quiet_NaN();
+    int status;
+    if (dstType == varDesc.fileDataType && !varDesc.isPacked) {
+        // Only floating point fill values need to be mapped to NaN, which can be done in-place.
+        status = nc_get_vara(ncid, varDesc.varid, start.data(), count.data(), dst);
+        if (status == NC_NOERR && getIsFieldDataTypeFloat(dstType) && varDesc.hasFillValue) {
+            auto* data = static_cast<uint8_t*>(dst);
+            decodeFieldEntries(data, dstType, data, dstType, numEntries, false, fillValue);
+        }
+    } else {
+        std::vector<uint8_t> fileData(numEntries * fileEntrySize);
+        status = nc_get_vara(ncid, varDesc.varid, start.data(), count.data(), fileData.data());
+        if (status == NC_NOERR) {
+            decodeFieldEntries(
+                    fileData.data(), varDesc.fileDataType, dst, dstType, numEntries, false, fillValue);
+        }
+        if (status == NC_NOERR && varDesc.isPacked) {
+            auto* data = static_cast<float*>(dst);
+            auto scaleFactor = float(varDesc.scaleFactor);
+            auto addOffset = float(varDesc.addOffset);
+            for (size_t i = 0; i < numEntries; i++) {
+                data[i] = data[i] * scaleFactor + addOffset;
+            }
+        }
+    }
+    if (status != NC_NOERR) {
+        throw std::runtime_error(
+                "Error in NetCdfLoader::readSlab: Reading variable \"" + varDesc.name + "\" from file \""
+                + filePath + "\" failed: " + nc_strerror(status));
+    }
+}
+
+bool NetCdfLoader::getFieldEntry(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, float*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    auto& varDesc = getVariableDescriptor(fieldName);
+    FieldSlab slab;
+    slab.zCount = varDesc.numLevels;
+    slab.yCount = ys;
+    auto* data = new float[xs * ys * varDesc.numLevels];
+    try {
+        readSlab(varDesc, timestepIdx, memberIdx, slab, data, FieldDataType::FLOAT32);
+    } catch (...) {
+        delete[] data;
+        throw;
+    }
+    fieldEntry = data;
+    varXs = xs;
+    varYs = ys;
+    varZs = varDesc.numLevels;
+    return true;
+}
+
+bool NetCdfLoader::getFieldEntryNative(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    auto& varDesc = getVariableDescriptor(fieldName);
+    FieldSlab slab;
+    slab.zCount = varDesc.numLevels;
+    slab.yCount = ys;
+    size_t numEntries = xs * ys * varDesc.numLevels;
+    auto* data = new uint8_t[numEntries * getFieldDataTypeSize(varDesc.dataType)];
+    try {
+        readSlab(varDesc, timestepIdx, memberIdx, slab, data, varDesc.dataType);
+    } catch (...) {
+        delete[] data;
+        throw;
+    }
+    fieldEntry = data;
+    varXs = xs;
+    varYs = ys;
+    varZs = varDesc.numLevels;
+    return true;
+}
+
+bool NetCdfLoader::getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) {
+    const auto& varDesc = getVariableDescriptor(fieldName);
+    varXs = xs;
+    varYs = ys;
+    varZs = varDesc.numLevels;
+    return true;
+}
+
+bool NetCdfLoader::getFieldSlabNative(
+        VolumeData* /*volumeData*/, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) {
+    auto& varDesc = getVariableDescriptor(fieldName);
+    readSlab(varDesc, timestepIdx, memberIdx, slab, slabData, varDesc.dataType);
+    return true;
+}
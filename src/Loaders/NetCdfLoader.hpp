@@ -0,0 +1,102 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CORRERENDER_NETCDFLOADER_HPP
+#define CORRERENDER_NETCDFLOADER_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "VolumeLoader.hpp"
+
+struct NetCdfVarDesc {
+    std::string name;
+    int varid = -1;
+    int numDims = 0;
+    int memberDimIdx = -1, timeDimIdx = -1, zDimIdx = -1; //< Positions of the dimensions (x and y are always last).
+    size_t numLevels = 1;
+    FieldDataType fileDataType = FieldDataType::FLOAT32; //< Data type of the variable in the file.
+    FieldDataType dataType = FieldDataType::FLOAT32; //< Data type returned by the loader.
+    bool hasFillValue = false;
+    double fillValue = 0.0;
+    bool isPacked = false; //< Whether the variable uses scale_factor/add_offset (unpacked to float32).
+    double scaleFactor = 1.0, addOffset = 0.0;
+    std::vector<size_t> chunkSizes; //< Empty for contiguous variables.
+    size_t chunkCacheSize = 0; //< Currently set size of the chunk cache of the variable.
+};
+
+/**
+ * Loader for NetCDF files, e.g., for rechunking or recompressing badly chunked data sets.
+ * Variables with the dimension order ([member], [time], [z], y, x) sharing the same horizontal grid are loaded.
+ * Slabs are read with one nc_get_vara call each. For chunked input files, the chunk cache of each variable is sized
+ * to hold all chunks intersecting a slab, and the chunk shape is reported to the writer via
+ * @see getFieldInputChunking, so that every input chunk is only decompressed once.
+ */
+class NetCdfLoader : public VolumeLoader {
+public:
+    static std::vector<std::string> getSupportedExtensions() { return { "nc", "nc4", "netcdf" }; }
+    NetCdfLoader();
+    ~NetCdfLoader() override;
+    bool setInputFiles(
+            VolumeData* volumeData, const std::string& filePath, const DataSetInformation& dataSetInformation) override;
+    bool getFieldEntry(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, float*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getHasFloat32Data() override;
+    FieldDataType getFieldDataType(const std::string& fieldName) override;
+    bool getFieldFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldInputFillValue(const std::string& fieldName, double& fillValue) override;
+    bool getFieldEntryNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry,
+            size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) override;
+    bool getFieldSlabNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) override;
+    bool getFieldInputChunking(
+            const std::string& fieldName, size_t& chunkT, size_t& chunkZ, size_t& chunkY) override;
+
+private:
+    DataSetInformation dataSetInformation;
+    std::string filePath;
+    int ncid = -1;
+    size_t xs = 0, ys = 0, zs = 1, ts = 1, es = 1;
+    std::unordered_map<std::string, int> variableNameMap;
+    std::vector<NetCdfVarDesc> variableDescriptors;
+
+    NetCdfVarDesc& getVariableDescriptor(const std::string& fieldName);
+    float* loadCoordinateArray(int dimid, size_t dimLen);
+    /// Reads a slab of the variable and decodes it to dstType (dst may point to a buffer of the file data type).
+    void readSlab(
+            NetCdfVarDesc& varDesc, size_t timestepIdx, size_t memberIdx, const FieldSlab& slab,
+            void* dst, FieldDataType dstType);
+};
+
+#endif //CORRERENDER_NETCDFLOADER_HPP
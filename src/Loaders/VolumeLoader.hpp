@@ -31,14 +31,42 @@
 
 #include <vector>
 #include <string>
-//#include "Volume/FieldType.hpp"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Volume/FieldType.hpp"
 //#include "DataSetList.hpp"
 
 class HostCacheEntryType;
 class VolumeData;
 
 struct DataSetInformation {
-    // TODO
+    /// Overrides the path of the data file given in the descriptor of GrADS data sets. "-" reads the data from stdin.
+    std::string dataFilePath;
+};
+
+/**
+ * A sub-region of a field. A slab either consists of whole z-levels, or of a band of rows within a single z-level.
+ * This way, each slab corresponds to one contiguous range of the field in (z, y, x) row-major order.
+ */
+struct FieldSlab {
+    size_t zOffset = 0, zCount = 1;
+    size_t yOffset = 0, yCount = 1;
+};
+
+/**
+ * The range of a file the entries of a field (for one time step and ensemble member) are stored in without any
+ * encoding, in (z, y, x) row-major order. This allows referencing the data instead of copying it.
+ */
+struct FieldFileRange {
+    std::string filePath;
+    uint64_t offset = 0;
+    uint64_t size = 0; ///< Size in bytes.
+    bool isBigEndian = false;
+    /// Whether entries equal to fillValue are missing (also for floating point fields). Only set if the data type
+    /// of the field can store fillValue.
+    bool hasFillValue = false;
+    double fillValue = 0.0;
 };
 
 class VolumeLoader {
@@ -48,8 +76,113 @@ public:
             VolumeData* volumeData, const std::string& filePath, const DataSetInformation& dataSetInformation) = 0;
     virtual bool getFieldEntry(
             VolumeData* volumeData, const std::string& fieldName,
-            int timestepIdx, int memberIdx, float*& fieldEntry, int& varXs, int& varYs, int& varZs) = 0;
+            size_t timestepIdx, size_t memberIdx, float*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) = 0;
     virtual bool getHasFloat32Data() { return true; }
+
+    /// Returns the data type the entries of the field are returned in by @see getFieldEntryNative.
+    virtual FieldDataType getFieldDataType(const std::string& /*fieldName*/) { return FieldDataType::FLOAT32; }
+    /// Returns the fill value used by fields with integer data type (floating point fields use NaN instead).
+    virtual bool getFieldFillValue(const std::string& /*fieldName*/, double& /*fillValue*/) { return false; }
+    /**
+     * Returns the value missing entries of the field have in the input file. Unlike @see getFieldFillValue, this
+     * includes floating point fields, e.g., for writing the same undef value when exporting the data set again.
+     */
+    virtual bool getFieldInputFillValue(const std::string& fieldName, double& fillValue) {
+        return getFieldFillValue(fieldName, fillValue);
+    }
+    /**
+     * Same as @see getFieldEntry, but the data is returned in the data type given by @see getFieldDataType.
+     * This way, no bandwidth is wasted on inflating integer data to float. The returned array needs to be freed
+     * using "delete[]". The default implementation falls back to @see getFieldEntry.
+     */
+    virtual bool getFieldEntryNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs);
+
+    /**
+     * Returns the extent of the field without loading its data.
+     * The default implementation loads the first time step of the field using @see getFieldEntryNative.
+     */
+    virtual bool getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs);
+    /**
+     * Loads a slab of the field in the data type given by @see getFieldDataType into the passed buffer.
+     * This allows streaming fields larger than the available memory. The buffer needs to be large enough to store
+     * varXs * slab.yCount * slab.zCount entries. The default implementation copies the slab out of the data returned
+     * by @see getFieldEntryNative.
+     */
+    virtual bool getFieldSlabNative(
+            VolumeData* volumeData, const std::string& fieldName,
+            size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData);
+    /**
+     * Returns the chunk shape of the field in the input file along the time, z and y axes, or false if the input is
+     * not chunked. If slabs are aligned with this shape, and all time steps of a slab are read before the next slab,
+     * each compressed input chunk only needs to be decompressed once.
+     */
+    virtual bool getFieldInputChunking(
+            const std::string& /*fieldName*/, size_t& /*chunkT*/, size_t& /*chunkZ*/, size_t& /*chunkY*/) {
+        return false;
+    }
+    /**
+     * Whether @see getFieldSlabNative may be called on another thread while the calling thread uses the NetCDF
+     * library, which is not thread-safe. This allows reading the next slab while the current one is written.
+     * Only one slab is read at a time.
+     */
+    virtual bool getSupportsAsyncReads() { return false; }
+    /**
+     * Returns the range of the input file storing the field in the data type given by @see getFieldDataType, or
+     * false if the data needs to be decoded or computed (e.g., compressed, derived or coarsened fields).
+     */
+    virtual bool getFieldFileRange(
+            const std::string& /*fieldName*/, size_t /*timestepIdx*/, size_t /*memberIdx*/, FieldFileRange& /*range*/) {
+        return false;
+    }
+    /**
+     * Whether the input is a non-seekable stream (e.g., a pipe), whose data can only be read once in the order it is
+     * stored in. Reading data in front of data that was already read throws an exception. The writers then read the
+     * fields record by record (members > time steps > fields).
+     */
+    virtual bool getRequiresSequentialReads() { return false; }
+    /// Whether some fields are computed from other fields, whose slabs are then read again (@see DerivedFieldLoader).
+    virtual bool getHasDerivedFields() { return false; }
 };
 
+inline bool VolumeLoader::getFieldEntryNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, uint8_t*& fieldEntry, size_t& varXs, size_t& varYs, size_t& varZs) {
+    float* data = nullptr;
+    if (!getFieldEntry(volumeData, fieldName, timestepIdx, memberIdx, data, varXs, varYs, varZs)) {
+        return false;
+    }
+    size_t sizeInBytes = size_t(varXs) * size_t(varYs) * std::max(varZs, size_t(1)) * sizeof(float);
+    fieldEntry = new uint8_t[sizeInBytes];
+    memcpy(fieldEntry, data, sizeInBytes);
+    delete[] data;
+    return true;
+}
+
+inline bool VolumeLoader::getFieldExtent(const std::string& fieldName, size_t& varXs, size_t& varYs, size_t& varZs) {
+    uint8_t* data = nullptr;
+    if (!getFieldEntryNative(nullptr, fieldName, 0, 0, data, varXs, varYs, varZs)) {
+        return false;
+    }
+    delete[] data;
+    return true;
+}
+
+inline bool VolumeLoader::getFieldSlabNative(
+        VolumeData* volumeData, const std::string& fieldName,
+        size_t timestepIdx, size_t memberIdx, const FieldSlab& slab, uint8_t* slabData) {
+    uint8_t* data = nullptr;
+    size_t varXs = 0, varYs = 0, varZs = 0;
+    if (!getFieldEntryNative(volumeData, fieldName, timestepIdx, memberIdx, data, varXs, varYs, varZs)) {
+        return false;
+    }
+    size_t entrySize = getFieldDataTypeSize(getFieldDataType(fieldName));
+    size_t offset = (slab.zOffset * size_t(varYs) + slab.yOffset) * size_t(varXs) * entrySize;
+    size_t sizeInBytes = slab.zCount * slab.yCount * size_t(varXs) * entrySize;
+    memcpy(slabData, data + offset, sizeInBytes);
+    delete[] data;
+    return true;
+}
+
 #endif //CORRERENDER_VOLUMELOADER_HPP
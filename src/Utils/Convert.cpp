@@ -27,6 +27,8 @@
  */
 
 #include "Convert.hpp"
+#include <cctype>
+#include <stdexcept>
 #include <boost/algorithm/string/predicate.hpp>
 
 namespace sgl
@@ -95,4 +97,30 @@ std::string numberToCommaString(int64_t number) {
     }
 }
 
+// Parses sizes like "4096", "512K", "512M" or "4G" to a number of bytes
+size_t parseMemorySize(const std::string& sizeString) {
+    if (sizeString.empty()) {
+        throw std::runtime_error("Error in parseMemorySize: Empty memory size string.");
+    }
+    size_t multiplier = 1;
+    std::string numberString = sizeString;
+    char suffix = char(std::toupper(sizeString.back()));
+    if (suffix == 'K' || suffix == 'M' || suffix == 'G' || suffix == 'T') {
+        numberString = sizeString.substr(0, sizeString.size() - 1);
+        if (suffix == 'K') {
+            multiplier = size_t(1) << 10;
+        } else if (suffix == 'M') {
+            multiplier = size_t(1) << 20;
+        } else if (suffix == 'G') {
+            multiplier = size_t(1) << 30;
+        } else {
+            multiplier = size_t(1) << 40;
+        }
+    }
+    if (numberString.empty() || !sgl::isNumeric(numberString)) {
+        throw std::runtime_error("Error in parseMemorySize: Invalid memory size \"" + sizeString + "\".");
+    }
+    return size_t(sgl::fromString<double>(numberString) * double(multiplier));
+}
+
 }
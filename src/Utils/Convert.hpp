@@ -103,6 +103,8 @@ bool isNumeric(const std::string &stringObject);
 int stringToNumber(const char *str);
 /// Converts e.g. 123456789 to "123,456,789"
 std::string numberToCommaString(int64_t number);
+/// Parses sizes like "4096", "512K", "512M" or "4G" to a number of bytes
+size_t parseMemorySize(const std::string &sizeString);
 
 }
 
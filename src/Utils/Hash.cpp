@@ -0,0 +1,143 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "TaskScheduler.hpp"
+#include "Hash.hpp"
+
+namespace sgl {
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* ptr) {
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(uint64_t));
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+static inline uint64_t xxh64Round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+}
+
+static inline uint64_t xxh64MergeRound(uint64_t acc, uint64_t val) {
+    val = xxh64Round(0, val);
+    acc ^= val;
+    acc = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+}
+
+uint64_t hashXXH64(const void* data, size_t length, uint64_t seed) {
+    // The reference implementation reads the input in little endian byte order, as is done here on x86 and ARM.
+    const auto* ptr = static_cast<const uint8_t*>(data);
+    const uint8_t* end = ptr + length;
+    uint64_t h64;
+
+    if (length >= 32) {
+        const uint8_t* limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = xxh64Round(v1, read64(ptr));
+            v2 = xxh64Round(v2, read64(ptr + 8));
+            v3 = xxh64Round(v3, read64(ptr + 16));
+            v4 = xxh64Round(v4, read64(ptr + 24));
+            ptr += 32;
+        } while (ptr <= limit);
+        h64 = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h64 = xxh64MergeRound(h64, v1);
+        h64 = xxh64MergeRound(h64, v2);
+        h64 = xxh64MergeRound(h64, v3);
+        h64 = xxh64MergeRound(h64, v4);
+    } else {
+        h64 = seed + PRIME64_5;
+    }
+
+    h64 += uint64_t(length);
+
+    while (ptr + 8 <= end) {
+        uint64_t k1 = xxh64Round(0, read64(ptr));
+        h64 ^= k1;
+        h64 = rotl64(h64, 27) * PRIME64_1 + PRIME64_4;
+        ptr += 8;
+    }
+    if (ptr + 4 <= end) {
+        h64 ^= uint64_t(read32(ptr)) * PRIME64_1;
+        h64 = rotl64(h64, 23) * PRIME64_2 + PRIME64_3;
+        ptr += 4;
+    }
+    while (ptr < end) {
+        h64 ^= uint64_t(*ptr) * PRIME64_5;
+        h64 = rotl64(h64, 11) * PRIME64_1;
+        ptr++;
+    }
+
+    h64 ^= h64 >> 33;
+    h64 *= PRIME64_2;
+    h64 ^= h64 >> 29;
+    h64 *= PRIME64_3;
+    h64 ^= h64 >> 32;
+    return h64;
+}
+
+uint64_t hashXXH64Parallel(const void* data, size_t length) {
+    const size_t blockSize = size_t(1) << 20;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    size_t numBlocks = (length + blockSize - 1) / blockSize;
+    std::vector<uint64_t> blockHashes(numBlocks);
+    parallelFor(0, numBlocks, 1, [&](size_t blockBegin, size_t blockEnd) {
+        for (size_t blockIdx = blockBegin; blockIdx < blockEnd; blockIdx++) {
+            size_t offset = blockIdx * blockSize;
+            blockHashes[blockIdx] = hashXXH64(bytes + offset, std::min(blockSize, length - offset));
+        }
+    });
+    return hashXXH64(blockHashes.data(), numBlocks * sizeof(uint64_t), uint64_t(length));
+}
+
+}
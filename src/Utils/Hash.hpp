@@ -0,0 +1,52 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_HASH_HPP
+#define NCCONV_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sgl {
+
+/**
+ * Computes the 64-bit xxHash (XXH64) of the passed data.
+ * XXH64 is a fast non-cryptographic hash, which is limited by memory bandwidth rather than by computation.
+ */
+uint64_t hashXXH64(const void* data, size_t length, uint64_t seed = 0);
+
+/**
+ * Hashes the passed data in parallel. The data is split into blocks of 1 MiB, which are hashed independently with
+ * XXH64. The result is the XXH64 hash of the block hashes (seeded with the data length). Thus, the hash does not
+ * depend on the number of threads.
+ */
+uint64_t hashXXH64Parallel(const void* data, size_t length);
+
+}
+
+#endif //NCCONV_HASH_HPP
@@ -0,0 +1,169 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstdio>
+
+#include "JsonUtils.hpp"
+
+namespace sgl {
+
+static void skipWhitespace(const std::string& str, size_t& idx) {
+    while (idx < str.size() && (str[idx] == ' ' || str[idx] == '\t' || str[idx] == '\n' || str[idx] == '\r')) {
+        idx++;
+    }
+}
+
+static bool parseJsonString(const std::string& str, size_t& idx, std::string& value) {
+    if (idx >= str.size() || str[idx] != '"') {
+        return false;
+    }
+    idx++;
+    value.clear();
+    while (idx < str.size() && str[idx] != '"') {
+        char c = str[idx++];
+        if (c != '\\') {
+            value.push_back(c);
+            continue;
+        }
+        if (idx >= str.size()) {
+            return false;
+        }
+        char escaped = str[idx++];
+        switch (escaped) {
+            case 'n': value.push_back('\n'); break;
+            case 't': value.push_back('\t'); break;
+            case 'r': value.push_back('\r'); break;
+            case 'b': value.push_back('\b'); break;
+            case 'f': value.push_back('\f'); break;
+            case 'u': {
+                // Only code points in the ASCII range are supported.
+                if (idx + 4 > str.size()) {
+                    return false;
+                }
+                unsigned int codePoint = std::stoul(str.substr(idx, 4), nullptr, 16);
+                idx += 4;
+                value.push_back(codePoint < 0x80 ? char(codePoint) : '?');
+                break;
+            }
+            default: value.push_back(escaped); break;
+        }
+    }
+    if (idx >= str.size()) {
+        return false;
+    }
+    idx++;
+    return true;
+}
+
+bool parseFlatJsonObject(
+        const std::string& jsonString, std::map<std::string, std::string>& values, std::string& errorMessage) {
+    size_t idx = 0;
+    skipWhitespace(jsonString, idx);
+    if (idx >= jsonString.size() || jsonString[idx] != '{') {
+        errorMessage = "Expected '{'.";
+        return false;
+    }
+    idx++;
+    skipWhitespace(jsonString, idx);
+    if (idx < jsonString.size() && jsonString[idx] == '}') {
+        return true;
+    }
+    while (idx < jsonString.size()) {
+        std::string key, value;
+        skipWhitespace(jsonString, idx);
+        if (!parseJsonString(jsonString, idx, key)) {
+            errorMessage = "Expected a key string.";
+            return false;
+        }
+        skipWhitespace(jsonString, idx);
+        if (idx >= jsonString.size() || jsonString[idx] != ':') {
+            errorMessage = "Expected ':' after key \"" + key + "\".";
+            return false;
+        }
+        idx++;
+        skipWhitespace(jsonString, idx);
+        if (idx < jsonString.size() && jsonString[idx] == '"') {
+            if (!parseJsonString(jsonString, idx, value)) {
+                errorMessage = "Invalid string value for key \"" + key + "\".";
+                return false;
+            }
+        } else {
+            while (idx < jsonString.size() && jsonString[idx] != ',' && jsonString[idx] != '}'
+                    && jsonString[idx] != ' ' && jsonString[idx] != '\t') {
+                if (jsonString[idx] == '{' || jsonString[idx] == '[') {
+                    errorMessage = "Nested values are not supported (key \"" + key + "\").";
+                    return false;
+                }
+                value.push_back(jsonString[idx++]);
+            }
+            if (value.empty()) {
+                errorMessage = "Missing value for key \"" + key + "\".";
+                return false;
+            }
+        }
+        values[key] = value;
+        skipWhitespace(jsonString, idx);
+        if (idx < jsonString.size() && jsonString[idx] == ',') {
+            idx++;
+        } else if (idx < jsonString.size() && jsonString[idx] == '}') {
+            return true;
+        } else {
+            errorMessage = "Expected ',' or '}'.";
+            return false;
+        }
+    }
+    errorMessage = "Unexpected end of input.";
+    return false;
+}
+
+std::string escapeJsonString(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '\t') {
+            escaped += "\\t";
+        } else if (c == '\r') {
+            escaped += "\\r";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+            escaped += buffer;
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    return escaped;
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef NCCONV_JSONUTILS_HPP
+#define NCCONV_JSONUTILS_HPP
+
+#include <string>
+#include <map>
+
+namespace sgl {
+
+/**
+ * Parses a flat JSON object like {"input": "a.ctl", "max_memory": 1024, "verify": true}.
+ * Nested objects and arrays are not supported. Numbers, booleans and null are returned as their string representation.
+ * @param jsonString The JSON string to parse.
+ * @param values The parsed key-value pairs.
+ * @param errorMessage Set to a description of the error if parsing failed.
+ * @return Whether parsing was successful.
+ */
+bool parseFlatJsonObject(
+        const std::string& jsonString, std::map<std::string, std::string>& values, std::string& errorMessage);
+
+/// Escapes quotes, backslashes and control characters for use in a JSON string literal.
+std::string escapeJsonString(const std::string& str);
+
+}
+
+#endif //NCCONV_JSONUTILS_HPP
@@ -0,0 +1,244 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TaskScheduler.hpp"
+
+namespace sgl {
+
+/// The pool and queue index of the worker running on the current thread (if any).
+static thread_local const TaskPool* currentPool = nullptr;
+static thread_local size_t currentWorkerIdx = 0;
+
+TaskPool::TaskPool(size_t numWorkers) {
+    startWorkers(numWorkers);
+}
+
+TaskPool::~TaskPool() {
+    stopWorkers();
+}
+
+void TaskPool::setNumWorkers(size_t numWorkers) {
+    if (numWorkers != workers.size()) {
+        stopWorkers();
+        startWorkers(numWorkers);
+    }
+}
+
+void TaskPool::startWorkers(size_t numWorkers) {
+    // A pool without workers keeps one queue, from which the tasks are run by the waiting threads.
+    queues.clear();
+    for (size_t queueIdx = 0; queueIdx < std::max(numWorkers, size_t(1)); queueIdx++) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t workerIdx = 0; workerIdx < numWorkers; workerIdx++) {
+        workers.emplace_back([this, workerIdx]() { runWorker(workerIdx); });
+    }
+}
+
+void TaskPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = true;
+    }
+    sleepCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    isStopping = false;
+}
+
+void TaskPool::submit(std::function<void()> task) {
+    size_t queueIdx = currentPool == this ? currentWorkerIdx : nextQueueIdx++ % queues.size();
+    {
+        TaskQueue& queue = *queues.at(queueIdx);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        numPendingTasks++;
+    }
+    sleepCondition.notify_one();
+    // Threads waiting for a task group run the new task if no worker takes it first.
+    waitCondition.notify_all();
+}
+
+bool TaskPool::takeTask(size_t workerIdx, std::function<void()>& task) {
+    bool hasTask = false;
+    {
+        TaskQueue& queue = *queues.at(workerIdx);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            hasTask = true;
+        }
+    }
+    for (size_t i = 1; i < queues.size() && !hasTask; i++) {
+        TaskQueue& queue = *queues.at((workerIdx + i) % queues.size());
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            hasTask = true;
+        }
+    }
+    if (hasTask) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        numPendingTasks--;
+    }
+    return hasTask;
+}
+
+bool TaskPool::runPendingTask() {
+    std::function<void()> task;
+    // Threads outside of the pool steal like a worker whose own queue is the next one in the round-robin order, so
+    // successive calls start at different queues.
+    size_t queueIdx = currentPool == this ? currentWorkerIdx : nextQueueIdx++ % queues.size();
+    if (!takeTask(queueIdx, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void TaskPool::waitForTasks(const std::function<bool()>& isDone) {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    waitCondition.wait(lock, [&]() { return numPendingTasks > 0 || isDone(); });
+}
+
+void TaskPool::notifyWaiters() {
+    {
+        // Waiters evaluate their condition while holding the mutex, so they are either waiting or see the new state.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    waitCondition.notify_all();
+}
+
+void TaskPool::runWorker(size_t workerIdx) {
+    currentPool = this;
+    currentWorkerIdx = workerIdx;
+    while (true) {
+        std::function<void()> task;
+        if (takeTask(workerIdx, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this]() { return isStopping || numPendingTasks > 0; });
+        if (isStopping && numPendingTasks == 0) {
+            break;
+        }
+    }
+}
+
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        numRunningTasks++;
+    }
+    pool.submit([this, task = std::move(task)]() {
+        std::exception_ptr taskException;
+        try {
+            task();
+        } catch (...) {
+            taskException = std::current_exception();
+        }
+        // The group may be destroyed as soon as the mutex is released, so the waiters are notified while holding it.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (taskException && !exception) {
+            exception = taskException;
+        }
+        if (--numRunningTasks == 0) {
+            pool.notifyWaiters();
+        }
+    });
+}
+
+void TaskGroup::wait() {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (numRunningTasks == 0) {
+                break;
+            }
+        }
+        if (pool.runPendingTask()) {
+            continue;
+        }
+        // The remaining tasks are running on other threads. Sleep until the last one finished, or until a task is
+        // submitted (e.g., a nested task of a running task), which this thread can run in the meantime.
+        pool.waitForTasks([this]() { return numRunningTasks == 0; });
+    }
+    std::exception_ptr taskException;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(taskException, exception);
+    }
+    if (taskException) {
+        std::rethrow_exception(taskException);
+    }
+}
+
+
+static size_t getNumHardwareThreads() {
+    return std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+}
+
+TaskPool& getComputeTaskPool() {
+    static TaskPool computePool(getNumHardwareThreads() - 1);
+    return computePool;
+}
+
+TaskPool& getIoTaskPool() {
+    static TaskPool ioPool(1);
+    return ioPool;
+}
+
+void setNumThreads(size_t numComputeThreads, size_t numIoThreads) {
+    if (numComputeThreads == 0) {
+        numComputeThreads = getNumHardwareThreads();
+    }
+    getComputeTaskPool().setNumWorkers(numComputeThreads - 1);
+    getIoTaskPool().setNumWorkers(numIoThreads);
+}
+
+size_t getNumComputeThreads() {
+    return getComputeTaskPool().getNumWorkers() + 1;
+}
+
+}
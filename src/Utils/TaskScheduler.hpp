@@ -0,0 +1,180 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_TASKSCHEDULER_HPP
+#define NCCONV_TASKSCHEDULER_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sgl {
+
+/**
+ * Pool of persistent worker threads with work stealing. Each worker owns a task queue. Workers take tasks from the
+ * back of their own queue (i.e., most recently submitted tasks first, which keeps their data in the cache) and steal
+ * from the front of the queues of other workers when their queue is empty. Tasks submitted by threads outside of the
+ * pool are distributed round-robin over the queues.
+ * Threads waiting for tasks (@see TaskGroup::wait) run pending tasks of the pool in the meantime, so tasks may submit
+ * and wait for nested tasks without deadlocks, and a pool without workers runs all tasks on the waiting threads.
+ */
+class TaskPool {
+public:
+    explicit TaskPool(size_t numWorkers);
+    ~TaskPool();
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /// Restarts the pool with a different number of workers. Must not be called while tasks are pending.
+    void setNumWorkers(size_t numWorkers);
+    [[nodiscard]] size_t getNumWorkers() const { return workers.size(); }
+    void submit(std::function<void()> task);
+    /// Runs one pending task on the calling thread. Returns false if no task is pending.
+    bool runPendingTask();
+    /**
+     * Blocks the calling thread until a task is submitted or isDone returns true. isDone is evaluated while holding
+     * the lock taken by @see notifyWaiters, so a state change followed by notifyWaiters is never missed.
+     */
+    void waitForTasks(const std::function<bool()>& isDone);
+    /// Wakes up the threads in @see waitForTasks, e.g., after the last task of a task group finished.
+    void notifyWaiters();
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    void startWorkers(size_t numWorkers);
+    void stopWorkers();
+    void runWorker(size_t workerIdx);
+    /// Takes a task from the back of the queue of the worker, or steals one from the front of another queue.
+    bool takeTask(size_t workerIdx, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueueIdx{0};
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition; ///< Wakes up the workers when tasks are submitted or the pool stops.
+    std::condition_variable waitCondition; ///< Wakes up threads in @see waitForTasks.
+    size_t numPendingTasks = 0; ///< Protected by sleepMutex.
+    bool isStopping = false; ///< Protected by sleepMutex.
+};
+
+/**
+ * Set of tasks run on a pool, which can be waited for. The first exception thrown by a task is rethrown by @see wait.
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool& pool) : pool(pool) {}
+    /// Waits for the pending tasks, but discards their exceptions.
+    ~TaskGroup();
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    /// Waits until all tasks of the group finished. Pending tasks of the pool are run by the calling thread meanwhile.
+    void wait();
+
+private:
+    TaskPool& pool;
+    std::mutex mutex;
+    /// Changed while holding mutex, but also read by @see TaskPool::waitForTasks without it.
+    std::atomic<size_t> numRunningTasks{0};
+    std::exception_ptr exception; ///< Protected by mutex.
+};
+
+/**
+ * The pools shared by all stages of the conversion. The compute pool runs CPU-bound work (decoding, hashing,
+ * compression) and has one worker less than the number of threads, as the thread waiting for a parallel loop
+ * participates in it. The I/O pool runs blocking reads ahead of the compute and write stages, so its threads spend
+ * most of their time waiting and do not oversubscribe the cores used by the compute pool.
+ */
+TaskPool& getComputeTaskPool();
+TaskPool& getIoTaskPool();
+/**
+ * Sets the number of threads used for computations (including the calling thread; 0 selects the number of hardware
+ * threads) and the number of I/O threads. Must not be called while tasks are pending.
+ */
+void setNumThreads(size_t numComputeThreads, size_t numIoThreads = 1);
+/// Returns the number of threads used for computations, including the calling thread.
+size_t getNumComputeThreads();
+
+/**
+ * Calls body(rangeBegin, rangeEnd) for consecutive ranges of grainSize indices in [begin, end) on the compute pool.
+ * The ranges are assigned dynamically, and the calling thread processes ranges, too. Loops with a single range, and
+ * loops on a pool without workers, run on the calling thread without synchronization overhead.
+ */
+template<class Body>
+void parallelFor(size_t begin, size_t end, size_t grainSize, const Body& body) {
+    if (end <= begin) {
+        return;
+    }
+    TaskPool& pool = getComputeTaskPool();
+    grainSize = std::max(grainSize, size_t(1));
+    size_t numRanges = (end - begin + grainSize - 1) / grainSize;
+    size_t numTasks = std::min(numRanges, pool.getNumWorkers() + 1);
+    if (numTasks <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    std::atomic<size_t> nextRangeIdx{0};
+    auto processRanges = [&]() {
+        for (size_t rangeIdx = nextRangeIdx++; rangeIdx < numRanges; rangeIdx = nextRangeIdx++) {
+            size_t rangeBegin = begin + rangeIdx * grainSize;
+            body(rangeBegin, std::min(rangeBegin + grainSize, end));
+        }
+    };
+    TaskGroup group(pool);
+    for (size_t taskIdx = 1; taskIdx < numTasks; taskIdx++) {
+        group.run(processRanges);
+    }
+    std::exception_ptr callerException;
+    try {
+        processRanges();
+    } catch (...) {
+        callerException = std::current_exception();
+        nextRangeIdx = numRanges;
+    }
+    group.wait();
+    if (callerException) {
+        std::rethrow_exception(callerException);
+    }
+}
+
+}
+
+#endif //NCCONV_TASKSCHEDULER_HPP
@@ -0,0 +1,556 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <limits>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Utils/Hash.hpp"
+#include "Utils/TaskScheduler.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "NcFieldType.hpp"
+#include "VolumeData.hpp"
+#include "Cdf5Writer.hpp"
+
+// Tags of the lists in the header of classic NetCDF files.
+static const uint32_t CDF_TAG_DIMENSION = 0x0A;
+static const uint32_t CDF_TAG_VARIABLE = 0x0B;
+static const uint32_t CDF_TAG_ATTRIBUTE = 0x0C;
+/// The data of the fields starts at multiples of the page size, so that the large writes are page-aligned.
+static const uint64_t CDF_FIELD_ALIGNMENT = 4096;
+
+/// Appends a value in big endian byte order, like all numbers in classic NetCDF files.
+template<class T>
+static void appendBigEndian(std::vector<uint8_t>& data, T value) {
+    value = byteSwapValue(value);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+/// Appends the bytes and zero bytes padding them to a multiple of four bytes.
+static void appendPadded(std::vector<uint8_t>& data, const uint8_t* bytes, size_t numBytes) {
+    data.insert(data.end(), bytes, bytes + numBytes);
+    data.resize(data.size() + (4 - numBytes % 4) % 4, 0);
+}
+
+static void appendName(std::vector<uint8_t>& data, const std::string& name) {
+    appendBigEndian<uint64_t>(data, name.size());
+    appendPadded(data, reinterpret_cast<const uint8_t*>(name.data()), name.size());
+}
+
+static void appendAttributeList(std::vector<uint8_t>& data, const std::vector<Cdf5Attribute>& attributes) {
+    // An absent list has the tag and number of entries zero.
+    appendBigEndian<uint32_t>(data, attributes.empty() ? 0 : CDF_TAG_ATTRIBUTE);
+    appendBigEndian<uint64_t>(data, attributes.size());
+    for (const Cdf5Attribute& attribute : attributes) {
+        appendName(data, attribute.name);
+        appendBigEndian<uint32_t>(data, uint32_t(attribute.ncType));
+        appendBigEndian<uint64_t>(data, attribute.numValues);
+        appendPadded(data, attribute.values.data(), attribute.values.size());
+    }
+}
+
+static Cdf5Attribute makeTextAttribute(const std::string& name, const std::string& text) {
+    Cdf5Attribute attribute;
+    attribute.name = name;
+    attribute.ncType = NC_CHAR;
+    attribute.numValues = text.size();
+    attribute.values.assign(text.begin(), text.end());
+    return attribute;
+}
+
+template<class T>
+static Cdf5Attribute makeArrayAttribute(const std::string& name, nc_type ncType, const std::vector<T>& values) {
+    Cdf5Attribute attribute;
+    attribute.name = name;
+    attribute.ncType = ncType;
+    attribute.numValues = values.size();
+    for (T value : values) {
+        appendBigEndian(attribute.values, value);
+    }
+    return attribute;
+}
+
+/// The fill value attribute needs to have the type of its variable.
+static Cdf5Attribute makeFillValueAttribute(FieldDataType dataType, double fillValue) {
+    if (!getIsFieldDataTypeFloat(dataType) && !getIsFillValueRepresentable(dataType, fillValue)) {
+        throw std::runtime_error(
+                "Error in makeFillValueAttribute: The fill value " + std::to_string(fillValue)
+                + " is out of the range of " + getFieldDataTypeName(dataType) + ".");
+    }
+    Cdf5Attribute attribute;
+    attribute.name = "_FillValue";
+    attribute.ncType = getNcType(dataType);
+    attribute.numValues = 1;
+    switch (dataType) {
+        case FieldDataType::INT8:
+            appendBigEndian(attribute.values, static_cast<int8_t>(fillValue));
+            break;
+        case FieldDataType::UINT8:
+            appendBigEndian(attribute.values, static_cast<uint8_t>(fillValue));
+            break;
+        case FieldDataType::INT16:
+            appendBigEndian(attribute.values, static_cast<int16_t>(fillValue));
+            break;
+        case FieldDataType::UINT16:
+            appendBigEndian(attribute.values, static_cast<uint16_t>(fillValue));
+            break;
+        case FieldDataType::INT32:
+            appendBigEndian(attribute.values, static_cast<int32_t>(fillValue));
+            break;
+        case FieldDataType::FLOAT32:
+            appendBigEndian(attribute.values, static_cast<float>(fillValue));
+            break;
+        case FieldDataType::FLOAT64:
+            appendBigEndian(attribute.values, fillValue);
+            break;
+    }
+    return attribute;
+}
+
+#ifndef _WIN32
+/// Writes all bytes at the passed file offset. May be called from multiple threads for disjoint ranges.
+static void writeAt(int fd, const uint8_t* data, size_t numBytes, uint64_t offset, const std::string& filePath) {
+    while (numBytes > 0) {
+        ssize_t numBytesWritten = pwrite(fd, data, numBytes, off_t(offset));
+        if (numBytesWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numBytesWritten <= 0) {
+            throw std::runtime_error(
+                    "Error in Cdf5Writer::writeAt: Writing to file \"" + filePath + "\" failed: "
+                    + std::string(strerror(errno)));
+        }
+        data += numBytesWritten;
+        numBytes -= size_t(numBytesWritten);
+        offset += uint64_t(numBytesWritten);
+    }
+}
+#endif
+
+Cdf5Writer::Cdf5Writer(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+bool Cdf5Writer::writeToFile(const std::string& _filePath) {
+#ifdef _WIN32
+    throw std::runtime_error("Error in Cdf5Writer::writeToFile: The CDF-5 writer is not supported on Windows.");
+#else
+    checkSettings();
+    // The fields are streamed by a single process; with MPI, the first rank writes the whole data set.
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+    if (mpiRank != 0) {
+        return true;
+    }
+    filePath = _filePath;
+
+    // The header keeps its size when the file offsets and slab hashes are filled in.
+    defineVariables();
+    uint64_t fileSize = serializeHeader().size();
+    for (size_t varIdx = 0; varIdx < variables.size(); varIdx++) {
+        Cdf5Variable& variable = variables.at(varIdx);
+        if (varIdx >= numCoordinateVariables) {
+            fileSize = (fileSize + CDF_FIELD_ALIGNMENT - 1) / CDF_FIELD_ALIGNMENT * CDF_FIELD_ALIGNMENT;
+        }
+        variable.begin = fileSize;
+        fileSize += (variable.size + 3) / 4 * 4;
+    }
+
+    int fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(
+                "Error in Cdf5Writer::writeToFile: Couldn't open file \"" + filePath + "\" for writing.");
+    }
+    try {
+        // Setting the final size up front avoids extending the file by each of the concurrent writes.
+        if (ftruncate(fd, off_t(fileSize)) != 0) {
+            throw std::runtime_error(
+                    "Error in Cdf5Writer::writeToFile: Couldn't resize file \"" + filePath + "\".");
+        }
+        writeCoordinates(fd);
+        writeFields(fd);
+        std::vector<uint8_t> header = serializeHeader();
+        writeAt(fd, header.data(), header.size(), 0, filePath);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd) != 0) {
+        throw std::runtime_error("Error in Cdf5Writer::writeToFile: Closing file \"" + filePath + "\" failed.");
+    }
+    return true;
+#endif
+}
+
+void Cdf5Writer::checkSettings() {
+    volumeData->checkSequentialReadSettings();
+    if (volumeData->getOutputLayout() == OutputLayout::TIME_SERIES && volumeData->getNumTimeSteps() > 1) {
+        throw std::runtime_error(
+                "Error in Cdf5Writer::checkSettings: The time series layout is only supported for NetCDF-4 files.");
+    }
+    if (!volumeData->getChunkShape().empty() || volumeData->getAccessPattern() != AccessPattern::DEFAULT
+            || volumeData->getDeflateLevel() > 0 || volumeData->getUseShuffleFilter()) {
+        throw std::runtime_error(
+                "Error in Cdf5Writer::checkSettings: CDF-5 files support neither chunking nor compression.");
+    }
+    if (volumeData->getTimeAggregation().type != TimeAggregationType::NONE
+            || !volumeData->getEnsembleStatistics().empty() || !volumeData->getWriteEnsembleMembers()) {
+        throw std::runtime_error(
+                "Error in Cdf5Writer::checkSettings: Temporal aggregation and ensemble statistics are only supported "
+                "for NetCDF-4 files.");
+    }
+    if (volumeData->getCollapseTimeInvariantFields()) {
+        throw std::runtime_error(
+                "Error in Cdf5Writer::checkSettings: Collapsing time-invariant variables is only supported for "
+                "NetCDF-4 files.");
+    }
+}
+
+void Cdf5Writer::defineVariables() {
+    VolumeLoader* loader = volumeData->getLoader();
+    size_t xs = volumeData->getGridSizeX();
+    size_t ys = volumeData->getGridSizeY();
+    auto zs = std::max(volumeData->getGridSizeZ(), size_t(1));
+    size_t ts = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    size_t es = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+
+    // The dimensions, attributes and variables match the ones written by VolumeData::writeToNcHandle.
+    dimensions = { { "x", xs }, { "y", ys }, { "z", zs } };
+    size_t xDim = 0, yDim = 1, zDim = 2, tDim = 0, eDim = 0;
+    if (ts > 1) {
+        tDim = dimensions.size();
+        dimensions.emplace_back("time", ts);
+    }
+    if (es > 1) {
+        eDim = dimensions.size();
+        dimensions.emplace_back("member", es);
+    }
+
+    globalAttributes = {
+            makeTextAttribute("Conventions", "CF-1.5"),
+            makeTextAttribute("title", "Exported scalar field"),
+            makeTextAttribute("history", "ncconv"),
+            makeTextAttribute(
+                    "institution", "Technical University of Munich, Chair of Computer Graphics and Visualization"),
+            makeTextAttribute(
+                    "source",
+                    "ncconv, a utility program for converting meteorological data sets to the NetCDF format."),
+            makeTextAttribute("references", "https://github.com/chrismile/ncconv"),
+            makeTextAttribute("comment", "ncconv is released under the 2-clause BSD license."),
+    };
+    if (es > 1) {
+        globalAttributes.push_back(makeTextAttribute("ncconv_ensemble_members", "all"));
+    }
+
+    variables.clear();
+    auto addCoordinateVariable = [&](const std::string& name, size_t dimId, const std::string& coordinateType) {
+        Cdf5Variable variable;
+        variable.name = name;
+        variable.ncType = NC_FLOAT;
+        variable.dimIds = { dimId };
+        if (!coordinateType.empty()) {
+            variable.attributes.push_back(makeTextAttribute("coordinate_type", coordinateType));
+        }
+        variable.size = dimensions.at(dimId).second * sizeof(float);
+        variables.push_back(variable);
+    };
+    addCoordinateVariable("x", xDim, "Cartesian X");
+    addCoordinateVariable("y", yDim, "Cartesian Y");
+    addCoordinateVariable("z", zDim, "Cartesian Z");
+    addCoordinateVariable("lon", xDim, "");
+    addCoordinateVariable("lat", yDim, "");
+    numCoordinateVariables = variables.size();
+
+    // One slab is read while the others are converted and written. All of them fit into the memory budget together.
+    numSlabBuffers = std::clamp(sgl::getIoTaskPool().getNumWorkers() + 1, size_t(2), size_t(4));
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        size_t varxs = 0, varys = 0, varzs = 0;
+        loader->getFieldExtent(fieldName, varxs, varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+        FieldDataType nativeDataType = loader->getFieldDataType(fieldName);
+        OutputFloatType outputFloatType = volumeData->getOutputFloatType();
+        bool isHalfOutput = outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(nativeDataType);
+        FieldDataType dataType = isHalfOutput ? FieldDataType::UINT16 : nativeDataType;
+        auto entrySize = size_t(getFieldDataTypeSize(dataType));
+        size_t slabEntrySize = entrySize * numSlabBuffers + (isHalfOutput ? getFieldDataTypeSize(nativeDataType) : 0);
+
+        Cdf5Variable variable;
+        variable.name = fieldName;
+        variable.ncType = getNcType(dataType);
+        variable.dimIds = { yDim, xDim };
+        if (varzs > 1) {
+            variable.dimIds.insert(variable.dimIds.begin(), zDim);
+        }
+        if (ts > 1) {
+            variable.dimIds.insert(variable.dimIds.begin(), tDim);
+        }
+        if (es > 1) {
+            variable.dimIds.insert(variable.dimIds.begin(), eDim);
+        }
+        variable.size = es * ts * varzs * varys * varxs * entrySize;
+        variable.slabs = volumeData->computeFieldSlabs(varxs, varys, varzs, slabEntrySize, 1, 1);
+
+        double fillValue = 0.0;
+        if (isHalfOutput) {
+            variable.attributes.push_back(
+                    makeFillValueAttribute(dataType, double(getOutputFloatTypeNaN(outputFloatType))));
+            variable.attributes.push_back(
+                    makeTextAttribute("ncconv_dtype", getOutputFloatTypeName(outputFloatType)));
+        } else if (loader->getFieldFillValue(fieldName, fillValue)
+                && getIsFillValueRepresentable(dataType, fillValue)) {
+            variable.attributes.push_back(makeFillValueAttribute(dataType, fillValue));
+        } else if (getIsFieldDataTypeFloat(dataType)) {
+            variable.attributes.push_back(
+                    makeFillValueAttribute(dataType, std::numeric_limits<double>::quiet_NaN()));
+        }
+        if (volumeData->getRecordSlabHashes()) {
+            std::vector<int64_t> slabsData;
+            for (const FieldSlab& slab : variable.slabs) {
+                slabsData.insert(slabsData.end(), {
+                        int64_t(slab.zOffset), int64_t(slab.zCount), int64_t(slab.yOffset), int64_t(slab.yCount) });
+            }
+            variable.attributes.push_back(makeArrayAttribute(SLAB_HASHES_SLABS_ATTRIBUTE, NC_INT64, slabsData));
+            // Placeholders for the hashes, which are set in writeFields.
+            std::vector<uint64_t> slabHashes(es * ts * variable.slabs.size(), 0);
+            variable.attributes.push_back(makeArrayAttribute(SLAB_HASHES_ATTRIBUTE, NC_UINT64, slabHashes));
+        }
+        variables.push_back(variable);
+    }
+}
+
+std::vector<uint8_t> Cdf5Writer::serializeHeader() const {
+    std::vector<uint8_t> header = { 'C', 'D', 'F', 5 };
+    // Number of records (there is no record dimension).
+    appendBigEndian<uint64_t>(header, 0);
+
+    appendBigEndian<uint32_t>(header, dimensions.empty() ? 0 : CDF_TAG_DIMENSION);
+    appendBigEndian<uint64_t>(header, dimensions.size());
+    for (const auto& dimension : dimensions) {
+        appendName(header, dimension.first);
+        appendBigEndian<uint64_t>(header, dimension.second);
+    }
+
+    appendAttributeList(header, globalAttributes);
+
+    appendBigEndian<uint32_t>(header, variables.empty() ? 0 : CDF_TAG_VARIABLE);
+    appendBigEndian<uint64_t>(header, variables.size());
+    for (const Cdf5Variable& variable : variables) {
+        appendName(header, variable.name);
+        appendBigEndian<uint64_t>(header, variable.dimIds.size());
+        for (size_t dimId : variable.dimIds) {
+            appendBigEndian<uint64_t>(header, dimId);
+        }
+        appendAttributeList(header, variable.attributes);
+        appendBigEndian<uint32_t>(header, uint32_t(variable.ncType));
+        // The size is padded to a multiple of four bytes.
+        appendBigEndian<uint64_t>(header, (variable.size + 3) / 4 * 4);
+        appendBigEndian<uint64_t>(header, variable.begin);
+    }
+    return header;
+}
+
+void Cdf5Writer::writeCoordinates(int fd) {
+#ifndef _WIN32
+    std::vector<float> levels(std::max(volumeData->getGridSizeZ(), size_t(1)));
+    for (size_t z = 0; z < levels.size(); z++) {
+        levels.at(z) = volumeData->getLev1d() ? volumeData->getLev1d()[z] : float(z);
+    }
+    const float* coordinates[] = {
+            volumeData->getLon1d(), volumeData->getLat1d(), levels.data(), volumeData->getLon1d(),
+            volumeData->getLat1d()
+    };
+    for (size_t varIdx = 0; varIdx < numCoordinateVariables; varIdx++) {
+        const Cdf5Variable& variable = variables.at(varIdx);
+        size_t numEntries = variable.size / sizeof(float);
+        std::vector<uint8_t> data(variable.size);
+        encodeFieldEntries(
+                coordinates[varIdx], FieldDataType::FLOAT32, data.data(), numEntries, true,
+                std::numeric_limits<double>::quiet_NaN());
+        writeAt(fd, data.data(), data.size(), variable.begin, filePath);
+    }
+#endif
+}
+
+/// State of a field while its (member, time step, slab) items are written by @see Cdf5Writer::writeFields.
+struct Cdf5FieldWrite {
+    Cdf5Variable* variable = nullptr;
+    std::string fieldName;
+    size_t varxs = 0, varys = 0;
+    size_t mapSize = 0; ///< Number of entries of one (member, time step) record of the field.
+    FieldDataType nativeDataType = FieldDataType::FLOAT32;
+    FieldDataType dataType = FieldDataType::FLOAT32;
+    bool isHalfOutput = false;
+    std::vector<uint64_t> slabHashes;
+    HalfFloatStats halfFloatStats;
+};
+
+void Cdf5Writer::writeFields(int fd) {
+#ifndef _WIN32
+    VolumeLoader* loader = volumeData->getLoader();
+    auto numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    auto numMembers = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    OutputFloatType outputFloatType = volumeData->getOutputFloatType();
+    bool recordSlabHashes = volumeData->getRecordSlabHashes();
+    const std::vector<std::string>& fieldNames = volumeData->getFieldNames();
+    std::vector<Cdf5FieldWrite> fields(fieldNames.size());
+    size_t maxSlabDataSize = 0, maxNativeSlabDataSize = 0;
+    for (size_t fieldIdx = 0; fieldIdx < fieldNames.size(); fieldIdx++) {
+        Cdf5FieldWrite& field = fields.at(fieldIdx);
+        field.variable = &variables.at(numCoordinateVariables + fieldIdx);
+        field.fieldName = fieldNames.at(fieldIdx);
+        size_t varzs = 0;
+        loader->getFieldExtent(field.fieldName, field.varxs, field.varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+        field.mapSize = varzs * field.varys * field.varxs;
+        field.nativeDataType = loader->getFieldDataType(field.fieldName);
+        field.isHalfOutput =
+                outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(field.nativeDataType);
+        field.dataType = field.isHalfOutput ? FieldDataType::UINT16 : field.nativeDataType;
+        field.slabHashes.resize(recordSlabHashes ? numMembers * numTimeSteps * field.variable->slabs.size() : 0, 0);
+        for (const FieldSlab& slab : field.variable->slabs) {
+            size_t numEntries = slab.zCount * slab.yCount * field.varxs;
+            maxSlabDataSize = std::max(maxSlabDataSize, numEntries * getFieldDataTypeSize(field.dataType));
+            if (field.isHalfOutput) {
+                maxNativeSlabDataSize =
+                        std::max(maxNativeSlabDataSize, numEntries * getFieldDataTypeSize(field.nativeDataType));
+            }
+        }
+    }
+
+    // Items are (member, time step, slab) tuples in the order of the data in the file. Each item is converted to big
+    // endian byte order in-place and written by a task on the I/O pool, which is waited for before its slab buffer is
+    // reused. The slabs of each field were computed for numSlabBuffers buffers, so the buffers are shared by all.
+    std::vector<std::vector<uint8_t>> slabBuffers(numSlabBuffers, std::vector<uint8_t>(maxSlabDataSize));
+    std::vector<uint8_t> nativeSlabData(maxNativeSlabDataSize);
+    size_t bufferIdx = 0;
+    // Declared after the buffers, so pending writes finish before they are freed (e.g., if a read fails).
+    std::vector<std::unique_ptr<sgl::TaskGroup>> writeGroups;
+    for (size_t i = 0; i < numSlabBuffers; i++) {
+        writeGroups.push_back(std::make_unique<sgl::TaskGroup>(sgl::getIoTaskPool()));
+    }
+    auto writeRecord = [&](Cdf5FieldWrite& field, size_t m, size_t t) {
+        const std::vector<FieldSlab>& slabs = field.variable->slabs;
+        auto entrySize = size_t(getFieldDataTypeSize(field.dataType));
+        for (size_t slabIdx = 0; slabIdx < slabs.size(); slabIdx++) {
+            const FieldSlab& slab = slabs.at(slabIdx);
+            size_t numEntries = slab.zCount * slab.yCount * field.varxs;
+            sgl::TaskGroup& writeGroup = *writeGroups.at(bufferIdx);
+            writeGroup.wait();
+            uint8_t* slabData = slabBuffers.at(bufferIdx).data();
+            bufferIdx = (bufferIdx + 1) % numSlabBuffers;
+            if (field.isHalfOutput) {
+                loader->getFieldSlabNative(
+                        volumeData, field.fieldName, t, m, slab, nativeSlabData.data());
+                encodeHalfFloats(
+                        nativeSlabData.data(), field.nativeDataType, reinterpret_cast<uint16_t*>(slabData),
+                        numEntries, outputFloatType, field.halfFloatStats);
+            } else {
+                loader->getFieldSlabNative(volumeData, field.fieldName, t, m, slab, slabData);
+            }
+            uint64_t entryOffset =
+                    (m * numTimeSteps + t) * field.mapSize
+                    + (slab.zOffset * field.varys + slab.yOffset) * field.varxs;
+            uint64_t fileOffset = field.variable->begin + entryOffset * entrySize;
+            size_t itemIdx = (m * numTimeSteps + t) * slabs.size() + slabIdx;
+            writeGroup.run([&, itemIdx, slabData, numEntries, entrySize, fileOffset]() {
+                if (recordSlabHashes) {
+                    canonicalizeNaNs(slabData, field.dataType, numEntries);
+                    field.slabHashes.at(itemIdx) = sgl::hashXXH64Parallel(slabData, numEntries * entrySize);
+                }
+                encodeFieldEntries(
+                        slabData, field.dataType, slabData, numEntries, true,
+                        std::numeric_limits<double>::quiet_NaN());
+                writeAt(fd, slabData, numEntries * entrySize, fileOffset, filePath);
+            });
+        }
+    };
+    auto finishField = [&](Cdf5FieldWrite& field) {
+        if (field.isHalfOutput) {
+            volumeData->reportHalfFloatStats(field.fieldName, field.halfFloatStats);
+        }
+        if (recordSlabHashes) {
+            for (Cdf5Attribute& attribute : field.variable->attributes) {
+                if (attribute.name == SLAB_HASHES_ATTRIBUTE) {
+                    attribute = makeArrayAttribute(SLAB_HASHES_ATTRIBUTE, NC_UINT64, field.slabHashes);
+                }
+            }
+        }
+    };
+    auto waitForWrites = [&]() {
+        for (auto& writeGroup : writeGroups) {
+            writeGroup->wait();
+        }
+    };
+
+    if (loader->getRequiresSequentialReads()) {
+        // Input read from a stream (e.g., stdin) is written record by record in the order of the data file.
+        if (volumeData->getIsVerbose()) {
+            std::cout << "Writing " << fields.size() << " variable(s) record by record..." << std::endl;
+        }
+        for (size_t m = 0; m < numMembers; m++) {
+            for (size_t t = 0; t < numTimeSteps; t++) {
+                for (Cdf5FieldWrite& field : fields) {
+                    writeRecord(field, m, t);
+                }
+            }
+        }
+        waitForWrites();
+        for (Cdf5FieldWrite& field : fields) {
+            finishField(field);
+        }
+    } else {
+        for (Cdf5FieldWrite& field : fields) {
+            if (volumeData->getIsVerbose()) {
+                std::cout << "Writing variable '" << field.fieldName << "'..." << std::endl;
+            }
+            for (size_t m = 0; m < numMembers; m++) {
+                for (size_t t = 0; t < numTimeSteps; t++) {
+                    writeRecord(field, m, t);
+                }
+            }
+            waitForWrites();
+            finishField(field);
+        }
+    }
+#endif
+}
@@ -0,0 +1,100 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_CDF5WRITER_HPP
+#define NCCONV_CDF5WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "Loaders/VolumeLoader.hpp"
+#include "VolumeWriter.hpp"
+
+class VolumeData;
+
+/// Attribute of a variable (or a global attribute) in the header of a CDF-5 file.
+struct Cdf5Attribute {
+    std::string name;
+    int ncType = 0;
+    size_t numValues = 0;
+    std::vector<uint8_t> values; ///< Big endian values, not padded.
+};
+
+/// Non-record variable of a CDF-5 file, whose data is stored contiguously at the file offset begin.
+struct Cdf5Variable {
+    std::string name;
+    int ncType = 0;
+    std::vector<size_t> dimIds;
+    std::vector<Cdf5Attribute> attributes;
+    uint64_t size = 0; ///< Size of the data in bytes.
+    uint64_t begin = 0; ///< File offset of the data.
+    std::vector<FieldSlab> slabs; ///< Slabs in which fields are streamed.
+};
+
+/**
+ * Writes a data set to a classic NetCDF file in the CDF-5 (64-bit data) format without the NetCDF library. CDF-5 is
+ * chosen over the 64-bit offset format (CDF-2), as it supports unsigned integer types and variables of any size.
+ * The header and the file offset of each variable are computed up front from the dimensions and variables of the data
+ * set. The variables are stored contiguously without a record dimension, so each (member, time step, slab) item of a
+ * field is one contiguous range of the file. The items are read on the calling thread, while their conversion to big
+ * endian byte order and their positional writes (pwrite) run concurrently on the I/O pool. The header is written
+ * last, once the slab hashes are known.
+ * The result is readable by any NetCDF library (version 4.4 or newer) and tool. Compression, chunking, the time
+ * series layout and the statistics written by @see VolumeData are not supported by this writer. Not available on
+ * Windows.
+ */
+class Cdf5Writer : public VolumeWriter {
+public:
+    explicit Cdf5Writer(VolumeData* volumeData);
+    bool writeToFile(const std::string& filePath) override;
+
+private:
+    void checkSettings();
+    void defineVariables();
+    /// Serializes the header with the current attributes and variable offsets.
+    [[nodiscard]] std::vector<uint8_t> serializeHeader() const;
+    void writeCoordinates(int fd);
+    /**
+     * Streams the members and time steps of the fields and stores the slab hashes (if recorded) in their attributes.
+     * The fields are written one after the other, or record by record (members > time steps > fields) for input that
+     * can only be read sequentially (e.g., from stdin).
+     */
+    void writeFields(int fd);
+
+    VolumeData* volumeData;
+    std::string filePath;
+    std::vector<std::pair<std::string, size_t>> dimensions;
+    std::vector<Cdf5Attribute> globalAttributes;
+    std::vector<Cdf5Variable> variables;
+    size_t numCoordinateVariables = 0; ///< The fields follow the coordinate variables.
+    size_t numSlabBuffers = 2; ///< Number of items being read or written at the same time.
+};
+
+#endif //NCCONV_CDF5WRITER_HPP
@@ -0,0 +1,123 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ChunkTuning.hpp"
+
+AccessPattern parseAccessPattern(const std::string& patternName) {
+    if (patternName == "default") {
+        return AccessPattern::DEFAULT;
+    } else if (patternName == "maps") {
+        return AccessPattern::MAPS;
+    } else if (patternName == "profiles") {
+        return AccessPattern::PROFILES;
+    } else if (patternName == "timeseries") {
+        return AccessPattern::TIME_SERIES;
+    } else if (patternName == "balanced") {
+        return AccessPattern::BALANCED;
+    }
+    throw std::runtime_error("Error in parseAccessPattern: Unknown access pattern \"" + patternName + "\".");
+}
+
+/**
+ * Splits a horizontal grid of size ys x xs into tiles of at most numPoints points. Tiles are as square as possible,
+ * but whole rows are preferred if the tile is at least as wide as the grid.
+ */
+static void computeHorizontalTile(size_t numPoints, size_t ys, size_t xs, size_t& chunkY, size_t& chunkX) {
+    numPoints = std::max(numPoints, size_t(1));
+    chunkX = std::clamp(size_t(std::sqrt(double(numPoints))), size_t(1), xs);
+    chunkY = std::clamp(numPoints / chunkX, size_t(1), ys);
+    if (chunkY == ys) {
+        chunkX = std::clamp(numPoints / chunkY, size_t(1), xs);
+    }
+}
+
+std::array<size_t, 4> computeChunkShape(
+        AccessPattern pattern, size_t ts, size_t zs, size_t ys, size_t xs, size_t entrySize, size_t targetChunkSize) {
+    ts = std::max(ts, size_t(1));
+    zs = std::max(zs, size_t(1));
+    size_t numEntries = std::max(targetChunkSize / entrySize, size_t(1));
+    std::array<size_t, 4> chunk = { 1, 1, 1, 1 };
+
+    if (pattern == AccessPattern::MAPS) {
+        // Whole maps, or bands of rows if a map is larger than the target size.
+        chunk[3] = std::min(numEntries, xs);
+        chunk[2] = std::clamp(numEntries / chunk[3], size_t(1), ys);
+    } else if (pattern == AccessPattern::PROFILES) {
+        chunk[1] = std::min(zs, numEntries);
+        computeHorizontalTile(numEntries / chunk[1], ys, xs, chunk[2], chunk[3]);
+    } else if (pattern == AccessPattern::TIME_SERIES) {
+        chunk[0] = std::min(ts, numEntries);
+        computeHorizontalTile(numEntries / chunk[0], ys, xs, chunk[2], chunk[3]);
+    } else if (pattern == AccessPattern::BALANCED) {
+        // Scale all axes by the same factor, so that each axis is split into a similar number of chunks.
+        const std::array<size_t, 4> extent = { ts, zs, ys, xs };
+        double numEntriesTotal = double(ts) * double(zs) * double(ys) * double(xs);
+        int numAxes = 0;
+        for (size_t e : extent) {
+            numAxes += e > 1 ? 1 : 0;
+        }
+        double scale = numAxes == 0 ? 1.0 : std::pow(double(numEntries) / numEntriesTotal, 1.0 / double(numAxes));
+        scale = std::min(scale, 1.0);
+        for (int i = 0; i < 4; i++) {
+            chunk[i] = std::clamp(size_t(double(extent[i]) * scale), size_t(1), extent[i]);
+        }
+        // Rounding down may leave space; grow the innermost axes while the chunk stays within the target size.
+        for (int i = 3; i >= 0; i--) {
+            size_t otherEntries = 1;
+            for (int j = 0; j < 4; j++) {
+                otherEntries *= j == i ? size_t(1) : chunk[j];
+            }
+            chunk[i] = std::clamp(numEntries / otherEntries, chunk[i], extent[i]);
+        }
+    } else {
+        throw std::runtime_error("Error in computeChunkShape: No access pattern specified.");
+    }
+    return chunk;
+}
+
+size_t getNextPrime(size_t n) {
+    auto isPrime = [](size_t k) {
+        if (k < 2) {
+            return false;
+        }
+        for (size_t d = 2; d * d <= k; d++) {
+            if (k % d == 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    while (!isPrime(n)) {
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,69 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_CHUNKTUNING_HPP
+#define NCCONV_CHUNKTUNING_HPP
+
+#include <array>
+#include <string>
+#include <cstddef>
+
+/**
+ * Expected read access pattern of the output file, used for choosing the chunk shape of the output variables.
+ * - MAPS: Horizontal maps of single time steps and levels.
+ * - PROFILES: Vertical columns of single time steps.
+ * - TIME_SERIES: The time series of single grid points.
+ * - BALANCED: Compromise between all access patterns, i.e., all axes are split into a similar number of chunks.
+ * - DEFAULT: The chunk shape is chosen by the NetCDF library (or given explicitly by the user).
+ */
+enum class AccessPattern {
+    DEFAULT, MAPS, PROFILES, TIME_SERIES, BALANCED
+};
+/// Parses "maps", "profiles", "timeseries", "balanced" and "default". Throws an exception for unknown names.
+AccessPattern parseAccessPattern(const std::string& patternName);
+
+/**
+ * Computes the chunk shape (t, z, y, x) of a variable for an access pattern. The chunks hold at most
+ * targetChunkSize bytes (at least one entry), and horizontal tiles are kept as square as the grid allows.
+ * @param pattern The expected read access pattern (must not be AccessPattern::DEFAULT).
+ * @param ts, zs, ys, xs The extent of the variable. Absent dimensions have an extent of 1.
+ * @param entrySize The size of one entry in bytes.
+ * @param targetChunkSize The maximum size of one chunk in bytes.
+ */
+std::array<size_t, 4> computeChunkShape(
+        AccessPattern pattern, size_t ts, size_t zs, size_t ys, size_t xs, size_t entrySize, size_t targetChunkSize);
+
+/// Returns the number of chunks of size chunkSize overlapping the range [offset, offset + count).
+inline size_t countChunksSpanned(size_t offset, size_t count, size_t chunkSize) {
+    return count == 0 ? 0 : (offset + count - 1) / chunkSize - offset / chunkSize + 1;
+}
+
+/// Returns the smallest prime number >= n, as recommended for the number of hash table slots of the chunk cache.
+size_t getNextPrime(size_t n);
+
+#endif //NCCONV_CHUNKTUNING_HPP
@@ -0,0 +1,463 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#include <netcdf.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Utils/StringUtils.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "NcFieldType.hpp"
+#include "ShuffleFilter.hpp"
+#include "TimeAggregation.hpp"
+#include "VolumeData.hpp"
+#include "ConversionEstimator.hpp"
+
+/// Returns the current resident set size of the process, or 0 if it cannot be queried.
+static size_t getResidentSetSize() {
+#ifdef __linux__
+    std::ifstream statusFile("/proc/self/status");
+    std::string line;
+    while (std::getline(statusFile, line)) {
+        if (sgl::startsWith(line, "VmRSS:")) {
+            return size_t(std::strtoull(line.c_str() + 6, nullptr, 10)) * size_t(1024);
+        }
+    }
+#endif
+    return 0;
+}
+
+static std::string formatBytes(double numBytes) {
+    const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    int unitIdx = 0;
+    while (numBytes >= 1024.0 && unitIdx < 4) {
+        numBytes /= 1024.0;
+        unitIdx++;
+    }
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(unitIdx == 0 ? 0 : 2) << numBytes << " " << units[unitIdx];
+    return stream.str();
+}
+
+static std::string formatDuration(double seconds) {
+    std::ostringstream stream;
+    auto totalSeconds = static_cast<long long>(seconds + 0.5);
+    if (totalSeconds >= 3600) {
+        stream << totalSeconds / 3600 << "h " << (totalSeconds % 3600) / 60 << "min";
+    } else if (totalSeconds >= 60) {
+        stream << totalSeconds / 60 << "min " << totalSeconds % 60 << "s";
+    } else {
+        stream << std::fixed << std::setprecision(1) << seconds << "s";
+    }
+    return stream.str();
+}
+
+ConversionEstimator::ConversionEstimator(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+void ConversionEstimator::setNumSamples(int _numSamples) {
+    numSamples = std::max(_numSamples, 1);
+}
+
+void ConversionEstimator::setSampleSize(size_t _sampleSize) {
+    sampleSize = std::max(_sampleSize, size_t(1));
+}
+
+void ConversionEstimator::setIsCdf5Output(bool _isCdf5Output) {
+    isCdf5Output = _isCdf5Output;
+}
+
+void ConversionEstimator::setProbeWriteBandwidth(bool _probeWriteBandwidth) {
+    probeWriteBandwidthEnabled = _probeWriteBandwidth;
+}
+
+bool ConversionEstimator::getIsHalfOutput(FieldDataType dataType) const {
+    return outputKind != OutputKind::GRADS && volumeData->getOutputFloatType() != OutputFloatType::NATIVE
+            && getIsFieldDataTypeFloat(dataType);
+}
+
+ConversionEstimate ConversionEstimator::estimate(const std::string& outputFilePath) {
+    ConversionEstimate estimate;
+    VolumeLoader* loader = volumeData->getLoader();
+    // The output kind is selected like in the command line tool.
+    if (sgl::endsWith(outputFilePath, ".ctl")) {
+        outputKind = OutputKind::GRADS;
+    } else if (sgl::endsWith(outputFilePath, ".json")) {
+        outputKind = OutputKind::REFERENCE_INDEX;
+    } else if (sgl::endsWith(outputFilePath, ".zarr")) {
+        outputKind = OutputKind::ZARR;
+    } else {
+        outputKind = isCdf5Output ? OutputKind::CDF5 : OutputKind::NETCDF4;
+    }
+    bool isNetCdf4Output = outputKind == OutputKind::NETCDF4;
+    auto numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    auto numMembers = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    // All writers write all members, unless the NetCDF-4 writer only writes the ensemble statistics. The statistics
+    // are computed in a separate pass reading all members. Only NetCDF-4 files can store statistics and aggregates.
+    const std::vector<EnsembleStatistic>& ensembleStatistics = volumeData->getEnsembleStatistics();
+    size_t numWrittenMembers = !isNetCdf4Output || volumeData->getWriteEnsembleMembers() ? numMembers : 0;
+    size_t numStatisticReadMembers = isNetCdf4Output && !ensembleStatistics.empty() ? numMembers : 0;
+    size_t numAggregationPeriods = 0;
+    const TimeAggregation& timeAggregation = volumeData->getTimeAggregation();
+    if (isNetCdf4Output && timeAggregation.type != TimeAggregationType::NONE && numTimeSteps > 1) {
+        std::vector<int> aggregationPeriods = computeAggregationPeriods(
+                timeAggregation, volumeData->getTimeAxis(), numTimeSteps);
+        numAggregationPeriods = size_t(aggregationPeriods.back() + 1);
+    }
+
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        size_t varxs = 0, varys = 0, varzs = 0;
+        loader->getFieldExtent(fieldName, varxs, varys, varzs);
+        FieldDataType dataType = loader->getFieldDataType(fieldName);
+        size_t numEntries = varxs * varys * std::max(varzs, size_t(1));
+        size_t fieldSize = numEntries * getFieldDataTypeSize(dataType);
+        estimate.inputBytes += fieldSize * numTimeSteps * numMembers;
+        if (outputKind == OutputKind::REFERENCE_INDEX) {
+            // A reference index reads no data and stores one line per (member, time step) with the chunk key, the
+            // absolute path of the input file, the offset and the size.
+            FieldFileRange range;
+            size_t filePathLength = 64;
+            if (loader->getFieldFileRange(fieldName, 0, 0, range)) {
+                filePathLength = boost::filesystem::absolute(range.filePath).string().size();
+            }
+            estimate.outputBytes += (fieldName.size() + filePathLength + 48) * numTimeSteps * numMembers;
+            continue;
+        }
+        size_t outputFieldSize = fieldSize;
+        if (getIsHalfOutput(dataType)) {
+            outputFieldSize = numEntries * sizeof(uint16_t);
+        }
+        estimate.readBytes += fieldSize * numTimeSteps * (numWrittenMembers + numStatisticReadMembers);
+        estimate.outputBytes += outputFieldSize * numTimeSteps * numWrittenMembers;
+        if (numStatisticReadMembers > 0) {
+            estimate.outputBytes += numEntries * sizeof(float) * numTimeSteps * ensembleStatistics.size();
+        }
+        // The mean, minimum, maximum (float32) and count (int32) of each period.
+        estimate.outputBytes += numEntries * 4 * sizeof(float) * numAggregationPeriods;
+    }
+
+    bool useCompression =
+            (isNetCdf4Output || outputKind == OutputKind::ZARR)
+            && (volumeData->getDeflateLevel() > 0 || volumeData->getUseShuffleFilter());
+#ifndef USE_ZLIB
+    if (useCompression && volumeData->getDeflateLevel() > 0) {
+        std::cerr << "Warning in ConversionEstimator::estimate: Estimating the compression ratio requires building "
+                  << "with zlib. The uncompressed size is reported instead." << std::endl;
+        useCompression = false;
+    }
+#endif
+    if (outputKind != OutputKind::REFERENCE_INDEX) {
+        sampleSlabs(useCompression, estimate);
+    }
+    estimate.predictedOutputBytes = size_t(double(estimate.outputBytes) * estimate.compressionRatio);
+    if (probeWriteBandwidthEnabled) {
+        estimate.writeBandwidth = probeWriteBandwidth(outputFilePath);
+    }
+
+    // The writer reads, compresses and writes sequentially.
+    double wallTime = 0.0;
+    if (estimate.readBandwidth > 0.0) {
+        wallTime += double(estimate.readBytes) / estimate.readBandwidth;
+    }
+    if (estimate.compressionThroughput > 0.0) {
+        wallTime += double(estimate.outputBytes) / estimate.compressionThroughput;
+    }
+    if (estimate.writeBandwidth > 0.0) {
+        wallTime += double(estimate.predictedOutputBytes) / estimate.writeBandwidth;
+    }
+    estimate.wallTimeSeconds = wallTime;
+    estimate.peakMemoryBytes = getResidentSetSize() + estimateWriterMemory();
+    return estimate;
+}
+
+void ConversionEstimator::sampleSlabs(bool useCompression, ConversionEstimate& estimate) {
+    VolumeLoader* loader = volumeData->getLoader();
+    const std::vector<std::string>& fieldNames = volumeData->getFieldNames();
+    if (fieldNames.empty()) {
+        return;
+    }
+    auto numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    const std::vector<size_t>& chunkShape = volumeData->getChunkShape();
+
+    size_t numBytesRead = 0, numBytesCompressed = 0, numBytesUncompressed = 0;
+    double readTime = 0.0, compressionTime = 0.0;
+    std::vector<uint8_t> sampleData, halfSampleData, chunkData, shuffledData, compressedData;
+    for (int sampleIdx = 0; sampleIdx < numSamples; sampleIdx++) {
+        // Spread the samples over the fields, time steps and z-levels.
+        const std::string& fieldName = fieldNames.at(size_t(sampleIdx) % fieldNames.size());
+        size_t varxs = 0, varys = 0, varzs = 0;
+        loader->getFieldExtent(fieldName, varxs, varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+        FieldDataType dataType = loader->getFieldDataType(fieldName);
+        size_t entrySize = getFieldDataTypeSize(dataType);
+        size_t rowSize = varxs * entrySize;
+        FieldSlab slab;
+        slab.zOffset = size_t(sampleIdx) * varzs / size_t(numSamples);
+        slab.yCount = std::clamp(sampleSize / rowSize, size_t(1), varys);
+        slab.yOffset = (varys - slab.yCount) / 2;
+        size_t t = size_t(sampleIdx) * numTimeSteps / size_t(numSamples);
+        size_t slabSize = slab.yCount * rowSize;
+        sampleData.resize(slabSize);
+
+        auto startTime = std::chrono::steady_clock::now();
+        loader->getFieldSlabNative(volumeData, fieldName, t, 0, slab, sampleData.data());
+        auto endTime = std::chrono::steady_clock::now();
+        readTime += std::chrono::duration<double>(endTime - startTime).count();
+        numBytesRead += slabSize;
+        estimate.numSamples++;
+
+        if (!useCompression) {
+            continue;
+        }
+        // Samples of fields stored as 16-bit floats are converted like in the writer.
+        FieldDataType outputDataType = dataType;
+        size_t outputSlabSize = slabSize;
+        if (getIsHalfOutput(dataType)) {
+            size_t numEntries = slabSize / entrySize;
+            halfSampleData.resize(numEntries * sizeof(uint16_t));
+            HalfFloatStats halfFloatStats;
+            encodeHalfFloats(
+                    sampleData.data(), dataType, reinterpret_cast<uint16_t*>(halfSampleData.data()), numEntries,
+                    volumeData->getOutputFloatType(), halfFloatStats);
+            outputDataType = FieldDataType::UINT16;
+            outputSlabSize = halfSampleData.size();
+        }
+        const uint8_t* outputSampleData = outputDataType == dataType ? sampleData.data() : halfSampleData.data();
+
+        // Pass the chunks of the sample through the same filters as the writer. The deflate filter of HDF5 and the
+        // zlib codec of the Zarr writer both store the output of compress2, so the compressed chunks have the size
+        // they have in the output file without its metadata. Edge chunks are stored with the full chunk shape.
+        size_t outputEntrySize = getFieldDataTypeSize(outputDataType);
+        size_t chunkY = slab.yCount, chunkX = varxs;
+        if (!chunkShape.empty()) {
+            chunkY = std::clamp(chunkShape.at(1), size_t(1), slab.yCount);
+            chunkX = std::clamp(chunkShape.at(2), size_t(1), varxs);
+        }
+        size_t chunkNumEntries = chunkY * chunkX;
+        size_t chunkSize = chunkNumEntries * outputEntrySize;
+        bool useShuffleFilter = volumeData->getUseShuffleFilter() && outputEntrySize > 1;
+        int deflateLevel = volumeData->getDeflateLevel();
+        chunkData.resize(chunkSize);
+        shuffledData.resize(useShuffleFilter ? chunkSize : 0);
+        startTime = std::chrono::steady_clock::now();
+        for (size_t y0 = 0; y0 < slab.yCount; y0 += chunkY) {
+            for (size_t x0 = 0; x0 < varxs; x0 += chunkX) {
+                size_t numY = std::min(chunkY, slab.yCount - y0);
+                size_t rowPartSize = std::min(chunkX, varxs - x0) * outputEntrySize;
+                std::fill(chunkData.begin(), chunkData.end(), uint8_t(0));
+                for (size_t y = 0; y < numY; y++) {
+                    memcpy(chunkData.data() + y * chunkX * outputEntrySize,
+                           outputSampleData + ((y0 + y) * varxs + x0) * outputEntrySize, rowPartSize);
+                }
+                [[maybe_unused]] const uint8_t* filteredData = chunkData.data();
+                if (useShuffleFilter) {
+                    shuffleBytes(chunkData.data(), shuffledData.data(), chunkNumEntries, outputEntrySize);
+                    filteredData = shuffledData.data();
+                }
+                size_t filteredSize = chunkSize;
+#ifdef USE_ZLIB
+                if (deflateLevel > 0) {
+                    auto compressedSize = uLongf(compressBound(uLong(chunkSize)));
+                    compressedData.resize(compressedSize);
+                    if (compress2(compressedData.data(), &compressedSize, filteredData, uLong(chunkSize),
+                                  deflateLevel) != Z_OK) {
+                        throw std::runtime_error(
+                                "Error in ConversionEstimator::sampleSlabs: Compressing a sampled chunk failed.");
+                    }
+                    filteredSize = compressedSize;
+                }
+#endif
+                numBytesCompressed += filteredSize;
+            }
+        }
+        endTime = std::chrono::steady_clock::now();
+        compressionTime += std::chrono::duration<double>(endTime - startTime).count();
+        numBytesUncompressed += outputSlabSize;
+    }
+
+    if (readTime > 0.0) {
+        estimate.readBandwidth = double(numBytesRead) / readTime;
+    }
+    if (numBytesUncompressed > 0) {
+        estimate.compressionRatio = double(numBytesCompressed) / double(numBytesUncompressed);
+        if (compressionTime > 0.0) {
+            estimate.compressionThroughput = double(numBytesUncompressed) / compressionTime;
+        }
+    }
+}
+
+double ConversionEstimator::probeWriteBandwidth(const std::string& outputFilePath) {
+    // Write a short burst of data to the output directory and flush it to the storage device.
+    boost::filesystem::path outputDirectory = boost::filesystem::path(outputFilePath).parent_path();
+    if (outputDirectory.empty()) {
+        outputDirectory = boost::filesystem::current_path();
+    }
+    boost::filesystem::path probeFilePath =
+            outputDirectory / boost::filesystem::unique_path("ncconv-probe-%%%%-%%%%.bin");
+    FILE* probeFile = fopen(probeFilePath.string().c_str(), "wb");
+    if (!probeFile) {
+        std::cerr << "Warning in ConversionEstimator::probeWriteBandwidth: Couldn't create the probe file \""
+                  << probeFilePath.string() << "\"." << std::endl;
+        return 0.0;
+    }
+
+    const size_t blockSize = size_t(4) << 20;
+    const int numBlocks = 8;
+    std::vector<uint8_t> block(blockSize, 0x5a);
+    auto startTime = std::chrono::steady_clock::now();
+    size_t numBytesWritten = 0;
+    for (int blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+        numBytesWritten += fwrite(block.data(), 1, blockSize, probeFile);
+    }
+    fflush(probeFile);
+#if defined(__unix__) || defined(__APPLE__)
+    fsync(fileno(probeFile));
+#endif
+    auto endTime = std::chrono::steady_clock::now();
+    fclose(probeFile);
+    boost::system::error_code ec;
+    boost::filesystem::remove(probeFilePath, ec);
+
+    double elapsedTime = std::chrono::duration<double>(endTime - startTime).count();
+    return elapsedTime > 0.0 ? double(numBytesWritten) / elapsedTime : 0.0;
+}
+
+size_t ConversionEstimator::estimateWriterMemory() {
+    if (outputKind == OutputKind::REFERENCE_INDEX) {
+        // The references are streamed to the output file.
+        return 0;
+    }
+    bool isNetCdf4Output = outputKind == OutputKind::NETCDF4;
+    VolumeLoader* loader = volumeData->getLoader();
+    auto numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    size_t maxMemory = volumeData->getMaxMemory();
+    size_t chunkCacheSize = 0, chunkCacheNumElements = 0;
+    float chunkCachePreemption = 0.0f;
+    nc_get_chunk_cache(&chunkCacheSize, &chunkCacheNumElements, &chunkCachePreemption);
+
+    size_t maxBufferSize = 0, chunkCacheTotal = 0;
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        size_t varxs = 0, varys = 0, varzs = 0;
+        loader->getFieldExtent(fieldName, varxs, varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+        FieldDataType dataType = loader->getFieldDataType(fieldName);
+        size_t nativeEntrySize = getFieldDataTypeSize(dataType);
+        bool isHalfOutput = getIsHalfOutput(dataType);
+        size_t entrySize = isHalfOutput ? sizeof(uint16_t) : nativeEntrySize;
+        size_t levelSize = varxs * varys * entrySize;
+        size_t bufferSize;
+        if (isNetCdf4Output && volumeData->getOutputLayout() == OutputLayout::TIME_SERIES && numTimeSteps > 1) {
+            // Maps of all time steps and their transposed copy, or at most the memory budget when spilling.
+            bufferSize = 2 * levelSize * numTimeSteps;
+            if (maxMemory != 0 && bufferSize > maxMemory) {
+                bufferSize = std::max(maxMemory, levelSize + maxMemory / 2);
+            }
+        } else {
+            size_t maxSlabSize = 0;
+            for (const FieldSlab& slab : volumeData->computeFieldSlabs(varxs, varys, varzs, entrySize, 1, 1)) {
+                maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+            }
+            bufferSize = maxSlabSize * entrySize;
+            if (isHalfOutput) {
+                // Slabs are read in their native type before being converted to 16-bit floats.
+                bufferSize += maxSlabSize * nativeEntrySize;
+            }
+        }
+        if (isNetCdf4Output && volumeData->getTimeAggregation().type != TimeAggregationType::NONE
+                && numTimeSteps > 1) {
+            // Running sums (double), minima, maxima and counts of all entries, and the statistics of one period.
+            bufferSize += varxs * varys * varzs * (sizeof(double) + 3 * sizeof(float));
+            bufferSize += varxs * varys * varzs * 4 * sizeof(float);
+        }
+        const std::vector<EnsembleStatistic>& ensembleStatistics = volumeData->getEnsembleStatistics();
+        if (isNetCdf4Output && !ensembleStatistics.empty()) {
+            // Accumulators (and member values for quantiles), one member slab and the statistics of one slab.
+            bool needsQuantiles = false;
+            for (const EnsembleStatistic& statistic : ensembleStatistics) {
+                needsQuantiles = needsQuantiles || statistic.type == EnsembleStatisticType::QUANTILE;
+            }
+            size_t memoryPerEntry =
+                    EnsembleAccumulator::getMemoryPerEntry(volumeData->getEnsembleMemberCount(), needsQuantiles)
+                    + nativeEntrySize + sizeof(float) + ensembleStatistics.size() * sizeof(float);
+            size_t maxSlabSize = 0;
+            for (const FieldSlab& slab : volumeData->computeFieldSlabs(varxs, varys, varzs, memoryPerEntry, 1, 1)) {
+                maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+            }
+            maxBufferSize = std::max(maxBufferSize, maxSlabSize * memoryPerEntry);
+        }
+        maxBufferSize = std::max(maxBufferSize, bufferSize);
+        // Each open output variable may keep up to one chunk cache of (partially written) chunks.
+        chunkCacheTotal += std::min(chunkCacheSize, levelSize * varzs * numTimeSteps);
+    }
+    if (outputKind == OutputKind::GRADS) {
+        // Block buffer of the GrADS exporter; no NetCDF chunk caches are used.
+        return maxBufferSize + (size_t(4) << 20);
+    }
+    if (!isNetCdf4Output) {
+        // The CDF-5 and Zarr writers do not use the NetCDF library for the field data.
+        return maxBufferSize;
+    }
+    return maxBufferSize + chunkCacheTotal;
+}
+
+void ConversionEstimator::printEstimate(const ConversionEstimate& estimate, std::ostream& os) {
+    os << "Input data (logical):       " << formatBytes(double(estimate.inputBytes)) << std::endl;
+    os << "Output data (uncompressed): " << formatBytes(double(estimate.outputBytes)) << std::endl;
+    os << "Predicted output size:      " << formatBytes(double(estimate.predictedOutputBytes))
+       << " (compression ratio " << std::fixed << std::setprecision(3) << estimate.compressionRatio
+       << " from " << estimate.numSamples << " sampled slabs)" << std::endl;
+    os << "Read bandwidth (sampled):   " << formatBytes(estimate.readBandwidth) << "/s" << std::endl;
+    if (estimate.compressionThroughput > 0.0) {
+        os << "Compression throughput:     " << formatBytes(estimate.compressionThroughput) << "/s" << std::endl;
+    }
+    if (estimate.writeBandwidth > 0.0) {
+        os << "Write bandwidth (probe):    " << formatBytes(estimate.writeBandwidth) << "/s" << std::endl;
+    } else {
+        os << "Write bandwidth (probe):    not measured (the wall time excludes writing)" << std::endl;
+    }
+    os << "Predicted peak RSS:         " << formatBytes(double(estimate.peakMemoryBytes)) << std::endl;
+    os << "Predicted wall time:        " << formatDuration(estimate.wallTimeSeconds) << std::endl;
+}
@@ -0,0 +1,100 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_CONVERSIONESTIMATOR_HPP
+#define NCCONV_CONVERSIONESTIMATOR_HPP
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+#include "FieldType.hpp"
+
+class VolumeData;
+
+struct ConversionEstimate {
+    size_t inputBytes = 0; ///< Logical size of all input fields (all members and time steps).
+    size_t readBytes = 0; ///< Bytes read from the input during the conversion.
+    size_t outputBytes = 0; ///< Logical (i.e., uncompressed) size of the output variables.
+    size_t predictedOutputBytes = 0; ///< Output size after compression, estimated from the sampled slabs.
+    double compressionRatio = 1.0; ///< Compressed size of the sampled chunks divided by their uncompressed size.
+    double compressionThroughput = 0.0; ///< Uncompressed bytes per second (0 if compression is disabled).
+    double readBandwidth = 0.0; ///< Bytes per second when reading the sampled slabs.
+    double writeBandwidth = 0.0; ///< Bytes per second of the write probe in the output directory (0 if not probed).
+    size_t peakMemoryBytes = 0; ///< Predicted peak resident set size of the process.
+    double wallTimeSeconds = 0.0;
+    int numSamples = 0;
+};
+
+/**
+ * Predicts the resources needed for a conversion without converting, e.g., for requesting cluster resources.
+ * - The logical byte counts are computed from the field extents and data types reported by the loader, for the kind of
+ *   output selected by the file extension (NetCDF-4, CDF-5, GrADS, Zarr or a reference index) and the options
+ *   changing the written variables (16-bit floats, temporal aggregates and ensemble statistics).
+ * - A few slabs are read and their chunks are passed through the configured filters (shuffle and deflate, as applied
+ *   by HDF5 and the Zarr writer), which yields the read bandwidth, the compression ratio and the compression
+ *   throughput. Only the compressed chunk bytes are counted, so the file metadata does not distort the ratio.
+ * - Optionally, a short write probe in the output directory measures the write bandwidth.
+ * - The peak memory is the current resident set size plus the buffers and chunk caches used by the writer.
+ */
+class ConversionEstimator {
+public:
+    explicit ConversionEstimator(VolumeData* volumeData);
+    /// Number of slabs sampled for the compression estimate (default: 4).
+    void setNumSamples(int _numSamples);
+    /// Size in bytes of each sampled slab (default: 4 MiB). Smaller fields are sampled as a whole.
+    void setSampleSize(size_t _sampleSize);
+    /// Whether .nc output files are written in the CDF-5 format (@see Cdf5Writer) instead of NetCDF-4.
+    void setIsCdf5Output(bool _isCdf5Output);
+    /**
+     * Whether to measure the write bandwidth by writing and deleting 32 MiB in the output directory (default: false).
+     * Otherwise, the predicted wall time does not include writing the output.
+     */
+    void setProbeWriteBandwidth(bool _probeWriteBandwidth);
+    ConversionEstimate estimate(const std::string& outputFilePath);
+    static void printEstimate(const ConversionEstimate& estimate, std::ostream& os);
+
+private:
+    enum class OutputKind {
+        NETCDF4, CDF5, GRADS, ZARR, REFERENCE_INDEX
+    };
+    void sampleSlabs(bool useCompression, ConversionEstimate& estimate);
+    double probeWriteBandwidth(const std::string& outputFilePath);
+    size_t estimateWriterMemory();
+    /// Whether fields of the passed data type are stored as 16-bit floats in the output.
+    [[nodiscard]] bool getIsHalfOutput(FieldDataType dataType) const;
+
+    VolumeData* volumeData;
+    int numSamples = 4;
+    size_t sampleSize = size_t(4) << 20;
+    bool isCdf5Output = false;
+    bool probeWriteBandwidthEnabled = false;
+    OutputKind outputKind = OutputKind::NETCDF4;
+};
+
+#endif //NCCONV_CONVERSIONESTIMATOR_HPP
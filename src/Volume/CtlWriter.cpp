@@ -0,0 +1,273 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Loaders/VolumeLoader.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "VolumeData.hpp"
+#include "CtlWriter.hpp"
+
+/// Inverse of the data type encoding parsed by CtlLoader (see parseVarDataType in CtlLoader.cpp).
+static const char* getCtlUnitsString(FieldDataType dataType) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return "-1,40,1,-1";
+        case FieldDataType::UINT8:
+            return "-1,40,1";
+        case FieldDataType::INT16:
+            return "-1,40,2,-1";
+        case FieldDataType::UINT16:
+            return "-1,40,2";
+        case FieldDataType::INT32:
+            return "-1,40,4";
+        case FieldDataType::FLOAT32:
+            return "99";
+        case FieldDataType::FLOAT64:
+            return "-1,40,8";
+    }
+    return "99";
+}
+
+/// Writes a xdef/ydef/zdef entry, using the compact "linear" mapping if the coordinates are uniformly spaced.
+static void writeCtlDimensionDef(std::ofstream& file, const std::string& key, const float* coords, size_t dimLen) {
+    float step = dimLen > 1 ? coords[1] - coords[0] : 1.0f;
+    bool isLinear = true;
+    for (size_t i = 0; i < dimLen && isLinear; i++) {
+        float expected = coords[0] + step * float(i);
+        isLinear = std::abs(coords[i] - expected) <= 1e-5f * std::max(std::abs(step), 1.0f);
+    }
+    if (isLinear) {
+        file << key << " " << dimLen << " linear " << coords[0] << " " << step << "\n";
+        return;
+    }
+    file << key << " " << dimLen << " levels";
+    for (size_t i = 0; i < dimLen; i++) {
+        file << (i % 8 == 0 ? "\n" : " ") << coords[i];
+    }
+    file << "\n";
+}
+
+CtlWriter::CtlWriter(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+void CtlWriter::setIsBigEndian(bool _isBigEndian) {
+    isBigEndian = _isBigEndian;
+}
+
+bool CtlWriter::writeToFile(const std::string& ctlFilePath) {
+    volumeData->checkSequentialReadSettings();
+    // The GrADS format has no parallel write support; with MPI, the first rank writes the whole data set.
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+    if (mpiRank != 0) {
+        return true;
+    }
+
+    boost::filesystem::path datFilePath(ctlFilePath);
+    datFilePath.replace_extension(".dat");
+    double undefValue = 0.0;
+    getUndefValue(undefValue);
+    writeDescriptor(ctlFilePath, datFilePath.filename().string(), undefValue);
+    writeData(datFilePath.string(), undefValue);
+    return true;
+}
+
+bool CtlWriter::getUndefValue(double& undefValue) {
+    // GrADS uses one undef value for all variables. Integer variables keep their fill value, so the fill value of
+    // the first integer variable is used. Floating point variables map NaN to it.
+    VolumeLoader* loader = volumeData->getLoader();
+    bool hasIntegerFill = false;
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        double fillValue = 0.0;
+        if (!loader->getFieldFillValue(fieldName, fillValue)) {
+            continue;
+        }
+        if (!hasIntegerFill) {
+            undefValue = fillValue;
+            hasIntegerFill = true;
+        } else if (fillValue != undefValue) {
+            std::cerr << "Warning in CtlWriter::getUndefValue: The fill value of variable \"" << fieldName
+                      << "\" differs from the undef value " << undefValue << "." << std::endl;
+        }
+    }
+    if (hasIntegerFill) {
+        return true;
+    }
+
+    // Without integer variables, the undef value of the input data set is kept if it is known.
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        double fillValue = 0.0;
+        if (loader->getFieldInputFillValue(fieldName, fillValue)
+                && getIsFillValueRepresentable(FieldDataType::FLOAT32, fillValue)) {
+            undefValue = fillValue;
+            return false;
+        }
+    }
+    undefValue = -9.99e8;
+    return false;
+}
+
+void CtlWriter::writeDescriptor(
+        const std::string& ctlFilePath, const std::string& datFileName, double undefValue) {
+    std::ofstream file(ctlFilePath);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+                "Error in CtlWriter::writeDescriptor: Couldn't open file \"" + ctlFilePath + "\" for writing.");
+    }
+    file << std::setprecision(9);
+
+    VolumeLoader* loader = volumeData->getLoader();
+    size_t xs = volumeData->getGridSizeX();
+    size_t ys = volumeData->getGridSizeY();
+    size_t zs = std::max(volumeData->getGridSizeZ(), size_t(1));
+    size_t ts = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    size_t es = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+
+    file << "dset ^" << datFileName << "\n";
+    file << "options " << (isBigEndian ? "big_endian" : "little_endian") << "\n";
+    file << "undef " << undefValue << "\n";
+    writeCtlDimensionDef(file, "xdef", volumeData->getLon1d(), xs);
+    writeCtlDimensionDef(file, "ydef", volumeData->getLat1d(), ys);
+    if (volumeData->getLev1d()) {
+        writeCtlDimensionDef(file, "zdef", volumeData->getLev1d(), zs);
+    } else {
+        file << "zdef " << zs << " linear 0 1\n";
+    }
+    if (volumeData->getTimeAxis()) {
+        file << "tdef " << ts << " linear " << formatGradsTimeAxis(*volumeData->getTimeAxis()) << "\n";
+    } else {
+        file << "* The time axis of the source data set is not known; the start time and increment are placeholders.\n";
+        file << "tdef " << ts << " linear 00Z01JAN2000 1hr\n";
+    }
+    if (es > 1) {
+        file << "edef " << es << " names";
+        for (size_t e = 0; e < es; e++) {
+            file << " " << (e + 1);
+        }
+        file << "\n";
+    }
+
+    const std::vector<std::string>& fieldNames = volumeData->getFieldNames();
+    file << "vars " << fieldNames.size() << "\n";
+    for (const std::string& fieldName : fieldNames) {
+        size_t varxs = 0, varys = 0, varzs = 0;
+        loader->getFieldExtent(fieldName, varxs, varys, varzs);
+        if (varxs != xs || varys != ys) {
+            throw std::runtime_error(
+                    "Error in CtlWriter::writeDescriptor: Variable \"" + fieldName + "\" has a different grid.");
+        }
+        file << fieldName << " " << (varzs > 1 ? varzs : 0) << " "
+             << getCtlUnitsString(loader->getFieldDataType(fieldName)) << " " << fieldName << "\n";
+    }
+    file << "endvars\n";
+    if (!file.good()) {
+        throw std::runtime_error(
+                "Error in CtlWriter::writeDescriptor: Writing to file \"" + ctlFilePath + "\" failed.");
+    }
+}
+
+void CtlWriter::writeData(const std::string& datFilePath, double undefValue) {
+    FILE* file = fopen(datFilePath.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error(
+                "Error in CtlWriter::writeData: Couldn't open file \"" + datFilePath + "\" for writing.");
+    }
+    // The blocks are passed to the OS without further buffering by the C library.
+    setvbuf(file, nullptr, _IONBF, 0);
+
+    // Slabs are decoded directly into the write buffer and encoded in-place. Whenever at least one block is full,
+    // all full blocks are written with one call and the remainder is moved to the front of the buffer. This way,
+    // all writes except for the last one have a size (and file offset) that is a multiple of the block size.
+    const size_t blockSize = size_t(4) << 20;
+    std::vector<uint8_t> buffer(blockSize);
+    size_t bufferUsed = 0;
+    auto writeBytes = [&](size_t numBytes) {
+        if (fwrite(buffer.data(), 1, numBytes, file) != numBytes) {
+            fclose(file);
+            throw std::runtime_error(
+                    "Error in CtlWriter::writeData: Writing to file \"" + datFilePath + "\" failed.");
+        }
+    };
+
+    VolumeLoader* loader = volumeData->getLoader();
+    const std::vector<std::string>& fieldNames = volumeData->getFieldNames();
+    size_t ts = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    size_t es = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    for (size_t e = 0; e < es; e++) {
+        for (size_t t = 0; t < ts; t++) {
+            for (const std::string& fieldName : fieldNames) {
+                size_t varxs = 0, varys = 0, varzs = 0;
+                loader->getFieldExtent(fieldName, varxs, varys, varzs);
+                varzs = std::max(varzs, size_t(1));
+                FieldDataType dataType = loader->getFieldDataType(fieldName);
+                size_t entrySize = getFieldDataTypeSize(dataType);
+                std::vector<FieldSlab> slabs = volumeData->computeFieldSlabs(varxs, varys, varzs, entrySize, 1, 1);
+                for (const FieldSlab& slab : slabs) {
+                    size_t numEntries = slab.zCount * slab.yCount * varxs;
+                    size_t slabSize = numEntries * entrySize;
+                    if (bufferUsed + slabSize > buffer.size()) {
+                        buffer.resize(bufferUsed + slabSize);
+                    }
+                    uint8_t* slabData = buffer.data() + bufferUsed;
+                    loader->getFieldSlabNative(volumeData, fieldName, t, e, slab, slabData);
+                    encodeFieldEntries(slabData, dataType, slabData, numEntries, isBigEndian, undefValue);
+                    bufferUsed += slabSize;
+                    if (bufferUsed >= blockSize) {
+                        size_t numBytesFullBlocks = bufferUsed - bufferUsed % blockSize;
+                        writeBytes(numBytesFullBlocks);
+                        memmove(buffer.data(), buffer.data() + numBytesFullBlocks, bufferUsed - numBytesFullBlocks);
+                        bufferUsed -= numBytesFullBlocks;
+                    }
+                }
+            }
+        }
+    }
+    if (bufferUsed > 0) {
+        writeBytes(bufferUsed);
+    }
+
+    if (fclose(file) != 0) {
+        throw std::runtime_error(
+                "Error in CtlWriter::writeData: Closing file \"" + datFilePath + "\" failed.");
+    }
+}
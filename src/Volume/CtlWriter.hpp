@@ -0,0 +1,61 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_CTLWRITER_HPP
+#define NCCONV_CTLWRITER_HPP
+
+#include <string>
+#include "VolumeWriter.hpp"
+
+class VolumeData;
+
+/**
+ * Exports a data set to the GrADS format, i.e., a .ctl descriptor and a .dat binary file in the order
+ * es > ts > var > zs > ys > xs expected by @see CtlLoader.
+ * The fields are streamed slab by slab. NaN entries are replaced by the undef value and the bytes are swapped (if
+ * requested) in one pass, and the data is written in large blocks of equal size.
+ */
+class CtlWriter : public VolumeWriter {
+public:
+    explicit CtlWriter(VolumeData* volumeData);
+    /// Whether to write the binary data in big endian byte order (default: little endian).
+    void setIsBigEndian(bool _isBigEndian);
+    /// The .dat file is created next to the .ctl file with the same base name.
+    bool writeToFile(const std::string& ctlFilePath) override;
+
+private:
+    bool getUndefValue(double& undefValue);
+    void writeDescriptor(
+            const std::string& ctlFilePath, const std::string& datFileName, double undefValue);
+    void writeData(const std::string& datFilePath, double undefValue);
+
+    VolumeData* volumeData;
+    bool isBigEndian = false;
+};
+
+#endif //NCCONV_CTLWRITER_HPP
@@ -0,0 +1,314 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#include <hdf5.h>
+#include <zlib.h>
+
+#include "Utils/Hash.hpp"
+#include "Utils/TaskScheduler.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "ShuffleFilter.hpp"
+#include "VolumeData.hpp"
+#include "DirectChunkWriter.hpp"
+
+/// Checks that the filter pipeline of the data set is (shuffle, deflate) or a subset thereof in this order.
+static bool getHasExpectedFilters(hid_t datasetId, bool useShuffleFilter, bool useDeflate) {
+    hid_t plistId = H5Dget_create_plist(datasetId);
+    std::vector<H5Z_filter_t> expectedFilters;
+    if (useShuffleFilter) {
+        expectedFilters.push_back(H5Z_FILTER_SHUFFLE);
+    }
+    if (useDeflate) {
+        expectedFilters.push_back(H5Z_FILTER_DEFLATE);
+    }
+    int numFilters = H5Pget_nfilters(plistId);
+    bool hasExpectedFilters = numFilters == int(expectedFilters.size());
+    for (int filterIdx = 0; hasExpectedFilters && filterIdx < numFilters; filterIdx++) {
+        unsigned int flags = 0, filterConfig = 0;
+        size_t numValues = 0;
+        H5Z_filter_t filter = H5Pget_filter2(
+                plistId, unsigned(filterIdx), &flags, &numValues, nullptr, 0, nullptr, &filterConfig);
+        hasExpectedFilters = filter == expectedFilters.at(filterIdx);
+    }
+    H5Pclose(plistId);
+    return hasExpectedFilters;
+}
+
+DirectChunkWriter::DirectChunkWriter(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+std::vector<std::vector<unsigned long long>> DirectChunkWriter::writeFields(
+        const std::string& filePath, const std::vector<DirectChunkField>& fields) {
+    std::vector<std::vector<unsigned long long>> fieldSlabHashes(fields.size());
+    hid_t fileId = H5Fopen(filePath.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+    if (fileId < 0) {
+        throw std::runtime_error(
+                "Error in DirectChunkWriter::writeFields: H5Fopen failed for file \"" + filePath + "\".");
+    }
+    try {
+        for (size_t fieldIdx = 0; fieldIdx < fields.size(); fieldIdx++) {
+            writeField(fileId, fields.at(fieldIdx), fieldSlabHashes.at(fieldIdx));
+        }
+    } catch (...) {
+        H5Fclose(fileId);
+        throw;
+    }
+    if (H5Fclose(fileId) < 0) {
+        throw std::runtime_error(
+                "Error in DirectChunkWriter::writeFields: H5Fclose failed for file \"" + filePath + "\".");
+    }
+    return fieldSlabHashes;
+}
+
+void DirectChunkWriter::writeField(
+        int64_t fileId, const DirectChunkField& field, std::vector<unsigned long long>& slabHashes) {
+    const std::string& fieldName = field.fieldName;
+    // Variables sharing the name of a dimension without being its coordinate variable are renamed by NetCDF.
+    hid_t datasetId = -1;
+    H5E_BEGIN_TRY {
+        datasetId = H5Dopen2(fileId, fieldName.c_str(), H5P_DEFAULT);
+        if (datasetId < 0) {
+            datasetId = H5Dopen2(fileId, ("_nc4_non_coord_" + fieldName).c_str(), H5P_DEFAULT);
+        }
+    } H5E_END_TRY;
+    if (datasetId < 0) {
+        throw std::runtime_error(
+                "Error in DirectChunkWriter::writeField: Couldn't open the HDF5 data set of variable \""
+                + fieldName + "\".");
+    }
+    int deflateLevel = volumeData->getDeflateLevel();
+    bool useShuffleFilter = volumeData->getUseShuffleFilter();
+    if (!getHasExpectedFilters(datasetId, useShuffleFilter, deflateLevel > 0)) {
+        H5Dclose(datasetId);
+        throw std::runtime_error(
+                "Error in DirectChunkWriter::writeField: Unexpected filter pipeline of variable \"" + fieldName
+                + "\".");
+    }
+
+    VolumeLoader* volumeLoader = volumeData->getLoader();
+    size_t varxs = 0, varys = 0, varzs = 0;
+    volumeLoader->getFieldExtent(fieldName, varxs, varys, varzs);
+    // Fields converted to 16-bit floats are written as their bit patterns (see VolumeData::setOutputFloatType).
+    FieldDataType nativeDataType = volumeLoader->getFieldDataType(fieldName);
+    OutputFloatType outputFloatType = volumeData->getOutputFloatType();
+    bool isHalfOutput = outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(nativeDataType);
+    FieldDataType dataType = isHalfOutput ? FieldDataType::UINT16 : nativeDataType;
+    auto entrySize = size_t(getFieldDataTypeSize(dataType));
+    size_t numTimeSteps = field.numTimeSteps;
+    const std::vector<size_t>& chunkSizes = field.chunkSizes;
+    size_t chunkT = field.hasTimeDim ? chunkSizes.front() : 1;
+    size_t chunkZ = field.hasZDim ? chunkSizes.at(field.hasTimeDim ? 1 : 0) : 1;
+    size_t chunkY = chunkSizes.at(chunkSizes.size() - 2);
+    size_t chunkX = chunkSizes.back();
+    size_t chunkNumEntries = chunkT * chunkZ * chunkY * chunkX;
+    size_t chunkSize = chunkNumEntries * entrySize;
+    bool recordSlabHashes = volumeData->getRecordSlabHashes();
+    double fillValue = 0.0;
+    bool hasFillValue = volumeLoader->getFieldFillValue(fieldName, fillValue);
+    if (isHalfOutput) {
+        hasFillValue = true;
+        fillValue = double(getOutputFloatTypeNaN(outputFloatType));
+    }
+    std::vector<uint8_t> nativeSlabData;
+    HalfFloatStats halfFloatStats;
+    if (recordSlabHashes) {
+        slabHashes.assign(numTimeSteps * field.slabs.size(), 0);
+    }
+
+    std::vector<uint8_t> blockData;
+    std::vector<unsigned long long> blockHashes, previousBlockHashes;
+    size_t numDuplicateBlocks = 0, numSkippedChunks = 0;
+    std::vector<std::vector<uint8_t>> compressedChunks;
+    // Chunks without valid entries are not written, as the fill value of the variable represents missing entries.
+    std::vector<uint8_t> isChunkMissing;
+    std::vector<hsize_t> offset(chunkSizes.size(), 0);
+    for (size_t slabIdx = 0; slabIdx < field.slabs.size(); slabIdx++) {
+        const FieldSlab& slab = field.slabs.at(slabIdx);
+        size_t rowSize = varxs * entrySize;
+        size_t slabSize = slab.zCount * slab.yCount * rowSize;
+        size_t numChunksZ = (slab.zCount + chunkZ - 1) / chunkZ;
+        size_t numChunksY = (slab.yCount + chunkY - 1) / chunkY;
+        size_t numChunksX = (varxs + chunkX - 1) / chunkX;
+        size_t numChunks = numChunksZ * numChunksY * numChunksX;
+        compressedChunks.resize(numChunks);
+        isChunkMissing.resize(numChunks);
+
+        // The chunks of chunkT time steps of the slab are complete at once.
+        for (size_t t0 = 0; t0 < numTimeSteps; t0 += chunkT) {
+            size_t numBlockTimeSteps = std::min(chunkT, numTimeSteps - t0);
+            blockData.resize(numBlockTimeSteps * slabSize);
+            blockHashes.resize(numBlockTimeSteps);
+            for (size_t tt = 0; tt < numBlockTimeSteps; tt++) {
+                uint8_t* slabData = blockData.data() + tt * slabSize;
+                if (isHalfOutput) {
+                    nativeSlabData.resize(slabSize / entrySize * getFieldDataTypeSize(nativeDataType));
+                    volumeLoader->getFieldSlabNative(
+                            volumeData, fieldName, t0 + tt, 0, slab, nativeSlabData.data());
+                    encodeHalfFloats(
+                            nativeSlabData.data(), nativeDataType, reinterpret_cast<uint16_t*>(slabData),
+                            slabSize / entrySize, outputFloatType, halfFloatStats);
+                } else {
+                    volumeLoader->getFieldSlabNative(volumeData, fieldName, t0 + tt, 0, slab, slabData);
+                }
+                canonicalizeNaNs(slabData, dataType, slabSize / entrySize);
+                blockHashes.at(tt) = sgl::hashXXH64Parallel(slabData, slabSize);
+                if (recordSlabHashes) {
+                    slabHashes.at((t0 + tt) * field.slabs.size() + slabIdx) = blockHashes.at(tt);
+                }
+            }
+
+            // Static fields are often repeated in every time step. If the block is identical to the previous block of
+            // the slab, the compressed chunks of the previous block are written again without compressing them.
+            bool isDuplicateBlock = t0 > 0 && blockHashes == previousBlockHashes;
+            std::swap(blockHashes, previousBlockHashes);
+            if (isDuplicateBlock) {
+                numDuplicateBlocks++;
+            } else {
+                std::atomic<bool> hasCompressionFailed{false};
+                sgl::parallelFor(0, numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+                    // The buffers are reused by all chunks compressed on the same thread.
+                    static thread_local std::vector<uint8_t> chunkData, shuffledData;
+                    chunkData.resize(chunkSize);
+                    shuffledData.resize(useShuffleFilter ? chunkSize : 0);
+                    for (size_t chunkIdx = chunkBegin; chunkIdx < chunkEnd; chunkIdx++) {
+                        size_t xc = chunkIdx % numChunksX;
+                        size_t yc = (chunkIdx / numChunksX) % numChunksY;
+                        size_t zc = chunkIdx / (numChunksX * numChunksY);
+                        size_t x0 = xc * chunkX;
+                        size_t numX = std::min(chunkX, varxs - x0);
+                        size_t rowPartSize = numX * entrySize;
+                        size_t numZ = std::min(chunkZ, slab.zCount - zc * chunkZ);
+                        size_t numY = std::min(chunkY, slab.yCount - yc * chunkY);
+                        bool isMissing = true;
+                        for (size_t tt = 0; tt < numBlockTimeSteps && isMissing; tt++) {
+                            for (size_t z = 0; z < numZ && isMissing; z++) {
+                                for (size_t y = 0; y < numY && isMissing; y++) {
+                                    const uint8_t* srcRow =
+                                            blockData.data() + tt * slabSize
+                                            + ((zc * chunkZ + z) * slab.yCount + yc * chunkY + y) * rowSize;
+                                    isMissing = getAreEntriesMissing(
+                                            srcRow + x0 * entrySize, dataType, numX, hasFillValue, fillValue);
+                                }
+                            }
+                        }
+                        isChunkMissing.at(chunkIdx) = isMissing ? 1 : 0;
+                        if (isMissing) {
+                            continue;
+                        }
+
+                        // Gather the chunk from the slabs; entries outside of the grid are zero.
+                        std::fill(chunkData.begin(), chunkData.end(), uint8_t(0));
+                        for (size_t tt = 0; tt < numBlockTimeSteps; tt++) {
+                            for (size_t z = 0; z < numZ; z++) {
+                                for (size_t y = 0; y < numY; y++) {
+                                    const uint8_t* srcRow =
+                                            blockData.data() + tt * slabSize
+                                            + ((zc * chunkZ + z) * slab.yCount + yc * chunkY + y) * rowSize;
+                                    uint8_t* dstRow =
+                                            chunkData.data() + (((tt * chunkZ + z) * chunkY + y) * chunkX) * entrySize;
+                                    memcpy(dstRow, srcRow + x0 * entrySize, rowPartSize);
+                                }
+                            }
+                        }
+
+                        const uint8_t* filteredData = chunkData.data();
+                        if (useShuffleFilter) {
+                            shuffleBytes(chunkData.data(), shuffledData.data(), chunkNumEntries, entrySize);
+                            filteredData = shuffledData.data();
+                        }
+                        std::vector<uint8_t>& compressedChunk = compressedChunks.at(chunkIdx);
+                        if (deflateLevel > 0) {
+                            auto compressedSize = uLongf(compressBound(uLong(chunkSize)));
+                            compressedChunk.resize(compressedSize);
+                            if (compress2(compressedChunk.data(), &compressedSize, filteredData, uLong(chunkSize),
+                                          deflateLevel) != Z_OK) {
+                                hasCompressionFailed = true;
+                            }
+                            compressedChunk.resize(compressedSize);
+                        } else {
+                            compressedChunk.assign(filteredData, filteredData + chunkSize);
+                        }
+                    }
+                });
+                if (hasCompressionFailed) {
+                    H5Dclose(datasetId);
+                    throw std::runtime_error(
+                            "Error in DirectChunkWriter::writeField: Compressing a chunk of variable \"" + fieldName
+                            + "\" failed.");
+                }
+            }
+
+            // HDF5 is not thread-safe, so the chunks are written serially.
+            for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+                if (isChunkMissing.at(chunkIdx)) {
+                    numSkippedChunks++;
+                    continue;
+                }
+                size_t xc = chunkIdx % numChunksX;
+                size_t yc = (chunkIdx / numChunksX) % numChunksY;
+                size_t zc = chunkIdx / (numChunksX * numChunksY);
+                size_t dimIdx = 0;
+                if (field.hasTimeDim) {
+                    offset.at(dimIdx++) = hsize_t(t0);
+                }
+                if (field.hasZDim) {
+                    offset.at(dimIdx++) = hsize_t(slab.zOffset + zc * chunkZ);
+                }
+                offset.at(dimIdx++) = hsize_t(slab.yOffset + yc * chunkY);
+                offset.at(dimIdx) = hsize_t(xc * chunkX);
+                const std::vector<uint8_t>& compressedChunk = compressedChunks.at(chunkIdx);
+                if (H5Dwrite_chunk(
+                        datasetId, H5P_DEFAULT, 0, offset.data(), compressedChunk.size(),
+                        compressedChunk.data()) < 0) {
+                    H5Dclose(datasetId);
+                    throw std::runtime_error(
+                            "Error in DirectChunkWriter::writeField: H5Dwrite_chunk failed for variable \""
+                            + fieldName + "\".");
+                }
+            }
+        }
+    }
+    H5Dclose(datasetId);
+    if (isHalfOutput) {
+        volumeData->reportHalfFloatStats(fieldName, halfFloatStats);
+    }
+    if (numDuplicateBlocks > 0 && volumeData->getIsVerbose()) {
+        std::cout << "Reused the compressed chunks of " << numDuplicateBlocks << " identical slab(s) of variable '"
+                  << fieldName << "'." << std::endl;
+    }
+    if (numSkippedChunks > 0 && volumeData->getIsVerbose()) {
+        std::cout << "Skipped " << numSkippedChunks << " chunk(s) of variable '" << fieldName
+                  << "' without valid entries." << std::endl;
+    }
+}
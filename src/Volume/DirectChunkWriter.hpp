@@ -0,0 +1,75 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_DIRECTCHUNKWRITER_HPP
+#define NCCONV_DIRECTCHUNKWRITER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Loaders/VolumeLoader.hpp"
+
+class VolumeData;
+
+/// A variable defined by VolumeData::writeToNcHandle whose data is written by @see DirectChunkWriter.
+struct DirectChunkField {
+    std::string fieldName;
+    std::vector<FieldSlab> slabs; ///< Slabs aligned with the chunk shape in z and y.
+    std::vector<size_t> chunkSizes; ///< Chunk shape in the dimension order of the variable.
+    size_t numTimeSteps = 1; ///< 1 for time-invariant fields written without the time dimension.
+    bool hasTimeDim = false;
+    bool hasZDim = false;
+};
+
+/**
+ * Writes compressed variables of a NetCDF-4 file with the HDF5 direct chunk write API (H5Dwrite_chunk). HDF5 applies
+ * the filter pipeline of a variable serially inside of nc_put_vara, so the compression is limited to one core.
+ * Instead, the chunks of each slab are shuffled and deflated in parallel on the compute pool and then passed to HDF5
+ * pre-filtered. The variables, including their filter pipeline, are defined by the NetCDF library beforehand, so the
+ * result is a standard NetCDF-4 file readable by any NetCDF library.
+ * Only available when built with USE_HDF5_DIRECT_CHUNK_WRITE, and not with MPI. The HDF5 library needs to be the
+ * one the NetCDF library was built against.
+ */
+class DirectChunkWriter {
+public:
+    explicit DirectChunkWriter(VolumeData* volumeData);
+    /**
+     * Writes the data of the passed fields into the file created (and closed again) by the NetCDF library.
+     * @return The XXH64 hashes of the (time step, slab) pairs of each field, if recording them is enabled.
+     */
+    std::vector<std::vector<unsigned long long>> writeFields(
+            const std::string& filePath, const std::vector<DirectChunkField>& fields);
+
+private:
+    void writeField(int64_t fileId, const DirectChunkField& field, std::vector<unsigned long long>& slabHashes);
+
+    VolumeData* volumeData;
+};
+
+#endif //NCCONV_DIRECTCHUNKWRITER_HPP
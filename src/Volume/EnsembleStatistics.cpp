@@ -0,0 +1,212 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Utils/StringUtils.hpp"
+#include "Utils/TaskScheduler.hpp"
+#include "EnsembleStatistics.hpp"
+
+static const size_t STATISTICS_GRAIN_SIZE = size_t(1) << 16;
+/// Number of entries whose member values are transposed into a contiguous block before computing their quantiles.
+static const size_t QUANTILE_BLOCK_SIZE = 256;
+/// Up to this number of values, quantiles are computed with an insertion sort instead of std::sort.
+static const int SMALL_SORT_SIZE = 32;
+
+std::vector<EnsembleStatistic> parseEnsembleStatistics(const std::string& statisticsString) {
+    std::vector<std::string> statisticNames;
+    sgl::splitString(statisticsString, ',', statisticNames);
+    std::vector<EnsembleStatistic> statistics;
+    for (const std::string& statisticName : statisticNames) {
+        EnsembleStatistic statistic;
+        statistic.name = statisticName;
+        if (statisticName == "mean") {
+            statistic.type = EnsembleStatisticType::MEAN;
+        } else if (statisticName == "std") {
+            statistic.type = EnsembleStatisticType::STD;
+        } else if (statisticName == "median" || (statisticName.size() > 1 && statisticName.front() == 'p')) {
+            statistic.type = EnsembleStatisticType::QUANTILE;
+            double percentile = 50.0;
+            if (statisticName != "median") {
+                std::string percentileString = statisticName.substr(1);
+                size_t pos = 0;
+                try {
+                    percentile = std::stod(percentileString, &pos);
+                } catch (const std::exception&) {
+                    pos = 0;
+                }
+                if (pos == 0 || pos != percentileString.size() || !(percentile >= 0.0 && percentile <= 100.0)) {
+                    throw std::runtime_error(
+                            "Error in parseEnsembleStatistics: Invalid percentile \"" + statisticName + "\".");
+                }
+            }
+            statistic.quantile = float(percentile / 100.0);
+        } else {
+            throw std::runtime_error(
+                    "Error in parseEnsembleStatistics: Unknown statistic \"" + statisticName
+                    + "\". Expected 'mean', 'std', 'median' or a percentile like 'p90'.");
+        }
+        for (const EnsembleStatistic& otherStatistic : statistics) {
+            if (otherStatistic.name == statistic.name) {
+                throw std::runtime_error(
+                        "Error in parseEnsembleStatistics: Statistic \"" + statisticName + "\" is passed twice.");
+            }
+        }
+        statistics.push_back(statistic);
+    }
+    return statistics;
+}
+
+/**
+ * Welford update of the mean and sum of squared deviations with the entries of one member. Missing entries are replaced
+ * by the current mean, so that they leave the accumulators unchanged and the loop stays free of branches.
+ */
+static void updateWelford(const float* values, float* mean, float* m2, int32_t* count, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        float value = values[i];
+        float oldMean = mean[i];
+        bool isValid = value == value;
+        float validValue = isValid ? value : oldMean;
+        int32_t newCount = count[i] + int32_t(isValid);
+        float delta = validValue - oldMean;
+        float newMean = oldMean + delta / float(std::max(newCount, 1));
+        mean[i] = newMean;
+        m2[i] = m2[i] + delta * (validValue - newMean);
+        count[i] = newCount;
+    }
+}
+
+static void insertionSort(float* values, int n) {
+    for (int i = 1; i < n; i++) {
+        float value = values[i];
+        int j = i - 1;
+        for (; j >= 0 && values[j] > value; j--) {
+            values[j + 1] = values[j];
+        }
+        values[j + 1] = value;
+    }
+}
+
+EnsembleAccumulator::EnsembleAccumulator(size_t numMembers, bool needsQuantiles)
+        : numMembers(numMembers), needsQuantiles(needsQuantiles) {
+}
+
+size_t EnsembleAccumulator::getMemoryPerEntry(size_t numMembers, bool needsQuantiles) {
+    return 2 * sizeof(float) + sizeof(int32_t) + (needsQuantiles ? numMembers * sizeof(float) : 0);
+}
+
+void EnsembleAccumulator::reset(size_t _numEntries) {
+    numEntries = _numEntries;
+    mean.assign(numEntries, 0.0f);
+    m2.assign(numEntries, 0.0f);
+    count.assign(numEntries, 0);
+    if (needsQuantiles) {
+        memberValues.resize(numEntries * numMembers);
+    }
+}
+
+void EnsembleAccumulator::addMember(size_t memberIdx, const float* values) {
+    if (memberIdx >= numMembers) {
+        throw std::runtime_error("Error in EnsembleAccumulator::addMember: Invalid member index.");
+    }
+    sgl::parallelFor(0, numEntries, STATISTICS_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        updateWelford(values + begin, mean.data() + begin, m2.data() + begin, count.data() + begin, end - begin);
+        if (needsQuantiles) {
+            std::copy(values + begin, values + end, memberValues.data() + memberIdx * numEntries + begin);
+        }
+    });
+}
+
+void EnsembleAccumulator::computeMean(float* meanOut) const {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    sgl::parallelFor(0, numEntries, STATISTICS_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float value = mean[i];
+            meanOut[i] = count[i] > 0 ? value : nan;
+        }
+    });
+}
+
+void EnsembleAccumulator::computeStandardDeviation(float* standardDeviation) const {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    sgl::parallelFor(0, numEntries, STATISTICS_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float variance = std::max(m2[i], 0.0f) / float(std::max(count[i] - 1, 1));
+            standardDeviation[i] = count[i] > 1 ? std::sqrt(variance) : nan;
+        }
+    });
+}
+
+void EnsembleAccumulator::computeQuantiles(const std::vector<float>& quantiles, float* const* outputs) const {
+    if (!needsQuantiles) {
+        throw std::runtime_error("Error in EnsembleAccumulator::computeQuantiles: Quantiles were not requested.");
+    }
+    sgl::parallelFor(0, numEntries, STATISTICS_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        // The member values of a block of entries are transposed, so that the values of each entry are contiguous.
+        std::vector<float> block(QUANTILE_BLOCK_SIZE * numMembers);
+        std::vector<float> sortedValues(numMembers);
+        for (size_t blockStart = begin; blockStart < end; blockStart += QUANTILE_BLOCK_SIZE) {
+            size_t blockSize = std::min(QUANTILE_BLOCK_SIZE, end - blockStart);
+            for (size_t m = 0; m < numMembers; m++) {
+                const float* src = memberValues.data() + m * numEntries + blockStart;
+                for (size_t j = 0; j < blockSize; j++) {
+                    block[j * numMembers + m] = src[j];
+                }
+            }
+            for (size_t j = 0; j < blockSize; j++) {
+                const float* values = block.data() + j * numMembers;
+                int numValid = 0;
+                for (size_t m = 0; m < numMembers; m++) {
+                    if (values[m] == values[m]) {
+                        sortedValues[numValid++] = values[m];
+                    }
+                }
+                if (numValid <= SMALL_SORT_SIZE) {
+                    insertionSort(sortedValues.data(), numValid);
+                } else {
+                    std::sort(sortedValues.begin(), sortedValues.begin() + numValid);
+                }
+                for (size_t q = 0; q < quantiles.size(); q++) {
+                    float result = std::numeric_limits<float>::quiet_NaN();
+                    if (numValid > 0) {
+                        double position = double(quantiles.at(q)) * double(numValid - 1);
+                        int lower = std::min(int(position), numValid - 1);
+                        int upper = std::min(lower + 1, numValid - 1);
+                        auto fraction = float(position - double(lower));
+                        float low = sortedValues[lower], high = sortedValues[upper];
+                        result = low + fraction * (high - low);
+                    }
+                    outputs[q][blockStart + j] = result;
+                }
+            }
+        }
+    });
+}
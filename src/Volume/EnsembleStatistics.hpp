@@ -0,0 +1,90 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_ENSEMBLESTATISTICS_HPP
+#define NCCONV_ENSEMBLESTATISTICS_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+enum class EnsembleStatisticType {
+    MEAN, STD, QUANTILE
+};
+
+/// A statistic computed over the ensemble members of a data set at each grid point and time step.
+struct EnsembleStatistic {
+    EnsembleStatisticType type = EnsembleStatisticType::MEAN;
+    float quantile = 0.0f; ///< Quantile in [0, 1] for EnsembleStatisticType::QUANTILE.
+    std::string name; ///< Suffix of the output variable, e.g., "mean", "std" or "p90".
+};
+/**
+ * Parses a comma-separated list of statistics, e.g., "mean,std,p10,p50,p90", where pN is the N-th percentile (N may
+ * have decimals, e.g., p2.5) and "median" is an alias of p50. Throws an exception for unknown statistics.
+ */
+std::vector<EnsembleStatistic> parseEnsembleStatistics(const std::string& statisticsString);
+
+/**
+ * Computes statistics over the ensemble members of a slab while the member slabs are read one after another.
+ * The mean and standard deviation use Welford's online algorithm, so they are numerically stable without a second pass
+ * and need only three accumulators per entry. Quantiles need all member values of an entry, so the members of the slab
+ * are kept in a buffer of numMembers entries per entry if quantiles are requested (@see getMemoryPerEntry). Missing
+ * entries (NaN) are excluded from all statistics.
+ */
+class EnsembleAccumulator {
+public:
+    EnsembleAccumulator(size_t numMembers, bool needsQuantiles);
+    /// Number of bytes per slab entry used by the accumulators.
+    [[nodiscard]] static size_t getMemoryPerEntry(size_t numMembers, bool needsQuantiles);
+    /// Resets the accumulators for a slab with numEntries entries.
+    void reset(size_t numEntries);
+    /// Adds the entries of one member. Each member needs to be added exactly once per slab.
+    void addMember(size_t memberIdx, const float* values);
+    /// The mean of the valid member values, or NaN if no member has a valid value.
+    void computeMean(float* mean) const;
+    /// The sample standard deviation of the valid member values, or NaN for less than two valid values.
+    void computeStandardDeviation(float* standardDeviation) const;
+    /**
+     * Computes the quantiles of the valid member values with linear interpolation between the closest ranks (like
+     * the default method of numpy.quantile), or NaN if no member has a valid value.
+     * @param quantiles The quantiles in [0, 1].
+     * @param outputs One array of entries per quantile.
+     */
+    void computeQuantiles(const std::vector<float>& quantiles, float* const* outputs) const;
+
+private:
+    size_t numMembers;
+    bool needsQuantiles;
+    size_t numEntries = 0;
+    std::vector<float> mean, m2; ///< Welford accumulators.
+    std::vector<int32_t> count;
+    std::vector<float> memberValues; ///< Entries of member m at [m * numEntries, (m + 1) * numEntries).
+};
+
+#endif //NCCONV_ENSEMBLESTATISTICS_HPP
@@ -0,0 +1,375 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "Utils/TaskScheduler.hpp"
+#include "FieldExpression.hpp"
+
+/// Number of entries each instruction is applied to at once. The stack of one block fits into the L1 cache.
+static const size_t BLOCK_SIZE = 256;
+static const size_t EVALUATION_GRAIN_SIZE = size_t(1) << 16;
+
+struct FunctionDesc {
+    const char* name;
+    int numArgs;
+};
+
+template<class Func>
+static inline void applyUnary(float* a, size_t n, Func func) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] = func(a[i]);
+    }
+}
+
+template<class Func>
+static inline void applyBinary(float* a, const float* b, size_t n, Func func) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] = func(a[i], b[i]);
+    }
+}
+
+static bool getIsIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool getIsIdentifierChar(char c) {
+    return getIsIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+FieldExpression::FieldExpression(const std::string& expression) : expressionString(expression) {
+    parseExpression();
+    skipWhitespace();
+    if (position != expressionString.size()) {
+        throwSyntaxError("Unexpected character '" + std::string(1, expressionString.at(position)) + "'");
+    }
+}
+
+void FieldExpression::throwSyntaxError(const std::string& message) const {
+    throw std::runtime_error(
+            "Error in FieldExpression::FieldExpression: " + message + " at position " + std::to_string(position)
+            + " of expression \"" + expressionString + "\".");
+}
+
+void FieldExpression::skipWhitespace() {
+    while (position < expressionString.size() && std::isspace(static_cast<unsigned char>(expressionString[position]))) {
+        position++;
+    }
+}
+
+bool FieldExpression::consume(char c) {
+    skipWhitespace();
+    if (position < expressionString.size() && expressionString[position] == c) {
+        position++;
+        return true;
+    }
+    return false;
+}
+
+void FieldExpression::emit(const Instruction& instruction) {
+    switch (instruction.opCode) {
+        case OpCode::VARIABLE:
+        case OpCode::CONSTANT:
+            stackDepth++;
+            break;
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::DIV:
+        case OpCode::POW:
+        case OpCode::ATAN2:
+        case OpCode::MIN:
+        case OpCode::MAX:
+            stackDepth--;
+            break;
+        default:
+            break;
+    }
+    maxStackDepth = std::max(maxStackDepth, stackDepth);
+    instructions.push_back(instruction);
+}
+
+void FieldExpression::parseExpression() {
+    parseTerm();
+    while (true) {
+        if (consume('+')) {
+            parseTerm();
+            emit({ OpCode::ADD });
+        } else if (consume('-')) {
+            parseTerm();
+            emit({ OpCode::SUB });
+        } else {
+            break;
+        }
+    }
+}
+
+void FieldExpression::parseTerm() {
+    parseUnary();
+    while (true) {
+        if (consume('*')) {
+            parseUnary();
+            emit({ OpCode::MUL });
+        } else if (consume('/')) {
+            parseUnary();
+            emit({ OpCode::DIV });
+        } else {
+            break;
+        }
+    }
+}
+
+void FieldExpression::parseUnary() {
+    if (consume('-')) {
+        parseUnary();
+        emit({ OpCode::NEG });
+    } else if (consume('+')) {
+        parseUnary();
+    } else {
+        parsePower();
+    }
+}
+
+void FieldExpression::parsePower() {
+    parsePrimary();
+    if (consume('^')) {
+        parseUnary();
+        // Squares are the most common powers (e.g., for vector magnitudes) and much cheaper than pow.
+        if (instructions.back().opCode == OpCode::CONSTANT && instructions.back().constant == 2.0f) {
+            instructions.pop_back();
+            stackDepth--;
+            emit({ OpCode::SQUARE });
+        } else {
+            emit({ OpCode::POW });
+        }
+    }
+}
+
+void FieldExpression::parsePrimary() {
+    skipWhitespace();
+    if (position >= expressionString.size()) {
+        throwSyntaxError("Unexpected end");
+    }
+    char c = expressionString[position];
+    if (consume('(')) {
+        parseExpression();
+        if (!consume(')')) {
+            throwSyntaxError("Missing ')'");
+        }
+    } else if ((c >= '0' && c <= '9') || c == '.') {
+        const char* start = expressionString.c_str() + position;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start) {
+            throwSyntaxError("Invalid number");
+        }
+        position += size_t(end - start);
+        Instruction instruction{ OpCode::CONSTANT };
+        instruction.constant = float(value);
+        emit(instruction);
+    } else if (getIsIdentifierStart(c)) {
+        size_t start = position;
+        while (position < expressionString.size() && getIsIdentifierChar(expressionString[position])) {
+            position++;
+        }
+        std::string name = expressionString.substr(start, position - start);
+        if (consume('(')) {
+            parseFunctionCall(name);
+            return;
+        }
+        auto it = std::find(variableNames.begin(), variableNames.end(), name);
+        Instruction instruction{ OpCode::VARIABLE };
+        instruction.variableIdx = int(it - variableNames.begin());
+        if (it == variableNames.end()) {
+            variableNames.push_back(name);
+        }
+        emit(instruction);
+    } else {
+        throwSyntaxError("Unexpected character '" + std::string(1, c) + "'");
+    }
+}
+
+void FieldExpression::parseFunctionCall(const std::string& functionName) {
+    static const std::pair<FunctionDesc, OpCode> functions[] = {
+            { { "sqrt", 1 }, OpCode::SQRT }, { { "exp", 1 }, OpCode::EXP }, { { "log", 1 }, OpCode::LOG },
+            { { "log10", 1 }, OpCode::LOG10 }, { { "abs", 1 }, OpCode::ABS }, { { "sin", 1 }, OpCode::SIN },
+            { { "cos", 1 }, OpCode::COS }, { { "tan", 1 }, OpCode::TAN }, { { "asin", 1 }, OpCode::ASIN },
+            { { "acos", 1 }, OpCode::ACOS }, { { "atan", 1 }, OpCode::ATAN }, { { "atan2", 2 }, OpCode::ATAN2 },
+            { { "pow", 2 }, OpCode::POW }, { { "min", 2 }, OpCode::MIN }, { { "max", 2 }, OpCode::MAX },
+    };
+    for (const auto& function : functions) {
+        if (functionName != function.first.name) {
+            continue;
+        }
+        for (int argIdx = 0; argIdx < function.first.numArgs; argIdx++) {
+            if (argIdx > 0 && !consume(',')) {
+                throwSyntaxError("Function '" + functionName + "' expects " + std::to_string(function.first.numArgs)
+                        + " arguments");
+            }
+            parseExpression();
+        }
+        if (!consume(')')) {
+            throwSyntaxError("Missing ')' after the arguments of function '" + functionName + "'");
+        }
+        emit({ function.second });
+        return;
+    }
+    throwSyntaxError("Unknown function '" + functionName + "'");
+}
+
+void FieldExpression::evaluate(const float* const* inputs, float* output, size_t n) const {
+    sgl::parallelFor(0, n, EVALUATION_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        std::vector<float> stack(size_t(maxStackDepth) * BLOCK_SIZE);
+        std::vector<const float*> blockInputs(variableNames.size());
+        for (size_t blockStart = begin; blockStart < end; blockStart += BLOCK_SIZE) {
+            size_t blockSize = std::min(BLOCK_SIZE, end - blockStart);
+            for (size_t varIdx = 0; varIdx < variableNames.size(); varIdx++) {
+                blockInputs[varIdx] = inputs[varIdx] + blockStart;
+            }
+            evaluateBlock(blockInputs.data(), output + blockStart, blockSize, stack.data());
+        }
+    });
+}
+
+void FieldExpression::evaluateBlock(const float* const* inputs, float* output, size_t n, float* stack) const {
+    size_t stackTop = 0;
+    // Entry 1 is the topmost stack entry, i.e., the operand of unary and the right operand of binary operations.
+    // Entry 2 is the left operand of binary operations, which is replaced by the result.
+    auto getEntry = [&](size_t depth) { return stack + (stackTop - depth) * BLOCK_SIZE; };
+    for (const Instruction& instruction : instructions) {
+        switch (instruction.opCode) {
+            case OpCode::VARIABLE:
+                memcpy(stack + stackTop * BLOCK_SIZE, inputs[instruction.variableIdx], n * sizeof(float));
+                stackTop++;
+                break;
+            case OpCode::CONSTANT:
+                std::fill_n(stack + stackTop * BLOCK_SIZE, n, instruction.constant);
+                stackTop++;
+                break;
+            case OpCode::ADD:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return x + y; });
+                stackTop--;
+                break;
+            case OpCode::SUB:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return x - y; });
+                stackTop--;
+                break;
+            case OpCode::MUL:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return x * y; });
+                stackTop--;
+                break;
+            case OpCode::DIV:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return x / y; });
+                stackTop--;
+                break;
+            case OpCode::POW:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return std::pow(x, y); });
+                stackTop--;
+                break;
+            case OpCode::ATAN2:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) { return std::atan2(x, y); });
+                stackTop--;
+                break;
+            case OpCode::MIN:
+                // NaN (missing) operands propagate, unlike with std::fmin.
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) {
+                    return x != x || y != y ? x + y : std::min(x, y);
+                });
+                stackTop--;
+                break;
+            case OpCode::MAX:
+                applyBinary(getEntry(2), getEntry(1), n, [](float x, float y) {
+                    return x != x || y != y ? x + y : std::max(x, y);
+                });
+                stackTop--;
+                break;
+            case OpCode::NEG:
+                applyUnary(getEntry(1), n, [](float x) { return -x; });
+                break;
+            case OpCode::SQUARE:
+                applyUnary(getEntry(1), n, [](float x) { return x * x; });
+                break;
+            case OpCode::SQRT:
+                applyUnary(getEntry(1), n, [](float x) { return std::sqrt(x); });
+                break;
+            case OpCode::EXP:
+                applyUnary(getEntry(1), n, [](float x) { return std::exp(x); });
+                break;
+            case OpCode::LOG:
+                applyUnary(getEntry(1), n, [](float x) { return std::log(x); });
+                break;
+            case OpCode::LOG10:
+                applyUnary(getEntry(1), n, [](float x) { return std::log10(x); });
+                break;
+            case OpCode::ABS:
+                applyUnary(getEntry(1), n, [](float x) { return std::abs(x); });
+                break;
+            case OpCode::SIN:
+                applyUnary(getEntry(1), n, [](float x) { return std::sin(x); });
+                break;
+            case OpCode::COS:
+                applyUnary(getEntry(1), n, [](float x) { return std::cos(x); });
+                break;
+            case OpCode::TAN:
+                applyUnary(getEntry(1), n, [](float x) { return std::tan(x); });
+                break;
+            case OpCode::ASIN:
+                applyUnary(getEntry(1), n, [](float x) { return std::asin(x); });
+                break;
+            case OpCode::ACOS:
+                applyUnary(getEntry(1), n, [](float x) { return std::acos(x); });
+                break;
+            case OpCode::ATAN:
+                applyUnary(getEntry(1), n, [](float x) { return std::atan(x); });
+                break;
+        }
+    }
+    memcpy(output, stack, n * sizeof(float));
+}
+
+void parseDerivedFieldDefinition(const std::string& definition, std::string& name, std::string& expression) {
+    size_t equalsPos = definition.find('=');
+    if (equalsPos == std::string::npos) {
+        throw std::runtime_error(
+                "Error in parseDerivedFieldDefinition: Expected \"name=expression\", but got \"" + definition + "\".");
+    }
+    name = definition.substr(0, equalsPos);
+    expression = definition.substr(equalsPos + 1);
+    name.erase(0, name.find_first_not_of(" \t"));
+    name.erase(name.find_last_not_of(" \t") + 1);
+    if (name.empty()) {
+        throw std::runtime_error(
+                "Error in parseDerivedFieldDefinition: Missing variable name in \"" + definition + "\".");
+    }
+}
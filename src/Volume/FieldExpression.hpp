@@ -0,0 +1,97 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_FIELDEXPRESSION_HPP
+#define NCCONV_FIELDEXPRESSION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * An arithmetic expression over the variables of a data set, e.g., "sqrt(u^2 + v^2)" or "t - 273.15".
+ * Supported are numbers, variable names, the operators + - * / ^ (power, right-associative), parentheses and the
+ * functions sqrt, exp, log, log10, abs, sin, cos, tan, asin, acos, atan, atan2(y, x), pow(x, y), min(x, y) and
+ * max(x, y). Trigonometric functions use radians.
+ * The expression is compiled once into postfix instructions for a stack machine. Instead of interpreting the
+ * instructions per entry, each instruction is applied to a whole block of entries at a time, so the interpreter
+ * overhead is amortized and the loop of each instruction can be vectorized by the compiler. Missing values (NaN)
+ * propagate to the result.
+ */
+class FieldExpression {
+public:
+    /// Parses and compiles the expression. Throws an exception on syntax errors or unknown functions.
+    explicit FieldExpression(const std::string& expression);
+    /// The names of the variables used by the expression in the order of their first occurrence.
+    [[nodiscard]] const std::vector<std::string>& getVariableNames() const { return variableNames; }
+    [[nodiscard]] const std::string& getExpressionString() const { return expressionString; }
+    /**
+     * Evaluates the expression for n entries.
+     * @param inputs One array of n entries per variable (in the order of @see getVariableNames).
+     * @param output The destination array of n entries.
+     */
+    void evaluate(const float* const* inputs, float* output, size_t n) const;
+
+private:
+    enum class OpCode {
+        VARIABLE, CONSTANT, ADD, SUB, MUL, DIV, POW, NEG, SQUARE,
+        SQRT, EXP, LOG, LOG10, ABS, SIN, COS, TAN, ASIN, ACOS, ATAN, ATAN2, MIN, MAX
+    };
+    struct Instruction {
+        OpCode opCode;
+        int variableIdx = 0;
+        float constant = 0.0f;
+    };
+
+    // Recursive descent parser emitting the instructions in postfix order.
+    void parseExpression();
+    void parseTerm();
+    void parseUnary();
+    void parsePower();
+    void parsePrimary();
+    void parseFunctionCall(const std::string& functionName);
+    void skipWhitespace();
+    bool consume(char c);
+    [[noreturn]] void throwSyntaxError(const std::string& message) const;
+    void emit(const Instruction& instruction);
+    void evaluateBlock(const float* const* inputs, float* output, size_t n, float* stack) const;
+
+    std::string expressionString;
+    size_t position = 0;
+    std::vector<std::string> variableNames;
+    std::vector<Instruction> instructions;
+    int stackDepth = 0, maxStackDepth = 0;
+};
+
+/**
+ * Parses a derived variable definition "name=expression", e.g., "ws=sqrt(u^2+v^2)".
+ * Throws an exception if the definition has no name.
+ */
+void parseDerivedFieldDefinition(const std::string& definition, std::string& name, std::string& expression);
+
+#endif //NCCONV_FIELDEXPRESSION_HPP
@@ -0,0 +1,151 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef NCCONV_FIELDTYPE_HPP
+#define NCCONV_FIELDTYPE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+/**
+ * Data type of the entries of a field as stored by the loader (after decoding, i.e., in host byte order).
+ * Floating point fields store missing values as NaN; integer fields keep the fill value of the input data set.
+ */
+enum class FieldDataType {
+    INT8, UINT8, INT16, UINT16, INT32, FLOAT32, FLOAT64
+};
+
+inline size_t getFieldDataTypeSize(FieldDataType dataType) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+        case FieldDataType::UINT8:
+            return 1;
+        case FieldDataType::INT16:
+        case FieldDataType::UINT16:
+            return 2;
+        case FieldDataType::INT32:
+        case FieldDataType::FLOAT32:
+            return 4;
+        case FieldDataType::FLOAT64:
+            return 8;
+    }
+    return 4;
+}
+
+inline bool getIsFieldDataTypeFloat(FieldDataType dataType) {
+    return dataType == FieldDataType::FLOAT32 || dataType == FieldDataType::FLOAT64;
+}
+
+/**
+ * Returns whether a value can be converted to T without overflow. Integer types need to store it exactly, while
+ * floating point values are rounded like GrADS does when comparing entries against the undef value (e.g., -1e20).
+ */
+template<class T>
+inline bool getIsValueRepresentable(double value) {
+    if (std::isnan(value) || value < double(std::numeric_limits<T>::lowest())
+            || value > double(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    return std::numeric_limits<T>::is_integer ? double(T(value)) == value : true;
+}
+
+/**
+ * Returns whether a fill value can be stored exactly in the passed data type. Other fill values (e.g., "undef -9999"
+ * for a uint8 field) can never match an entry, and casting them to the data type would be undefined behavior.
+ */
+inline bool getIsFillValueRepresentable(FieldDataType dataType, double fillValue) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return getIsValueRepresentable<int8_t>(fillValue);
+        case FieldDataType::UINT8:
+            return getIsValueRepresentable<uint8_t>(fillValue);
+        case FieldDataType::INT16:
+            return getIsValueRepresentable<int16_t>(fillValue);
+        case FieldDataType::UINT16:
+            return getIsValueRepresentable<uint16_t>(fillValue);
+        case FieldDataType::INT32:
+            return getIsValueRepresentable<int32_t>(fillValue);
+        case FieldDataType::FLOAT32:
+            return getIsValueRepresentable<float>(fillValue);
+        case FieldDataType::FLOAT64:
+            return !std::isnan(fillValue);
+    }
+    return false;
+}
+
+inline const char* getFieldDataTypeName(FieldDataType dataType) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return "int8";
+        case FieldDataType::UINT8:
+            return "uint8";
+        case FieldDataType::INT16:
+            return "int16";
+        case FieldDataType::UINT16:
+            return "uint16";
+        case FieldDataType::INT32:
+            return "int32";
+        case FieldDataType::FLOAT32:
+            return "float32";
+        case FieldDataType::FLOAT64:
+            return "float64";
+    }
+    return "unknown";
+}
+
+/**
+ * Storage type of floating point fields in NetCDF output files. NetCDF has no 16-bit floating point type, so FLOAT16
+ * (IEEE 754 binary16) and BFLOAT16 entries are stored as their bit patterns in NC_USHORT variables, which carry the
+ * attribute "ncconv_dtype" with the name of the type. Missing entries are the canonical quiet NaN of the type, which
+ * is also the _FillValue of the variable.
+ */
+enum class OutputFloatType {
+    NATIVE, FLOAT16, BFLOAT16
+};
+
+inline const char* getOutputFloatTypeName(OutputFloatType outputFloatType) {
+    switch (outputFloatType) {
+        case OutputFloatType::NATIVE:
+            return "native";
+        case OutputFloatType::FLOAT16:
+            return "float16";
+        case OutputFloatType::BFLOAT16:
+            return "bfloat16";
+    }
+    return "unknown";
+}
+
+/// Returns the bit pattern of the canonical quiet NaN of a 16-bit output float type.
+inline uint16_t getOutputFloatTypeNaN(OutputFloatType outputFloatType) {
+    return outputFloatType == OutputFloatType::BFLOAT16 ? uint16_t(0x7FC0) : uint16_t(0x7E00);
+}
+
+#endif //NCCONV_FIELDTYPE_HPP
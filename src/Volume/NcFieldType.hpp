@@ -0,0 +1,66 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_NCFIELDTYPE_HPP
+#define NCCONV_NCFIELDTYPE_HPP
+
+#include <netcdf.h>
+
+#include "FieldType.hpp"
+
+/// Returns the NetCDF external type storing entries of the passed field data type without conversion.
+inline nc_type getNcType(FieldDataType dataType) {
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return NC_BYTE;
+        case FieldDataType::UINT8:
+            return NC_UBYTE;
+        case FieldDataType::INT16:
+            return NC_SHORT;
+        case FieldDataType::UINT16:
+            return NC_USHORT;
+        case FieldDataType::INT32:
+            return NC_INT;
+        case FieldDataType::FLOAT32:
+            return NC_FLOAT;
+        case FieldDataType::FLOAT64:
+            return NC_DOUBLE;
+    }
+    return NC_FLOAT;
+}
+
+/*
+ * XXH64 hashes of the (member, time step, slab) tuples of a variable (in member-major, then time step-major order) are
+ * recorded in the attribute "ncconv_xxh64". The slabs are stored as (zOffset, zCount, yOffset, yCount) tuples in
+ * "ncconv_xxh64_slabs". NaN entries are canonicalized before hashing, so the hashes of the input and output data can
+ * be compared.
+ */
+static const char* const SLAB_HASHES_ATTRIBUTE = "ncconv_xxh64";
+static const char* const SLAB_HASHES_SLABS_ATTRIBUTE = "ncconv_xxh64_slabs";
+
+#endif //NCCONV_NCFIELDTYPE_HPP
@@ -0,0 +1,210 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+#include <netcdf.h>
+
+#include "ChunkTuning.hpp"
+#include "ReadBenchmark.hpp"
+
+namespace {
+
+struct NcVariableInfo {
+    int varid = -1;
+    int numDims = 0;
+    size_t entrySize = 0;
+    std::vector<size_t> dimLengths;
+    std::vector<size_t> chunkSizes; ///< Empty for contiguous variables.
+    int tloc = -1, zloc = -1, yloc = -1, xloc = -1;
+};
+
+bool inquireVariable(int ncid, int varid, NcVariableInfo& info) {
+    int dimids[NC_MAX_VAR_DIMS];
+    nc_type xtype = NC_NAT;
+    info.varid = varid;
+    nc_inq_var(ncid, varid, nullptr, &xtype, &info.numDims, dimids, nullptr);
+    nc_inq_type(ncid, xtype, nullptr, &info.entrySize);
+    info.dimLengths.resize(info.numDims);
+    for (int dimIdx = 0; dimIdx < info.numDims; dimIdx++) {
+        char dimName[NC_MAX_NAME + 1];
+        nc_inq_dim(ncid, dimids[dimIdx], dimName, &info.dimLengths.at(dimIdx));
+        std::string name = dimName;
+        if (name == "time") {
+            info.tloc = dimIdx;
+        } else if (name == "z") {
+            info.zloc = dimIdx;
+        } else if (name == "y") {
+            info.yloc = dimIdx;
+        } else if (name == "x") {
+            info.xloc = dimIdx;
+        }
+    }
+    int storage = NC_CONTIGUOUS;
+    std::vector<size_t> chunkSizes(info.numDims, 1);
+    if (info.numDims > 0 && nc_inq_var_chunking(ncid, varid, &storage, chunkSizes.data()) == NC_NOERR
+            && storage == NC_CHUNKED) {
+        info.chunkSizes = chunkSizes;
+    }
+    return info.yloc >= 0 && info.xloc >= 0;
+}
+
+}
+
+std::vector<ReadBenchmarkResult> benchmarkNcFileReads(
+        const std::string& filePath, const std::string& variableName, int numReads) {
+    const char* accessPatterns[] = { "maps", "profiles", "timeseries" };
+    std::vector<ReadBenchmarkResult> results;
+    for (const char* accessPattern : accessPatterns) {
+        int ncid = -1;
+        int status = nc_open(filePath.c_str(), NC_NOWRITE, &ncid);
+        if (status != NC_NOERR) {
+            throw std::runtime_error(
+                    "Error in benchmarkNcFileReads: Couldn't open file \"" + filePath + "\": " + nc_strerror(status));
+        }
+
+        NcVariableInfo info;
+        if (!variableName.empty()) {
+            int varid = -1;
+            if (nc_inq_varid(ncid, variableName.c_str(), &varid) != NC_NOERR || !inquireVariable(ncid, varid, info)) {
+                nc_close(ncid);
+                throw std::runtime_error(
+                        "Error in benchmarkNcFileReads: No gridded variable \"" + variableName + "\" in file \""
+                        + filePath + "\".");
+            }
+        } else {
+            int numVars = 0;
+            nc_inq_nvars(ncid, &numVars);
+            size_t maxVarSize = 0;
+            for (int varid = 0; varid < numVars; varid++) {
+                NcVariableInfo candidate;
+                if (!inquireVariable(ncid, varid, candidate)) {
+                    continue;
+                }
+                size_t varSize = candidate.entrySize;
+                for (size_t dimLength : candidate.dimLengths) {
+                    varSize *= dimLength;
+                }
+                if (varSize > maxVarSize) {
+                    maxVarSize = varSize;
+                    info = candidate;
+                }
+            }
+            if (info.varid < 0) {
+                nc_close(ncid);
+                throw std::runtime_error(
+                        "Error in benchmarkNcFileReads: No gridded variable in file \"" + filePath + "\".");
+            }
+        }
+
+        // The axis read completely by the access pattern; the other axes are read at single positions.
+        std::string patternName = accessPattern;
+        int fullAxes[2] = { -1, -1 };
+        if (patternName == "maps") {
+            fullAxes[0] = info.yloc;
+            fullAxes[1] = info.xloc;
+        } else if (patternName == "profiles") {
+            fullAxes[0] = info.zloc;
+        } else {
+            fullAxes[0] = info.tloc;
+        }
+        if (fullAxes[0] < 0 || info.dimLengths.at(fullAxes[0]) <= 1) {
+            nc_close(ncid);
+            continue;
+        }
+
+        ReadBenchmarkResult result;
+        result.accessPattern = patternName;
+        result.numReads = numReads;
+        std::vector<size_t> start(info.numDims, 0), count(info.numDims, 1);
+        size_t numEntriesPerRead = 1;
+        for (int axis : fullAxes) {
+            if (axis >= 0) {
+                count.at(axis) = info.dimLengths.at(axis);
+                numEntriesPerRead *= info.dimLengths.at(axis);
+            }
+        }
+        result.bytesPerRead = numEntriesPerRead * info.entrySize;
+        std::vector<uint8_t> buffer(result.bytesPerRead);
+        std::mt19937_64 generator(17);
+        size_t numChunksTouched = 0, chunkSize = info.entrySize;
+        for (size_t c : info.chunkSizes) {
+            chunkSize *= c;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (int readIdx = 0; readIdx < numReads; readIdx++) {
+            size_t numChunks = 1;
+            for (int dimIdx = 0; dimIdx < info.numDims; dimIdx++) {
+                if (dimIdx != fullAxes[0] && dimIdx != fullAxes[1]) {
+                    start.at(dimIdx) = size_t(generator() % info.dimLengths.at(dimIdx));
+                }
+                if (!info.chunkSizes.empty()) {
+                    numChunks *= countChunksSpanned(start.at(dimIdx), count.at(dimIdx), info.chunkSizes.at(dimIdx));
+                }
+            }
+            numChunksTouched += numChunks;
+            status = nc_get_vara(ncid, info.varid, start.data(), count.data(), buffer.data());
+            if (status != NC_NOERR) {
+                nc_close(ncid);
+                throw std::runtime_error(
+                        std::string() + "Error in benchmarkNcFileReads: nc_get_vara failed: " + nc_strerror(status));
+            }
+        }
+        auto endTime = std::chrono::steady_clock::now();
+        nc_close(ncid);
+
+        double elapsedTime = std::chrono::duration<double>(endTime - startTime).count();
+        result.secondsPerRead = elapsedTime / double(numReads);
+        if (elapsedTime > 0.0) {
+            result.bandwidth = double(result.bytesPerRead) * double(numReads) / elapsedTime;
+        }
+        if (!info.chunkSizes.empty()) {
+            result.chunksPerRead = (numChunksTouched + size_t(numReads) - 1) / size_t(numReads);
+            result.readAmplification =
+                    double(numChunksTouched * chunkSize) / double(result.bytesPerRead * size_t(numReads));
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+void printReadBenchmark(const std::vector<ReadBenchmarkResult>& results, std::ostream& os) {
+    os << std::left << std::setw(12) << "Pattern" << std::right << std::setw(12) << "ms/read"
+       << std::setw(12) << "MiB/s" << std::setw(14) << "chunks/read" << std::setw(16) << "amplification" << std::endl;
+    for (const ReadBenchmarkResult& result : results) {
+        os << std::left << std::setw(12) << result.accessPattern << std::right << std::fixed
+           << std::setprecision(3) << std::setw(12) << result.secondsPerRead * 1e3
+           << std::setw(12) << result.bandwidth / double(1 << 20)
+           << std::setw(14) << result.chunksPerRead
+           << std::setprecision(2) << std::setw(16) << result.readAmplification << std::endl;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_READBENCHMARK_HPP
+#define NCCONV_READBENCHMARK_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+struct ReadBenchmarkResult {
+    std::string accessPattern; ///< "maps", "profiles" or "timeseries".
+    int numReads = 0;
+    double secondsPerRead = 0.0;
+    double bandwidth = 0.0; ///< Requested (i.e., uncompressed) bytes per second.
+    size_t bytesPerRead = 0;
+    size_t chunksPerRead = 0; ///< Number of chunks touched per read (0 for contiguous variables).
+    /// Uncompressed size of the touched chunks divided by the requested size (1 is optimal).
+    double readAmplification = 1.0;
+};
+
+/**
+ * Benchmarks reading a NetCDF file written by ncconv with the access patterns maps (one horizontal map), profiles
+ * (one vertical column) and timeseries (the time series of one grid point) at reproducible random positions.
+ * The file is reopened for each access pattern, so the chunk cache of the NetCDF library starts cold (the page cache
+ * of the operating system may not). Access patterns whose axis does not exist in the variable are skipped.
+ * @param filePath The NetCDF file to read.
+ * @param variableName The variable to read. If empty, the largest variable with horizontal dimensions is used.
+ * @param numReads The number of reads per access pattern.
+ */
+std::vector<ReadBenchmarkResult> benchmarkNcFileReads(
+        const std::string& filePath, const std::string& variableName = "", int numReads = 16);
+void printReadBenchmark(const std::vector<ReadBenchmarkResult>& results, std::ostream& os);
+
+#endif //NCCONV_READBENCHMARK_HPP
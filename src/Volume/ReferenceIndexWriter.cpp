@@ -0,0 +1,251 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Utils/JsonUtils.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "VolumeData.hpp"
+#include "ZarrMetadata.hpp"
+#include "ReferenceIndexWriter.hpp"
+
+static std::string encodeBase64(const uint8_t* data, size_t size) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t bits = uint32_t(data[i]) << 16;
+        if (i + 1 < size) {
+            bits |= uint32_t(data[i + 1]) << 8;
+        }
+        if (i + 2 < size) {
+            bits |= uint32_t(data[i + 2]);
+        }
+        encoded.push_back(alphabet[(bits >> 18) & 0x3Fu]);
+        encoded.push_back(alphabet[(bits >> 12) & 0x3Fu]);
+        encoded.push_back(i + 1 < size ? alphabet[(bits >> 6) & 0x3Fu] : '=');
+        encoded.push_back(i + 2 < size ? alphabet[bits & 0x3Fu] : '=');
+    }
+    return encoded;
+}
+
+/// Writes a reference key. Metadata values are JSON documents themselves, so they are stored as escaped strings.
+static void writeReferenceKey(std::ostream& file, const std::string& key, const std::string& value) {
+    file << ",\n\"" << sgl::escapeJsonString(key) << "\": \"" << sgl::escapeJsonString(value) << "\"";
+}
+
+ReferenceIndexWriter::ReferenceIndexWriter(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+bool ReferenceIndexWriter::writeToFile(const std::string& filePath) {
+    // With MPI, the first rank writes the whole (small) index.
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+    if (mpiRank != 0) {
+        return true;
+    }
+
+    checkSettings();
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::writeToFile: Couldn't open file \"" + filePath + "\" for writing.");
+    }
+    file << std::setprecision(17);
+
+    file << "{\"version\": 1, \"refs\": {\n";
+    file << "\".zgroup\": \"" << sgl::escapeJsonString("{\"zarr_format\": 2}") << "\"";
+    writeReferenceKey(file, ".zattrs", makeZarrGroupAttributes(volumeData->getEnsembleMemberCount()));
+    writeCoordinates(file);
+    for (const std::string& fieldName : volumeData->getFieldNames()) {
+        writeField(file, fieldName);
+    }
+    file << "\n}}\n";
+
+    if (!file.good()) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::writeToFile: Writing to file \"" + filePath + "\" failed.");
+    }
+    return true;
+}
+
+void ReferenceIndexWriter::checkSettings() {
+    if (volumeData->getOutputLayout() == OutputLayout::TIME_SERIES && volumeData->getNumTimeSteps() > 1) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::checkSettings: The time series layout is only supported for NetCDF-4 "
+                "files.");
+    }
+    if (!volumeData->getChunkShape().empty() || volumeData->getAccessPattern() != AccessPattern::DEFAULT
+            || volumeData->getDeflateLevel() > 0 || volumeData->getUseShuffleFilter()) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::checkSettings: The chunks of a reference index are the fields of the "
+                "input file, so neither chunking nor compression are supported.");
+    }
+    if (volumeData->getOutputFloatType() != OutputFloatType::NATIVE) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::checkSettings: 16-bit floating point output is only supported for "
+                "NetCDF files.");
+    }
+    if (volumeData->getTimeAggregation().type != TimeAggregationType::NONE
+            || !volumeData->getEnsembleStatistics().empty() || !volumeData->getWriteEnsembleMembers()) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::checkSettings: Temporal aggregation and ensemble statistics are only "
+                "supported for NetCDF-4 files.");
+    }
+    if (volumeData->getCollapseTimeInvariantFields()) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::checkSettings: Collapsing time-invariant variables is only supported "
+                "for NetCDF-4 files.");
+    }
+}
+
+void ReferenceIndexWriter::writeCoordinates(std::ostream& file) {
+    auto writeCoordinateVariable = [&](
+            const std::string& name, const std::string& dimensionName, const std::string& coordinateType,
+            const float* coordinates, size_t dimLen) {
+        // The coordinates are stored as little endian float32 data.
+        std::vector<uint8_t> data(dimLen * sizeof(float));
+        memcpy(data.data(), coordinates, data.size());
+        std::vector<std::pair<std::string, std::string>> attributes;
+        if (!coordinateType.empty()) {
+            attributes.emplace_back("coordinate_type", coordinateType);
+        }
+        writeReferenceKey(file, name + "/.zarray", makeZarrArrayMetadata({ dimLen }, { dimLen }, "<f4", "\"NaN\""));
+        writeReferenceKey(file, name + "/.zattrs", makeZarrArrayAttributes({ dimensionName }, attributes));
+        writeReferenceKey(file, name + "/0", "base64:" + encodeBase64(data.data(), data.size()));
+    };
+
+    size_t xs = volumeData->getGridSizeX();
+    size_t ys = volumeData->getGridSizeY();
+    auto zs = std::max(volumeData->getGridSizeZ(), size_t(1));
+    std::vector<float> levels(zs);
+    for (size_t z = 0; z < zs; z++) {
+        levels.at(z) = volumeData->getLev1d() ? volumeData->getLev1d()[z] : float(z);
+    }
+    writeCoordinateVariable("x", "x", "Cartesian X", volumeData->getLon1d(), xs);
+    writeCoordinateVariable("y", "y", "Cartesian Y", volumeData->getLat1d(), ys);
+    writeCoordinateVariable("z", "z", "Cartesian Z", levels.data(), zs);
+    writeCoordinateVariable("lon", "x", "", volumeData->getLon1d(), xs);
+    writeCoordinateVariable("lat", "y", "", volumeData->getLat1d(), ys);
+}
+
+void ReferenceIndexWriter::writeField(std::ostream& file, const std::string& fieldName) {
+    VolumeLoader* loader = volumeData->getLoader();
+    size_t xs = volumeData->getGridSizeX();
+    size_t ys = volumeData->getGridSizeY();
+    size_t ts = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    size_t es = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    size_t varxs = 0, varys = 0, varzs = 0;
+    loader->getFieldExtent(fieldName, varxs, varys, varzs);
+    varzs = std::max(varzs, size_t(1));
+    if (varxs != xs || varys != ys) {
+        throw std::runtime_error(
+                "Error in ReferenceIndexWriter::writeField: Variable \"" + fieldName + "\" has a different grid.");
+    }
+    FieldDataType dataType = loader->getFieldDataType(fieldName);
+    uint64_t fieldSize = uint64_t(varzs) * uint64_t(varys) * uint64_t(varxs) * getFieldDataTypeSize(dataType);
+
+    // The dimensions match the ones written by VolumeData::writeToNcHandle. Each chunk is one 3D (or 2D) field.
+    std::vector<std::string> dimensionNames = { "y", "x" };
+    std::vector<size_t> shape = { varys, varxs };
+    if (varzs > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "z");
+        shape.insert(shape.begin(), varzs);
+    }
+    std::string chunkKeySuffix = varzs > 1 ? "0.0.0" : "0.0";
+    if (ts > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "time");
+        shape.insert(shape.begin(), ts);
+    }
+    if (es > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "member");
+        shape.insert(shape.begin(), es);
+    }
+    std::vector<size_t> chunks = shape;
+    for (size_t dimIdx = 0; dimIdx < chunks.size() - (varzs > 1 ? 3 : 2); dimIdx++) {
+        chunks.at(dimIdx) = 1;
+    }
+
+    FieldFileRange range;
+    std::string inputFilePath, absoluteInputFilePath;
+    for (size_t e = 0; e < es; e++) {
+        for (size_t t = 0; t < ts; t++) {
+            if (!loader->getFieldFileRange(fieldName, t, e, range)) {
+                throw std::runtime_error(
+                        "Error in ReferenceIndexWriter::writeField: Variable \"" + fieldName + "\" is not stored "
+                        "unencoded in the input file, so it cannot be referenced. Reference indices are only "
+                        "supported for GrADS input without derived fields or coarsening.");
+            }
+            if (range.size != fieldSize) {
+                throw std::runtime_error(
+                        "Error in ReferenceIndexWriter::writeField: The size of the file range of variable \""
+                        + fieldName + "\" does not match its extent.");
+            }
+            if (e == 0 && t == 0) {
+                // The endianness and fill value of the first range are used for the whole variable. A fill value
+                // the data type cannot store (e.g., -9999 for uint8) can never match an entry and is not written.
+                bool hasFillValue = range.hasFillValue && getIsFillValueRepresentable(dataType, range.fillValue);
+                std::string fillValue = formatZarrFillValue(dataType, hasFillValue, range.fillValue);
+                std::string dataTypeString = getZarrDataTypeString(dataType, range.isBigEndian);
+                writeReferenceKey(
+                        file, fieldName + "/.zarray",
+                        makeZarrArrayMetadata(shape, chunks, dataTypeString, fillValue));
+                writeReferenceKey(file, fieldName + "/.zattrs", makeZarrArrayAttributes(dimensionNames));
+            }
+            if (range.filePath != inputFilePath) {
+                inputFilePath = range.filePath;
+                absoluteInputFilePath = sgl::escapeJsonString(boost::filesystem::absolute(inputFilePath).string());
+            }
+            std::string chunkKey = fieldName + "/";
+            if (es > 1) {
+                chunkKey += std::to_string(e) + ".";
+            }
+            if (ts > 1) {
+                chunkKey += std::to_string(t) + ".";
+            }
+            chunkKey += chunkKeySuffix;
+            file << ",\n\"" << sgl::escapeJsonString(chunkKey) << "\": [\"" << absoluteInputFilePath << "\", "
+                 << range.offset << ", " << range.size << "]";
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_REFERENCEINDEXWRITER_HPP
+#define NCCONV_REFERENCEINDEXWRITER_HPP
+
+#include <string>
+#include <iosfwd>
+#include "VolumeWriter.hpp"
+
+class VolumeData;
+
+/**
+ * Writes a reference index instead of a copy of the data set, i.e., a JSON file in the version 1 reference format of
+ * kerchunk (https://fsspec.github.io/kerchunk/spec.html). It describes a Zarr (version 2) group with the same
+ * dimensions, variables and attributes as the NetCDF file written by @see VolumeData, where each chunk references the
+ * range of the input file storing one (member, time step) field. The ranges are queried from the loader using
+ * @see VolumeLoader::getFieldFileRange, so no field data is read and the index of a data set of any size is written
+ * within seconds. It can be opened, e.g., with xarray.open_dataset(path, engine="kerchunk") or fsspec and Zarr.
+ * The input files are referenced by their absolute paths. The (small) coordinate variables are stored inline.
+ * The endianness and fill value of the input data are kept. Fields that are not stored unencoded in the input file
+ * (e.g., derived or coarsened fields, or NetCDF input) and options that change the data are not supported.
+ */
+class ReferenceIndexWriter : public VolumeWriter {
+public:
+    explicit ReferenceIndexWriter(VolumeData* volumeData);
+    bool writeToFile(const std::string& filePath) override;
+
+private:
+    void checkSettings();
+    void writeCoordinates(std::ostream& file);
+    void writeField(std::ostream& file, const std::string& fieldName);
+
+    VolumeData* volumeData;
+};
+
+#endif //NCCONV_REFERENCEINDEXWRITER_HPP
@@ -0,0 +1,357 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <stdexcept>
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include "Utils/TaskScheduler.hpp"
+#include "TimeAggregation.hpp"
+
+static const size_t ACCUMULATION_GRAIN_SIZE = size_t(1) << 16;
+
+static const char* const MONTH_NAMES[] = {
+        "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"
+};
+
+/// Number of days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+static int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2 ? 1 : 0;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/// Inverse of @see daysFromCivil.
+static void civilFromDays(int64_t days, int64_t& year, int64_t& month, int64_t& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthPart = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthPart + 2) / 5 + 1;
+    month = monthPart < 10 ? monthPart + 3 : monthPart - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+static int parseNumber(const std::string& str, size_t& pos) {
+    size_t startPos = pos;
+    while (pos < str.size() && std::isdigit(static_cast<unsigned char>(str.at(pos)))) {
+        pos++;
+    }
+    if (pos == startPos || pos - startPos > 9) {
+        throw std::runtime_error("Error in parseGradsTimeAxis: Invalid time \"" + str + "\".");
+    }
+    return std::stoi(str.substr(startPos, pos - startPos));
+}
+
+TimeAxis parseGradsTimeAxis(const std::string& startTime, const std::string& increment) {
+    TimeAxis timeAxis;
+    std::string timeString = boost::to_lower_copy(startTime);
+    size_t pos = 0;
+    if (timeString.find('z') != std::string::npos) {
+        timeAxis.hour = parseNumber(timeString, pos);
+        if (pos < timeString.size() && timeString.at(pos) == ':') {
+            pos++;
+            timeAxis.minute = parseNumber(timeString, pos);
+        }
+        if (pos >= timeString.size() || timeString.at(pos) != 'z') {
+            throw std::runtime_error("Error in parseGradsTimeAxis: Invalid time \"" + startTime + "\".");
+        }
+        pos++;
+    }
+    if (pos < timeString.size() && std::isdigit(static_cast<unsigned char>(timeString.at(pos)))) {
+        timeAxis.day = parseNumber(timeString, pos);
+    }
+    timeAxis.month = 0;
+    for (int monthIdx = 0; monthIdx < 12; monthIdx++) {
+        if (timeString.compare(pos, 3, MONTH_NAMES[monthIdx]) == 0) {
+            timeAxis.month = monthIdx + 1;
+            pos += 3;
+            break;
+        }
+    }
+    if (timeAxis.month == 0) {
+        throw std::runtime_error("Error in parseGradsTimeAxis: Invalid month in time \"" + startTime + "\".");
+    }
+    size_t yearPos = pos;
+    timeAxis.year = parseNumber(timeString, pos);
+    // GrADS maps two-digit years to 1950-2049.
+    if (pos - yearPos == 2) {
+        timeAxis.year += timeAxis.year < 50 ? 2000 : 1900;
+    }
+    if (pos != timeString.size() || timeAxis.hour > 23 || timeAxis.minute > 59 || timeAxis.day < 1
+            || timeAxis.day > 31) {
+        throw std::runtime_error("Error in parseGradsTimeAxis: Invalid time \"" + startTime + "\".");
+    }
+
+    std::string incrementString = boost::to_lower_copy(increment);
+    pos = 0;
+    timeAxis.increment = parseNumber(incrementString, pos);
+    std::string unit = incrementString.substr(pos);
+    if (unit == "mn") {
+        timeAxis.incrementUnit = TimeIncrementUnit::MINUTES;
+    } else if (unit == "hr") {
+        timeAxis.increment *= 60;
+        timeAxis.incrementUnit = TimeIncrementUnit::MINUTES;
+    } else if (unit == "dy") {
+        timeAxis.increment *= 60 * 24;
+        timeAxis.incrementUnit = TimeIncrementUnit::MINUTES;
+    } else if (unit == "mo") {
+        timeAxis.incrementUnit = TimeIncrementUnit::MONTHS;
+    } else if (unit == "yr") {
+        timeAxis.increment *= 12;
+        timeAxis.incrementUnit = TimeIncrementUnit::MONTHS;
+    } else {
+        throw std::runtime_error("Error in parseGradsTimeAxis: Invalid time increment \"" + increment + "\".");
+    }
+    if (timeAxis.increment <= 0) {
+        throw std::runtime_error("Error in parseGradsTimeAxis: Invalid time increment \"" + increment + "\".");
+    }
+    return timeAxis;
+}
+
+std::string formatGradsTimeAxis(const TimeAxis& timeAxis) {
+    char startTime[64];
+    std::string month = boost::to_upper_copy(std::string(MONTH_NAMES[std::clamp(timeAxis.month, 1, 12) - 1]));
+    if (timeAxis.minute != 0) {
+        snprintf(
+                startTime, sizeof(startTime), "%02d:%02dZ%02d%s%04d",
+                timeAxis.hour, timeAxis.minute, timeAxis.day, month.c_str(), timeAxis.year);
+    } else {
+        snprintf(
+                startTime, sizeof(startTime), "%02dZ%02d%s%04d",
+                timeAxis.hour, timeAxis.day, month.c_str(), timeAxis.year);
+    }
+
+    // Use the largest unit the increment is a multiple of.
+    std::string increment;
+    if (timeAxis.incrementUnit == TimeIncrementUnit::MONTHS) {
+        increment = timeAxis.increment % 12 == 0
+                ? std::to_string(timeAxis.increment / 12) + "yr" : std::to_string(timeAxis.increment) + "mo";
+    } else if (timeAxis.increment % (60 * 24) == 0) {
+        increment = std::to_string(timeAxis.increment / (60 * 24)) + "dy";
+    } else if (timeAxis.increment % 60 == 0) {
+        increment = std::to_string(timeAxis.increment / 60) + "hr";
+    } else {
+        increment = std::to_string(timeAxis.increment) + "mn";
+    }
+    return std::string(startTime) + " " + increment;
+}
+
+TimeAggregation parseTimeAggregation(const std::string& aggregationName) {
+    TimeAggregation aggregation;
+    if (aggregationName == "daily") {
+        aggregation.type = TimeAggregationType::DAILY;
+    } else if (aggregationName == "monthly") {
+        aggregation.type = TimeAggregationType::MONTHLY;
+    } else {
+        size_t pos = 0;
+        try {
+            aggregation.numSteps = std::stoi(aggregationName, &pos);
+        } catch (const std::exception&) {
+            pos = 0;
+        }
+        if (pos == 0 || pos != aggregationName.size() || aggregation.numSteps < 1) {
+            throw std::runtime_error(
+                    "Error in parseTimeAggregation: Invalid temporal aggregation \"" + aggregationName
+                    + "\". Expected a number of time steps, 'daily' or 'monthly'.");
+        }
+        aggregation.type = TimeAggregationType::STEPS;
+    }
+    return aggregation;
+}
+
+std::string getTimeAggregationName(const TimeAggregation& aggregation) {
+    if (aggregation.type == TimeAggregationType::DAILY) {
+        return "daily";
+    } else if (aggregation.type == TimeAggregationType::MONTHLY) {
+        return "monthly";
+    } else if (aggregation.type == TimeAggregationType::STEPS) {
+        return std::to_string(aggregation.numSteps) + " steps";
+    }
+    return "none";
+}
+
+std::vector<int> computeAggregationPeriods(
+        const TimeAggregation& aggregation, const TimeAxis* timeAxis, size_t numTimeSteps) {
+    std::vector<int> periodIndices(numTimeSteps, 0);
+    if (aggregation.type == TimeAggregationType::STEPS) {
+        for (size_t t = 0; t < numTimeSteps; t++) {
+            periodIndices.at(t) = int(t / size_t(aggregation.numSteps));
+        }
+        return periodIndices;
+    }
+    if (aggregation.type == TimeAggregationType::NONE) {
+        return periodIndices;
+    }
+    if (!timeAxis) {
+        throw std::runtime_error(
+                "Error in computeAggregationPeriods: Daily and monthly aggregation need the time axis of the data set "
+                "(e.g., the tdef entry of a GrADS descriptor file).");
+    }
+
+    // The key of a time step is the day or month it lies in. A new period starts whenever the key changes.
+    int64_t startDays = daysFromCivil(timeAxis->year, timeAxis->month, timeAxis->day);
+    int64_t startMinutes = startDays * 1440 + timeAxis->hour * 60 + timeAxis->minute;
+    int64_t startMonths = int64_t(timeAxis->year) * 12 + timeAxis->month - 1;
+    int64_t lastKey = 0;
+    int periodIdx = -1;
+    for (size_t t = 0; t < numTimeSteps; t++) {
+        int64_t days, year, month, day;
+        if (timeAxis->incrementUnit == TimeIncrementUnit::MINUTES) {
+            int64_t minutes = startMinutes + int64_t(t) * timeAxis->increment;
+            days = minutes >= 0 ? minutes / 1440 : (minutes - 1439) / 1440;
+            civilFromDays(days, year, month, day);
+        } else {
+            int64_t months = startMonths + int64_t(t) * timeAxis->increment;
+            year = months >= 0 ? months / 12 : (months - 11) / 12;
+            month = months - year * 12 + 1;
+            days = daysFromCivil(year, month, timeAxis->day);
+        }
+        int64_t key = aggregation.type == TimeAggregationType::DAILY ? days : year * 12 + month - 1;
+        if (t == 0 || key != lastKey) {
+            periodIdx++;
+            lastKey = key;
+        }
+        periodIndices.at(t) = periodIdx;
+    }
+    return periodIndices;
+}
+
+/**
+ * Adds the entries of one time step to the running statistics. The loop is free of branches, so the compiler can
+ * vectorize it: missing entries are masked to zero for the sum and count, and comparisons with NaN are false, so they
+ * leave the minimum and maximum unchanged. The mask is applied to the bits of the value, as selecting the value before
+ * its conversion to double would keep the compiler from if-converting the loop (the conversion may trap for NaN).
+ */
+static void accumulateEntries(
+        const float* values, double* sum, float* minimum, float* maximum, int32_t* count, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        float value = values[i];
+        bool isValid = value == value;
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(float));
+        bits &= uint32_t(0) - uint32_t(isValid);
+        float validValue;
+        memcpy(&validValue, &bits, sizeof(float));
+        sum[i] = sum[i] + double(validValue);
+        count[i] = count[i] + int32_t(isValid);
+        float low = minimum[i], high = maximum[i];
+        minimum[i] = value < low ? value : low;
+        maximum[i] = value > high ? value : high;
+    }
+}
+
+/// The mean is NaN (0 / 0) for entries without valid values in the period.
+static void computeMeans(const double* sum, const int32_t* count, float* meanOut, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        meanOut[i] = float(sum[i] / double(count[i]));
+    }
+}
+
+/// Copies the minima or maxima. Entries without valid values in the period are NaN.
+static void copyValidExtrema(const float* extrema, const int32_t* count, float* extremaOut, size_t n) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t i = 0; i < n; i++) {
+        float extremum = extrema[i];
+        extremaOut[i] = count[i] > 0 ? extremum : nan;
+    }
+}
+
+TimeAggregator::TimeAggregator(std::vector<int> _periodIndices, std::vector<size_t> _slabSizes)
+        : periodIndices(std::move(_periodIndices)), slabSizes(std::move(_slabSizes)) {
+    for (size_t t = 0; t < periodIndices.size(); t++) {
+        if (size_t(periodIndices.at(t)) >= periodStartSteps.size()) {
+            periodStartSteps.push_back(int(t));
+        }
+    }
+    accumulators.resize(slabSizes.size());
+}
+
+void TimeAggregator::resetAccumulator(Accumulator& accumulator) {
+    std::fill(accumulator.sum.begin(), accumulator.sum.end(), 0.0);
+    std::fill(accumulator.minimum.begin(), accumulator.minimum.end(), std::numeric_limits<float>::infinity());
+    std::fill(accumulator.maximum.begin(), accumulator.maximum.end(), -std::numeric_limits<float>::infinity());
+    std::fill(accumulator.count.begin(), accumulator.count.end(), 0);
+}
+
+void TimeAggregator::addSlab(size_t slabIdx, size_t t, const float* values) {
+    size_t n = slabSizes.at(slabIdx);
+    Accumulator& accumulator = accumulators.at(slabIdx);
+    if (accumulator.sum.size() != n) {
+        accumulator.sum.resize(n);
+        accumulator.minimum.resize(n);
+        accumulator.maximum.resize(n);
+        accumulator.count.resize(n);
+        resetAccumulator(accumulator);
+    }
+    sgl::parallelFor(0, n, ACCUMULATION_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        accumulateEntries(
+                values + begin, accumulator.sum.data() + begin, accumulator.minimum.data() + begin,
+                accumulator.maximum.data() + begin, accumulator.count.data() + begin, end - begin);
+    });
+
+    size_t periodIdx = size_t(periodIndices.at(t));
+    bool isLastStep = t + 1 == periodIndices.size() || size_t(periodIndices.at(t + 1)) != periodIdx;
+    if (!isLastStep) {
+        return;
+    }
+    Result result;
+    result.periodIdx = periodIdx;
+    result.slabIdx = slabIdx;
+    result.mean.resize(n);
+    result.minimum.resize(n);
+    result.maximum.resize(n);
+    result.count = accumulator.count;
+    // One loop per output, as the compiler does not vectorize loops with multiple selects on the same condition.
+    sgl::parallelFor(0, n, ACCUMULATION_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        const int32_t* count = accumulator.count.data() + begin;
+        computeMeans(accumulator.sum.data() + begin, count, result.mean.data() + begin, end - begin);
+        copyValidExtrema(accumulator.minimum.data() + begin, count, result.minimum.data() + begin, end - begin);
+        copyValidExtrema(accumulator.maximum.data() + begin, count, result.maximum.data() + begin, end - begin);
+    });
+    completedResults.push_back(std::move(result));
+    resetAccumulator(accumulator);
+}
+
+std::vector<TimeAggregator::Result> TimeAggregator::takeCompletedResults() {
+    std::vector<Result> results;
+    std::swap(results, completedResults);
+    return results;
+}
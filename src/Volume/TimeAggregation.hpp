@@ -0,0 +1,129 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_TIMEAGGREGATION_HPP
+#define NCCONV_TIMEAGGREGATION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// Unit of the increment between the time steps of a time axis.
+enum class TimeIncrementUnit {
+    MINUTES, MONTHS
+};
+
+/**
+ * Linear time axis of a data set, e.g., "tdef 744 linear 00Z01JAN2000 1hr" in a GrADS descriptor file.
+ * Dates use the proleptic Gregorian calendar.
+ */
+struct TimeAxis {
+    int year = 1, month = 1, day = 1, hour = 0, minute = 0; ///< Time of the first time step.
+    int64_t increment = 0; ///< Increment between two time steps in incrementUnit.
+    TimeIncrementUnit incrementUnit = TimeIncrementUnit::MINUTES;
+};
+/**
+ * Parses the start time (hh[:mm]Zddmmmyyyy with optional parts, e.g., "00Z01JAN2000", "12:30Z1jan1990" or "jan2000")
+ * and increment (e.g., "30mn", "6hr", "1dy", "1mo" or "1yr") of a GrADS time axis. Throws an exception on errors.
+ */
+TimeAxis parseGradsTimeAxis(const std::string& startTime, const std::string& increment);
+/// Inverse of @see parseGradsTimeAxis. Returns the start time and increment, e.g., "06Z02FEB2001 6hr".
+std::string formatGradsTimeAxis(const TimeAxis& timeAxis);
+
+enum class TimeAggregationType {
+    NONE, STEPS, DAILY, MONTHLY
+};
+/// Periods of consecutive time steps that temporal aggregates are computed over.
+struct TimeAggregation {
+    TimeAggregationType type = TimeAggregationType::NONE;
+    int numSteps = 0; ///< Number of time steps per period for TimeAggregationType::STEPS.
+};
+/// Parses "daily", "monthly" or a number of time steps (e.g., "24"). Throws an exception for invalid values.
+TimeAggregation parseTimeAggregation(const std::string& aggregationName);
+/// Returns "daily", "monthly" or "N steps".
+std::string getTimeAggregationName(const TimeAggregation& aggregation);
+/**
+ * Assigns each time step to the period it is aggregated in. Periods are numbered consecutively starting at zero.
+ * Daily and monthly periods start at midnight and on the first day of a month, respectively, so the first and last
+ * period may be incomplete. These need a time axis (timeAxis != nullptr); otherwise, an exception is thrown.
+ */
+std::vector<int> computeAggregationPeriods(
+        const TimeAggregation& aggregation, const TimeAxis* timeAxis, size_t numTimeSteps);
+
+/**
+ * Computes the mean, minimum, maximum and number of valid entries over the time steps of each period while the time
+ * steps are streamed, i.e., without a second pass over the data. The field is split into slabs (@see FieldSlab), and
+ * each slab has its own running accumulators, which are allocated when the slab is added for the first time. Thus,
+ * at most one accumulator set of the size of the field exists at any time. The accumulators are updated with
+ * branch-free loops the compiler vectorizes. Missing entries (NaN) are skipped; the statistics of entries without
+ * valid values in a period are NaN (and a count of zero).
+ */
+class TimeAggregator {
+public:
+    /// Statistics of one slab over one period.
+    struct Result {
+        size_t periodIdx = 0;
+        size_t slabIdx = 0;
+        std::vector<float> mean, minimum, maximum;
+        std::vector<int32_t> count;
+    };
+
+    /**
+     * @param periodIndices The period of each time step (@see computeAggregationPeriods).
+     * @param slabSizes The number of entries of each slab.
+     */
+    TimeAggregator(std::vector<int> periodIndices, std::vector<size_t> slabSizes);
+    [[nodiscard]] size_t getNumPeriods() const { return periodStartSteps.size(); }
+    /// The first time step of each period.
+    [[nodiscard]] const std::vector<int>& getPeriodStartSteps() const { return periodStartSteps; }
+    /**
+     * Adds the entries of a slab at time step t. NaN entries are treated as missing. The time steps of a slab need to
+     * be added in ascending order. After the last time step of a period was added, the statistics of the slab are
+     * queued (@see takeCompletedResults) and its accumulators are reset.
+     */
+    void addSlab(size_t slabIdx, size_t t, const float* values);
+    /// Removes the statistics of all completed (period, slab) pairs from the queue and returns them.
+    std::vector<Result> takeCompletedResults();
+
+private:
+    struct Accumulator {
+        std::vector<double> sum;
+        std::vector<float> minimum, maximum;
+        std::vector<int32_t> count;
+    };
+    void resetAccumulator(Accumulator& accumulator);
+
+    std::vector<int> periodIndices;
+    std::vector<int> periodStartSteps;
+    std::vector<size_t> slabSizes;
+    std::vector<Accumulator> accumulators;
+    std::vector<Result> completedResults;
+};
+
+#endif //NCCONV_TIMEAGGREGATION_HPP
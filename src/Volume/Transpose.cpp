@@ -0,0 +1,70 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Transpose.hpp"
+
+template<class T>
+static void transposeBlockedTyped(const T* src, T* dst, size_t numRows, size_t numCols) {
+    constexpr size_t BLOCK_SIZE = 32;
+    for (size_t rowBlock = 0; rowBlock < numRows; rowBlock += BLOCK_SIZE) {
+        size_t rowEnd = std::min(rowBlock + BLOCK_SIZE, numRows);
+        for (size_t colBlock = 0; colBlock < numCols; colBlock += BLOCK_SIZE) {
+            size_t colEnd = std::min(colBlock + BLOCK_SIZE, numCols);
+            for (size_t col = colBlock; col < colEnd; col++) {
+                for (size_t row = rowBlock; row < rowEnd; row++) {
+                    dst[col * numRows + row] = src[row * numCols + col];
+                }
+            }
+        }
+    }
+}
+
+void transposeBlocked(const uint8_t* src, uint8_t* dst, size_t numRows, size_t numCols, size_t entrySize) {
+    switch (entrySize) {
+        case 1:
+            transposeBlockedTyped(src, dst, numRows, numCols);
+            break;
+        case 2:
+            transposeBlockedTyped(
+                    reinterpret_cast<const uint16_t*>(src), reinterpret_cast<uint16_t*>(dst), numRows, numCols);
+            break;
+        case 4:
+            transposeBlockedTyped(
+                    reinterpret_cast<const uint32_t*>(src), reinterpret_cast<uint32_t*>(dst), numRows, numCols);
+            break;
+        case 8:
+            transposeBlockedTyped(
+                    reinterpret_cast<const uint64_t*>(src), reinterpret_cast<uint64_t*>(dst), numRows, numCols);
+            break;
+        default:
+            throw std::runtime_error("Error in transposeBlocked: Unsupported entry size.");
+    }
+}
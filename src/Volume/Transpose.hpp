@@ -0,0 +1,46 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_TRANSPOSE_HPP
+#define NCCONV_TRANSPOSE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Transposes a row-major matrix of size numRows x numCols into a row-major matrix of size numCols x numRows.
+ * The matrix is processed in square blocks fitting into the L1 cache, so both the reads and the writes stay local.
+ * @param src The source matrix.
+ * @param dst The destination matrix. Must not overlap with the source matrix.
+ * @param numRows The number of rows of the source matrix.
+ * @param numCols The number of columns of the source matrix.
+ * @param entrySize The size of one entry in bytes (1, 2, 4 or 8).
+ */
+void transposeBlocked(const uint8_t* src, uint8_t* dst, size_t numRows, size_t numCols, size_t entrySize);
+
+#endif //NCCONV_TRANSPOSE_HPP
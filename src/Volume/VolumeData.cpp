@@ -28,12 +28,51 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <array>
+#include <limits>
+#include <memory>
 
+#include <boost/filesystem.hpp>
 #include <netcdf.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#include <netcdf_par.h>
+#endif
 
+#include "Utils/Hash.hpp"
+#include "Utils/TaskScheduler.hpp"
 #include "Loaders/VolumeLoader.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "FieldType.hpp"
+#include "NcFieldType.hpp"
+#include "Transpose.hpp"
+#include "DirectChunkWriter.hpp"
 #include "VolumeData.hpp"
 
+OutputLayout parseOutputLayout(const std::string& layoutName) {
+    if (layoutName == "maps" || layoutName == "default") {
+        return OutputLayout::MAPS;
+    } else if (layoutName == "timeseries") {
+        return OutputLayout::TIME_SERIES;
+    }
+    throw std::runtime_error("Error in parseOutputLayout: Unknown output layout \"" + layoutName + "\".");
+}
+
+OutputFloatType parseOutputFloatType(const std::string& typeName) {
+    if (typeName == "native" || typeName == "default") {
+        return OutputFloatType::NATIVE;
+    } else if (typeName == "float16" || typeName == "fp16" || typeName == "half") {
+        return OutputFloatType::FLOAT16;
+    } else if (typeName == "bfloat16" || typeName == "bf16") {
+        return OutputFloatType::BFLOAT16;
+    }
+    throw std::runtime_error("Error in parseOutputFloatType: Unknown output type \"" + typeName + "\".");
+}
+
 VolumeData::~VolumeData() {
     if (lon1d) {
         delete[] lon1d;
@@ -50,47 +89,756 @@ void VolumeData::setLoader(VolumeLoader* loader) {
     volumeLoader = loader;
 }
 
-void VolumeData::setGridExtent(int _xs, int _ys, int _zs, float* _lon1d, float* _lat1d, float* _lev1d) {
+void VolumeData::setGridExtent(size_t _xs, size_t _ys, size_t _zs, float* _lon1d, float* _lat1d, float* _lev1d) {
     xs = _xs;
     ys = _ys;
     zs = _zs;
+    // The grid may be replaced, e.g., by a coarsened grid (see CoarseningLoader).
+    if (lon1d != _lon1d) {
+        delete[] lon1d;
+    }
+    if (lat1d != _lat1d) {
+        delete[] lat1d;
+    }
+    if (lev1d != _lev1d) {
+        delete[] lev1d;
+    }
     lon1d = _lon1d;
     lat1d = _lat1d;
     lev1d = _lev1d;
 }
 
-void VolumeData::setNumTimeSteps(int _ts) {
+void VolumeData::setNumTimeSteps(size_t _ts) {
     ts = _ts;
 }
 
-void VolumeData::setEnsembleMemberCount(int _es) {
+void VolumeData::setEnsembleMemberCount(size_t _es) {
     es = _es;
 }
 
+void VolumeData::setTimeAxis(const TimeAxis& _timeAxis) {
+    timeAxis = _timeAxis;
+    hasTimeAxis = true;
+}
+
 void VolumeData::setFieldNames(const std::vector<std::string>& _fieldNames) {
     fieldNames = _fieldNames;
 }
 
+void VolumeData::setMaxMemory(size_t _maxMemory) {
+    maxMemory = _maxMemory;
+}
+
+void VolumeData::setIsVerbose(bool _isVerbose) {
+    isVerbose = _isVerbose;
+}
+
+void VolumeData::setOutputLayout(OutputLayout _outputLayout) {
+    outputLayout = _outputLayout;
+}
+
+void VolumeData::setSpillDirectory(const std::string& _spillDirectory) {
+    spillDirectory = _spillDirectory;
+}
+
+void VolumeData::setRecordSlabHashes(bool _recordSlabHashes) {
+    recordSlabHashes = _recordSlabHashes;
+}
+
+void VolumeData::setUseDirectChunkWrite(bool _useDirectChunkWrite) {
+    useDirectChunkWrite = _useDirectChunkWrite;
+}
+
+void VolumeData::setCollapseTimeInvariantFields(bool _collapseTimeInvariantFields) {
+    collapseTimeInvariantFields = _collapseTimeInvariantFields;
+}
+
+void VolumeData::setOutputFloatType(OutputFloatType _outputFloatType) {
+    outputFloatType = _outputFloatType;
+}
+
+void VolumeData::setTimeAggregation(const TimeAggregation& _timeAggregation) {
+    timeAggregation = _timeAggregation;
+}
+
+void VolumeData::setEnsembleStatistics(const std::vector<EnsembleStatistic>& _ensembleStatistics) {
+    ensembleStatistics = _ensembleStatistics;
+}
+
+void VolumeData::setWriteEnsembleMembers(bool _writeEnsembleMembers) {
+    writeEnsembleMembers = _writeEnsembleMembers;
+}
+
+void VolumeData::reportHalfFloatStats(const std::string& fieldName, const HalfFloatStats& stats) const {
+    int mpiRank = 0;
+    unsigned long long counts[] = {
+            stats.numEntries, stats.numMissing, stats.numOverflows, stats.numUnderflows, stats.numSubnormals };
+    double minValue = stats.minValue, maxValue = stats.maxValue;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Allreduce(MPI_IN_PLACE, counts, 5, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &minValue, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &maxValue, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    if (mpiRank != 0) {
+        return;
+    }
+    if (isVerbose) {
+        std::cout << "Converted variable '" << fieldName << "' to " << getOutputFloatTypeName(outputFloatType) << ": ";
+        if (minValue <= maxValue) {
+            std::cout << "range [" << minValue << ", " << maxValue << "], ";
+        }
+        std::cout << counts[1] << " of " << counts[0] << " entries missing, " << counts[2] << " overflow(s) to "
+                  << "infinity, " << counts[3] << " underflow(s) to zero, " << counts[4] << " subnormal(s)."
+                  << std::endl;
+    }
+    if (counts[2] > 0) {
+        std::cerr << "Warning: " << counts[2] << " finite entries of variable '" << fieldName << "' exceed the range "
+                  << "of " << getOutputFloatTypeName(outputFloatType) << " and were stored as infinity." << std::endl;
+    }
+}
+
+void VolumeData::setChunkShape(const std::vector<size_t>& _chunkShape) {
+    if (!_chunkShape.empty() && _chunkShape.size() != 3) {
+        throw std::runtime_error("Error in VolumeData::setChunkShape: Expected a chunk shape of the form (z, y, x).");
+    }
+    chunkShape = _chunkShape;
+}
+
+void VolumeData::setAccessPattern(AccessPattern _accessPattern) {
+    accessPattern = _accessPattern;
+}
+
+void VolumeData::setChunkTargetSize(size_t _chunkTargetSize) {
+    if (_chunkTargetSize == 0) {
+        throw std::runtime_error("Error in VolumeData::setChunkTargetSize: The chunk target size must be positive.");
+    }
+    chunkTargetSize = _chunkTargetSize;
+}
+
+void VolumeData::setDeflateLevel(int _deflateLevel) {
+    if (_deflateLevel < 0 || _deflateLevel > 9) {
+        throw std::runtime_error("Error in VolumeData::setDeflateLevel: The deflate level must be in [0, 9].");
+    }
+    deflateLevel = _deflateLevel;
+}
+
+void VolumeData::setUseShuffleFilter(bool _useShuffleFilter) {
+    useShuffleFilter = _useShuffleFilter;
+}
+
+void VolumeData::checkSequentialReadSettings() const {
+    if (!volumeLoader->getRequiresSequentialReads()) {
+        return;
+    }
+    int mpiSize = 1;
+#ifdef USE_MPI
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+#endif
+    // Derived fields read the slabs of their input fields again after these were written.
+    if (mpiSize > 1 || timeAggregation.type != TimeAggregationType::NONE || !ensembleStatistics.empty()
+            || collapseTimeInvariantFields || (outputLayout == OutputLayout::TIME_SERIES && ts > 1)
+            || volumeLoader->getHasDerivedFields()) {
+        throw std::runtime_error(
+                "Error in VolumeData::checkSequentialReadSettings: Input read from a stream only supports the maps "
+                "layout without temporal aggregation, ensemble statistics, collapsing time-invariant variables, "
+                "derived variables and MPI.");
+    }
+}
+
+std::vector<FieldSlab> VolumeData::computeFieldSlabs(
+        size_t varxs, size_t varys, size_t varzs, size_t entrySize, size_t chunkZ, size_t chunkY) const {
+    std::vector<FieldSlab> slabs;
+    size_t rowSize = varxs * entrySize;
+    size_t levelSize = rowSize * varys;
+    if (maxMemory == 0 || levelSize * varzs <= maxMemory) {
+        FieldSlab slab;
+        slab.zCount = varzs;
+        slab.yCount = varys;
+        slabs.push_back(slab);
+    } else if (levelSize <= maxMemory) {
+        // Stream whole z-levels.
+        size_t numLevelsPerSlab = maxMemory / levelSize;
+        if (numLevelsPerSlab >= chunkZ) {
+            numLevelsPerSlab -= numLevelsPerSlab % chunkZ;
+        }
+        for (size_t z = 0; z < varzs; z += numLevelsPerSlab) {
+            FieldSlab slab;
+            slab.zOffset = z;
+            slab.zCount = std::min(numLevelsPerSlab, varzs - z);
+            slab.yCount = varys;
+            slabs.push_back(slab);
+        }
+    } else {
+        // Even a single z-level does not fit into memory; stream bands of rows.
+        size_t numRowsPerSlab = std::max(maxMemory / rowSize, size_t(1));
+        if (numRowsPerSlab >= chunkY) {
+            numRowsPerSlab -= numRowsPerSlab % chunkY;
+        }
+        for (size_t z = 0; z < varzs; z++) {
+            for (size_t y = 0; y < varys; y += numRowsPerSlab) {
+                FieldSlab slab;
+                slab.zOffset = z;
+                slab.yOffset = y;
+                slab.yCount = std::min(numRowsPerSlab, varys - y);
+                slabs.push_back(slab);
+            }
+        }
+    }
+    return slabs;
+}
+
 
 void ncPutAttributeText(int ncid, int varid, const std::string &name, const std::string &value) {
     nc_put_att_text(ncid, varid, name.c_str(), value.size(), value.c_str());
 }
 
+/// Reads a text attribute. Returns false if the attribute does not exist or is not of type NC_CHAR.
+static bool ncGetAttributeText(int ncid, int varid, const std::string& name, std::string& value) {
+    nc_type type = NC_NAT;
+    size_t length = 0;
+    if (nc_inq_att(ncid, varid, name.c_str(), &type, &length) != NC_NOERR || type != NC_CHAR) {
+        return false;
+    }
+    value.resize(length);
+    return length == 0 || nc_get_att_text(ncid, varid, name.c_str(), &value[0]) == NC_NOERR;
+}
+
+/// Sets the fill value of a variable. The fill value is stored in the type of the variable.
+static void ncPutFillValue(int ncid, int varid, FieldDataType dataType, double fillValue) {
+    if (!getIsFieldDataTypeFloat(dataType) && !getIsFillValueRepresentable(dataType, fillValue)) {
+        throw std::runtime_error(
+                "Error in ncPutFillValue: The fill value " + std::to_string(fillValue) + " is out of the range of "
+                + getFieldDataTypeName(dataType) + ".");
+    }
+    switch (dataType) {
+        case FieldDataType::INT8: {
+            auto value = static_cast<signed char>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::UINT8: {
+            auto value = static_cast<unsigned char>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::INT16: {
+            auto value = static_cast<short>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::UINT16: {
+            auto value = static_cast<unsigned short>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::INT32: {
+            auto value = static_cast<int>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::FLOAT32: {
+            auto value = static_cast<float>(fillValue);
+            nc_def_var_fill(ncid, varid, 0, &value);
+            break;
+        }
+        case FieldDataType::FLOAT64: {
+            nc_def_var_fill(ncid, varid, 0, &fillValue);
+            break;
+        }
+    }
+}
+
+/**
+ * Writes the slab given by start and count, but skips the parts of the slab covering output chunks in which all
+ * entries are missing. As the fill value of the variable represents missing entries, these chunks need not be
+ * allocated by HDF5. The parts with valid entries are written as runs of chunks along x.
+ * @param runData Buffer for gathering the runs of chunks.
+ * @param numSkippedChunks Incremented by the number of skipped (partial) chunks.
+ */
+static int ncPutSlabSkippingMissingChunks(
+        int ncid, int varid, int zloc, int yloc, std::vector<size_t>& start, std::vector<size_t>& count,
+        const std::vector<size_t>& chunkSizes, const uint8_t* slabData, FieldDataType dataType, bool hasFillValue,
+        double fillValue, std::vector<uint8_t>& runData, size_t& numSkippedChunks) {
+    size_t entrySize = getFieldDataTypeSize(dataType);
+    size_t z0 = zloc >= 0 ? start[zloc] : 0, numZ = zloc >= 0 ? count[zloc] : 1;
+    size_t y0 = start[yloc], numY = count[yloc], numX = count.back();
+    size_t chunkZ = zloc >= 0 ? chunkSizes.at(zloc) : 1, chunkY = chunkSizes.at(yloc), chunkX = chunkSizes.back();
+    auto getEntries = [&](size_t z, size_t y, size_t x) {
+        return slabData + (((z - z0) * numY + (y - y0)) * numX + x) * entrySize;
+    };
+
+    // Rows of chunks in the slab, i.e., (z range, y range) pairs, and whether each chunk along x is all missing.
+    struct ChunkRow {
+        size_t zStart, zEnd, yStart, yEnd;
+    };
+    std::vector<ChunkRow> chunkRows;
+    for (size_t zStart = z0; zStart < z0 + numZ; zStart = (zStart / chunkZ + 1) * chunkZ) {
+        size_t zEnd = std::min((zStart / chunkZ + 1) * chunkZ, z0 + numZ);
+        for (size_t yStart = y0; yStart < y0 + numY; yStart = (yStart / chunkY + 1) * chunkY) {
+            size_t yEnd = std::min((yStart / chunkY + 1) * chunkY, y0 + numY);
+            chunkRows.push_back({ zStart, zEnd, yStart, yEnd });
+        }
+    }
+    size_t numChunksX = (numX + chunkX - 1) / chunkX;
+    std::vector<uint8_t> isChunkMissing(chunkRows.size() * numChunksX, 1);
+    size_t numMissingChunks = 0;
+    for (size_t rowIdx = 0; rowIdx < chunkRows.size(); rowIdx++) {
+        const ChunkRow& row = chunkRows.at(rowIdx);
+        for (size_t xc = 0; xc < numChunksX; xc++) {
+            size_t xStart = xc * chunkX, xCount = std::min(chunkX, numX - xStart);
+            bool isMissing = true;
+            for (size_t z = row.zStart; z < row.zEnd && isMissing; z++) {
+                for (size_t y = row.yStart; y < row.yEnd && isMissing; y++) {
+                    isMissing = getAreEntriesMissing(getEntries(z, y, xStart), dataType, xCount, hasFillValue, fillValue);
+                }
+            }
+            isChunkMissing.at(rowIdx * numChunksX + xc) = isMissing ? 1 : 0;
+            numMissingChunks += isMissing ? 1 : 0;
+        }
+    }
+    if (numMissingChunks == 0) {
+        return nc_put_vara(ncid, varid, start.data(), count.data(), slabData);
+    }
+    numSkippedChunks += numMissingChunks;
+
+    std::vector<size_t> runStart = start, runCount = count;
+    for (size_t rowIdx = 0; rowIdx < chunkRows.size(); rowIdx++) {
+        const ChunkRow& row = chunkRows.at(rowIdx);
+        for (size_t xc = 0; xc < numChunksX; ) {
+            if (isChunkMissing.at(rowIdx * numChunksX + xc)) {
+                xc++;
+                continue;
+            }
+            size_t xcEnd = xc;
+            while (xcEnd < numChunksX && !isChunkMissing.at(rowIdx * numChunksX + xcEnd)) {
+                xcEnd++;
+            }
+            size_t xStart = xc * chunkX, xCount = std::min(xcEnd * chunkX, numX) - xStart;
+            runData.resize((row.zEnd - row.zStart) * (row.yEnd - row.yStart) * xCount * entrySize);
+            uint8_t* runPtr = runData.data();
+            for (size_t z = row.zStart; z < row.zEnd; z++) {
+                for (size_t y = row.yStart; y < row.yEnd; y++) {
+                    memcpy(runPtr, getEntries(z, y, xStart), xCount * entrySize);
+                    runPtr += xCount * entrySize;
+                }
+            }
+            if (zloc >= 0) {
+                runStart[zloc] = row.zStart;
+                runCount[zloc] = row.zEnd - row.zStart;
+            }
+            runStart[yloc] = row.yStart;
+            runCount[yloc] = row.yEnd - row.yStart;
+            runStart.back() = start.back() + xStart;
+            runCount.back() = xCount;
+            int status = nc_put_vara(ncid, varid, runStart.data(), runCount.data(), runData.data());
+            if (status != NC_NOERR) {
+                return status;
+            }
+            xc = xcEnd;
+        }
+    }
+    return NC_NOERR;
+}
+
+static void ncPutSlabHashes(
+        int ncid, int varid, const std::vector<FieldSlab>& slabs, std::vector<unsigned long long>& slabHashes) {
+#ifdef USE_MPI
+    // Each hash was only computed by the rank owning the work item; the others are zero.
+    MPI_Allreduce(MPI_IN_PLACE, slabHashes.data(), int(slabHashes.size()), MPI_UNSIGNED_LONG_LONG, MPI_BXOR,
+                  MPI_COMM_WORLD);
+#endif
+    std::vector<long long> slabsData;
+    slabsData.reserve(slabs.size() * 4);
+    for (const FieldSlab& slab : slabs) {
+        slabsData.insert(slabsData.end(), {
+                (long long)slab.zOffset, (long long)slab.zCount, (long long)slab.yOffset, (long long)slab.yCount });
+    }
+    nc_put_att_longlong(ncid, varid, SLAB_HASHES_SLABS_ATTRIBUTE, NC_INT64, slabsData.size(), slabsData.data());
+    nc_put_att_ulonglong(ncid, varid, SLAB_HASHES_ATTRIBUTE, NC_UINT64, slabHashes.size(), slabHashes.data());
+}
+
+static bool ncGetSlabHashes(
+        int ncid, int varid, std::vector<FieldSlab>& slabs, std::vector<unsigned long long>& slabHashes) {
+    size_t numSlabsData = 0, numHashes = 0;
+    if (nc_inq_attlen(ncid, varid, SLAB_HASHES_SLABS_ATTRIBUTE, &numSlabsData) != NC_NOERR
+            || nc_inq_attlen(ncid, varid, SLAB_HASHES_ATTRIBUTE, &numHashes) != NC_NOERR
+            || numSlabsData % 4 != 0) {
+        return false;
+    }
+    // Files written before the slabs were stored as 64-bit integers use NC_INT, which is converted when reading.
+    std::vector<long long> slabsData(numSlabsData);
+    slabHashes.resize(numHashes);
+    if (nc_get_att_longlong(ncid, varid, SLAB_HASHES_SLABS_ATTRIBUTE, slabsData.data()) != NC_NOERR
+            || nc_get_att_ulonglong(ncid, varid, SLAB_HASHES_ATTRIBUTE, slabHashes.data()) != NC_NOERR
+            || std::any_of(slabsData.begin(), slabsData.end(), [](long long value) { return value < 0; })) {
+        return false;
+    }
+    slabs.resize(numSlabsData / 4);
+    for (size_t i = 0; i < slabs.size(); i++) {
+        slabs.at(i).zOffset = size_t(slabsData.at(i * 4));
+        slabs.at(i).zCount = size_t(slabsData.at(i * 4 + 1));
+        slabs.at(i).yOffset = size_t(slabsData.at(i * 4 + 2));
+        slabs.at(i).yCount = size_t(slabsData.at(i * 4 + 3));
+    }
+    return true;
+}
+
 bool VolumeData::writeToNcFile(const std::string& filePath) {
+    checkSequentialReadSettings();
     int ncid = -1;
-    int xVar{}, yVar{}, zVar{}, lonVar{}, latVar{};
-
-    float xOrigin = 0.0f;
-    float yOrigin = 0.0f;
-    float zOrigin = 0.0f;
 
+    // With MPI, all ranks write collectively into one file.
+#ifdef USE_MPI
+    int status = nc_create_par(
+            filePath.c_str(), NC_NETCDF4 | NC_CLOBBER, MPI_COMM_WORLD, MPI_INFO_NULL, &ncid);
+#else
     int status = nc_create(filePath.c_str(), NC_NETCDF4 | NC_CLOBBER, &ncid);
+#endif
     if (status != 0) {
         throw std::runtime_error(
-                "Error in NetCdfWriter::writeFieldToFile: File \"" + filePath + "\" couldn't be opened.");
+                "Error in NetCdfWriter::writeFieldToFile: File \"" + filePath + "\" couldn't be opened: "
+                + nc_strerror(status));
         return false;
     }
 
+    // The direct chunk writer reopens the file with HDF5 after the NetCDF library has closed it.
+    std::vector<DirectChunkField> directChunkFields;
+    bool isDirectChunkWriteSupported = false;
+#if defined(USE_HDF5_DIRECT_CHUNK_WRITE) && !defined(USE_MPI)
+    isDirectChunkWriteSupported = true;
+#endif
+    try {
+        writeToNcHandle(ncid, isDirectChunkWriteSupported && useDirectChunkWrite ? &directChunkFields : nullptr);
+    } catch (...) {
+        nc_close(ncid);
+        throw;
+    }
+
+    if (nc_close(ncid) != NC_NOERR) {
+        throw std::runtime_error(
+                "Error in NetCdfWriter::writeFieldToFile: nc_close failed for file \"" + filePath + "\".");
+        return false;
+    }
+
+    if (!directChunkFields.empty()) {
+        writeDirectChunkFields(filePath, directChunkFields);
+    }
+
+    return true;
+}
+
+void VolumeData::writeDirectChunkFields(
+        [[maybe_unused]] const std::string& filePath,
+        [[maybe_unused]] const std::vector<DirectChunkField>& directChunkFields) {
+#ifdef USE_HDF5_DIRECT_CHUNK_WRITE
+    if (isVerbose) {
+        std::cout << "Compressing " << directChunkFields.size() << " variable(s) with direct chunk writes..."
+                  << std::endl;
+    }
+    DirectChunkWriter directChunkWriter(this);
+    std::vector<std::vector<unsigned long long>> fieldSlabHashes =
+            directChunkWriter.writeFields(filePath, directChunkFields);
+    if (!recordSlabHashes) {
+        return;
+    }
+
+    // The slab hashes are only known after writing the data, so the file is reopened to add them as attributes.
+    int ncid = -1;
+    int status = nc_open(filePath.c_str(), NC_WRITE, &ncid);
+    if (status != NC_NOERR) {
+        throw std::runtime_error(
+                "Error in VolumeData::writeDirectChunkFields: Couldn't reopen file \"" + filePath + "\": "
+                + nc_strerror(status));
+    }
+    nc_redef(ncid);
+    for (size_t fieldIdx = 0; fieldIdx < directChunkFields.size(); fieldIdx++) {
+        int varid = -1;
+        nc_inq_varid(ncid, directChunkFields.at(fieldIdx).fieldName.c_str(), &varid);
+        ncPutSlabHashes(ncid, varid, directChunkFields.at(fieldIdx).slabs, fieldSlabHashes.at(fieldIdx));
+    }
+    nc_close(ncid);
+#endif
+}
+
+#ifdef USE_HDF5_DIRECT_CHUNK_WRITE
+/// Whether each slab starts at a chunk boundary in z and y, and ends at a chunk boundary or the end of the grid.
+static bool getAreSlabsChunkAligned(
+        const std::vector<FieldSlab>& slabs, size_t varzs, size_t varys, size_t chunkZ, size_t chunkY) {
+    for (const FieldSlab& slab : slabs) {
+        if (slab.zOffset % chunkZ != 0 || slab.yOffset % chunkY != 0
+                || (slab.zCount % chunkZ != 0 && slab.zOffset + slab.zCount != varzs)
+                || (slab.yCount % chunkY != 0 && slab.yOffset + slab.yCount != varys)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/// Variable IDs of the temporal aggregates of a field (@see TimeAggregator).
+struct AggregatedVariables {
+    int meanVar = -1, minVar = -1, maxVar = -1, countVar = -1;
+};
+
+/// Dimensions defined by @see VolumeData::defineNcDimensions. Negative if the file has no such dimension.
+struct NcFileDimensions {
+    int xDim = -1, yDim = -1, zDim = -1, tDim = -1, eDim = -1;
+    int aggregatedTDim = -1; ///< One entry per period of the temporal aggregates.
+    std::vector<int> aggregationPeriods; ///< Index of the period of each time step (@see computeAggregationPeriods).
+};
+
+/**
+ * Variable of a field defined by @see VolumeData::defineFieldVariable. The extent is the one of the field, and varts
+ * is 1 for collapsed time-invariant fields. The slabs and the chunking are set by @see VolumeData::planFieldSlabs.
+ */
+struct NcFieldVariable {
+    std::string fieldName;
+    int varid = -1;
+    size_t varxs = 0, varys = 0, varzs = 0, varts = 0;
+    FieldDataType dataType = FieldDataType::FLOAT32;
+    FieldDataType outputDataType = FieldDataType::FLOAT32;
+    size_t entrySize = 0, outputEntrySize = 0;
+    bool isHalfOutput = false;
+    bool hasMembers = false;
+    bool useTimeSeriesLayout = false;
+    size_t numDims = 0;
+    int tloc = -1, zloc = -1, yloc = 0; ///< Indices of the dimensions; negative if the variable has no such dimension.
+    bool hasFillValue = false;
+    double fillValue = 0.0;
+    bool isAggregated = false;
+    AggregatedVariables aggregatedVariables;
+
+    bool isChunked = false;
+    std::vector<size_t> chunkSizes;
+    size_t chunkT = 1; ///< Chunk size of the output in time.
+    /// If output or input chunks span multiple time steps, all time steps of a slab are written before the next slab.
+    bool isSlabMajor = false;
+    std::vector<FieldSlab> slabs;
+};
+
+/// Variable written by @see VolumeData::writeFieldsRecordMajor after all variables were defined.
+struct RecordMajorField {
+    NcFieldVariable variable;
+    bool skipMissingChunks = false;
+    std::vector<unsigned long long> slabHashes;
+    HalfFloatStats halfFloatStats;
+    size_t numSkippedChunks = 0;
+};
+
+/**
+ * Defines a float32 or int32 variable holding statistics of a field (e.g., temporal aggregates or ensemble statistics).
+ * Floating point variables use NaN as fill value. If chunkShape (z, y, x) is not empty, it is applied to the trailing
+ * dimensions, and the numLeadingDims leading dimensions (e.g., time) have a chunk size of 1.
+ */
+static int defineStatisticVariable(
+        int ncid, const std::string& varName, nc_type ncType, const std::vector<int>& dims, size_t numLeadingDims,
+        const std::string& cellMethods, const std::vector<size_t>& chunkShape, int deflateLevel,
+        bool useShuffleFilter) {
+    int varid = -1;
+    int status = nc_def_var(ncid, varName.c_str(), ncType, int(dims.size()), dims.data(), &varid);
+    if (status != NC_NOERR) {
+        throw std::runtime_error(
+                "Error in VolumeData::writeToNcHandle: Defining variable \"" + varName + "\" failed: "
+                + nc_strerror(status));
+    }
+    ncPutAttributeText(ncid, varid, "cell_methods", cellMethods);
+    if (ncType == NC_FLOAT) {
+        ncPutFillValue(ncid, varid, FieldDataType::FLOAT32, std::numeric_limits<double>::quiet_NaN());
+    }
+    if (!chunkShape.empty()) {
+        std::vector<size_t> chunkSizes(dims.size(), 1);
+        for (size_t i = numLeadingDims; i < dims.size(); i++) {
+            size_t dimLength = 1;
+            nc_inq_dimlen(ncid, dims.at(i), &dimLength);
+            chunkSizes.at(i) = std::clamp(chunkShape.at(chunkShape.size() - dims.size() + i), size_t(1), dimLength);
+        }
+        nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunkSizes.data());
+    }
+    if (deflateLevel > 0 || useShuffleFilter) {
+        nc_def_var_deflate(ncid, varid, useShuffleFilter ? 1 : 0, deflateLevel > 0 ? 1 : 0, deflateLevel);
+    }
+    return varid;
+}
+
+/**
+ * Defines the variables <name>_mean, <name>_min, <name>_max and <name>_count with the dimensions dims, whose first
+ * dimension is the aggregated time dimension. If chunkShape is not empty, chunks span one period.
+ */
+static AggregatedVariables defineAggregatedVariables(
+        int ncid, const std::string& fieldName, const std::vector<int>& dims, const std::vector<size_t>& chunkShape,
+        int deflateLevel, bool useShuffleFilter) {
+    AggregatedVariables aggregatedVariables;
+    const std::pair<const char*, int*> statistics[] = {
+            { "mean", &aggregatedVariables.meanVar }, { "min", &aggregatedVariables.minVar },
+            { "max", &aggregatedVariables.maxVar }, { "count", &aggregatedVariables.countVar },
+    };
+    for (const auto& statistic : statistics) {
+        bool isCount = statistic.second == &aggregatedVariables.countVar;
+        *statistic.second = defineStatisticVariable(
+                ncid, fieldName + "_" + statistic.first, isCount ? NC_INT : NC_FLOAT, dims, 1,
+                std::string("time_aggregated: ") + statistic.first, chunkShape, deflateLevel, useShuffleFilter);
+    }
+    return aggregatedVariables;
+}
+
+/// Converts a slab in its native type to float32 in floatData. Missing entries become NaN.
+static const float* getSlabAsFloat32(
+        const uint8_t* slabData, FieldDataType dataType, size_t numEntries, double fillValue,
+        std::vector<float>& floatData) {
+    if (dataType == FieldDataType::FLOAT32) {
+        return reinterpret_cast<const float*>(slabData);
+    }
+    floatData.resize(numEntries);
+    decodeFieldEntries(slabData, dataType, floatData.data(), FieldDataType::FLOAT32, numEntries, false, fillValue);
+    return floatData.data();
+}
+
+/// Converts a slab in its native type to float32 (if necessary) and adds it to the temporal aggregates.
+static void addSlabToAggregator(
+        TimeAggregator& timeAggregator, size_t slabIdx, size_t t, const uint8_t* slabData, FieldDataType dataType,
+        size_t numEntries, double fillValue, std::vector<float>& floatData) {
+    timeAggregator.addSlab(slabIdx, t, getSlabAsFloat32(slabData, dataType, numEntries, fillValue, floatData));
+}
+
+/// Writes the statistics of completed periods. The slabs are the slabs the aggregator was created with.
+static void writeAggregatedResults(
+        int ncid, const AggregatedVariables& aggregatedVariables, const std::string& fieldName,
+        const std::vector<FieldSlab>& slabs, size_t varxs, bool hasZDim,
+        const std::vector<TimeAggregator::Result>& results) {
+    std::vector<size_t> start(hasZDim ? 4 : 3, 0);
+    std::vector<size_t> count(hasZDim ? 4 : 3, 1);
+    for (const TimeAggregator::Result& result : results) {
+        const FieldSlab& slab = slabs.at(result.slabIdx);
+        start[0] = result.periodIdx;
+        if (hasZDim) {
+            start[1] = slab.zOffset;
+            count[1] = slab.zCount;
+        }
+        start[start.size() - 2] = slab.yOffset;
+        count[count.size() - 2] = slab.yCount;
+        count.back() = varxs;
+        int status = nc_put_vara_float(
+                ncid, aggregatedVariables.meanVar, start.data(), count.data(), result.mean.data());
+        if (status == NC_NOERR) {
+            status = nc_put_vara_float(
+                    ncid, aggregatedVariables.minVar, start.data(), count.data(), result.minimum.data());
+        }
+        if (status == NC_NOERR) {
+            status = nc_put_vara_float(
+                    ncid, aggregatedVariables.maxVar, start.data(), count.data(), result.maximum.data());
+        }
+        if (status == NC_NOERR) {
+            status = nc_put_vara_int(
+                    ncid, aggregatedVariables.countVar, start.data(), count.data(), result.count.data());
+        }
+        if (status != NC_NOERR) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeToNcHandle: Writing the temporal aggregates of variable \""
+                    + fieldName + "\" failed: " + nc_strerror(status));
+        }
+    }
+}
+
+bool VolumeData::writeToNcHandle(int ncid) {
+    return writeToNcHandle(ncid, nullptr);
+}
+
+bool VolumeData::writeToNcHandle(int ncid, [[maybe_unused]] std::vector<DirectChunkField>* directChunkFields) {
+    // With MPI, work items are distributed round-robin over the ranks.
+    int mpiRank = 0, mpiSize = 1;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+#endif
+
+    NcFileDimensions dimensions = defineNcDimensions(ncid, mpiRank, mpiSize);
+
+    // Input read from a stream (e.g., stdin) can only be read once in the order of the data file, i.e., members >
+    // time steps > variables. All variables are then defined first and written record by record.
+    bool isRecordMajor = volumeLoader->getRequiresSequentialReads();
+    std::vector<RecordMajorField> recordMajorFields;
+
+    for (size_t varIdx = 0; varIdx < fieldNames.size(); varIdx++) {
+        const std::string& fieldName = fieldNames.at(varIdx);
+        if (mpiRank == 0 && isVerbose && !isRecordMajor) {
+            std::cout << "Writing variable '" << fieldName << "'..." << std::endl;
+        }
+        size_t varxs = 0, varys = 0, varzs = 0;
+        auto entrySize = size_t(getFieldDataTypeSize(volumeLoader->getFieldDataType(fieldName)));
+        volumeLoader->getFieldExtent(fieldName, varxs, varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+
+        // Time-invariant fields are optionally written once without the time dimension.
+        size_t varts = ts;
+        if (collapseTimeInvariantFields && ts > 1
+                && getIsFieldTimeInvariant(fieldName, varxs, varys, varzs, entrySize, mpiRank, mpiSize)) {
+            if (mpiRank == 0 && isVerbose) {
+                std::cout << "Variable '" << fieldName << "' is time-invariant; writing a single time step..."
+                          << std::endl;
+            }
+            varts = 1;
+        }
+
+        // The ensemble statistics are written before (or instead of) the members.
+        if (!ensembleStatistics.empty()) {
+            writeEnsembleStatistics(ncid, dimensions, fieldName, varxs, varys, varzs, varts, mpiRank, mpiSize);
+            if (!writeEnsembleMembers) {
+                continue;
+            }
+        }
+
+        NcFieldVariable variable =
+                defineFieldVariable(ncid, dimensions, fieldName, varxs, varys, varzs, varts, mpiRank);
+        if (variable.useTimeSeriesLayout) {
+            writeFieldTimeSeriesLayout(
+                    ncid, variable.varid, fieldName, varxs, varys, varzs, variable.outputEntrySize,
+                    variable.chunkSizes.at(size_t(variable.yloc)), mpiRank, mpiSize,
+                    variable.isAggregated ? &variable.aggregatedVariables : nullptr);
+            continue;
+        }
+
+        planFieldSlabs(ncid, variable, isRecordMajor);
+        if (isRecordMajor) {
+            RecordMajorField recordMajorField;
+            recordMajorField.skipMissingChunks =
+                    variable.isChunked
+                    && (variable.hasFillValue || getIsFieldDataTypeFloat(variable.outputDataType));
+            recordMajorField.variable = std::move(variable);
+            recordMajorFields.push_back(std::move(recordMajorField));
+            continue;
+        }
+#ifdef USE_HDF5_DIRECT_CHUNK_WRITE
+        // The temporal aggregates are computed while streaming the slabs, so aggregated fields are written that way.
+        // The direct chunk writer does not support the member dimension.
+        if (directChunkFields && variable.isChunked && (deflateLevel > 0 || useShuffleFilter)
+                && !variable.isAggregated && !variable.hasMembers
+                && getAreSlabsChunkAligned(
+                        variable.slabs, varzs, varys,
+                        variable.zloc >= 0 ? variable.chunkSizes.at(size_t(variable.zloc)) : 1,
+                        variable.chunkSizes.at(size_t(variable.yloc)))) {
+            DirectChunkField directChunkField;
+            directChunkField.fieldName = fieldName;
+            directChunkField.slabs = variable.slabs;
+            directChunkField.chunkSizes = variable.chunkSizes;
+            directChunkField.numTimeSteps = std::max(varts, size_t(1));
+            directChunkField.hasTimeDim = varts > 1;
+            directChunkField.hasZDim = variable.zloc >= 0;
+            directChunkFields->push_back(directChunkField);
+            continue;
+        }
+#endif
+        writeFieldSlabs(ncid, variable, dimensions.aggregationPeriods, mpiRank, mpiSize);
+    }
+
+    if (!recordMajorFields.empty()) {
+        writeFieldsRecordMajor(ncid, recordMajorFields);
+    }
+
+    return true;
+}
+
+NcFileDimensions VolumeData::defineNcDimensions(int ncid, int mpiRank, int mpiSize) {
     ncPutAttributeText(ncid, NC_GLOBAL, "Conventions", "CF-1.5");
     ncPutAttributeText(ncid, NC_GLOBAL, "title", "Exported scalar field");
     ncPutAttributeText(ncid, NC_GLOBAL, "history", "ncconv");
@@ -100,23 +848,64 @@ bool VolumeData::writeToNcFile(const std::string& filePath) {
     ncPutAttributeText(ncid, NC_GLOBAL, "comment", "ncconv is released under the 2-clause BSD license.");
 
     // Create dimensions.
-    int xDim, yDim, zDim, tDim, eDim;
-    nc_def_dim(ncid, "x", xs, &xDim);
-    nc_def_dim(ncid, "y", ys, &yDim);
-    nc_def_dim(ncid, "z", zs, &zDim);
+    NcFileDimensions dimensions;
+    nc_def_dim(ncid, "x", xs, &dimensions.xDim);
+    nc_def_dim(ncid, "y", ys, &dimensions.yDim);
+    nc_def_dim(ncid, "z", zs, &dimensions.zDim);
     if (ts > 1) {
-        nc_def_dim(ncid, "time", ts, &tDim);
+        nc_def_dim(ncid, "time", ts, &dimensions.tDim);
     }
     if (es > 1) {
-        nc_def_dim(ncid, "member", es, &eDim);
+        nc_def_dim(ncid, "member", es, &dimensions.eDim);
+    }
+
+    // The members of ensemble data sets are written with the outermost dimension "member", like in GrADS data files.
+    bool useEnsembleStatistics = !ensembleStatistics.empty();
+    if (useEnsembleStatistics && es <= 1) {
+        throw std::runtime_error(
+                "Error in VolumeData::writeToNcHandle: Ensemble statistics need a data set with multiple members.");
+    }
+    if (es > 1 && !writeEnsembleMembers && !useEnsembleStatistics) {
+        throw std::runtime_error(
+                "Error in VolumeData::writeToNcHandle: Dropping the ensemble members needs ensemble statistics.");
+    }
+    if (es > 1) {
+        ncPutAttributeText(ncid, NC_GLOBAL, "ncconv_ensemble_members", writeEnsembleMembers ? "all" : "none");
+    }
+
+    // Temporal aggregates have their own time dimension with one entry per period.
+    bool useTimeAggregation = timeAggregation.type != TimeAggregationType::NONE;
+    int periodStartVar = -1;
+    if (useTimeAggregation) {
+        if (ts <= 1) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeToNcHandle: Temporal aggregation needs more than one time step.");
+        }
+        if (mpiSize > 1) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeToNcHandle: Temporal aggregation is not supported with MPI.");
+        }
+        if (es > 1) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeToNcHandle: Temporal aggregation of ensemble data sets is not "
+                    "supported.");
+        }
+        dimensions.aggregationPeriods = computeAggregationPeriods(timeAggregation, getTimeAxis(), ts);
+        nc_def_dim(
+                ncid, "time_aggregated", size_t(dimensions.aggregationPeriods.back() + 1),
+                &dimensions.aggregatedTDim);
+        nc_def_var(ncid, "time_aggregated_start", NC_INT, 1, &dimensions.aggregatedTDim, &periodStartVar);
+        ncPutAttributeText(ncid, periodStartVar, "long_name", "index of the first time step of the period");
+        ncPutAttributeText(ncid, NC_GLOBAL, "ncconv_time_aggregation", getTimeAggregationName(timeAggregation));
     }
 
     // Define the cell center variables.
-    nc_def_var(ncid, "x", NC_FLOAT, 1, &xDim, &xVar);
-    nc_def_var(ncid, "y", NC_FLOAT, 1, &yDim, &yVar);
-    nc_def_var(ncid, "z", NC_FLOAT, 1, &zDim, &zVar);
-    nc_def_var(ncid, "lon", NC_FLOAT, 1, &xDim, &lonVar);
-    nc_def_var(ncid, "lat", NC_FLOAT, 1, &yDim, &latVar);
+    int xVar{}, yVar{}, zVar{}, lonVar{}, latVar{};
+    nc_def_var(ncid, "x", NC_FLOAT, 1, &dimensions.xDim, &xVar);
+    nc_def_var(ncid, "y", NC_FLOAT, 1, &dimensions.yDim, &yVar);
+    nc_def_var(ncid, "z", NC_FLOAT, 1, &dimensions.zDim, &zVar);
+    nc_def_var(ncid, "lon", NC_FLOAT, 1, &dimensions.xDim, &lonVar);
+    nc_def_var(ncid, "lat", NC_FLOAT, 1, &dimensions.yDim, &latVar);
 
     ncPutAttributeText(ncid, xVar, "coordinate_type", "Cartesian X");
     ncPutAttributeText(ncid, yVar, "coordinate_type", "Cartesian Y");
@@ -127,86 +916,1034 @@ bool VolumeData::writeToNcFile(const std::string& filePath) {
     // ncPutAttributeText(ncid, yVar, "axis", "Y");
     // ncPutAttributeText(ncid, zVar, "axis", "Z");
 
-    // Write the grid cell centers to the x, y and z variables.
-    for (size_t x = 0; x < (size_t)xs; x++) {
-        nc_put_var1_float(ncid, xVar, &x, lon1d + x);
-        nc_put_var1_float(ncid, lonVar, &x, lon1d + x);
+    // Write the grid cell centers to the x, y and z variables (independent access when using MPI).
+    if (mpiRank == 0) {
+        for (size_t x = 0; x < (size_t)xs; x++) {
+            nc_put_var1_float(ncid, xVar, &x, lon1d + x);
+            nc_put_var1_float(ncid, lonVar, &x, lon1d + x);
+        }
+        for (size_t y = 0; y < (size_t)ys; y++) {
+            nc_put_var1_float(ncid, yVar, &y, lat1d + y);
+            nc_put_var1_float(ncid, latVar, &y, lat1d + y);
+        }
+        for (size_t z = 0; z < (size_t)zs; z++) {
+            nc_put_var1_float(ncid, zVar, &z, lev1d + z);
+        }
+        if (useTimeAggregation) {
+            std::vector<int> periodStartSteps =
+                    TimeAggregator(dimensions.aggregationPeriods, {}).getPeriodStartSteps();
+            size_t periodStart = 0, numPeriods = periodStartSteps.size();
+            nc_put_vara_int(ncid, periodStartVar, &periodStart, &numPeriods, periodStartSteps.data());
+        }
     }
-    for (size_t y = 0; y < (size_t)ys; y++) {
-        nc_put_var1_float(ncid, yVar, &y, lat1d + y);
-        nc_put_var1_float(ncid, latVar, &y, lat1d + y);
+
+    return dimensions;
+}
+
+NcFieldVariable VolumeData::defineFieldVariable(
+        int ncid, const NcFileDimensions& dimensions, const std::string& fieldName, size_t varxs, size_t varys,
+        size_t varzs, size_t varts, int mpiRank) {
+    NcFieldVariable variable;
+    variable.fieldName = fieldName;
+    variable.varxs = varxs;
+    variable.varys = varys;
+    variable.varzs = varzs;
+    variable.varts = varts;
+    variable.dataType = volumeLoader->getFieldDataType(fieldName);
+    variable.entrySize = size_t(getFieldDataTypeSize(variable.dataType));
+    // Floating point fields are optionally stored as 16-bit floats in NC_USHORT variables.
+    variable.isHalfOutput =
+            outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(variable.dataType);
+    variable.outputDataType = variable.isHalfOutput ? FieldDataType::UINT16 : variable.dataType;
+    variable.outputEntrySize = size_t(getFieldDataTypeSize(variable.outputDataType));
+    variable.hasMembers = es > 1 && writeEnsembleMembers;
+    variable.useTimeSeriesLayout = outputLayout == OutputLayout::TIME_SERIES && varts > 1;
+
+    const int xDim = dimensions.xDim, yDim = dimensions.yDim, zDim = dimensions.zDim, tDim = dimensions.tDim;
+    std::vector<int> dims;
+    int zloc, yloc;
+    if (variable.useTimeSeriesLayout && varzs > 1) {
+        dims = { zDim, yDim, xDim, tDim };
+        zloc = 0;
+        yloc = 1;
+    } else if (variable.useTimeSeriesLayout) {
+        dims = { yDim, xDim, tDim };
+        zloc = -1;
+        yloc = 0;
+    } else if (varts <= 1 && varzs > 1) {
+        dims = { zDim, yDim, xDim };
+        zloc = 0;
+        yloc = 1;
+    } else if (varts > 1 && varzs > 1) {
+        dims = { tDim, zDim, yDim, xDim };
+        zloc = 1;
+        yloc = 2;
+    } else if (varts <= 1) {
+        dims = { yDim, xDim };
+        zloc = -1;
+        yloc = 0;
+    } else {
+        dims = { tDim, yDim, xDim };
+        zloc = -1;
+        yloc = 1;
     }
-    for (size_t z = 0; z < (size_t)zs; z++) {
-        nc_put_var1_float(ncid, zVar, &z, lev1d + z);
+    int tloc = varts > 1 && !variable.useTimeSeriesLayout ? 0 : -1;
+    if (variable.hasMembers) {
+        dims.insert(dims.begin(), dimensions.eDim);
+        tloc = tloc >= 0 ? tloc + 1 : -1;
+        zloc = zloc >= 0 ? zloc + 1 : -1;
+        yloc++;
     }
+    variable.numDims = dims.size();
+    variable.tloc = tloc;
+    variable.zloc = zloc;
+    variable.yloc = yloc;
 
-    std::vector<int> dims;
-    std::vector<size_t> start;
-    std::vector<size_t> count;
-    //int dimsTimeIndependent3D[] = { zDim, yDim, xDim };
-    for (int varIdx = 0; varIdx < fieldNames.size(); varIdx++) {
-        const std::string& fieldName = fieldNames.at(varIdx);
-        std::cout << "Writing variable '" << fieldName << "'..." << std::endl;
-        int varxs = 0, varys = 0, varzs = 0;
-        float* fieldEntry = nullptr;
-        volumeLoader->getFieldEntry(this, fieldName, 0, 0, fieldEntry, varxs, varys, varzs);
-        varzs = std::max(varzs, 1);
-
-        int zloc, yloc;
-        if (ts <= 1 && varzs > 1) {
-            dims = { zDim, yDim, xDim };
-            zloc = 0;
-            yloc = 1;
-        } else if (ts > 1 && varzs > 1) {
-            dims = { tDim, zDim, yDim, xDim };
-            zloc = 1;
-            yloc = 2;
-        } else if (ts <= 1 && varzs <= 1) {
-            dims = { yDim, xDim };
-            zloc = -1;
-            yloc = 0;
-        } else if (ts > 1 && varzs <= 1) {
-            dims = { tDim, yDim, xDim };
-            zloc = -1;
-            yloc = 1;
-        }
-        start.clear();
-        count.clear();
-        start.resize(dims.size(), 0);
-        count.resize(dims.size(), 1);
-        count.back() = size_t(xs);
-
-        int scalarVar;
-        nc_def_var(ncid, fieldName.c_str(), NC_FLOAT, int(dims.size()), dims.data(), &scalarVar);
-        //size_t start[] = { 0, 0, 0 };
-        //size_t count[] = { 1, 1, size_t(xs) };
-        for (int t = 0; t < ts; t++) {
-            if (t != 0) {
-                delete[] fieldEntry;
-                fieldEntry = nullptr;
-                volumeLoader->getFieldEntry(this, fieldName, 0, 0, fieldEntry, varxs, varys, varzs);
-                varzs = std::max(varzs, 1);
-                start[0] = t;
-            }
-            for (int z = 0; z < varzs; z++) {
-                if (zloc >= 0) {
-                    start[zloc] = z;
+    int scalarVar;
+    nc_def_var(
+            ncid, fieldName.c_str(), getNcType(variable.outputDataType), int(dims.size()), dims.data(), &scalarVar);
+    variable.varid = scalarVar;
+    variable.hasFillValue = volumeLoader->getFieldFillValue(fieldName, variable.fillValue);
+    if (variable.isHalfOutput) {
+        variable.hasFillValue = true;
+        variable.fillValue = double(getOutputFloatTypeNaN(outputFloatType));
+        ncPutFillValue(ncid, scalarVar, variable.outputDataType, variable.fillValue);
+        ncPutAttributeText(ncid, scalarVar, "ncconv_dtype", getOutputFloatTypeName(outputFloatType));
+    } else if (variable.hasFillValue) {
+        ncPutFillValue(ncid, scalarVar, variable.dataType, variable.fillValue);
+    } else if (getIsFieldDataTypeFloat(variable.dataType)) {
+        // Missing entries of floating point fields are NaN, so chunks without valid entries need not be written.
+        ncPutFillValue(ncid, scalarVar, variable.dataType, std::numeric_limits<double>::quiet_NaN());
+    }
+    if (variable.useTimeSeriesLayout) {
+        // Chunks span the whole time axis, so reading the time series of one grid point touches one chunk.
+        size_t chunkPoints = std::max(chunkTargetSize / (varts * variable.outputEntrySize), size_t(1));
+        size_t chunkX = std::min(chunkPoints, varxs);
+        size_t chunkY = std::clamp(chunkPoints / chunkX, size_t(1), varys);
+        if (!chunkShape.empty()) {
+            chunkX = std::clamp(chunkShape.at(2), size_t(1), varxs);
+            chunkY = std::clamp(chunkShape.at(1), size_t(1), varys);
+        }
+        std::vector<size_t> chunkSizes(dims.size(), 1);
+        chunkSizes.at(yloc) = chunkY;
+        chunkSizes.at(yloc + 1) = chunkX;
+        chunkSizes.back() = varts;
+        nc_def_var_chunking(ncid, scalarVar, NC_CHUNKED, chunkSizes.data());
+        variable.isChunked = true;
+        variable.chunkSizes = chunkSizes;
+    } else if (!chunkShape.empty()) {
+        std::vector<size_t> chunkSizes(dims.size(), 1);
+        if (zloc >= 0) {
+            chunkSizes.at(zloc) = std::clamp(chunkShape.at(0), size_t(1), varzs);
+        }
+        chunkSizes.at(yloc) = std::clamp(chunkShape.at(1), size_t(1), varys);
+        chunkSizes.back() = std::clamp(chunkShape.at(2), size_t(1), varxs);
+        nc_def_var_chunking(ncid, scalarVar, NC_CHUNKED, chunkSizes.data());
+    } else if (accessPattern != AccessPattern::DEFAULT) {
+        std::array<size_t, 4> tunedChunk = computeChunkShape(
+                accessPattern, std::max(varts, size_t(1)), varzs, varys, varxs,
+                variable.outputEntrySize, chunkTargetSize);
+        std::vector<size_t> chunkSizes(dims.size(), 1);
+        if (tloc >= 0) {
+            chunkSizes.at(tloc) = tunedChunk[0];
+        }
+        if (zloc >= 0) {
+            chunkSizes.at(zloc) = tunedChunk[1];
+        }
+        chunkSizes.at(yloc) = tunedChunk[2];
+        chunkSizes.back() = tunedChunk[3];
+        nc_def_var_chunking(ncid, scalarVar, NC_CHUNKED, chunkSizes.data());
+        if (mpiRank == 0 && isVerbose) {
+            std::cout << "Chunk shape of variable '" << fieldName << "': (" << tunedChunk[0] << ", "
+                      << tunedChunk[1] << ", " << tunedChunk[2] << ", " << tunedChunk[3] << ")" << std::endl;
+        }
+    }
+    if (deflateLevel > 0 || useShuffleFilter) {
+        nc_def_var_deflate(ncid, scalarVar, useShuffleFilter ? 1 : 0, deflateLevel > 0 ? 1 : 0, deflateLevel);
+    }
+#ifdef USE_MPI
+    nc_var_par_access(ncid, scalarVar, NC_COLLECTIVE);
+#endif
+
+    // The aggregates of time-dependent fields always use the maps layout, as each series has few periods.
+    variable.isAggregated = timeAggregation.type != TimeAggregationType::NONE && varts > 1;
+    if (variable.isAggregated) {
+        std::vector<int> aggregatedDims = { dimensions.aggregatedTDim, yDim, xDim };
+        if (varzs > 1) {
+            aggregatedDims.insert(aggregatedDims.begin() + 1, zDim);
+        }
+        variable.aggregatedVariables = defineAggregatedVariables(
+                ncid, fieldName, aggregatedDims, chunkShape, deflateLevel, useShuffleFilter);
+    }
+    return variable;
+}
+
+void VolumeData::planFieldSlabs(int ncid, NcFieldVariable& variable, bool isRecordMajor) {
+    // The field is streamed in slabs fitting into the memory budget and aligned with the chunk shape of the variable.
+    int storage = NC_CONTIGUOUS;
+    std::vector<size_t> chunkSizes(variable.numDims, 1);
+    nc_inq_var_chunking(ncid, variable.varid, &storage, chunkSizes.data());
+    variable.isChunked = storage == NC_CHUNKED;
+    variable.chunkSizes = chunkSizes;
+    const int tloc = variable.tloc, zloc = variable.zloc, yloc = variable.yloc;
+    size_t chunkT = variable.isChunked && tloc >= 0 ? chunkSizes.at(tloc) : 1;
+    size_t chunkZ = variable.isChunked && zloc >= 0 ? chunkSizes.at(zloc) : 1;
+    size_t chunkY = variable.isChunked ? chunkSizes.at(yloc) : 1;
+    size_t outputChunkZ = chunkZ, outputChunkY = chunkY;
+    variable.chunkT = chunkT;
+    // If output chunks span multiple time steps, all time steps of a slab are written before the next slab, so
+    // the partially written chunks only stay in the chunk cache for a short time.
+    variable.isSlabMajor = chunkT > 1;
+    // When the input is chunked, too, the slabs also cover whole input chunks. If input chunks span multiple time
+    // steps, all time steps of a slab are read before the next slab, so the input chunks stay in the chunk cache.
+    size_t inputChunkT = 1, inputChunkZ = 1, inputChunkY = 1;
+    if (volumeLoader->getFieldInputChunking(variable.fieldName, inputChunkT, inputChunkZ, inputChunkY)) {
+        chunkZ = std::lcm(chunkZ, inputChunkZ);
+        chunkY = std::lcm(chunkY, inputChunkY);
+        variable.isSlabMajor = variable.isSlabMajor || inputChunkT > 1;
+    }
+    // The chunk cache holds chunkT time steps of a slab, so these need to fit into the memory budget together.
+    variable.slabs = computeFieldSlabs(
+            variable.varxs, variable.varys, variable.varzs, variable.entrySize * chunkT, chunkZ, chunkY);
+    if (!variable.isChunked) {
+        return;
+    }
+
+    // Size the chunk cache to hold all chunks overlapping one slab, so no chunk is evicted (and compressed) before it
+    // was written completely.
+    size_t chunkSize = variable.outputEntrySize;
+    for (size_t c : chunkSizes) {
+        chunkSize *= c;
+    }
+    size_t maxNumChunks = 0;
+    for (const FieldSlab& slab : variable.slabs) {
+        size_t numChunks =
+                countChunksSpanned(slab.yOffset, slab.yCount, outputChunkY)
+                * countChunksSpanned(0, size_t(variable.varxs), chunkSizes.back());
+        if (zloc >= 0) {
+            numChunks *= countChunksSpanned(slab.zOffset, slab.zCount, outputChunkZ);
+        }
+        // When writing record by record, chunks spanning multiple time steps are only complete once the last of
+        // their time steps was written, so the chunks of all slabs need to stay in the cache.
+        maxNumChunks = isRecordMajor && chunkT > 1 ? maxNumChunks + numChunks : std::max(maxNumChunks, numChunks);
+    }
+    nc_set_var_chunk_cache(
+            ncid, variable.varid, maxNumChunks * chunkSize, getNextPrime(4 * maxNumChunks), 1.0f);
+}
+
+void VolumeData::writeFieldSlabs(
+        int ncid, const NcFieldVariable& variable, const std::vector<int>& aggregationPeriods, int mpiRank,
+        int mpiSize) {
+    const std::string& fieldName = variable.fieldName;
+    const std::vector<FieldSlab>& slabs = variable.slabs;
+    const size_t varxs = variable.varxs;
+    const int tloc = variable.tloc, zloc = variable.zloc, yloc = variable.yloc;
+    size_t maxSlabSize = 0;
+    for (const FieldSlab& slab : slabs) {
+        maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+    }
+    if (slabs.size() > 1 && mpiRank == 0 && isVerbose) {
+        std::cout << "Streaming variable '" << fieldName << "' in " << slabs.size() << " slabs..." << std::endl;
+    }
+
+    // Work items are (member, time step, slab) tuples. As collective writes need to be issued by all ranks, ranks
+    // without a work item in the last round participate with an empty write.
+    auto numTimeSteps = std::max(variable.varts, size_t(1));
+    size_t numMembers = variable.hasMembers ? es : 1;
+    size_t numMemberItems = numTimeSteps * slabs.size();
+    size_t numItems = numMembers * numMemberItems;
+    bool isSlabMajor = variable.isSlabMajor;
+    auto getItem = [&](size_t itemIdx, size_t& m, size_t& t, size_t& slabIdx) {
+        m = itemIdx / numMemberItems;
+        size_t memberItemIdx = itemIdx % numMemberItems;
+        t = isSlabMajor ? memberItemIdx % numTimeSteps : memberItemIdx / slabs.size();
+        slabIdx = isSlabMajor ? memberItemIdx / numTimeSteps : memberItemIdx % slabs.size();
+    };
+    std::vector<unsigned long long> slabHashes(recordSlabHashes ? numItems : 0, 0);
+    size_t numRounds = (numItems + size_t(mpiSize) - 1) / size_t(mpiSize);
+    // Slabs converted to 16-bit floats are read into a separate buffer first. Only one slab is read at a time.
+    std::vector<uint8_t> nativeSlabData(variable.isHalfOutput ? maxSlabSize * variable.entrySize : 0);
+    HalfFloatStats halfFloatStats;
+    // The slabs are added to the temporal aggregates when they are read. Completed periods are written by the
+    // main thread after the read of the item completing them has finished.
+    std::unique_ptr<TimeAggregator> timeAggregator;
+    std::vector<float> aggregationData;
+    double aggregationFillValue = std::numeric_limits<double>::quiet_NaN();
+    if (variable.isAggregated) {
+        std::vector<size_t> slabSizes;
+        for (const FieldSlab& slab : slabs) {
+            slabSizes.push_back(slab.zCount * slab.yCount * varxs);
+        }
+        timeAggregator = std::make_unique<TimeAggregator>(aggregationPeriods, slabSizes);
+        volumeLoader->getFieldFillValue(fieldName, aggregationFillValue);
+    }
+    auto readItem = [&](size_t itemIdx, uint8_t* itemData) {
+        size_t m, t, slabIdx;
+        getItem(itemIdx, m, t, slabIdx);
+        const FieldSlab& slab = slabs.at(slabIdx);
+        size_t numEntries = slab.zCount * slab.yCount * varxs;
+        uint8_t* nativeData = variable.isHalfOutput ? nativeSlabData.data() : itemData;
+        volumeLoader->getFieldSlabNative(this, fieldName, t, m, slab, nativeData);
+        if (timeAggregator) {
+            addSlabToAggregator(
+                    *timeAggregator, slabIdx, t, nativeData, variable.dataType, numEntries, aggregationFillValue,
+                    aggregationData);
+        }
+        if (variable.isHalfOutput) {
+            encodeHalfFloats(
+                    nativeData, variable.dataType, reinterpret_cast<uint16_t*>(itemData), numEntries,
+                    outputFloatType, halfFloatStats);
+        }
+        if (recordSlabHashes) {
+            canonicalizeNaNs(itemData, variable.outputDataType, numEntries);
+            slabHashes.at(m * numMemberItems + t * slabs.size() + slabIdx) =
+                    sgl::hashXXH64Parallel(itemData, numEntries * variable.outputEntrySize);
+        }
+    };
+
+    // The next work item is read on the I/O pool while the current one is written, if the loader does not use
+    // the NetCDF library (which is not thread-safe) and a second slab buffer fits into the memory budget.
+    size_t slabBufferSize = maxSlabSize * variable.outputEntrySize;
+    bool usePrefetch =
+            numRounds > 1 && volumeLoader->getSupportsAsyncReads()
+            && (maxMemory == 0 || slabBufferSize * (variable.chunkT + 1) <= maxMemory);
+    std::vector<uint8_t> slabBuffers(usePrefetch ? 2 * slabBufferSize : slabBufferSize);
+    // Declared after the buffers, so a pending read finishes before they are freed (e.g., if a write fails).
+    sgl::TaskGroup prefetchGroup(sgl::getIoTaskPool());
+    if (usePrefetch && size_t(mpiRank) < numItems) {
+        prefetchGroup.run([&]() { readItem(size_t(mpiRank), slabBuffers.data()); });
+    }
+    // Chunks without valid entries are left unallocated and read back as the fill value. Collective writes need
+    // the same number of calls on all ranks, so chunks are only skipped when writing with a single rank.
+    bool skipMissingChunks =
+            variable.isChunked && mpiSize == 1
+            && (variable.hasFillValue || getIsFieldDataTypeFloat(variable.outputDataType));
+    std::vector<size_t> start(variable.numDims, 0);
+    std::vector<size_t> count(variable.numDims, 1);
+    std::vector<uint8_t> runData;
+    size_t numSkippedChunks = 0;
+    std::vector<TimeAggregator::Result> aggregatedResults;
+    for (size_t round = 0; round < numRounds; round++) {
+        size_t itemIdx = round * size_t(mpiSize) + size_t(mpiRank);
+        uint8_t* slabData = slabBuffers.data() + (usePrefetch ? round % 2 : 0) * slabBufferSize;
+        if (itemIdx < numItems) {
+            size_t m, t, slabIdx;
+            getItem(itemIdx, m, t, slabIdx);
+            const FieldSlab& slab = slabs.at(slabIdx);
+            if (usePrefetch) {
+                prefetchGroup.wait();
+                if (timeAggregator) {
+                    aggregatedResults = timeAggregator->takeCompletedResults();
+                }
+                size_t nextItemIdx = itemIdx + size_t(mpiSize);
+                if (nextItemIdx < numItems) {
+                    uint8_t* nextSlabData = slabBuffers.data() + ((round + 1) % 2) * slabBufferSize;
+                    prefetchGroup.run([&readItem, nextItemIdx, nextSlabData]() {
+                        readItem(nextItemIdx, nextSlabData);
+                    });
                 }
-                for (int y = 0; y < varys; y++) {
-                    start[yloc] = y;
-                    nc_put_vara_float(
-                            ncid, scalarVar, start.data(), count.data(), fieldEntry + y * varxs + z * varxs * varys);
+            } else {
+                readItem(itemIdx, slabData);
+                if (timeAggregator) {
+                    aggregatedResults = timeAggregator->takeCompletedResults();
                 }
             }
+            std::fill(start.begin(), start.end(), 0);
+            std::fill(count.begin(), count.end(), 1);
+            if (variable.hasMembers) {
+                start[0] = m;
+            }
+            if (tloc >= 0) {
+                start[tloc] = t;
+            }
+            if (zloc >= 0) {
+                start[zloc] = slab.zOffset;
+                count[zloc] = slab.zCount;
+            }
+            start[yloc] = slab.yOffset;
+            count[yloc] = slab.yCount;
+            count.back() = varxs;
+        } else {
+            std::fill(start.begin(), start.end(), 0);
+            std::fill(count.begin(), count.end(), 0);
+        }
+        int status;
+        if (skipMissingChunks && itemIdx < numItems) {
+            status = ncPutSlabSkippingMissingChunks(
+                    ncid, variable.varid, zloc, yloc, start, count, variable.chunkSizes, slabData,
+                    variable.outputDataType, variable.hasFillValue, variable.fillValue, runData, numSkippedChunks);
+        } else {
+            status = nc_put_vara(ncid, variable.varid, start.data(), count.data(), slabData);
         }
-        delete[] fieldEntry;
+        if (status != NC_NOERR) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeFieldSlabs: Writing variable \"" + fieldName + "\" failed: "
+                    + nc_strerror(status));
+        }
+        if (!aggregatedResults.empty()) {
+            writeAggregatedResults(
+                    ncid, variable.aggregatedVariables, fieldName, slabs, varxs, zloc >= 0, aggregatedResults);
+            aggregatedResults.clear();
+        }
+    }
+    if (recordSlabHashes) {
+        ncPutSlabHashes(ncid, variable.varid, slabs, slabHashes);
     }
+    if (variable.isHalfOutput) {
+        reportHalfFloatStats(fieldName, halfFloatStats);
+    }
+    if (isVerbose && numSkippedChunks > 0) {
+        std::cout << "Skipped " << numSkippedChunks << " chunk(s) of variable '" << fieldName
+                  << "' without valid entries." << std::endl;
+    }
+}
 
-    if (nc_close(ncid) != NC_NOERR) {
+void VolumeData::writeFieldsRecordMajor(int ncid, std::vector<RecordMajorField>& recordMajorFields) {
+    if (isVerbose) {
+        std::cout << "Writing " << recordMajorFields.size() << " variable(s) record by record..." << std::endl;
+    }
+    auto numTimeSteps = std::max(ts, size_t(1));
+    auto numMembers = std::max(es, size_t(1));
+    // The slabs are written synchronously, so all fields share the same buffers.
+    size_t maxSlabDataSize = 0, maxNativeSlabDataSize = 0;
+    for (RecordMajorField& field : recordMajorFields) {
+        const NcFieldVariable& variable = field.variable;
+        for (const FieldSlab& slab : variable.slabs) {
+            size_t numEntries = slab.zCount * slab.yCount * size_t(variable.varxs);
+            maxSlabDataSize = std::max(maxSlabDataSize, numEntries * variable.outputEntrySize);
+            if (variable.isHalfOutput) {
+                maxNativeSlabDataSize = std::max(maxNativeSlabDataSize, numEntries * variable.entrySize);
+            }
+        }
+        if (recordSlabHashes) {
+            field.slabHashes.resize(numMembers * numTimeSteps * variable.slabs.size(), 0);
+        }
+    }
+    std::vector<uint8_t> slabData(maxSlabDataSize), nativeSlabData(maxNativeSlabDataSize), runData;
+
+    for (size_t m = 0; m < numMembers; m++) {
+        for (size_t t = 0; t < numTimeSteps; t++) {
+            for (RecordMajorField& field : recordMajorFields) {
+                const NcFieldVariable& variable = field.variable;
+                std::vector<size_t> start(variable.numDims, 0), count(variable.numDims, 1);
+                if (numMembers > 1) {
+                    start[0] = m;
+                }
+                if (variable.tloc >= 0) {
+                    start[variable.tloc] = t;
+                }
+                count.back() = size_t(variable.varxs);
+                for (size_t slabIdx = 0; slabIdx < variable.slabs.size(); slabIdx++) {
+                    const FieldSlab& slab = variable.slabs.at(slabIdx);
+                    size_t numEntries = slab.zCount * slab.yCount * size_t(variable.varxs);
+                    uint8_t* nativeData = variable.isHalfOutput ? nativeSlabData.data() : slabData.data();
+                    volumeLoader->getFieldSlabNative(this, variable.fieldName, t, m, slab, nativeData);
+                    if (variable.isHalfOutput) {
+                        encodeHalfFloats(
+                                nativeData, variable.dataType, reinterpret_cast<uint16_t*>(slabData.data()),
+                                numEntries, outputFloatType, field.halfFloatStats);
+                    }
+                    if (recordSlabHashes) {
+                        canonicalizeNaNs(slabData.data(), variable.outputDataType, numEntries);
+                        field.slabHashes.at((m * numTimeSteps + t) * variable.slabs.size() + slabIdx) =
+                                sgl::hashXXH64Parallel(slabData.data(), numEntries * variable.outputEntrySize);
+                    }
+                    if (variable.zloc >= 0) {
+                        start[variable.zloc] = slab.zOffset;
+                        count[variable.zloc] = slab.zCount;
+                    }
+                    start[variable.yloc] = slab.yOffset;
+                    count[variable.yloc] = slab.yCount;
+                    int status;
+                    if (field.skipMissingChunks) {
+                        status = ncPutSlabSkippingMissingChunks(
+                                ncid, variable.varid, variable.zloc, variable.yloc, start, count, variable.chunkSizes,
+                                slabData.data(), variable.outputDataType, variable.hasFillValue, variable.fillValue,
+                                runData, field.numSkippedChunks);
+                    } else {
+                        status = nc_put_vara(ncid, variable.varid, start.data(), count.data(), slabData.data());
+                    }
+                    if (status != NC_NOERR) {
+                        throw std::runtime_error(
+                                "Error in VolumeData::writeFieldsRecordMajor: Writing variable \""
+                                + variable.fieldName + "\" failed: " + nc_strerror(status));
+                    }
+                }
+            }
+        }
+    }
+
+    for (RecordMajorField& field : recordMajorFields) {
+        if (recordSlabHashes) {
+            ncPutSlabHashes(ncid, field.variable.varid, field.variable.slabs, field.slabHashes);
+        }
+        if (field.variable.isHalfOutput) {
+            reportHalfFloatStats(field.variable.fieldName, field.halfFloatStats);
+        }
+        if (isVerbose && field.numSkippedChunks > 0) {
+            std::cout << "Skipped " << field.numSkippedChunks << " chunk(s) of variable '"
+                      << field.variable.fieldName << "' without valid entries." << std::endl;
+        }
+    }
+}
+
+bool VolumeData::getIsFieldTimeInvariant(
+        const std::string& fieldName, size_t varxs, size_t varys, size_t varzs, size_t entrySize,
+        int mpiRank, int mpiSize) {
+    FieldDataType dataType = volumeLoader->getFieldDataType(fieldName);
+    std::vector<FieldSlab> slabs = computeFieldSlabs(varxs, varys, varzs, entrySize, 1, 1);
+    size_t maxSlabSize = 0;
+    for (const FieldSlab& slab : slabs) {
+        maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+    }
+    std::vector<uint8_t> slabData(maxSlabSize * entrySize);
+
+    // Items are processed slab-major, so the first time step of a slab is hashed before the other ones. Without MPI,
+    // the search stops at the first slab differing from the first time step, which is usually the second item.
+    // Each ensemble member needs to be time-invariant on its own.
+    auto numTimeSteps = ts;
+    size_t numItems = std::max(es, size_t(1)) * slabs.size() * numTimeSteps;
+    std::vector<unsigned long long> slabHashes(numItems, 0);
+    bool isTimeInvariant = true;
+    for (size_t itemIdx = size_t(mpiRank); itemIdx < numItems && isTimeInvariant; itemIdx += size_t(mpiSize)) {
+        size_t t = itemIdx % numTimeSteps;
+        size_t slabIdx = (itemIdx / numTimeSteps) % slabs.size();
+        size_t m = itemIdx / (numTimeSteps * slabs.size());
+        const FieldSlab& slab = slabs.at(slabIdx);
+        size_t numEntries = slab.zCount * slab.yCount * varxs;
+        volumeLoader->getFieldSlabNative(this, fieldName, t, m, slab, slabData.data());
+        canonicalizeNaNs(slabData.data(), dataType, numEntries);
+        slabHashes.at(itemIdx) = sgl::hashXXH64Parallel(slabData.data(), numEntries * entrySize);
+        if (mpiSize == 1 && t > 0 && slabHashes.at(itemIdx) != slabHashes.at(itemIdx - t)) {
+            isTimeInvariant = false;
+        }
+    }
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, slabHashes.data(), int(slabHashes.size()), MPI_UNSIGNED_LONG_LONG, MPI_BXOR,
+                  MPI_COMM_WORLD);
+    for (size_t itemIdx = 0; itemIdx < numItems; itemIdx++) {
+        if (slabHashes.at(itemIdx) != slabHashes.at(itemIdx - itemIdx % numTimeSteps)) {
+            isTimeInvariant = false;
+        }
+    }
+#endif
+    return isTimeInvariant;
+}
+
+void VolumeData::writeEnsembleStatistics(
+        int ncid, const NcFileDimensions& dimensions, const std::string& fieldName, size_t varxs, size_t varys,
+        size_t varzs, size_t varts, int mpiRank, int mpiSize) {
+    std::vector<int> statisticDims = { dimensions.yDim, dimensions.xDim };
+    if (varzs > 1) {
+        statisticDims.insert(statisticDims.begin(), dimensions.zDim);
+    }
+    if (varts > 1) {
+        statisticDims.insert(statisticDims.begin(), dimensions.tDim);
+    }
+    std::vector<int> statisticVars;
+    for (const EnsembleStatistic& statistic : ensembleStatistics) {
+        std::string cellMethods =
+                statistic.type == EnsembleStatisticType::MEAN ? "member: mean"
+                : statistic.type == EnsembleStatisticType::STD ? "member: standard_deviation"
+                : "member: " + statistic.name;
+        int statisticVar = defineStatisticVariable(
+                ncid, fieldName + "_ens_" + statistic.name, NC_FLOAT, statisticDims, varts > 1 ? 1 : 0,
+                cellMethods, chunkShape, deflateLevel, useShuffleFilter);
+#ifdef USE_MPI
+        nc_var_par_access(ncid, statisticVar, NC_COLLECTIVE);
+#endif
+        statisticVars.push_back(statisticVar);
+    }
+
+    FieldDataType dataType = volumeLoader->getFieldDataType(fieldName);
+    auto entrySize = size_t(getFieldDataTypeSize(dataType));
+    double fillValue = std::numeric_limits<double>::quiet_NaN();
+    volumeLoader->getFieldFillValue(fieldName, fillValue);
+    std::vector<float> quantiles;
+    for (const EnsembleStatistic& statistic : ensembleStatistics) {
+        if (statistic.type == EnsembleStatisticType::QUANTILE) {
+            quantiles.push_back(statistic.quantile);
+        }
+    }
+    bool needsQuantiles = !quantiles.empty();
+
+    // The accumulators, one member slab in its native type and as float32, and the statistics of a slab need to fit
+    // into the memory budget. The slabs are aligned with the chunks of the statistics variables.
+    size_t memoryPerEntry =
+            EnsembleAccumulator::getMemoryPerEntry(es, needsQuantiles) + entrySize
+            + (dataType == FieldDataType::FLOAT32 ? 0 : sizeof(float)) + ensembleStatistics.size() * sizeof(float);
+    size_t chunkZ = chunkShape.empty() ? 1 : std::max(chunkShape.at(0), size_t(1));
+    size_t chunkY = chunkShape.empty() ? 1 : std::max(chunkShape.at(1), size_t(1));
+    std::vector<FieldSlab> slabs = computeFieldSlabs(varxs, varys, varzs, memoryPerEntry, chunkZ, chunkY);
+    size_t maxSlabSize = 0;
+    for (const FieldSlab& slab : slabs) {
+        maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+    }
+    if (mpiRank == 0 && isVerbose) {
+        std::cout << "Computing the ensemble statistics of variable '" << fieldName << "' over " << es
+                  << " members..." << std::endl;
+    }
+
+    EnsembleAccumulator accumulator(es, needsQuantiles);
+    std::vector<uint8_t> nativeData(maxSlabSize * entrySize);
+    std::vector<float> floatData;
+    std::vector<float> statisticData(ensembleStatistics.size() * maxSlabSize);
+    std::vector<float*> quantileOutputs;
+    for (size_t i = 0; i < ensembleStatistics.size(); i++) {
+        if (ensembleStatistics.at(i).type == EnsembleStatisticType::QUANTILE) {
+            quantileOutputs.push_back(statisticData.data() + i * maxSlabSize);
+        }
+    }
+
+    // Work items are (time step, slab) pairs. As collective writes need to be issued by all ranks, ranks without a
+    // work item in the last round participate with empty writes.
+    auto numTimeSteps = std::max(varts, size_t(1));
+    size_t numItems = numTimeSteps * slabs.size();
+    size_t numRounds = (numItems + size_t(mpiSize) - 1) / size_t(mpiSize);
+    size_t numDims = (varts > 1 ? 1 : 0) + (varzs > 1 ? 1 : 0) + 2;
+    std::vector<size_t> start(numDims, 0);
+    std::vector<size_t> count(numDims, 0);
+    for (size_t round = 0; round < numRounds; round++) {
+        size_t itemIdx = round * size_t(mpiSize) + size_t(mpiRank);
+        if (itemIdx < numItems) {
+            size_t t = itemIdx / slabs.size();
+            const FieldSlab& slab = slabs.at(itemIdx % slabs.size());
+            size_t numEntries = slab.zCount * slab.yCount * varxs;
+            accumulator.reset(numEntries);
+            for (size_t m = 0; m < es; m++) {
+                volumeLoader->getFieldSlabNative(this, fieldName, t, m, slab, nativeData.data());
+                accumulator.addMember(
+                        m, getSlabAsFloat32(nativeData.data(), dataType, numEntries, fillValue, floatData));
+            }
+            for (size_t i = 0; i < ensembleStatistics.size(); i++) {
+                float* output = statisticData.data() + i * maxSlabSize;
+                if (ensembleStatistics.at(i).type == EnsembleStatisticType::MEAN) {
+                    accumulator.computeMean(output);
+                } else if (ensembleStatistics.at(i).type == EnsembleStatisticType::STD) {
+                    accumulator.computeStandardDeviation(output);
+                }
+            }
+            if (needsQuantiles) {
+                accumulator.computeQuantiles(quantiles, quantileOutputs.data());
+            }
+            size_t dimIdx = 0;
+            if (varts > 1) {
+                start[dimIdx] = t;
+                count[dimIdx++] = 1;
+            }
+            if (varzs > 1) {
+                start[dimIdx] = slab.zOffset;
+                count[dimIdx++] = slab.zCount;
+            }
+            start[dimIdx] = slab.yOffset;
+            count[dimIdx++] = slab.yCount;
+            count[dimIdx] = varxs;
+        } else {
+            std::fill(start.begin(), start.end(), 0);
+            std::fill(count.begin(), count.end(), 0);
+        }
+        for (size_t i = 0; i < ensembleStatistics.size(); i++) {
+            int status = nc_put_vara_float(
+                    ncid, statisticVars.at(i), start.data(), count.data(), statisticData.data() + i * maxSlabSize);
+            if (status != NC_NOERR) {
+                throw std::runtime_error(
+                        "Error in VolumeData::writeEnsembleStatistics: Writing variable \"" + fieldName + "_ens_"
+                        + ensembleStatistics.at(i).name + "\" failed: " + nc_strerror(status));
+            }
+        }
+    }
+}
+
+void VolumeData::writeFieldTimeSeriesLayout(
+        int ncid, int varid, const std::string& fieldName, size_t varxs, size_t varys, size_t varzs, size_t entrySize,
+        size_t chunkY, int mpiRank, int mpiSize, const AggregatedVariables* aggregatedVariables) {
+    // The loader delivers maps of shape (t)(y, x) per z-level. These are transposed to (y, x)(t) in bands of rows.
+    // Half of the memory budget is used for reading the maps, the other half for the band and its transposed copy.
+    auto numTimeSteps = ts;
+    bool hasMembers = es > 1 && writeEnsembleMembers;
+    size_t numMembers = hasMembers ? es : 1;
+    size_t rowSize = varxs * entrySize;
+    size_t levelSize = rowSize * varys;
+    bool useSpillFile = maxMemory != 0 && 2 * levelSize * numTimeSteps > maxMemory;
+    size_t numBandRows = varys;
+    size_t numGroupTimeSteps = numTimeSteps;
+    if (useSpillFile) {
+        numBandRows = std::clamp(maxMemory / 4 / (rowSize * numTimeSteps), size_t(1), varys);
+        if (numBandRows > chunkY) {
+            numBandRows -= numBandRows % chunkY;
+        }
+        numGroupTimeSteps = std::clamp(maxMemory / 2 / levelSize, size_t(1), numTimeSteps);
+    }
+    size_t numBands = (varys + numBandRows - 1) / numBandRows;
+
+    // Maps larger than the budget are read in bands of rows, too.
+    std::vector<FieldSlab> levelSlabs = computeFieldSlabs(varxs, varys, 1, entrySize, 1, 1);
+    // Fields converted to 16-bit floats are read slab by slab into a separate buffer.
+    FieldDataType nativeDataType = volumeLoader->getFieldDataType(fieldName);
+    bool isHalfOutput = outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(nativeDataType);
+    FieldDataType dataType = isHalfOutput ? FieldDataType::UINT16 : nativeDataType;
+    std::vector<uint8_t> nativeSlabData;
+    HalfFloatStats halfFloatStats;
+    if (isHalfOutput) {
+        size_t maxSlabRows = 0;
+        for (const FieldSlab& slab : levelSlabs) {
+            maxSlabRows = std::max(maxSlabRows, slab.yCount);
+        }
+        nativeSlabData.resize(maxSlabRows * varxs * getFieldDataTypeSize(nativeDataType));
+    }
+    // The hashed (and aggregated) slabs are the map slabs of all z-levels.
+    std::vector<FieldSlab> hashSlabs;
+    std::vector<unsigned long long> slabHashes;
+    if (recordSlabHashes || aggregatedVariables) {
+        for (size_t z = 0; z < varzs; z++) {
+            for (FieldSlab slab : levelSlabs) {
+                slab.zOffset = z;
+                hashSlabs.push_back(slab);
+            }
+        }
+    }
+    if (recordSlabHashes) {
+        slabHashes.resize(numMembers * numTimeSteps * hashSlabs.size(), 0);
+    }
+    std::unique_ptr<TimeAggregator> timeAggregator;
+    std::vector<float> aggregationData;
+    double aggregationFillValue = std::numeric_limits<double>::quiet_NaN();
+    if (aggregatedVariables) {
+        std::vector<size_t> slabSizes;
+        for (const FieldSlab& slab : hashSlabs) {
+            slabSizes.push_back(slab.yCount * varxs);
+        }
+        timeAggregator = std::make_unique<TimeAggregator>(
+                computeAggregationPeriods(timeAggregation, getTimeAxis(), ts), slabSizes);
+        volumeLoader->getFieldFillValue(fieldName, aggregationFillValue);
+    }
+    std::vector<uint8_t> levelData(levelSize * numGroupTimeSteps);
+    std::vector<uint8_t> bandData(useSpillFile ? rowSize * numBandRows * numTimeSteps : 0);
+    std::vector<uint8_t> transposedData(rowSize * numBandRows * numTimeSteps);
+
+    // The spill file stores the bands one after another as (band)(t, y, x). Thus, each band of a group of time steps
+    // is appended with one contiguous write, and each band is read back with one contiguous read.
+    FILE* spillFile = nullptr;
+    boost::filesystem::path spillFilePath;
+    if (useSpillFile) {
+        boost::filesystem::path spillDir =
+                spillDirectory.empty() ? boost::filesystem::temp_directory_path() : spillDirectory;
+        spillFilePath = spillDir / boost::filesystem::unique_path("ncconv-spill-%%%%-%%%%-%%%%.bin");
+        spillFile = fopen(spillFilePath.string().c_str(), "w+b");
+        if (!spillFile) {
+            throw std::runtime_error(
+                    "Error in VolumeData::writeFieldTimeSeriesLayout: Could not create spill file \""
+                    + spillFilePath.string() + "\".");
+        }
+        if (mpiRank == 0 && isVerbose) {
+            std::cout << "Transposing variable '" << fieldName << "' out-of-core in " << numBands << " bands..."
+                      << std::endl;
+        }
+    }
+    auto cleanup = [&]() {
+        if (spillFile) {
+            fclose(spillFile);
+            spillFile = nullptr;
+            boost::system::error_code ec;
+            boost::filesystem::remove(spillFilePath, ec);
+        }
+    };
+    auto throwError = [&](const std::string& message) {
+        cleanup();
+        throw std::runtime_error("Error in VolumeData::writeFieldTimeSeriesLayout: " + message);
+    };
+
+    size_t zloc = hasMembers ? 1 : 0;
+    size_t numDims = (varzs > 1 ? 4 : 3) + (hasMembers ? 1 : 0);
+    size_t yloc = zloc + (varzs > 1 ? 1 : 0);
+    std::vector<size_t> start(numDims, 0);
+    std::vector<size_t> count(numDims, 0);
+
+    // (member, z-level) pairs are distributed round-robin over the ranks. Each level issues one collective write per
+    // band.
+    size_t numLevelItems = numMembers * varzs;
+    size_t numRounds = (numLevelItems + size_t(mpiSize) - 1) / size_t(mpiSize);
+    for (size_t round = 0; round < numRounds; round++) {
+        size_t levelItemIdx = round * size_t(mpiSize) + size_t(mpiRank);
+        size_t m = levelItemIdx / varzs;
+        size_t z = levelItemIdx % varzs;
+        bool hasLevel = levelItemIdx < numLevelItems;
+
+        for (size_t t0 = 0; hasLevel && t0 < numTimeSteps; t0 += numGroupTimeSteps) {
+            size_t numGroupEntries = std::min(numGroupTimeSteps, numTimeSteps - t0);
+            for (size_t tt = 0; tt < numGroupEntries; tt++) {
+                uint8_t* mapData = levelData.data() + tt * levelSize;
+                for (size_t slabIdx = 0; slabIdx < levelSlabs.size(); slabIdx++) {
+                    FieldSlab slab = levelSlabs.at(slabIdx);
+                    slab.zOffset = z;
+                    uint8_t* slabData = mapData + slab.yOffset * rowSize;
+                    uint8_t* nativeData = isHalfOutput ? nativeSlabData.data() : slabData;
+                    volumeLoader->getFieldSlabNative(this, fieldName, t0 + tt, m, slab, nativeData);
+                    if (timeAggregator) {
+                        size_t aggregationSlabIdx = z * levelSlabs.size() + slabIdx;
+                        addSlabToAggregator(
+                                *timeAggregator, aggregationSlabIdx, t0 + tt, nativeData, nativeDataType,
+                                slab.yCount * varxs, aggregationFillValue, aggregationData);
+                        writeAggregatedResults(
+                                ncid, *aggregatedVariables, fieldName, hashSlabs, varxs, varzs > 1,
+                                timeAggregator->takeCompletedResults());
+                    }
+                    if (isHalfOutput) {
+                        encodeHalfFloats(
+                                nativeData, nativeDataType, reinterpret_cast<uint16_t*>(slabData),
+                                slab.yCount * varxs, outputFloatType, halfFloatStats);
+                    }
+                    if (recordSlabHashes) {
+                        size_t numEntries = slab.yCount * varxs;
+                        canonicalizeNaNs(slabData, dataType, numEntries);
+                        size_t hashIdx =
+                                (m * numTimeSteps + t0 + tt) * hashSlabs.size() + z * levelSlabs.size() + slabIdx;
+                        slabHashes.at(hashIdx) = sgl::hashXXH64Parallel(slabData, numEntries * entrySize);
+                    }
+                }
+            }
+            if (!useSpillFile) {
+                continue;
+            }
+            for (size_t y0 = 0; y0 < varys; y0 += numBandRows) {
+                size_t bandRows = std::min(numBandRows, varys - y0);
+                auto offset = off_t(y0 * rowSize * numTimeSteps + t0 * bandRows * rowSize);
+                if (fseeko(spillFile, offset, SEEK_SET) != 0) {
+                    throwError("Seeking in the spill file failed.");
+                }
+                for (size_t tt = 0; tt < numGroupEntries; tt++) {
+                    const uint8_t* bandSrc = levelData.data() + tt * levelSize + y0 * rowSize;
+                    if (fwrite(bandSrc, 1, bandRows * rowSize, spillFile) != bandRows * rowSize) {
+                        throwError("Writing to the spill file failed.");
+                    }
+                }
+            }
+        }
+
+        for (size_t bandIdx = 0; bandIdx < numBands; bandIdx++) {
+            size_t y0 = bandIdx * numBandRows;
+            size_t bandRows = std::min(numBandRows, varys - y0);
+            if (hasLevel) {
+                const uint8_t* bandSrc = levelData.data();
+                if (useSpillFile) {
+                    size_t bandSize = bandRows * rowSize * numTimeSteps;
+                    if (fseeko(spillFile, off_t(y0 * rowSize * numTimeSteps), SEEK_SET) != 0
+                            || fread(bandData.data(), 1, bandSize, spillFile) != bandSize) {
+                        throwError("Reading from the spill file failed.");
+                    }
+                    bandSrc = bandData.data();
+                }
+                transposeBlocked(
+                        bandSrc, transposedData.data(), numTimeSteps, bandRows * varxs, entrySize);
+                if (hasMembers) {
+                    start[0] = m;
+                    count[0] = 1;
+                }
+                if (varzs > 1) {
+                    start[zloc] = z;
+                    count[zloc] = 1;
+                }
+                start[yloc] = y0;
+                count[yloc] = bandRows;
+                count[yloc + 1] = varxs;
+                count[yloc + 2] = numTimeSteps;
+            } else {
+                std::fill(start.begin(), start.end(), 0);
+                std::fill(count.begin(), count.end(), 0);
+            }
+            int status = nc_put_vara(ncid, varid, start.data(), count.data(), transposedData.data());
+            if (status != NC_NOERR) {
+                throwError("Writing variable \"" + fieldName + "\" failed: " + nc_strerror(status));
+            }
+        }
+    }
+
+    cleanup();
+    if (recordSlabHashes) {
+        ncPutSlabHashes(ncid, varid, hashSlabs, slabHashes);
+    }
+    if (isHalfOutput) {
+        reportHalfFloatStats(fieldName, halfFloatStats);
+    }
+}
+
+bool VolumeData::verifyNcFile(const std::string& filePath, bool useRecordedHashesOnly) {
+    int mpiRank = 0, mpiSize = 1;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+#endif
+
+    int ncid = -1;
+    int status = nc_open(filePath.c_str(), NC_NOWRITE, &ncid);
+    if (status != NC_NOERR) {
         throw std::runtime_error(
-                "Error in NetCdfWriter::writeFieldToFile: nc_close failed for file \"" + filePath + "\".");
-        return false;
+                "Error in VolumeData::verifyNcFile: Couldn't open file \"" + filePath + "\": "
+                + nc_strerror(status));
     }
 
-    return true;
+    // Files written with setWriteEnsembleMembers(false) only contain the ensemble statistics, which are not verified.
+    std::string ensembleMembers;
+    bool hasNoMembers =
+            ncGetAttributeText(ncid, NC_GLOBAL, "ncconv_ensemble_members", ensembleMembers)
+            && ensembleMembers == "none";
+
+    unsigned long long numMismatches = 0;
+    for (const std::string& fieldName : fieldNames) {
+        if (hasNoMembers) {
+            continue;
+        }
+        int varid = -1;
+        if (nc_inq_varid(ncid, fieldName.c_str(), &varid) != NC_NOERR) {
+            std::cerr << "Verification failed: Variable '" << fieldName << "' is missing." << std::endl;
+            numMismatches++;
+            continue;
+        }
+        size_t varxs = 0, varys = 0, varzs = 0;
+        volumeLoader->getFieldExtent(fieldName, varxs, varys, varzs);
+        varzs = std::max(varzs, size_t(1));
+        FieldDataType nativeDataType = volumeLoader->getFieldDataType(fieldName);
+        auto nativeEntrySize = size_t(getFieldDataTypeSize(nativeDataType));
+        auto numTimeSteps = std::max(ts, size_t(1));
+        // Fields stored as 16-bit floats are compared after converting the input data the same way.
+        OutputFloatType fileFloatType = OutputFloatType::NATIVE;
+        std::string fileFloatTypeName;
+        if (ncGetAttributeText(ncid, varid, "ncconv_dtype", fileFloatTypeName)) {
+            fileFloatType = parseOutputFloatType(fileFloatTypeName);
+        }
+        bool isHalfOutput = fileFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(nativeDataType);
+        FieldDataType dataType = isHalfOutput ? FieldDataType::UINT16 : nativeDataType;
+        auto entrySize = size_t(getFieldDataTypeSize(dataType));
+
+        // Find the dimensions of the output variable by name, as their order depends on the output layout.
+        int numDims = 0;
+        int dimids[NC_MAX_VAR_DIMS];
+        nc_inq_var(ncid, varid, nullptr, nullptr, &numDims, dimids, nullptr);
+        int mloc = -1, tloc = -1, zloc = -1, yloc = -1, xloc = -1;
+        for (int dimIdx = 0; dimIdx < numDims; dimIdx++) {
+            char dimName[NC_MAX_NAME + 1];
+            nc_inq_dimname(ncid, dimids[dimIdx], dimName);
+            std::string name = dimName;
+            if (name == "member") {
+                mloc = dimIdx;
+            } else if (name == "time") {
+                tloc = dimIdx;
+            } else if (name == "z") {
+                zloc = dimIdx;
+            } else if (name == "y") {
+                yloc = dimIdx;
+            } else if (name == "x") {
+                xloc = dimIdx;
+            }
+        }
+        if (yloc < 0 || xloc < 0 || (zloc < 0 && varzs > 1)) {
+            nc_close(ncid);
+            throw std::runtime_error(
+                    "Error in VolumeData::verifyNcFile: Unexpected dimensions of variable \"" + fieldName + "\".");
+        }
+        // Time-invariant fields may have been written without the time dimension (see setCollapseTimeInvariantFields).
+        size_t numOutputTimeSteps = tloc >= 0 ? numTimeSteps : 1;
+        size_t numMembers = mloc >= 0 ? std::max(es, size_t(1)) : 1;
+
+        std::vector<FieldSlab> slabs;
+        std::vector<unsigned long long> recordedHashes;
+        bool hasRecordedHashes =
+                ncGetSlabHashes(ncid, varid, slabs, recordedHashes)
+                && recordedHashes.size() == numMembers * numOutputTimeSteps * slabs.size();
+        if (!hasRecordedHashes) {
+            if (useRecordedHashesOnly) {
+                nc_close(ncid);
+                throw std::runtime_error(
+                        "Error in VolumeData::verifyNcFile: Variable \"" + fieldName
+                        + "\" has no recorded slab hashes.");
+            }
+            slabs = computeFieldSlabs(varxs, varys, varzs, entrySize, 1, 1);
+        }
+
+        size_t maxSlabSize = 0;
+        for (const FieldSlab& slab : slabs) {
+            maxSlabSize = std::max(maxSlabSize, slab.zCount * slab.yCount * varxs);
+        }
+        std::vector<uint8_t> inputData(useRecordedHashesOnly ? 0 : maxSlabSize * entrySize);
+        std::vector<uint8_t> nativeInputData(
+                useRecordedHashesOnly || !isHalfOutput ? 0 : maxSlabSize * nativeEntrySize);
+        HalfFloatStats halfFloatStats;
+        std::vector<uint8_t> outputData(maxSlabSize * entrySize);
+        std::vector<size_t> start(numDims, 0);
+        std::vector<size_t> count(numDims, 1);
+
+        // Each input time step is compared against the single output time step of collapsed fields.
+        size_t numMemberItems = (useRecordedHashesOnly ? numOutputTimeSteps : numTimeSteps) * slabs.size();
+        size_t numItems = numMembers * numMemberItems;
+        for (size_t itemIdx = size_t(mpiRank); itemIdx < numItems; itemIdx += size_t(mpiSize)) {
+            size_t m = itemIdx / numMemberItems;
+            size_t t = (itemIdx % numMemberItems) / slabs.size();
+            size_t slabIdx = itemIdx % slabs.size();
+            size_t outputItemIdx = (m * numOutputTimeSteps + (tloc >= 0 ? t : 0)) * slabs.size() + slabIdx;
+            const FieldSlab& slab = slabs.at(slabIdx);
+            size_t numEntries = slab.zCount * slab.yCount * varxs;
+            if (mloc >= 0) {
+                start[mloc] = m;
+            }
+            if (tloc >= 0) {
+                start[tloc] = t;
+            }
+            if (zloc >= 0) {
+                start[zloc] = slab.zOffset;
+                count[zloc] = slab.zCount;
+            }
+            start[yloc] = slab.yOffset;
+            count[yloc] = slab.yCount;
+            count[xloc] = varxs;
+            status = nc_get_vara(ncid, varid, start.data(), count.data(), outputData.data());
+            if (status != NC_NOERR) {
+                nc_close(ncid);
+                throw std::runtime_error(
+                        "Error in VolumeData::verifyNcFile: Reading variable \"" + fieldName + "\" failed: "
+                        + nc_strerror(status));
+            }
+            canonicalizeNaNs(outputData.data(), dataType, numEntries);
+            uint64_t outputHash = sgl::hashXXH64Parallel(outputData.data(), numEntries * entrySize);
+
+            bool isMatch;
+            if (useRecordedHashesOnly) {
+                isMatch = outputHash == recordedHashes.at(outputItemIdx);
+            } else {
+                if (isHalfOutput) {
+                    volumeLoader->getFieldSlabNative(this, fieldName, t, m, slab, nativeInputData.data());
+                    encodeHalfFloats(
+                            nativeInputData.data(), nativeDataType, reinterpret_cast<uint16_t*>(inputData.data()),
+                            numEntries, fileFloatType, halfFloatStats);
+                } else {
+                    volumeLoader->getFieldSlabNative(this, fieldName, t, m, slab, inputData.data());
+                }
+                canonicalizeNaNs(inputData.data(), dataType, numEntries);
+                uint64_t inputHash = sgl::hashXXH64Parallel(inputData.data(), numEntries * entrySize);
+                isMatch =
+                        inputHash == outputHash
+                        && (!hasRecordedHashes || inputHash == recordedHashes.at(outputItemIdx));
+            }
+            if (!isMatch) {
+                numMismatches++;
+                std::cerr << "Verification failed: Mismatch in variable '" << fieldName << "' at time step " << t
+                          << (mloc >= 0 ? " of member " + std::to_string(m) : "")
+                          << " (z: " << slab.zOffset << "-" << (slab.zOffset + slab.zCount - 1)
+                          << ", y: " << slab.yOffset << "-" << (slab.yOffset + slab.yCount - 1) << ")." << std::endl;
+            }
+        }
+    }
+    nc_close(ncid);
+
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &numMismatches, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    if (mpiRank == 0 && isVerbose) {
+        if (numMismatches == 0) {
+            std::cout << "Verification of '" << filePath << "' succeeded." << std::endl;
+        } else {
+            std::cout << "Verification of '" << filePath << "' failed (" << numMismatches << " mismatches)."
+                      << std::endl;
+        }
+    }
+    return numMismatches == 0;
 }
@@ -32,23 +32,234 @@
 #include <vector>
 #include <string>
 
+#include "ChunkTuning.hpp"
+#include "FieldType.hpp"
+#include "TimeAggregation.hpp"
+#include "EnsembleStatistics.hpp"
+
 class VolumeLoader;
+struct FieldSlab;
+struct DirectChunkField;
+struct HalfFloatStats;
+struct AggregatedVariables;
+struct NcFileDimensions;
+struct NcFieldVariable;
+struct RecordMajorField;
+
+/**
+ * Dimension order of the time-dependent variables in the output file.
+ * - MAPS: (time, lev, lat, lon), i.e., one contiguous map per time step (default).
+ * - TIME_SERIES: (lev, lat, lon, time), i.e., the time series of each grid point is contiguous.
+ */
+enum class OutputLayout {
+    MAPS, TIME_SERIES
+};
+/// Parses "maps" (or "default") and "timeseries". Throws an exception for unknown names.
+OutputLayout parseOutputLayout(const std::string& layoutName);
+/// Parses "native", "float16" (or "fp16", "half") and "bfloat16" (or "bf16"). Throws an exception for unknown names.
+OutputFloatType parseOutputFloatType(const std::string& typeName);
 
 class VolumeData {
 public:
     ~VolumeData();
     void setLoader(VolumeLoader* loader);
-    void setGridExtent(int _xs, int _ys, int _zs, float* _lon1d, float* _lat1d, float* _lev1d);
-    void setNumTimeSteps(int _ts);
-    void setEnsembleMemberCount(int _es);
+    /// Takes ownership of the coordinate arrays (allocated with new[]) and frees previously set arrays.
+    void setGridExtent(size_t _xs, size_t _ys, size_t _zs, float* _lon1d, float* _lat1d, float* _lev1d);
+    void setNumTimeSteps(size_t _ts);
+    void setEnsembleMemberCount(size_t _es);
+    /// Sets the start and increment of the time axis, which are needed for daily and monthly temporal aggregates.
+    void setTimeAxis(const TimeAxis& _timeAxis);
     void setFieldNames(const std::vector<std::string>& _fieldNames);
+    /// Maximum number of bytes used for buffering field data while writing (0 means no limit).
+    void setMaxMemory(size_t _maxMemory);
+    /// Whether to print progress information to stdout while writing (default: true).
+    void setIsVerbose(bool _isVerbose);
+    void setOutputLayout(OutputLayout _outputLayout);
+    /// Directory for the temporary spill file used when transposing to OutputLayout::TIME_SERIES out-of-core.
+    void setSpillDirectory(const std::string& _spillDirectory);
+    /// Chunk shape (z, y, x) of the output variables. If empty, the default of the NetCDF library is used.
+    void setChunkShape(const std::vector<size_t>& _chunkShape);
+    /**
+     * Expected read access pattern of the output file. Unless a chunk shape is set explicitly, the chunk shape of each
+     * variable is derived from the pattern (see @see computeChunkShape). Ignored for OutputLayout::TIME_SERIES, where
+     * the chunks always span the time axis.
+     */
+    void setAccessPattern(AccessPattern _accessPattern);
+    /// Target size in bytes of the chunks chosen for an access pattern (default: 1 MiB).
+    void setChunkTargetSize(size_t _chunkTargetSize);
+    /// Deflate compression level (1-9) of the output variables. 0 disables the compression (default).
+    void setDeflateLevel(int _deflateLevel);
+    /// Whether to apply the shuffle filter before compression.
+    void setUseShuffleFilter(bool _useShuffleFilter);
+    /// Whether to record the XXH64 hash of each written slab as a variable attribute (default: true).
+    void setRecordSlabHashes(bool _recordSlabHashes);
+    /**
+     * Whether to write variables whose slabs are identical in all time steps (e.g., orography or land-sea masks
+     * repeated in every time step of a GrADS data set) once without the time dimension (default: false). The slabs
+     * are compared by their XXH64 hashes in a pass before writing each variable.
+     */
+    void setCollapseTimeInvariantFields(bool _collapseTimeInvariantFields);
+    /**
+     * Whether to compress the chunks of compressed variables on multiple threads and write them with the HDF5 direct
+     * chunk write API (default: true). Only has an effect when built with USE_HDF5_DIRECT_CHUNK_WRITE and without MPI.
+     */
+    void setUseDirectChunkWrite(bool _useDirectChunkWrite);
+    /**
+     * Storage type of floating point fields in NetCDF output files (default: OutputFloatType::NATIVE). 16-bit types
+     * halve the output size of float32 fields, e.g., for machine learning data sets. Integer fields are not converted.
+     * The range statistics of the conversion are printed for each variable.
+     */
+    void setOutputFloatType(OutputFloatType _outputFloatType);
+    /**
+     * Periods over which the mean, minimum, maximum and number of valid entries of each time-dependent field are
+     * computed while writing (default: none). The statistics are written as the variables <name>_mean, <name>_min,
+     * <name>_max and <name>_count over the dimension time_aggregated in addition to the field itself, so both are
+     * produced from one read of the input data. Not supported with more than one MPI rank.
+     */
+    void setTimeAggregation(const TimeAggregation& _timeAggregation);
+    /**
+     * Statistics over the ensemble members (e.g., mean, standard deviation and percentiles) written as the variables
+     * <name>_ens_<statistic> for each field of data sets with multiple members (default: none). They are computed in a
+     * separate pass over the members of each slab. Not supported for data sets without ensemble members.
+     */
+    void setEnsembleStatistics(const std::vector<EnsembleStatistic>& _ensembleStatistics);
+    /**
+     * Whether to write the members of ensemble data sets with the dimension "member" (default: true). If false, only
+     * the ensemble statistics are written (@see setEnsembleStatistics).
+     */
+    void setWriteEnsembleMembers(bool _writeEnsembleMembers);
     bool writeToNcFile(const std::string& filePath);
+    /// Writes the data set to an already created NetCDF-4 file in define mode. The file is not closed.
+    bool writeToNcHandle(int ncid);
+    /**
+     * Verifies a NetCDF file written by @see writeToNcFile by comparing per-slab XXH64 hashes. NaN entries are
+     * treated as equal to each other (i.e., to the undef value of the input data).
+     * @param filePath The NetCDF file to verify.
+     * @param useRecordedHashesOnly If true, only the output file is read, and its slabs are compared against the
+     * hashes recorded at write time. Otherwise, the input data is read, too, and compared against the output data and
+     * (if available) the recorded hashes.
+     * @return Whether all slabs match.
+     */
+    bool verifyNcFile(const std::string& filePath, bool useRecordedHashesOnly = false);
+
+    [[nodiscard]] VolumeLoader* getLoader() const { return volumeLoader; }
+    [[nodiscard]] const std::vector<std::string>& getFieldNames() const { return fieldNames; }
+    [[nodiscard]] size_t getNumTimeSteps() const { return ts; }
+    [[nodiscard]] size_t getEnsembleMemberCount() const { return es; }
+    [[nodiscard]] size_t getGridSizeX() const { return xs; }
+    [[nodiscard]] size_t getGridSizeY() const { return ys; }
+    [[nodiscard]] size_t getGridSizeZ() const { return zs; }
+    [[nodiscard]] const float* getLon1d() const { return lon1d; }
+    [[nodiscard]] const float* getLat1d() const { return lat1d; }
+    [[nodiscard]] const float* getLev1d() const { return lev1d; }
+    [[nodiscard]] size_t getMaxMemory() const { return maxMemory; }
+    [[nodiscard]] OutputLayout getOutputLayout() const { return outputLayout; }
+    [[nodiscard]] const std::vector<size_t>& getChunkShape() const { return chunkShape; }
+    [[nodiscard]] AccessPattern getAccessPattern() const { return accessPattern; }
+    [[nodiscard]] size_t getChunkTargetSize() const { return chunkTargetSize; }
+    [[nodiscard]] int getDeflateLevel() const { return deflateLevel; }
+    [[nodiscard]] bool getUseShuffleFilter() const { return useShuffleFilter; }
+    [[nodiscard]] bool getRecordSlabHashes() const { return recordSlabHashes; }
+    [[nodiscard]] bool getIsVerbose() const { return isVerbose; }
+    [[nodiscard]] bool getCollapseTimeInvariantFields() const { return collapseTimeInvariantFields; }
+    [[nodiscard]] OutputFloatType getOutputFloatType() const { return outputFloatType; }
+    [[nodiscard]] const TimeAggregation& getTimeAggregation() const { return timeAggregation; }
+    [[nodiscard]] const std::vector<EnsembleStatistic>& getEnsembleStatistics() const { return ensembleStatistics; }
+    [[nodiscard]] bool getWriteEnsembleMembers() const { return writeEnsembleMembers; }
+    /// Returns the time axis, or nullptr if the loader did not set one.
+    [[nodiscard]] const TimeAxis* getTimeAxis() const { return hasTimeAxis ? &timeAxis : nullptr; }
+    /**
+     * Prints the range statistics of the conversion of a field to the 16-bit output float type. With MPI, this needs
+     * to be called by all ranks, and the statistics of all ranks are combined.
+     */
+    void reportHalfFloatStats(const std::string& fieldName, const HalfFloatStats& stats) const;
+
+    /// Splits a field into contiguous slabs fitting into the memory budget and aligned with the output chunk shape.
+    [[nodiscard]] std::vector<FieldSlab> computeFieldSlabs(
+            size_t varxs, size_t varys, size_t varzs, size_t entrySize, size_t chunkZ, size_t chunkY) const;
+    /**
+     * Input read from a stream (@see VolumeLoader::getRequiresSequentialReads) can only be read once in the order of
+     * the data file. Throws an exception if the settings need to read it in another order. The writers call this
+     * before creating any output file.
+     */
+    void checkSequentialReadSettings() const;
 
 private:
-    int xs = 0, ys = 0, zs = 0, ts = 0, es = 0;
+    /**
+     * If directChunkFields is not null, compressed variables whose slabs are aligned with their chunks are only
+     * defined, and are appended to the list for writing them with @see DirectChunkWriter after closing the file.
+     */
+    bool writeToNcHandle(int ncid, std::vector<DirectChunkField>* directChunkFields);
+    /// Writes the global attributes, defines the dimensions and writes the coordinate variables.
+    NcFileDimensions defineNcDimensions(int ncid, int mpiRank, int mpiSize);
+    /**
+     * Defines the variable of a field with its fill value, chunking and compression settings, and the variables of its
+     * temporal aggregates. varts is 1 for time-invariant fields written without the time dimension.
+     */
+    NcFieldVariable defineFieldVariable(
+            int ncid, const NcFileDimensions& dimensions, const std::string& fieldName, size_t varxs, size_t varys,
+            size_t varzs, size_t varts, int mpiRank);
+    /**
+     * Splits the field of a variable in OutputLayout::MAPS into slabs aligned with the output and input chunks, and
+     * sizes the chunk cache of the variable to hold the chunks overlapping one slab (or all slabs if isRecordMajor).
+     */
+    void planFieldSlabs(int ncid, NcFieldVariable& variable, bool isRecordMajor);
+    /**
+     * Writes the slabs of a variable in OutputLayout::MAPS, including its temporal aggregates. With MPI, the
+     * (member, time step, slab) work items are distributed round-robin over the ranks.
+     */
+    void writeFieldSlabs(
+            int ncid, const NcFieldVariable& variable, const std::vector<int>& aggregationPeriods, int mpiRank,
+            int mpiSize);
+    /// Whether all time steps of the field are identical (compared by the XXH64 hashes of their slabs).
+    bool getIsFieldTimeInvariant(
+            const std::string& fieldName, size_t varxs, size_t varys, size_t varzs, size_t entrySize,
+            int mpiRank, int mpiSize);
+    /**
+     * Defines the variables <name>_ens_<statistic> (in the order of ensembleStatistics), computes the ensemble
+     * statistics of a field from the members of each (time step, slab) pair and writes them to these variables.
+     */
+    void writeEnsembleStatistics(
+            int ncid, const NcFileDimensions& dimensions, const std::string& fieldName, size_t varxs, size_t varys,
+            size_t varzs, size_t varts, int mpiRank, int mpiSize);
+    void writeDirectChunkFields(const std::string& filePath, const std::vector<DirectChunkField>& directChunkFields);
+    /**
+     * Writes the already defined variables of input that can only be read sequentially (e.g., from stdin). For each
+     * (member, time step) record, the slabs of all variables are read in the order of the data file and written as
+     * they arrive.
+     */
+    void writeFieldsRecordMajor(int ncid, std::vector<RecordMajorField>& recordMajorFields);
+    /**
+     * Writes one field in OutputLayout::TIME_SERIES via a cache-blocked transpose, spilling to disk if necessary.
+     * entrySize is the size of the entries in the output file (see setOutputFloatType). If aggregatedVariables is
+     * not null, the temporal aggregates of the field are written to these variables, too.
+     */
+    void writeFieldTimeSeriesLayout(
+            int ncid, int varid, const std::string& fieldName, size_t varxs, size_t varys, size_t varzs,
+            size_t entrySize, size_t chunkY, int mpiRank, int mpiSize, const AggregatedVariables* aggregatedVariables);
+
+    size_t xs = 0, ys = 0, zs = 0, ts = 0, es = 0;
     float* lon1d = nullptr, *lat1d = nullptr, *lev1d = nullptr;
     std::vector<std::string> fieldNames;
     VolumeLoader* volumeLoader = nullptr;
+    size_t maxMemory = 0;
+    bool isVerbose = true;
+    OutputLayout outputLayout = OutputLayout::MAPS;
+    std::string spillDirectory;
+    std::vector<size_t> chunkShape;
+    AccessPattern accessPattern = AccessPattern::DEFAULT;
+    size_t chunkTargetSize = size_t(1) << 20;
+    int deflateLevel = 0;
+    bool useShuffleFilter = false;
+    bool recordSlabHashes = true;
+    bool useDirectChunkWrite = true;
+    bool collapseTimeInvariantFields = false;
+    OutputFloatType outputFloatType = OutputFloatType::NATIVE;
+    TimeAggregation timeAggregation;
+    std::vector<EnsembleStatistic> ensembleStatistics;
+    bool writeEnsembleMembers = true;
+    TimeAxis timeAxis;
+    bool hasTimeAxis = false;
 };
 
 #endif //NCCONV_VOLUMEDATA_HPP
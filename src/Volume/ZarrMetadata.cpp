@@ -0,0 +1,131 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+
+#include "Utils/JsonUtils.hpp"
+#include "ZarrMetadata.hpp"
+
+std::string getZarrDataTypeString(FieldDataType dataType, bool isBigEndian) {
+    const char* byteOrder = isBigEndian ? ">" : "<";
+    switch (dataType) {
+        case FieldDataType::INT8:
+            return "|i1";
+        case FieldDataType::UINT8:
+            return "|u1";
+        case FieldDataType::INT16:
+            return std::string(byteOrder) + "i2";
+        case FieldDataType::UINT16:
+            return std::string(byteOrder) + "u2";
+        case FieldDataType::INT32:
+            return std::string(byteOrder) + "i4";
+        case FieldDataType::FLOAT32:
+            return std::string(byteOrder) + "f4";
+        case FieldDataType::FLOAT64:
+            return std::string(byteOrder) + "f8";
+    }
+    return std::string(byteOrder) + "f4";
+}
+
+std::string formatZarrFillValue(FieldDataType dataType, bool hasFillValue, double fillValue) {
+    // Values the data type cannot store (e.g., -9999 for "|u1") would make the metadata invalid.
+    if (!hasFillValue || !getIsFillValueRepresentable(dataType, fillValue)) {
+        return getIsFieldDataTypeFloat(dataType) ? "\"NaN\"" : "null";
+    }
+    std::ostringstream stream;
+    stream << std::setprecision(17);
+    if (getIsFieldDataTypeFloat(dataType)) {
+        stream << fillValue;
+    } else {
+        stream << int64_t(fillValue);
+    }
+    return stream.str();
+}
+
+static void writeJsonList(std::ostringstream& stream, const std::vector<size_t>& values) {
+    stream << "[";
+    for (size_t i = 0; i < values.size(); i++) {
+        stream << (i == 0 ? "" : ", ") << values.at(i);
+    }
+    stream << "]";
+}
+
+std::string makeZarrArrayMetadata(
+        const std::vector<size_t>& shape, const std::vector<size_t>& chunks, const std::string& dataType,
+        const std::string& fillValue, const std::string& compressor, const std::string& filters) {
+    std::ostringstream stream;
+    stream << "{\"chunks\": ";
+    writeJsonList(stream, chunks);
+    stream << ", \"compressor\": " << compressor << ", \"dtype\": \"" << dataType << "\", \"fill_value\": "
+           << fillValue << ", \"filters\": " << filters << ", \"order\": \"C\", \"shape\": ";
+    writeJsonList(stream, shape);
+    stream << ", \"zarr_format\": 2}";
+    return stream.str();
+}
+
+static std::string makeJsonStringAttributes(const std::vector<std::pair<std::string, std::string>>& attributes) {
+    std::string json;
+    for (size_t i = 0; i < attributes.size(); i++) {
+        json += std::string(i == 0 ? "" : ", ") + "\"" + sgl::escapeJsonString(attributes.at(i).first) + "\": \""
+                + sgl::escapeJsonString(attributes.at(i).second) + "\"";
+    }
+    return json;
+}
+
+std::string makeZarrArrayAttributes(
+        const std::vector<std::string>& dimensionNames,
+        const std::vector<std::pair<std::string, std::string>>& attributes) {
+    std::string zattrs = "{\"_ARRAY_DIMENSIONS\": [";
+    for (size_t i = 0; i < dimensionNames.size(); i++) {
+        zattrs += std::string(i == 0 ? "" : ", ") + "\"" + dimensionNames.at(i) + "\"";
+    }
+    zattrs += "]";
+    if (!attributes.empty()) {
+        zattrs += ", " + makeJsonStringAttributes(attributes);
+    }
+    zattrs += "}";
+    return zattrs;
+}
+
+std::string makeZarrGroupAttributes(size_t numMembers) {
+    std::vector<std::pair<std::string, std::string>> globalAttributes = {
+            { "Conventions", "CF-1.5" },
+            { "title", "Exported scalar field" },
+            { "history", "ncconv" },
+            { "institution", "Technical University of Munich, Chair of Computer Graphics and Visualization" },
+            { "source", "ncconv, a utility program for converting meteorological data sets to the NetCDF format." },
+            { "references", "https://github.com/chrismile/ncconv" },
+            { "comment", "ncconv is released under the 2-clause BSD license." },
+    };
+    if (numMembers > 1) {
+        globalAttributes.emplace_back("ncconv_ensemble_members", "all");
+    }
+    return "{" + makeJsonStringAttributes(globalAttributes) + "}";
+}
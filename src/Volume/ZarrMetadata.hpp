@@ -0,0 +1,70 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_ZARRMETADATA_HPP
+#define NCCONV_ZARRMETADATA_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include "FieldType.hpp"
+
+/*
+ * Helpers for the JSON metadata of Zarr (version 2) groups and arrays, shared by @see ZarrWriter and
+ * @see ReferenceIndexWriter. For the format see https://zarr-specs.readthedocs.io/en/latest/v2/v2.0.html.
+ */
+
+/// Zarr (NumPy) data type string, e.g., "<f4" for little endian float32 data.
+std::string getZarrDataTypeString(FieldDataType dataType, bool isBigEndian);
+
+/**
+ * Formats the fill value of an array as JSON. Floating point arrays without a fill value use NaN, and integer arrays
+ * without a fill value use null. Fill values the data type cannot store are treated like no fill value.
+ */
+std::string formatZarrFillValue(FieldDataType dataType, bool hasFillValue, double fillValue);
+
+/**
+ * Array metadata (.zarray) of an array in C order.
+ * @param compressor The compressor configuration as JSON (e.g., {"id": "zlib", "level": 6}) or "null".
+ * @param filters The list of filter configurations as JSON or "null".
+ */
+std::string makeZarrArrayMetadata(
+        const std::vector<size_t>& shape, const std::vector<size_t>& chunks, const std::string& dataType,
+        const std::string& fillValue, const std::string& compressor = "null", const std::string& filters = "null");
+
+/// Array attributes (.zattrs) storing the dimension names like xarray does, and additional string attributes.
+std::string makeZarrArrayAttributes(
+        const std::vector<std::string>& dimensionNames,
+        const std::vector<std::pair<std::string, std::string>>& attributes = {});
+
+/// Group attributes (.zattrs) matching the global attributes written by VolumeData::writeToNcHandle.
+std::string makeZarrGroupAttributes(size_t numMembers);
+
+#endif //NCCONV_ZARRMETADATA_HPP
@@ -0,0 +1,519 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Utils/TaskScheduler.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "ChunkTuning.hpp"
+#include "ShuffleFilter.hpp"
+#include "ZarrMetadata.hpp"
+#include "VolumeData.hpp"
+#include "ZarrWriter.hpp"
+
+static bool writeWholeFile(const std::string& filePath, const void* data, size_t size) {
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool isWritten = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && isWritten;
+}
+
+ZarrWriter::ZarrWriter(VolumeData* volumeData) : volumeData(volumeData) {
+}
+
+bool ZarrWriter::writeToFile(const std::string& _storePath) {
+    // With MPI, the first rank writes the whole store.
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+    if (mpiRank != 0) {
+        return true;
+    }
+
+    storePath = _storePath;
+    checkSettings();
+    prepareStore();
+    metadata.clear();
+    writeMetadata(".zgroup", "{\"zarr_format\": 2}");
+    writeMetadata(".zattrs", makeZarrGroupAttributes(volumeData->getEnsembleMemberCount()));
+    writeCoordinates();
+    if (volumeData->getLoader()->getRequiresSequentialReads()) {
+        writeFieldsRecordMajor();
+    } else {
+        for (const std::string& fieldName : volumeData->getFieldNames()) {
+            writeField(fieldName);
+        }
+    }
+
+    // The consolidated metadata is written last, so readers relying on it never see an incomplete store.
+    std::string zmetadata = "{\"metadata\": {";
+    for (size_t i = 0; i < metadata.size(); i++) {
+        zmetadata += std::string(i == 0 ? "" : ",") + "\n\"" + metadata.at(i).first + "\": " + metadata.at(i).second;
+    }
+    zmetadata += "},\n\"zarr_consolidated_format\": 1}\n";
+    std::string zmetadataPath = storePath + "/.zmetadata";
+    if (!writeWholeFile(zmetadataPath, zmetadata.data(), zmetadata.size())) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::writeToFile: Writing to file \"" + zmetadataPath + "\" failed.");
+    }
+    return true;
+}
+
+void ZarrWriter::checkSettings() {
+    volumeData->checkSequentialReadSettings();
+    if (volumeData->getOutputLayout() == OutputLayout::TIME_SERIES && volumeData->getNumTimeSteps() > 1) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::checkSettings: The time series layout is only supported for NetCDF-4 files. "
+                "Use '--access-pattern timeseries' instead.");
+    }
+    if (volumeData->getTimeAggregation().type != TimeAggregationType::NONE
+            || !volumeData->getEnsembleStatistics().empty() || !volumeData->getWriteEnsembleMembers()) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::checkSettings: Temporal aggregation and ensemble statistics are only supported "
+                "for NetCDF-4 files.");
+    }
+    if (volumeData->getCollapseTimeInvariantFields()) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::checkSettings: Collapsing time-invariant variables is only supported for "
+                "NetCDF-4 files.");
+    }
+#ifndef USE_ZLIB
+    if (volumeData->getDeflateLevel() > 0) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::checkSettings: Compressing Zarr chunks requires building with zlib.");
+    }
+#endif
+}
+
+void ZarrWriter::prepareStore() {
+    // Chunks without valid entries are not written, so chunks of a previous store at the same path must not remain.
+    boost::filesystem::path path(storePath);
+    if (boost::filesystem::exists(path)) {
+        if (!boost::filesystem::is_directory(path)
+                || (!boost::filesystem::is_empty(path) && !boost::filesystem::exists(path / ".zgroup"))) {
+            throw std::runtime_error(
+                    "Error in ZarrWriter::prepareStore: \"" + storePath + "\" exists and is not a Zarr store.");
+        }
+        boost::filesystem::remove_all(path);
+    }
+    boost::filesystem::create_directories(path);
+}
+
+void ZarrWriter::writeMetadata(const std::string& key, const std::string& value) {
+    std::string filePath = storePath + "/" + key;
+    if (!writeWholeFile(filePath, value.data(), value.size())) {
+        throw std::runtime_error("Error in ZarrWriter::writeMetadata: Writing to file \"" + filePath + "\" failed.");
+    }
+    metadata.emplace_back(key, value);
+}
+
+void ZarrWriter::writeCoordinates() {
+    auto writeCoordinateVariable = [&](
+            const std::string& name, const std::string& dimensionName, const std::string& coordinateType,
+            const float* coordinates, size_t dimLen) {
+        std::vector<std::pair<std::string, std::string>> attributes;
+        if (!coordinateType.empty()) {
+            attributes.emplace_back("coordinate_type", coordinateType);
+        }
+        boost::filesystem::create_directory(storePath + "/" + name);
+        writeMetadata(name + "/.zarray", makeZarrArrayMetadata({ dimLen }, { dimLen }, "<f4", "\"NaN\""));
+        writeMetadata(name + "/.zattrs", makeZarrArrayAttributes({ dimensionName }, attributes));
+        // The coordinates are stored uncompressed as little endian float32 data in a single chunk.
+        std::string chunkPath = storePath + "/" + name + "/0";
+        if (!writeWholeFile(chunkPath, coordinates, dimLen * sizeof(float))) {
+            throw std::runtime_error(
+                    "Error in ZarrWriter::writeCoordinates: Writing to file \"" + chunkPath + "\" failed.");
+        }
+    };
+
+    size_t xs = volumeData->getGridSizeX();
+    size_t ys = volumeData->getGridSizeY();
+    auto zs = std::max(volumeData->getGridSizeZ(), size_t(1));
+    std::vector<float> levels(zs);
+    for (size_t z = 0; z < zs; z++) {
+        levels.at(z) = volumeData->getLev1d() ? volumeData->getLev1d()[z] : float(z);
+    }
+    writeCoordinateVariable("x", "x", "Cartesian X", volumeData->getLon1d(), xs);
+    writeCoordinateVariable("y", "y", "Cartesian Y", volumeData->getLat1d(), ys);
+    writeCoordinateVariable("z", "z", "Cartesian Z", levels.data(), zs);
+    writeCoordinateVariable("lon", "x", "", volumeData->getLon1d(), xs);
+    writeCoordinateVariable("lat", "y", "", volumeData->getLat1d(), ys);
+}
+
+/// State of a field while its blocks are written by @see ZarrWriter::writeFieldBlock.
+struct ZarrFieldWrite {
+    std::string fieldName;
+    std::string fieldPath; ///< Directory of the chunk files (with a trailing slash).
+    size_t varxs = 0, varys = 0, varzs = 0;
+    size_t numTimeSteps = 1, numMembers = 1;
+    FieldDataType nativeDataType = FieldDataType::FLOAT32;
+    FieldDataType dataType = FieldDataType::FLOAT32; ///< Type of the stored entries (uint16 for 16-bit floats).
+    bool isHalfOutput = false;
+    size_t entrySize = 0, nativeEntrySize = 0;
+    size_t chunkT = 1, chunkZ = 1, chunkY = 1, chunkX = 1;
+    std::vector<FieldSlab> slabs;
+    bool hasFillValue = false;
+    double fillValue = 0.0;
+    int deflateLevel = 0;
+    bool useShuffleFilter = false;
+    size_t maxSlabSize = 0; ///< Maximum number of entries of a slab.
+    HalfFloatStats halfFloatStats;
+    size_t numSkippedChunks = 0;
+};
+
+void ZarrWriter::writeField(const std::string& fieldName) {
+    ZarrFieldWrite field = beginField(fieldName, false);
+    std::vector<uint8_t> blockData(field.maxSlabSize * field.chunkT * field.entrySize);
+    std::vector<uint8_t> nativeSlabData(field.isHalfOutput ? field.maxSlabSize * field.nativeEntrySize : 0);
+    for (size_t m = 0; m < field.numMembers; m++) {
+        for (size_t slabIdx = 0; slabIdx < field.slabs.size(); slabIdx++) {
+            for (size_t t0 = 0; t0 < field.numTimeSteps; t0 += field.chunkT) {
+                writeFieldBlock(field, m, slabIdx, t0, blockData.data(), nativeSlabData.data());
+            }
+        }
+    }
+    finishField(field);
+}
+
+void ZarrWriter::writeFieldsRecordMajor() {
+    const std::vector<std::string>& fieldNames = volumeData->getFieldNames();
+    std::vector<ZarrFieldWrite> fields;
+    size_t maxBlockDataSize = 0, maxNativeSlabDataSize = 0;
+    for (const std::string& fieldName : fieldNames) {
+        fields.push_back(beginField(fieldName, true));
+        const ZarrFieldWrite& field = fields.back();
+        maxBlockDataSize = std::max(maxBlockDataSize, field.maxSlabSize * field.entrySize);
+        if (field.isHalfOutput) {
+            maxNativeSlabDataSize = std::max(maxNativeSlabDataSize, field.maxSlabSize * field.nativeEntrySize);
+        }
+    }
+    if (volumeData->getIsVerbose()) {
+        std::cout << "Writing " << fields.size() << " variable(s) record by record..." << std::endl;
+    }
+    // The blocks are written synchronously, so all fields share the same buffers.
+    std::vector<uint8_t> blockData(maxBlockDataSize), nativeSlabData(maxNativeSlabDataSize);
+    auto numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    auto numMembers = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    for (size_t m = 0; m < numMembers; m++) {
+        for (size_t t = 0; t < numTimeSteps; t++) {
+            for (ZarrFieldWrite& field : fields) {
+                for (size_t slabIdx = 0; slabIdx < field.slabs.size(); slabIdx++) {
+                    writeFieldBlock(field, m, slabIdx, t, blockData.data(), nativeSlabData.data());
+                }
+            }
+        }
+    }
+    for (const ZarrFieldWrite& field : fields) {
+        finishField(field);
+    }
+}
+
+ZarrFieldWrite ZarrWriter::beginField(const std::string& fieldName, bool isRecordMajor) {
+    VolumeLoader* loader = volumeData->getLoader();
+    ZarrFieldWrite field;
+    field.fieldName = fieldName;
+    size_t& varxs = field.varxs;
+    size_t& varys = field.varys;
+    size_t& varzs = field.varzs;
+    loader->getFieldExtent(fieldName, varxs, varys, varzs);
+    varzs = std::max(varzs, size_t(1));
+    if (varxs != volumeData->getGridSizeX() || varys != volumeData->getGridSizeY()) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::beginField: Variable \"" + fieldName + "\" has a different grid.");
+    }
+    field.numTimeSteps = std::max(volumeData->getNumTimeSteps(), size_t(1));
+    field.numMembers = std::max(volumeData->getEnsembleMemberCount(), size_t(1));
+    size_t numTimeSteps = field.numTimeSteps, numMembers = field.numMembers;
+    FieldDataType nativeDataType = loader->getFieldDataType(fieldName);
+    OutputFloatType outputFloatType = volumeData->getOutputFloatType();
+    bool isHalfOutput = outputFloatType != OutputFloatType::NATIVE && getIsFieldDataTypeFloat(nativeDataType);
+    FieldDataType dataType = isHalfOutput ? FieldDataType::UINT16 : nativeDataType;
+    auto entrySize = size_t(getFieldDataTypeSize(dataType));
+    auto nativeEntrySize = size_t(getFieldDataTypeSize(nativeDataType));
+    field.nativeDataType = nativeDataType;
+    field.dataType = dataType;
+    field.isHalfOutput = isHalfOutput;
+    field.entrySize = entrySize;
+    field.nativeEntrySize = nativeEntrySize;
+
+    // The chunk shape (t, z, y, x) is chosen like for NetCDF-4 output. As Zarr has no default chunk shape, the maps
+    // access pattern is used if neither a chunk shape nor an access pattern is set.
+    size_t chunkT = 1, chunkZ = 1, chunkY = 1, chunkX = 1;
+    const std::vector<size_t>& chunkShape = volumeData->getChunkShape();
+    if (!chunkShape.empty()) {
+        chunkZ = std::clamp(chunkShape.at(0), size_t(1), varzs);
+        chunkY = std::clamp(chunkShape.at(1), size_t(1), varys);
+        chunkX = std::clamp(chunkShape.at(2), size_t(1), varxs);
+    } else {
+        AccessPattern accessPattern = volumeData->getAccessPattern();
+        std::array<size_t, 4> tunedChunk = computeChunkShape(
+                accessPattern == AccessPattern::DEFAULT ? AccessPattern::MAPS : accessPattern,
+                numTimeSteps, varzs, varys, varxs, entrySize,
+                volumeData->getChunkTargetSize());
+        chunkT = tunedChunk[0];
+        chunkZ = tunedChunk[1];
+        chunkY = tunedChunk[2];
+        chunkX = tunedChunk[3];
+    }
+    if (isRecordMajor && chunkT > 1) {
+        // Each chunk file is written at once, but the time steps of a field arrive one record after the other.
+        if (volumeData->getIsVerbose()) {
+            std::cout << "Chunks of variable '" << fieldName << "' span a single time step, as the input is read "
+                      << "record by record." << std::endl;
+        }
+        chunkT = 1;
+    }
+    // The slabs of chunkT time steps are read into one block. Each chunk file needs to be written at once, so if the
+    // memory budget only allows slabs smaller than a chunk, the chunks are shrunk to the slab extent.
+    size_t memoryPerEntry = entrySize * chunkT + (isHalfOutput ? nativeEntrySize : 0);
+    std::vector<FieldSlab> slabs = volumeData->computeFieldSlabs(varxs, varys, varzs, memoryPerEntry, chunkZ, chunkY);
+    chunkZ = std::min(chunkZ, size_t(slabs.front().zCount));
+    chunkY = std::min(chunkY, size_t(slabs.front().yCount));
+
+    std::vector<std::string> dimensionNames = { "y", "x" };
+    std::vector<size_t> shape = { varys, varxs };
+    std::vector<size_t> chunks = { chunkY, chunkX };
+    if (varzs > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "z");
+        shape.insert(shape.begin(), varzs);
+        chunks.insert(chunks.begin(), chunkZ);
+    }
+    if (numTimeSteps > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "time");
+        shape.insert(shape.begin(), numTimeSteps);
+        chunks.insert(chunks.begin(), chunkT);
+    }
+    if (numMembers > 1) {
+        dimensionNames.insert(dimensionNames.begin(), "member");
+        shape.insert(shape.begin(), numMembers);
+        chunks.insert(chunks.begin(), size_t(1));
+    }
+
+    double fillValue = 0.0;
+    bool hasFillValue =
+            loader->getFieldFillValue(fieldName, fillValue) && getIsFillValueRepresentable(nativeDataType, fillValue);
+    std::string dataTypeString = getZarrDataTypeString(dataType, false);
+    std::string fillValueString = formatZarrFillValue(dataType, hasFillValue, fillValue);
+    std::vector<std::pair<std::string, std::string>> attributes;
+    if (isHalfOutput) {
+        hasFillValue = true;
+        fillValue = double(getOutputFloatTypeNaN(outputFloatType));
+        if (outputFloatType == OutputFloatType::FLOAT16) {
+            // float16 is a native Zarr type, so no attribute is needed for decoding it.
+            dataTypeString = "<f2";
+            fillValueString = "\"NaN\"";
+        } else {
+            fillValueString = formatZarrFillValue(dataType, true, fillValue);
+            attributes.emplace_back("ncconv_dtype", getOutputFloatTypeName(outputFloatType));
+        }
+    }
+    int deflateLevel = volumeData->getDeflateLevel();
+    bool useShuffleFilter = volumeData->getUseShuffleFilter() && entrySize > 1;
+    std::string compressor = "null", filters = "null";
+    if (deflateLevel > 0) {
+        compressor = "{\"id\": \"zlib\", \"level\": " + std::to_string(deflateLevel) + "}";
+    }
+    if (useShuffleFilter) {
+        filters = "[{\"id\": \"shuffle\", \"elementsize\": " + std::to_string(entrySize) + "}]";
+    }
+    boost::filesystem::create_directory(storePath + "/" + fieldName);
+    writeMetadata(
+            fieldName + "/.zarray",
+            makeZarrArrayMetadata(shape, chunks, dataTypeString, fillValueString, compressor, filters));
+    writeMetadata(fieldName + "/.zattrs", makeZarrArrayAttributes(dimensionNames, attributes));
+    if (volumeData->getIsVerbose()) {
+        std::cout << "Chunk shape of variable '" << fieldName << "': (" << chunkT << ", " << chunkZ << ", " << chunkY
+                  << ", " << chunkX << ")" << std::endl;
+    }
+
+    field.chunkT = chunkT;
+    field.chunkZ = chunkZ;
+    field.chunkY = chunkY;
+    field.chunkX = chunkX;
+    field.slabs = slabs;
+    field.hasFillValue = hasFillValue;
+    field.fillValue = fillValue;
+    field.deflateLevel = deflateLevel;
+    field.useShuffleFilter = useShuffleFilter;
+    for (const FieldSlab& slab : slabs) {
+        field.maxSlabSize = std::max(field.maxSlabSize, slab.zCount * slab.yCount * varxs);
+    }
+    field.fieldPath = storePath + "/" + fieldName + "/";
+    return field;
+}
+
+void ZarrWriter::writeFieldBlock(
+        ZarrFieldWrite& field, size_t m, size_t slabIdx, size_t t0, uint8_t* blockData, uint8_t* nativeSlabData) {
+    VolumeLoader* loader = volumeData->getLoader();
+    OutputFloatType outputFloatType = volumeData->getOutputFloatType();
+    const std::string& fieldName = field.fieldName;
+    const FieldSlab& slab = field.slabs.at(slabIdx);
+    const size_t entrySize = field.entrySize, chunkT = field.chunkT, chunkZ = field.chunkZ, chunkY = field.chunkY;
+    const size_t chunkX = field.chunkX, numTimeSteps = field.numTimeSteps;
+    const size_t varxs = field.varxs, varzs = field.varzs;
+    size_t rowSize = varxs * entrySize;
+    size_t numChunksX = (varxs + chunkX - 1) / chunkX;
+    size_t chunkNumEntries = chunkT * chunkZ * chunkY * chunkX;
+    size_t chunkSize = chunkNumEntries * entrySize;
+
+    size_t numEntries = slab.zCount * slab.yCount * varxs;
+    size_t slabSize = numEntries * entrySize;
+    size_t numChunksY = (slab.yCount + chunkY - 1) / chunkY;
+    size_t numChunksZ = (slab.zCount + chunkZ - 1) / chunkZ;
+    size_t numChunks = numChunksZ * numChunksY * numChunksX;
+    size_t numBlockTimeSteps = std::min(chunkT, numTimeSteps - t0);
+    for (size_t tt = 0; tt < numBlockTimeSteps; tt++) {
+        uint8_t* slabData = blockData + tt * slabSize;
+        if (field.isHalfOutput) {
+            loader->getFieldSlabNative(volumeData, fieldName, t0 + tt, m, slab, nativeSlabData);
+            encodeHalfFloats(
+                    nativeSlabData, field.nativeDataType, reinterpret_cast<uint16_t*>(slabData), numEntries,
+                    outputFloatType, field.halfFloatStats);
+        } else {
+            loader->getFieldSlabNative(volumeData, fieldName, t0 + tt, m, slab, slabData);
+        }
+    }
+
+    // Each chunk is gathered, filtered and written to its own file independently of the others.
+    std::atomic<bool> hasWriteFailed{false};
+    std::atomic<size_t> numMissingChunks{0};
+    sgl::parallelFor(0, numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+        // The buffers are reused by all chunks written on the same thread.
+        static thread_local std::vector<uint8_t> chunkData, shuffledData, compressedData;
+        chunkData.resize(chunkSize);
+        shuffledData.resize(field.useShuffleFilter ? chunkSize : 0);
+        for (size_t chunkIdx = chunkBegin; chunkIdx < chunkEnd; chunkIdx++) {
+            size_t xc = chunkIdx % numChunksX;
+            size_t yc = (chunkIdx / numChunksX) % numChunksY;
+            size_t zc = chunkIdx / (numChunksX * numChunksY);
+            size_t x0 = xc * chunkX;
+            size_t numX = std::min(chunkX, varxs - x0);
+            size_t rowPartSize = numX * entrySize;
+            size_t numZ = std::min(chunkZ, slab.zCount - zc * chunkZ);
+            size_t numY = std::min(chunkY, slab.yCount - yc * chunkY);
+            auto getSrcRow = [&](size_t tt, size_t z, size_t y) {
+                return blockData + tt * slabSize
+                        + ((zc * chunkZ + z) * slab.yCount + yc * chunkY + y) * rowSize + x0 * entrySize;
+            };
+            bool isMissing = true;
+            for (size_t tt = 0; tt < numBlockTimeSteps && isMissing; tt++) {
+                for (size_t z = 0; z < numZ && isMissing; z++) {
+                    for (size_t y = 0; y < numY && isMissing; y++) {
+                        isMissing = getAreEntriesMissing(
+                                getSrcRow(tt, z, y), field.dataType, numX, field.hasFillValue, field.fillValue);
+                    }
+                }
+            }
+            if (isMissing) {
+                numMissingChunks++;
+                continue;
+            }
+
+            // Edge chunks are always stored with the full chunk shape; entries outside of the array are zero.
+            std::fill(chunkData.begin(), chunkData.end(), uint8_t(0));
+            for (size_t tt = 0; tt < numBlockTimeSteps; tt++) {
+                for (size_t z = 0; z < numZ; z++) {
+                    for (size_t y = 0; y < numY; y++) {
+                        uint8_t* dstRow = chunkData.data() + (((tt * chunkZ + z) * chunkY + y) * chunkX) * entrySize;
+                        memcpy(dstRow, getSrcRow(tt, z, y), rowPartSize);
+                    }
+                }
+            }
+            const uint8_t* filteredData = chunkData.data();
+            if (field.useShuffleFilter) {
+                shuffleBytes(chunkData.data(), shuffledData.data(), chunkNumEntries, entrySize);
+                filteredData = shuffledData.data();
+            }
+            size_t filteredSize = chunkSize;
+#ifdef USE_ZLIB
+            if (field.deflateLevel > 0) {
+                auto compressedSize = uLongf(compressBound(uLong(chunkSize)));
+                compressedData.resize(compressedSize);
+                if (compress2(compressedData.data(), &compressedSize, filteredData, uLong(chunkSize),
+                              field.deflateLevel) != Z_OK) {
+                    hasWriteFailed = true;
+                    continue;
+                }
+                filteredData = compressedData.data();
+                filteredSize = compressedSize;
+            }
+#endif
+
+            // The chunk key consists of the chunk indices of all dimensions separated by dots.
+            std::string chunkKey;
+            if (field.numMembers > 1) {
+                chunkKey += std::to_string(m) + ".";
+            }
+            if (numTimeSteps > 1) {
+                chunkKey += std::to_string(t0 / chunkT) + ".";
+            }
+            if (varzs > 1) {
+                chunkKey += std::to_string(slab.zOffset / chunkZ + zc) + ".";
+            }
+            chunkKey += std::to_string(slab.yOffset / chunkY + yc) + "." + std::to_string(xc);
+            if (!writeWholeFile(field.fieldPath + chunkKey, filteredData, filteredSize)) {
+                hasWriteFailed = true;
+            }
+        }
+    });
+    if (hasWriteFailed) {
+        throw std::runtime_error(
+                "Error in ZarrWriter::writeFieldBlock: Compressing or writing a chunk of variable \"" + fieldName
+                + "\" failed.");
+    }
+    field.numSkippedChunks += numMissingChunks;
+}
+
+void ZarrWriter::finishField(const ZarrFieldWrite& field) {
+    if (field.isHalfOutput) {
+        volumeData->reportHalfFloatStats(field.fieldName, field.halfFloatStats);
+    }
+    if (field.numSkippedChunks > 0 && volumeData->getIsVerbose()) {
+        std::cout << "Skipped " << field.numSkippedChunks << " chunk(s) of variable '" << field.fieldName
+                  << "' without valid entries." << std::endl;
+    }
+}
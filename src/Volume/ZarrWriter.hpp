@@ -0,0 +1,87 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_ZARRWRITER_HPP
+#define NCCONV_ZARRWRITER_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "VolumeWriter.hpp"
+
+class VolumeData;
+struct ZarrFieldWrite;
+
+/**
+ * Writes a data set to a Zarr (version 2) directory store, which can be read by Zarr-based analysis tools (e.g.,
+ * xarray.open_zarr) without converting a NetCDF file first. The group has the same dimensions, variables and global
+ * attributes as the NetCDF file written by @see VolumeData. The dimension names are stored in the attribute
+ * "_ARRAY_DIMENSIONS", and the metadata of all arrays is also consolidated in ".zmetadata".
+ * The chunk shape is chosen like for NetCDF output from --chunks or the access pattern (default: maps). Each chunk is
+ * an independent file, so after the slabs of a block of time steps are read, all of its chunks are gathered, shuffled
+ * and compressed (zlib) and written in parallel on the compute pool. Chunks without valid entries are not written, as
+ * Zarr reads missing chunks as the fill value. float16 output uses the Zarr type "<f2"; bfloat16 output is stored as
+ * uint16 with the attribute "ncconv_dtype" like in NetCDF files. Compression is only available when built with zlib.
+ */
+class ZarrWriter : public VolumeWriter {
+public:
+    explicit ZarrWriter(VolumeData* volumeData);
+    /// Writes the store to the passed directory. An existing Zarr store at this path is replaced.
+    bool writeToFile(const std::string& storePath) override;
+
+private:
+    void checkSettings();
+    void prepareStore();
+    /// Writes a metadata file of the store and adds it to the consolidated metadata.
+    void writeMetadata(const std::string& key, const std::string& value);
+    void writeCoordinates();
+    void writeField(const std::string& fieldName);
+    /**
+     * Writes all fields of input that can only be read sequentially (e.g., from stdin). For each (member, time step)
+     * record, the slabs of all fields are read in the order of the data file and their chunks are written as they
+     * arrive. The chunks of these fields span a single time step.
+     */
+    void writeFieldsRecordMajor();
+    /// Chooses the chunk shape and slabs of a field and writes its metadata.
+    ZarrFieldWrite beginField(const std::string& fieldName, bool isRecordMajor);
+    /**
+     * Reads the slab slabIdx of the time steps t0 to t0 + chunkT - 1 of a member into blockData and writes its chunks.
+     * nativeSlabData is used for converting floats to 16-bit output types.
+     */
+    void writeFieldBlock(
+            ZarrFieldWrite& field, size_t m, size_t slabIdx, size_t t0, uint8_t* blockData, uint8_t* nativeSlabData);
+    void finishField(const ZarrFieldWrite& field);
+
+    VolumeData* volumeData;
+    std::string storePath;
+    std::vector<std::pair<std::string, std::string>> metadata; ///< Metadata files for ".zmetadata".
+};
+
+#endif //NCCONV_ZARRWRITER_HPP
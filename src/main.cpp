@@ -27,19 +27,103 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
 
 #include "Utils/StringUtils.hpp"
-#include "Loaders/CtlLoader.hpp"
-#include "Volume/VolumeData.hpp"
+#include "Api/Dataset.hpp"
+#include "Api/ConversionServer.hpp"
 
 void printHelp() {
     std::cout << "Supported options:" << std::endl;
     std::cout << "--input or -i: Path to the input file." << std::endl;
-    std::cout << "--output or -o: Path to the output file." << std::endl;
+    std::cout << "--data: Path to the data file of GrADS input, overriding 'dset'. '-' reads the data from stdin."
+              << std::endl;
+    std::cout << "--output or -o: Path to the output file (.nc for NetCDF, .ctl for GrADS, .zarr for a Zarr store, "
+              << ".json for a reference index pointing into the input file)." << std::endl;
+    std::cout << "--big-endian: Write the binary data of GrADS output in big endian byte order." << std::endl;
+    std::cout << "--cdf5: Write an uncompressed classic NetCDF file in the CDF-5 format without the NetCDF library."
+              << std::endl;
+    std::cout << "--max-memory: Memory budget for field data (e.g., 512M or 4G). Larger fields are streamed in slabs."
+              << std::endl;
+    std::cout << "--layout: Dimension order of time-dependent variables. 'maps' (default) writes (time, lev, lat, lon),"
+              << " 'timeseries' writes (lev, lat, lon, time)." << std::endl;
+    std::cout << "--output-type: Storage type of floating point variables in NetCDF output. 'native' (default), "
+              << "'float16' or 'bfloat16'." << std::endl;
+    std::cout << "--spill-dir: Directory for temporary files if '--layout timeseries' exceeds '--max-memory'."
+              << std::endl;
+    std::cout << "--coarsen: Average blocks of N x N (or NX,NY) horizontal grid points weighted by the cosine of the "
+              << "latitude while reading." << std::endl;
+    std::cout << "--regrid: Coarsen the grid to the passed spacing in degrees (e.g., 1.0 or 1.0,0.5 for lon,lat)."
+              << std::endl;
+    std::cout << "--derive: Add a variable computed while writing, e.g., \"ws=sqrt(u^2+v^2)\". May be passed multiple "
+              << "times, or with multiple definitions separated by ';'." << std::endl;
+    std::cout << "--aggregate-time: Also write the mean, min, max and count of each time-dependent variable over "
+              << "periods of N time steps, 'daily' or 'monthly'." << std::endl;
+    std::cout << "--ensemble-stats: Also write statistics over the ensemble members, e.g., 'mean,std,p10,p50,p90'."
+              << std::endl;
+    std::cout << "--drop-members: Only write the ensemble statistics, not the members themselves." << std::endl;
+    std::cout << "--chunks: Chunk shape of the output variables as z,y,x (e.g., 1,256,256)." << std::endl;
+    std::cout << "--access-pattern: Choose the chunk shape for reading 'maps', 'profiles', 'timeseries' or 'balanced'."
+              << std::endl;
+    std::cout << "--chunk-size: Target size of the chunks chosen for '--access-pattern' (default: 1M)." << std::endl;
+    std::cout << "--benchmark-read: Benchmark reading the output file with different access patterns after writing it."
+              << std::endl;
+    std::cout << "--deflate: Deflate compression level (1-9) of the output variables." << std::endl;
+    std::cout << "--shuffle: Apply the shuffle filter before compression." << std::endl;
+    std::cout << "--collapse-static: Write variables that are identical in all time steps once without the time "
+              << "dimension." << std::endl;
+    std::cout << "--no-direct-chunk-write: Let HDF5 compress the chunks on a single thread (if built with "
+              << "USE_HDF5_DIRECT_CHUNK_WRITE)." << std::endl;
+    std::cout << "--verify: Verify an existing output file against the input file using per-slab hashes." << std::endl;
+    std::cout << "--verify-recorded: Verify only the output file against the slab hashes recorded when writing it."
+              << std::endl;
+    std::cout << "--dry-run: Print the predicted output size, peak memory and wall time without converting."
+              << std::endl;
+    std::cout << "--probe-write: With --dry-run, measure the write bandwidth by writing 32 MiB to the output directory."
+              << std::endl;
+    std::cout << "--threads: Number of threads for decoding, hashing and compression (default: all hardware threads)."
+              << std::endl;
+    std::cout << "--io-threads: Number of threads reading ahead while writing (default: 1, 0 disables reading ahead)."
+              << std::endl;
+    std::cout << "--no-slab-hashes: Do not record per-slab hashes in the output file." << std::endl;
+    std::cout << "--server: Process newline-delimited JSON jobs from stdin, keeping opened data sets cached." << std::endl;
+    std::cout << "--socket: Like --server, but listen for jobs on the passed Unix domain socket path." << std::endl;
 }
 
-int main(int argc, char *argv[]) {
-    std::string inputFile, outputFile;
+/// Parses the command line arguments and runs the conversion. Returns the exit code; errors throw exceptions.
+static int runNcconv(int argc, char *argv[], int mpiRank) {
+    std::string inputFile, outputFile, socketPath, spillDirectory;
+    size_t maxMemory = 0;
+    OutputLayout outputLayout = OutputLayout::MAPS;
+    OutputFloatType outputFloatType = OutputFloatType::NATIVE;
+    std::vector<size_t> chunkShape;
+    std::vector<int> coarseningFactors;
+    std::vector<double> targetResolution;
+    std::vector<std::string> derivedFieldDefinitions;
+    TimeAggregation timeAggregation;
+    std::vector<EnsembleStatistic> ensembleStatistics;
+    bool writeEnsembleMembers = true;
+    AccessPattern accessPattern = AccessPattern::DEFAULT;
+    size_t chunkTargetSize = size_t(1) << 20;
+    bool isReadBenchmark = false;
+    int deflateLevel = 0;
+    bool useShuffleFilter = false;
+    bool useDirectChunkWrite = true;
+    bool collapseTimeInvariantFields = false;
+    bool isBigEndian = false;
+    bool useCdf5Format = false;
+    bool isVerifyMode = false, useRecordedHashesOnly = false, recordSlabHashes = true;
+    bool isDryRun = false, probeWriteBandwidth = false;
+    bool isServerMode = false;
+    DataSetInformation dataSetInformation;
+    size_t numThreads = 0, numIoThreads = 1;
     for (int i = 1; i < argc; i++) {
         std::string command = argv[i];
         if (command == "--input" || command == "-i") {
@@ -48,39 +132,300 @@ int main(int argc, char *argv[]) {
                 throw std::runtime_error("Error: Command line arguments '--input' and '-i' expect a file path.");
             }
             inputFile = argv[i];
+        } else if (command == "--data") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--data' expects a file path or '-'.");
+            }
+            dataSetInformation.dataFilePath = argv[i];
         } else if (command == "--output" || command == "-o") {
             i++;
             if (i >= argc) {
-                throw std::runtime_error("Error: Command line arguments '--input' and '-i' expect a file path.");
+                throw std::runtime_error("Error: Command line arguments '--output' and '-o' expect a file path.");
             }
             outputFile = argv[i];
+        } else if (command == "--max-memory") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--max-memory' expects a size.");
+            }
+            maxMemory = sgl::parseMemorySize(argv[i]);
+        } else if (command == "--layout") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--layout' expects 'maps' or 'timeseries'.");
+            }
+            outputLayout = parseOutputLayout(argv[i]);
+        } else if (command == "--output-type") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error(
+                        "Error: Command line argument '--output-type' expects 'native', 'float16' or 'bfloat16'.");
+            }
+            outputFloatType = parseOutputFloatType(argv[i]);
+        } else if (command == "--spill-dir") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--spill-dir' expects a directory path.");
+            }
+            spillDirectory = argv[i];
+        } else if (command == "--coarsen") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--coarsen' expects a factor N or NX,NY.");
+            }
+            coarseningFactors.clear();
+            sgl::splitStringTyped<int>(argv[i], ',', coarseningFactors);
+            if (coarseningFactors.size() == 1) {
+                coarseningFactors.push_back(coarseningFactors.front());
+            }
+            if (coarseningFactors.size() != 2) {
+                throw std::runtime_error("Error: Command line argument '--coarsen' expects a factor N or NX,NY.");
+            }
+        } else if (command == "--regrid") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--regrid' expects a grid spacing in degrees.");
+            }
+            targetResolution.clear();
+            sgl::splitStringTyped<double>(argv[i], ',', targetResolution);
+            if (targetResolution.size() == 1) {
+                targetResolution.push_back(targetResolution.front());
+            }
+            if (targetResolution.size() != 2) {
+                throw std::runtime_error("Error: Command line argument '--regrid' expects a grid spacing in degrees.");
+            }
+        } else if (command == "--derive") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error(
+                        "Error: Command line argument '--derive' expects a definition name=expression.");
+            }
+            sgl::splitString(argv[i], ';', derivedFieldDefinitions);
+        } else if (command == "--aggregate-time") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error(
+                        "Error: Command line argument '--aggregate-time' expects N, 'daily' or 'monthly'.");
+            }
+            timeAggregation = parseTimeAggregation(argv[i]);
+        } else if (command == "--ensemble-stats") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error(
+                        "Error: Command line argument '--ensemble-stats' expects a list of statistics.");
+            }
+            ensembleStatistics = parseEnsembleStatistics(argv[i]);
+        } else if (command == "--drop-members") {
+            writeEnsembleMembers = false;
+        } else if (command == "--chunks") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--chunks' expects a chunk shape z,y,x.");
+            }
+            chunkShape.clear();
+            sgl::splitStringTyped<size_t>(argv[i], ',', chunkShape);
+        } else if (command == "--access-pattern") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error(
+                        "Error: Command line argument '--access-pattern' expects 'maps', 'profiles', 'timeseries' or "
+                        "'balanced'.");
+            }
+            accessPattern = parseAccessPattern(argv[i]);
+        } else if (command == "--chunk-size") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--chunk-size' expects a size.");
+            }
+            chunkTargetSize = sgl::parseMemorySize(argv[i]);
+        } else if (command == "--benchmark-read") {
+            isReadBenchmark = true;
+        } else if (command == "--deflate") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--deflate' expects a compression level.");
+            }
+            deflateLevel = sgl::fromString<int>(argv[i]);
+        } else if (command == "--shuffle") {
+            useShuffleFilter = true;
+        } else if (command == "--collapse-static") {
+            collapseTimeInvariantFields = true;
+        } else if (command == "--no-direct-chunk-write") {
+            useDirectChunkWrite = false;
+        } else if (command == "--threads") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--threads' expects a number of threads.");
+            }
+            numThreads = sgl::fromString<size_t>(argv[i]);
+        } else if (command == "--io-threads") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--io-threads' expects a number of threads.");
+            }
+            numIoThreads = sgl::fromString<size_t>(argv[i]);
+        } else if (command == "--big-endian") {
+            isBigEndian = true;
+        } else if (command == "--cdf5") {
+            useCdf5Format = true;
+        } else if (command == "--verify") {
+            isVerifyMode = true;
+        } else if (command == "--verify-recorded") {
+            isVerifyMode = true;
+            useRecordedHashesOnly = true;
+        } else if (command == "--dry-run") {
+            isDryRun = true;
+        } else if (command == "--probe-write") {
+            probeWriteBandwidth = true;
+        } else if (command == "--no-slab-hashes") {
+            recordSlabHashes = false;
+        } else if (command == "--server") {
+            isServerMode = true;
+        } else if (command == "--socket") {
+            i++;
+            if (i >= argc) {
+                throw std::runtime_error("Error: Command line argument '--socket' expects a socket path.");
+            }
+            isServerMode = true;
+            socketPath = argv[i];
         } else if (command == "--help" || command == "-h") {
-            printHelp();
+            if (mpiRank == 0) {
+                printHelp();
+            }
             return 0;
         }
     }
 
+#ifdef USE_MPI
+    if (numThreads == 0) {
+        // Ranks running on the same node share its hardware threads.
+        MPI_Comm nodeComm;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+        int numNodeRanks = 1;
+        MPI_Comm_size(nodeComm, &numNodeRanks);
+        MPI_Comm_free(&nodeComm);
+        numThreads = std::max(size_t(std::thread::hardware_concurrency()) / size_t(numNodeRanks), size_t(1));
+    }
+#endif
+    ncconv::Dataset::setNumThreads(numThreads, numIoThreads);
+
+    if (isServerMode) {
+        if (!dataSetInformation.dataFilePath.empty()) {
+            throw std::runtime_error("Error: '--data' cannot be used together with '--server' or '--socket'.");
+        }
+        ncconv::ConversionServer server;
+        if (socketPath.empty()) {
+            server.run(std::cin, std::cout);
+        } else {
+            server.runUnixSocket(socketPath);
+        }
+        return 0;
+    }
+
+    if (isDryRun && outputFile.empty() && !inputFile.empty()) {
+        outputFile = inputFile + ".nc";
+        if (mpiRank == 0) {
+            std::cout << "No output file specified; estimating the conversion to \"" << outputFile << "\"."
+                      << std::endl;
+        }
+    }
     if (inputFile.empty() || outputFile.empty()) {
         throw std::runtime_error("Error: Input or output file path not specified. Use '--help' for more information.");
     }
 
-    CtlLoader* loader = nullptr;
-    if (sgl::endsWith(inputFile, ".ctl")) {
-        loader = new CtlLoader;
-    } else {
+    if (!ncconv::Dataset::getIsFileSupported(inputFile)) {
         throw std::runtime_error("Error: Unsupported input file extension.");
     }
 
-    VolumeData* volumeData = new VolumeData;
-    std::cout << "Opening input file..." << std::endl;
-    if (!loader->setInputFiles(volumeData, inputFile, {})) {
-        throw std::runtime_error("Error: Parsing input file format failed.");
+    if (mpiRank == 0) {
+        std::cout << "Opening input file..." << std::endl;
+    }
+    bool isVerified = true;
+    {
+        ncconv::Dataset dataset(inputFile, dataSetInformation);
+        dataset.setMaxMemory(maxMemory);
+        if (!coarseningFactors.empty()) {
+            dataset.setCoarseningFactors(coarseningFactors.at(0), coarseningFactors.at(1));
+        }
+        if (!targetResolution.empty()) {
+            dataset.setTargetResolution(targetResolution.at(0), targetResolution.at(1));
+        }
+        dataset.setDerivedFields(derivedFieldDefinitions);
+        dataset.setOutputLayout(outputLayout);
+        dataset.setOutputFloatType(outputFloatType);
+        dataset.setTimeAggregation(timeAggregation);
+        dataset.setEnsembleStatistics(ensembleStatistics);
+        dataset.setWriteEnsembleMembers(writeEnsembleMembers);
+        dataset.setSpillDirectory(spillDirectory);
+        dataset.setChunkShape(chunkShape);
+        dataset.setAccessPattern(accessPattern);
+        dataset.setChunkTargetSize(chunkTargetSize);
+        dataset.setDeflateLevel(deflateLevel);
+        dataset.setUseShuffleFilter(useShuffleFilter);
+        dataset.setUseDirectChunkWrite(useDirectChunkWrite);
+        dataset.setCollapseTimeInvariantFields(collapseTimeInvariantFields);
+        dataset.setRecordSlabHashes(recordSlabHashes);
+        if (isDryRun) {
+            if (mpiRank == 0) {
+                std::cout << "Estimating conversion..." << std::endl;
+                ConversionEstimate estimate = dataset.estimateConversion(
+                        outputFile, useCdf5Format, probeWriteBandwidth);
+                ConversionEstimator::printEstimate(estimate, std::cout);
+            }
+        } else if (isVerifyMode) {
+            if (mpiRank == 0) {
+                std::cout << "Verifying output file..." << std::endl;
+            }
+            isVerified = dataset.verifyNcFile(outputFile, useRecordedHashesOnly);
+        } else {
+            if (mpiRank == 0) {
+                std::cout << "Writing output file..." << std::endl;
+            }
+            if (sgl::endsWith(outputFile, ".ctl")) {
+                dataset.writeToCtlFile(outputFile, isBigEndian);
+            } else if (sgl::endsWith(outputFile, ".json")) {
+                dataset.writeToReferenceIndex(outputFile);
+            } else if (sgl::endsWith(outputFile, ".zarr")) {
+                dataset.writeToZarrStore(outputFile);
+            } else {
+                if (useCdf5Format) {
+                    dataset.writeToCdf5File(outputFile);
+                } else {
+                    dataset.writeToNcFile(outputFile);
+                }
+                if (isReadBenchmark && mpiRank == 0) {
+                    std::cout << "Benchmarking reads of the output file..." << std::endl;
+                    printReadBenchmark(dataset.benchmarkNcFileReads(outputFile), std::cout);
+                }
+            }
+        }
+    }
+
+    return isVerified ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+
+    int exitCode = 1;
+    try {
+        exitCode = runNcconv(argc, argv, mpiRank);
+    } catch (const std::exception& exception) {
+        // Invalid arguments or input data are reported like other errors instead of aborting the process.
+        std::cerr << exception.what() << std::endl;
+#ifdef USE_MPI
+        MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+        return 1;
     }
-    volumeData->setLoader(loader);
-    std::cout << "Writing output file..." << std::endl;
-    volumeData->writeToNcFile(outputFile);
-    delete volumeData;
-    delete loader;
 
-    return 0;
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+    return exitCode;
 }
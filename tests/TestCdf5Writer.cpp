@@ -0,0 +1,75 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the built-in CDF-5 writer (Cdf5Writer). The output is read with the NetCDF library and compared against the
+ * NetCDF-4 output of the same data set.
+ */
+
+NCCONV_TEST(cdf5MatchesNetCdf4Output) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    std::string cdf5FilePath = testDirectory + "/typed_cdf5.nc";
+    std::string nc4FilePath = testDirectory + "/typed_nc4.nc";
+    dataset.writeToCdf5File(cdf5FilePath);
+    dataset.writeToNcFile(nc4FilePath);
+
+    for (const std::string& fieldName : dataset.getFieldNames()) {
+        NCCONV_CHECK_EQUAL(
+                ncconv_test::getNcVariableType(cdf5FilePath, fieldName),
+                ncconv_test::getNcVariableType(nc4FilePath, fieldName));
+        double cdf5FillValue = 0.0, nc4FillValue = 0.0;
+        bool cdf5HasFillValue = ncconv_test::getNcFillValue(cdf5FilePath, fieldName, cdf5FillValue);
+        NCCONV_CHECK_EQUAL(cdf5HasFillValue, ncconv_test::getNcFillValue(nc4FilePath, fieldName, nc4FillValue));
+        if (cdf5HasFillValue && !std::isnan(nc4FillValue)) {
+            NCCONV_CHECK_EQUAL(cdf5FillValue, nc4FillValue);
+        }
+        auto cdf5Values = ncconv_test::readNcVariable(cdf5FilePath, fieldName);
+        auto nc4Values = ncconv_test::readNcVariable(nc4FilePath, fieldName);
+        NCCONV_CHECK_EQUAL(cdf5Values.size(), nc4Values.size());
+        for (size_t i = 0; i < cdf5Values.size(); i++) {
+            bool isNaN = std::isnan(cdf5Values.at(i)) && std::isnan(nc4Values.at(i));
+            NCCONV_CHECK(isNaN || cdf5Values.at(i) == nc4Values.at(i));
+        }
+    }
+
+    // The undef value -9999 cannot be stored in uint8, so the entry 241 stays valid.
+    double fillValue = 0.0;
+    NCCONV_CHECK(!ncconv_test::getNcFillValue(cdf5FilePath, "cnt", fillValue));
+    NCCONV_CHECK_EQUAL(ncconv_test::readNcVariable(cdf5FilePath, "cnt").at(0), 241.0);
+    NCCONV_CHECK(ncconv_test::getNcFillValue(cdf5FilePath, "i16", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, -9999.0);
+    NCCONV_CHECK(dataset.verifyNcFile(cdf5FilePath));
+}
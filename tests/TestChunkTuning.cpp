@@ -0,0 +1,126 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "Volume/ChunkTuning.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of choosing the chunk shape of the output variables from the expected read access pattern (ChunkTuning).
+ */
+
+/// Returns the chunk sizes of a variable, or an empty vector if the variable is not chunked.
+static std::vector<size_t> getNcChunkSizes(const std::string& filePath, const std::string& varName) {
+    int ncid = -1, varid = -1, numDims = 0, storage = 0;
+    NCCONV_CHECK(nc_open(filePath.c_str(), NC_NOWRITE, &ncid) == NC_NOERR);
+    NCCONV_CHECK(nc_inq_varid(ncid, varName.c_str(), &varid) == NC_NOERR);
+    nc_inq_varndims(ncid, varid, &numDims);
+    std::vector<size_t> chunkSizes(numDims);
+    nc_inq_var_chunking(ncid, varid, &storage, chunkSizes.data());
+    nc_close(ncid);
+    return storage == NC_CHUNKED ? chunkSizes : std::vector<size_t>();
+}
+
+NCCONV_TEST(chunkShapeFollowsAccessPattern) {
+    // 1000 float entries per chunk for a variable with the extent (t, z, y, x) = (8, 4, 100, 200).
+    const size_t targetSize = 1000 * sizeof(float);
+    auto computeShape = [&](AccessPattern pattern) {
+        return computeChunkShape(pattern, 8, 4, 100, 200, sizeof(float), targetSize);
+    };
+    // Maps are split into bands of whole rows, profiles span all levels, and time series span all time steps.
+    NCCONV_CHECK((computeShape(AccessPattern::MAPS) == std::array<size_t, 4>{ 1, 1, 5, 200 }));
+    NCCONV_CHECK((computeShape(AccessPattern::PROFILES) == std::array<size_t, 4>{ 1, 4, 16, 15 }));
+    NCCONV_CHECK((computeShape(AccessPattern::TIME_SERIES) == std::array<size_t, 4>{ 8, 1, 11, 11 }));
+    // Balanced chunks scale all axes by ~0.2 (rounded down), and the innermost axis then grows up to the target size.
+    std::array<size_t, 4> balanced = computeShape(AccessPattern::BALANCED);
+    NCCONV_CHECK((balanced == std::array<size_t, 4>{ 1, 1, 19, 52 }));
+    NCCONV_CHECK(balanced[0] * balanced[1] * balanced[2] * balanced[3] <= 1000);
+    // Whole maps are used if they fit.
+    NCCONV_CHECK((
+            computeChunkShape(AccessPattern::MAPS, 8, 4, 100, 200, sizeof(float), size_t(1) << 20)
+            == std::array<size_t, 4>{ 1, 1, 100, 200 }));
+
+    bool hasThrown = false;
+    try {
+        computeShape(AccessPattern::DEFAULT);
+    } catch (const std::runtime_error&) {
+        hasThrown = true;
+    }
+    NCCONV_CHECK(hasThrown);
+    NCCONV_CHECK(parseAccessPattern("timeseries") == AccessPattern::TIME_SERIES);
+    NCCONV_CHECK_EQUAL(countChunksSpanned(3, 5, 4), size_t(2));
+    NCCONV_CHECK_EQUAL(getNextPrime(90), size_t(97));
+}
+
+NCCONV_TEST(accessPatternSetsOutputChunks) {
+    ncconv_test::writeTextFile(testDirectory + "/chunks.ctl",
+            "dset ^chunks.dat\n"
+            "undef -9999\n"
+            "xdef 20 linear 0 1.0\n"
+            "ydef 10 linear 0 1.0\n"
+            "zdef 3 levels 1000 850 500\n"
+            "tdef 6 linear 00Z01JAN2000 6hr\n"
+            "vars 1\n"
+            "t 3 99 temperature\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 6 * 3 * 10 * 20; i++) {
+        ncconv_test::appendValue(data, float(i), false);
+    }
+    ncconv_test::writeBinaryFile(testDirectory + "/chunks.dat", data);
+    ncconv::Dataset dataset(testDirectory + "/chunks.ctl");
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/default.nc");
+
+    const size_t targetSize = 120 * sizeof(float);
+    dataset.setChunkTargetSize(targetSize);
+    for (AccessPattern pattern : { AccessPattern::MAPS, AccessPattern::PROFILES, AccessPattern::TIME_SERIES }) {
+        std::string filePath = testDirectory + "/pattern_" + std::to_string(int(pattern)) + ".nc";
+        dataset.setAccessPattern(pattern);
+        dataset.writeToNcFile(filePath);
+        std::array<size_t, 4> expectedShape = computeChunkShape(pattern, 6, 3, 10, 20, sizeof(float), targetSize);
+        std::vector<size_t> chunkSizes = getNcChunkSizes(filePath, "t");
+        NCCONV_CHECK(chunkSizes == std::vector<size_t>(expectedShape.begin(), expectedShape.end()));
+        ncconv_test::checkNcVariablesEqual(testDirectory + "/default.nc", filePath, "t");
+    }
+
+    // An explicit chunk shape (z, y, x) takes precedence over the access pattern.
+    dataset.setChunkShape({ 1, 2, 5 });
+    dataset.writeToNcFile(testDirectory + "/explicit.nc");
+    std::vector<size_t> chunkSizes = getNcChunkSizes(testDirectory + "/explicit.nc", "t");
+    NCCONV_CHECK_EQUAL(chunkSizes.size(), size_t(4));
+    NCCONV_CHECK((std::vector<size_t>(chunkSizes.begin() + 1, chunkSizes.end()) == std::vector<size_t>{ 1, 2, 5 }));
+    ncconv_test::checkNcVariablesEqual(testDirectory + "/default.nc", testDirectory + "/explicit.nc", "t");
+}
@@ -0,0 +1,149 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the coarsening of the horizontal grid (see CoarseningLoader). Each output grid point needs to be the mean of
+ * the valid entries of its block weighted by the cosine of the latitude, including the smaller blocks at the edges.
+ */
+
+const size_t CG_XS = 7, CG_YS = 6, CG_ZS = 2;
+
+static bool getIsMissingCoarseningEntry(size_t x, size_t y, size_t z) {
+    // The block (3, 2) of the 2 x 2 coarsening of level 1 has no valid entry.
+    return (z == 1 && x == 6 && y >= 4) || (x + 2 * y + 3 * z) % 11 == 5;
+}
+
+static float getCoarseningEntry(size_t x, size_t y, size_t z) {
+    return float(x) * 1.5f - float(y * y) * 0.25f + float(z) * 10.0f;
+}
+
+/// Writes a data set with a 3D variable "t" (7 x 6 x 2) on a grid from 0°N to 75°N with a spacing of 15°.
+static std::string writeCoarseningDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/coarse.ctl",
+            "dset ^coarse.dat\n"
+            "undef -9999\n"
+            "xdef 7 linear 0 1.0\n"
+            "ydef 6 linear 0 15.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 1 linear 00Z01JAN2000 6hr\n"
+            "vars 1\n"
+            "t 2 99 temperature\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (size_t z = 0; z < CG_ZS; z++) {
+        for (size_t y = 0; y < CG_YS; y++) {
+            for (size_t x = 0; x < CG_XS; x++) {
+                float value = getIsMissingCoarseningEntry(x, y, z) ? -9999.0f : getCoarseningEntry(x, y, z);
+                ncconv_test::appendValue(data, value, false);
+            }
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/coarse.dat", data);
+    return directory + "/coarse.ctl";
+}
+
+/// Checks the entries of "t" coarsened by factorX x factorY against the cosine of latitude weighted block means.
+static void checkCoarsenedEntries(const std::string& filePath, size_t factorX, size_t factorY) {
+    const size_t coarseXs = (CG_XS + factorX - 1) / factorX;
+    const size_t coarseYs = (CG_YS + factorY - 1) / factorY;
+    std::vector<double> values = ncconv_test::readNcVariable(filePath, "t");
+    NCCONV_CHECK_EQUAL(values.size(), coarseXs * coarseYs * CG_ZS);
+    const double degreesToRadians = 3.14159265358979323846 / 180.0;
+    for (size_t z = 0; z < CG_ZS; z++) {
+        for (size_t yc = 0; yc < coarseYs; yc++) {
+            for (size_t xc = 0; xc < coarseXs; xc++) {
+                double sum = 0.0, weightSum = 0.0;
+                for (size_t y = yc * factorY; y < std::min((yc + 1) * factorY, CG_YS); y++) {
+                    double weight = std::cos(double(y) * 15.0 * degreesToRadians);
+                    for (size_t x = xc * factorX; x < std::min((xc + 1) * factorX, CG_XS); x++) {
+                        if (!getIsMissingCoarseningEntry(x, y, z)) {
+                            sum += weight * double(getCoarseningEntry(x, y, z));
+                            weightSum += weight;
+                        }
+                    }
+                }
+                double value = values.at((z * coarseYs + yc) * coarseXs + xc);
+                if (weightSum == 0.0) {
+                    NCCONV_CHECK(std::isnan(value));
+                } else {
+                    double expectedValue = sum / weightSum;
+                    NCCONV_CHECK(std::abs(value - expectedValue) <= 1e-5 * std::max(std::abs(expectedValue), 1.0));
+                }
+            }
+        }
+    }
+}
+
+NCCONV_TEST(coarseningWeightsRowsByLatitude) {
+    ncconv::Dataset dataset(writeCoarseningDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setCoarseningFactors(2, 2);
+    dataset.writeToNcFile(testDirectory + "/coarse_2x2.nc");
+    checkCoarsenedEntries(testDirectory + "/coarse_2x2.nc", 2, 2);
+    // The coordinates of the coarse grid are the means of the block coordinates.
+    std::vector<double> lat = ncconv_test::readNcVariable(testDirectory + "/coarse_2x2.nc", "lat");
+    NCCONV_CHECK((lat == std::vector<double>{ 7.5, 37.5, 67.5 }));
+    std::vector<double> lon = ncconv_test::readNcVariable(testDirectory + "/coarse_2x2.nc", "lon");
+    NCCONV_CHECK((lon == std::vector<double>{ 0.5, 2.5, 4.5, 6.0 }));
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/coarse_2x2.nc"));
+
+    dataset.setCoarseningFactors(3, 4);
+    dataset.writeToNcFile(testDirectory + "/coarse_3x4.nc");
+    checkCoarsenedEntries(testDirectory + "/coarse_3x4.nc", 3, 4);
+
+    // Factors of 1 restore the input grid.
+    dataset.setCoarseningFactors(1, 1);
+    dataset.writeToNcFile(testDirectory + "/fine.nc");
+    checkCoarsenedEntries(testDirectory + "/fine.nc", 1, 1);
+}
+
+NCCONV_TEST(targetResolutionSelectsCoarseningFactors) {
+    ncconv::Dataset dataset(writeCoarseningDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setTargetResolution(2.0, 30.0);
+    dataset.writeToNcFile(testDirectory + "/coarse.nc");
+    checkCoarsenedEntries(testDirectory + "/coarse.nc", 2, 2);
+
+    // The target spacing needs to be an integer multiple of the grid spacing.
+    bool hasThrown = false;
+    try {
+        dataset.setTargetResolution(1.5, 30.0);
+    } catch (const std::runtime_error& exception) {
+        hasThrown = std::string(exception.what()).find("integer multiple") != std::string::npos;
+    }
+    NCCONV_CHECK(hasThrown);
+}
@@ -0,0 +1,143 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the dry-run estimate (ConversionEstimator). The logical output sizes need to match the variables the
+ * writers actually write, and the compression ratio needs to be measured on the sampled chunks without the metadata
+ * of a temporary file, which dominates for small inputs.
+ */
+
+/// Writes a data set with a constant float variable "c" and a smooth float variable "s" (64 x 32, four time steps).
+static std::string writeEstimateDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/estimate.ctl",
+            "dset ^estimate.dat\n"
+            "undef -9999\n"
+            "xdef 64 linear 0 1.0\n"
+            "ydef 32 linear 0 1.0\n"
+            "zdef 1 levels 1000\n"
+            "tdef 4 linear 00Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "c 0 99 constant\n"
+            "s 0 99 smooth\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < 64 * 32; i++) {
+            ncconv_test::appendValue(data, 1.5f, false);
+        }
+        for (int i = 0; i < 64 * 32; i++) {
+            ncconv_test::appendValue(data, float(std::sin(0.01 * double(i + t))), false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/estimate.dat", data);
+    return directory + "/estimate.ctl";
+}
+
+static size_t countDirectoryEntries(const std::string& directory) {
+    size_t numEntries = 0;
+    for (boost::filesystem::directory_iterator it(directory), end; it != end; ++it) {
+        numEntries++;
+    }
+    return numEntries;
+}
+
+NCCONV_TEST(dryRunMeasuresCompressedChunks) {
+    ncconv::Dataset dataset(writeEstimateDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    const size_t fieldBytes = size_t(64) * size_t(32) * sizeof(float) * 4;
+    size_t numDirectoryEntries = countDirectoryEntries(testDirectory);
+
+    // Without compression, the output has the logical size of the input.
+    ConversionEstimate estimate = dataset.estimateConversion(testDirectory + "/out.nc");
+    NCCONV_CHECK_EQUAL(estimate.inputBytes, 2 * fieldBytes);
+    NCCONV_CHECK_EQUAL(estimate.outputBytes, 2 * fieldBytes);
+    NCCONV_CHECK_EQUAL(estimate.predictedOutputBytes, 2 * fieldBytes);
+    NCCONV_CHECK_EQUAL(estimate.compressionRatio, 1.0);
+
+    // Half of the samples are the constant field, which deflates to almost nothing, so the ratio is clearly below 1.
+    // Measuring whole files instead yields ratios above 1 for inputs this small.
+    dataset.setDeflateLevel(4);
+    dataset.setUseShuffleFilter(true);
+    estimate = dataset.estimateConversion(testDirectory + "/out.nc");
+    NCCONV_CHECK(estimate.compressionRatio > 0.0 && estimate.compressionRatio < 0.75);
+    NCCONV_CHECK(estimate.predictedOutputBytes < estimate.outputBytes);
+    NCCONV_CHECK(estimate.compressionThroughput > 0.0);
+    ConversionEstimate zarrEstimate = dataset.estimateConversion(testDirectory + "/out.zarr");
+    NCCONV_CHECK_EQUAL(zarrEstimate.compressionRatio, estimate.compressionRatio);
+
+    // The write bandwidth is only probed on request, so no file is created in the output directory.
+    NCCONV_CHECK_EQUAL(estimate.writeBandwidth, 0.0);
+    NCCONV_CHECK_EQUAL(countDirectoryEntries(testDirectory), numDirectoryEntries);
+    estimate = dataset.estimateConversion(testDirectory + "/out.nc", false, true);
+    NCCONV_CHECK(estimate.writeBandwidth > 0.0);
+    NCCONV_CHECK_EQUAL(countDirectoryEntries(testDirectory), numDirectoryEntries);
+}
+
+NCCONV_TEST(dryRunAccountsForOutputKind) {
+    ncconv::Dataset dataset(writeEstimateDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    const size_t numEntries = size_t(64) * size_t(32);
+    const size_t fieldBytes = numEntries * sizeof(float) * 4;
+
+    // 16-bit floats halve the NetCDF-4, CDF-5 and Zarr output, while GrADS output keeps the native type.
+    dataset.setOutputFloatType(OutputFloatType::FLOAT16);
+    NCCONV_CHECK_EQUAL(dataset.estimateConversion(testDirectory + "/out.nc").outputBytes, fieldBytes);
+    NCCONV_CHECK_EQUAL(dataset.estimateConversion(testDirectory + "/out.nc", true).outputBytes, fieldBytes);
+    NCCONV_CHECK_EQUAL(dataset.estimateConversion(testDirectory + "/out.zarr").outputBytes, fieldBytes);
+    NCCONV_CHECK_EQUAL(dataset.estimateConversion(testDirectory + "/out.ctl").outputBytes, 2 * fieldBytes);
+    dataset.setOutputFloatType(OutputFloatType::NATIVE);
+
+    // CDF-5 files are never compressed.
+    dataset.setDeflateLevel(4);
+    ConversionEstimate estimate = dataset.estimateConversion(testDirectory + "/out.nc", true);
+    NCCONV_CHECK_EQUAL(estimate.compressionRatio, 1.0);
+    NCCONV_CHECK_EQUAL(estimate.predictedOutputBytes, 2 * fieldBytes);
+    dataset.setDeflateLevel(0);
+
+    // A reference index reads no data and only stores one reference per field and time step.
+    estimate = dataset.estimateConversion(testDirectory + "/out.json");
+    NCCONV_CHECK_EQUAL(estimate.readBytes, size_t(0));
+    NCCONV_CHECK(estimate.outputBytes > 0 && estimate.outputBytes < 2 * 4 * 256);
+
+    // Temporal aggregates of two periods add the mean, minimum, maximum and count of each field.
+    TimeAggregation timeAggregation;
+    timeAggregation.type = TimeAggregationType::STEPS;
+    timeAggregation.numSteps = 2;
+    dataset.setTimeAggregation(timeAggregation);
+    estimate = dataset.estimateConversion(testDirectory + "/out.nc");
+    NCCONV_CHECK_EQUAL(estimate.outputBytes, 2 * fieldBytes + 2 * 2 * 4 * numEntries * sizeof(float));
+    NCCONV_CHECK_EQUAL(dataset.estimateConversion(testDirectory + "/out.ctl").outputBytes, 2 * fieldBytes);
+}
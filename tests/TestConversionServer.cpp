@@ -0,0 +1,98 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sstream>
+#include <string>
+#include <boost/filesystem.hpp>
+
+#include "Api/ConversionServer.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the conversion server. Data sets are cached across jobs, so every option needs to be set for every job;
+ * otherwise, an option of one job would leak into the next job on the same data set.
+ */
+
+static bool getHasSubstring(const std::string& str, const std::string& substring) {
+    return str.find(substring) != std::string::npos;
+}
+
+NCCONV_TEST(serverResetsOptionsBetweenJobs) {
+    std::string ctlFilePath = ncconv_test::writeTypedDataSet(testDirectory, "-9999");
+    std::string noHashesFilePath = testDirectory + "/no_hashes.nc";
+    std::string hashesFilePath = testDirectory + "/hashes.nc";
+    std::string spillDirectory = testDirectory + "/spill";
+    boost::filesystem::create_directory(spillDirectory);
+
+    ncconv::ConversionServer server;
+    std::string response = server.processJob(
+            "{\"id\": \"a\", \"input\": \"" + ctlFilePath + "\", \"output\": \"" + noHashesFilePath
+            + "\", \"slab_hashes\": false, \"direct_chunk_write\": false, \"deflate\": 1, \"spill_dir\": \""
+            + spillDirectory + "\"}");
+    NCCONV_CHECK(getHasSubstring(response, "\"id\": \"a\", \"status\": \"ok\", \"cached\": false"));
+    NCCONV_CHECK(!ncconv_test::getNcHasAttribute(noHashesFilePath, "f32", "ncconv_xxh64"));
+
+    // The second job on the cached data set uses the defaults again.
+    response = server.processJob(
+            "{\"id\": \"b\", \"input\": \"" + ctlFilePath + "\", \"output\": \"" + hashesFilePath + "\"}");
+    NCCONV_CHECK(getHasSubstring(response, "\"id\": \"b\", \"status\": \"ok\", \"cached\": true"));
+    NCCONV_CHECK(ncconv_test::getNcHasAttribute(hashesFilePath, "f32", "ncconv_xxh64"));
+    NCCONV_CHECK(
+            ncconv_test::readNcVariable(hashesFilePath, "i16") == ncconv_test::readNcVariable(noHashesFilePath, "i16"));
+}
+
+NCCONV_TEST(serverRejectsInvalidJobs) {
+    std::string ctlFilePath = ncconv_test::writeTypedDataSet(testDirectory, "-9999");
+    std::string outputFilePath = testDirectory + "/out.nc";
+
+    // Unknown keys (e.g., misspelled options) are rejected instead of being ignored.
+    ncconv::ConversionServer server;
+    std::string response = server.processJob(
+            "{\"id\": \"1\", \"input\": \"" + ctlFilePath + "\", \"output\": \"" + outputFilePath
+            + "\", \"slab_hash\": false}");
+    NCCONV_CHECK(getHasSubstring(response, "\"status\": \"error\""));
+    NCCONV_CHECK(getHasSubstring(response, "Unknown job key \\\"slab_hash\\\""));
+    NCCONV_CHECK(!boost::filesystem::exists(outputFilePath));
+
+    response = server.processJob("{\"id\": \"2\", \"input\": \"" + ctlFilePath + "\"}");
+    NCCONV_CHECK(getHasSubstring(response, "\"status\": \"error\""));
+    response = server.processJob("not json");
+    NCCONV_CHECK(getHasSubstring(response, "\"status\": \"error\""));
+
+    // Jobs are processed line by line until the shutdown job.
+    std::istringstream input(
+            "{\"id\": \"3\", \"input\": \"" + ctlFilePath + "\", \"output\": \"" + outputFilePath + "\"}\n\n"
+            "{\"command\": \"shutdown\"}\n"
+            "{\"id\": \"4\", \"input\": \"" + ctlFilePath + "\", \"output\": \"" + outputFilePath + "\"}\n");
+    std::ostringstream output;
+    server.run(input, output);
+    NCCONV_CHECK(server.getShouldStop());
+    NCCONV_CHECK(getHasSubstring(output.str(), "\"id\": \"3\", \"status\": \"ok\""));
+    NCCONV_CHECK(!getHasSubstring(output.str(), "\"id\": \"4\""));
+    NCCONV_CHECK_EQUAL(ncconv_test::readNcVariable(outputFilePath, "cnt").size(), size_t(8));
+}
@@ -0,0 +1,105 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the GrADS export (CtlWriter). Converting a GrADS data set to GrADS again needs to reproduce its entries,
+ * data types, time axis and undef value.
+ */
+
+/// Returns the first line of a text starting with the passed key.
+static std::string findLine(const std::string& text, const std::string& key) {
+    size_t pos = text.find("\n" + key + " ");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    return text.substr(pos + 1, text.find('\n', pos + 1) - pos - 1);
+}
+
+NCCONV_TEST(ctlRoundTripKeepsTypedEntries) {
+    ncconv::Dataset input(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    input.setIsVerbose(false);
+    input.writeToCtlFile(testDirectory + "/out.ctl", true);
+    ncconv::Dataset output(testDirectory + "/out.ctl");
+    ncconv_test::checkDataSetsEqual(input, output);
+
+    std::string descriptor = ncconv_test::readFile(testDirectory + "/out.ctl");
+    NCCONV_CHECK_EQUAL(findLine(descriptor, "undef"), "undef -9999");
+    NCCONV_CHECK_EQUAL(findLine(descriptor, "tdef"), "tdef 1 linear 00Z01JAN2000 6hr");
+}
+
+NCCONV_TEST(ctlRoundTripKeepsTimeAxisAndUndef) {
+    // Float-only ensemble data set with a non-default time axis and undef value.
+    ncconv_test::writeTextFile(testDirectory + "/ens.ctl",
+            "dset ^ens.dat\n"
+            "undef -1e+20\n"
+            "xdef 3 linear 10 0.5\n"
+            "ydef 2 levels 40 42\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 3 linear 06:30Z02FEB2001 6hr\n"
+            "edef 2 names 1 2\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int m = 0; m < 2; m++) {
+        for (int t = 0; t < 3; t++) {
+            for (int i = 0; i < 2 * 6 + 6; i++) {
+                ncconv_test::appendValue(data, entryIdx % 7 == 3 ? -1e20f : float(entryIdx) * 0.25f, false);
+                entryIdx++;
+            }
+        }
+    }
+    ncconv_test::writeBinaryFile(testDirectory + "/ens.dat", data);
+
+    ncconv::Dataset input(testDirectory + "/ens.ctl");
+    input.setIsVerbose(false);
+    // -1e20 is not exactly representable as float, but entries equal to it after rounding are missing.
+    ncconv::SlabIterator iterator = input.iterateSlabs("t");
+    NCCONV_CHECK(iterator.next());
+    NCCONV_CHECK(std::isnan(iterator.get().getData<float>()[3]));
+    NCCONV_CHECK_EQUAL(iterator.get().getData<float>()[4], 1.0f);
+    input.writeToCtlFile(testDirectory + "/out.ctl");
+    ncconv::Dataset output(testDirectory + "/out.ctl");
+    ncconv_test::checkDataSetsEqual(input, output);
+
+    std::string descriptor = ncconv_test::readFile(testDirectory + "/out.ctl");
+    NCCONV_CHECK_EQUAL(findLine(descriptor, "undef"), "undef -1e+20");
+    NCCONV_CHECK_EQUAL(findLine(descriptor, "tdef"), "tdef 3 linear 06:30Z02FEB2001 6hr");
+    NCCONV_CHECK_EQUAL(findLine(descriptor, "edef"), "edef 2 names 1 2");
+    // The data file is written in the layout of the input file, so the bytes are equal, too.
+    NCCONV_CHECK(
+            ncconv_test::readFile(testDirectory + "/out.dat") == ncconv_test::readFile(testDirectory + "/ens.dat"));
+}
@@ -0,0 +1,155 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the derived fields (see DerivedFieldLoader and FieldExpression). The derived variables need to be computed
+ * per entry from their input fields, with missing entries of the inputs propagating to the result.
+ */
+
+const size_t DF_XS = 6, DF_YS = 3, DF_TS = 2;
+
+static bool getIsMissingWindEntry(size_t i) {
+    return i % 7 == 3;
+}
+
+/// Writes a data set with the 2D wind components "u" and "v" (6 x 3) and two time steps.
+static std::string writeWindDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/wind.ctl",
+            "dset ^wind.dat\n"
+            "undef -9999\n"
+            "xdef 6 linear 0 1.0\n"
+            "ydef 3 linear 0 1.0\n"
+            "zdef 1 levels 1000\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "u 0 99 eastward wind\n"
+            "v 0 99 northward wind\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (size_t t = 0; t < DF_TS; t++) {
+        for (int varIdx = 0; varIdx < 2; varIdx++) {
+            for (size_t i = 0; i < DF_XS * DF_YS; i++) {
+                // The missing entries of "v" are shifted against the ones of "u".
+                size_t entryIdx = t * DF_XS * DF_YS + i + size_t(varIdx) * 2;
+                float value = float(i) * 0.5f - float(varIdx) * 3.0f + float(t);
+                ncconv_test::appendValue(data, getIsMissingWindEntry(entryIdx) ? -9999.0f : value, false);
+            }
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/wind.dat", data);
+    return directory + "/wind.ctl";
+}
+
+static void checkIsClose(double value, double expectedValue) {
+    if (std::isnan(expectedValue)) {
+        NCCONV_CHECK(std::isnan(value));
+    } else {
+        NCCONV_CHECK(std::abs(value - expectedValue) <= 1e-5 * std::max(std::abs(expectedValue), 1.0));
+    }
+}
+
+NCCONV_TEST(derivedFieldsAreComputedPerEntry) {
+    ncconv::Dataset dataset(writeWindDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    // "wsk" uses the derived field "ws".
+    dataset.setDerivedFields({ "ws=sqrt(u^2+v^2)", "wsk=ws*3.6", "dir=atan2(-u, -v)" });
+    std::string filePath = testDirectory + "/wind.nc";
+    dataset.writeToNcFile(filePath);
+
+    std::vector<double> u = ncconv_test::readNcVariable(filePath, "u");
+    std::vector<double> v = ncconv_test::readNcVariable(filePath, "v");
+    std::vector<double> ws = ncconv_test::readNcVariable(filePath, "ws");
+    std::vector<double> wsk = ncconv_test::readNcVariable(filePath, "wsk");
+    std::vector<double> dir = ncconv_test::readNcVariable(filePath, "dir");
+    NCCONV_CHECK_EQUAL(u.size(), DF_XS * DF_YS * DF_TS);
+    NCCONV_CHECK_EQUAL(ws.size(), u.size());
+    NCCONV_CHECK_EQUAL(wsk.size(), u.size());
+    NCCONV_CHECK_EQUAL(dir.size(), u.size());
+    NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(filePath, "ws"), NC_FLOAT);
+    size_t numMissing = 0;
+    for (size_t i = 0; i < u.size(); i++) {
+        double expectedWs = std::sqrt(u.at(i) * u.at(i) + v.at(i) * v.at(i));
+        numMissing += std::isnan(expectedWs) ? 1 : 0;
+        checkIsClose(ws.at(i), expectedWs);
+        checkIsClose(wsk.at(i), expectedWs * 3.6);
+        checkIsClose(dir.at(i), std::atan2(-u.at(i), -v.at(i)));
+    }
+    // The missing entries of both components propagate to the derived fields.
+    NCCONV_CHECK(numMissing > 6);
+    NCCONV_CHECK(dataset.verifyNcFile(filePath));
+}
+
+NCCONV_TEST(derivedFieldsMapIntegerFillValues) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    dataset.setDerivedFields({ "i16c=i16*0.5+1" });
+    std::string filePath = testDirectory + "/typed.nc";
+    dataset.writeToNcFile(filePath);
+
+    std::vector<double> i16 = ncconv_test::readNcVariable(filePath, "i16");
+    std::vector<double> i16c = ncconv_test::readNcVariable(filePath, "i16c");
+    double fillValue = 0.0;
+    NCCONV_CHECK(ncconv_test::getNcFillValue(filePath, "i16", fillValue));
+    NCCONV_CHECK_EQUAL(i16c.size(), i16.size());
+    NCCONV_CHECK(std::find(i16.begin(), i16.end(), fillValue) != i16.end());
+    for (size_t i = 0; i < i16.size(); i++) {
+        // The fill value of the integer input is mapped to NaN and not scaled like a valid entry.
+        checkIsClose(i16c.at(i), i16.at(i) == fillValue ? std::nan("") : i16.at(i) * 0.5 + 1.0);
+    }
+}
+
+NCCONV_TEST(invalidDerivedFieldsAreRejected) {
+    ncconv::Dataset dataset(writeWindDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setDerivedFields({ "ws=sqrt(u^2+v^2)" });
+    for (const char* definition : { "w=u+q", "w=sqrt(u", "=u+v" }) {
+        bool hasThrown = false;
+        try {
+            dataset.setDerivedFields({ definition });
+        } catch (const std::runtime_error&) {
+            hasThrown = true;
+        }
+        NCCONV_CHECK(hasThrown);
+    }
+
+    // The previous definitions are kept if the new ones are rejected.
+    std::string filePath = testDirectory + "/wind.nc";
+    dataset.writeToNcFile(filePath);
+    NCCONV_CHECK_EQUAL(ncconv_test::readNcVariable(filePath, "ws").size(), DF_XS * DF_YS * DF_TS);
+}
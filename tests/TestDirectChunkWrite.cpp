@@ -0,0 +1,68 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Test of compressing chunks on multiple threads and writing them with HDF5 direct chunk writes (DirectChunkWriter).
+ * The output needs to be readable with the filters declared by the NetCDF library and equal to the output written via
+ * the NetCDF library. Without USE_HDF5_DIRECT_CHUNK_WRITE, both outputs are written via the NetCDF library.
+ */
+
+NCCONV_TEST(directChunkWriteMatchesNetCdfFilters) {
+    // Chunks of (1, 3, 3) entries do not divide the 4 x 2 grid, so the edge chunks are partial.
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    dataset.setChunkShape({ 1, 3, 3 });
+    dataset.setDeflateLevel(6);
+    dataset.setUseShuffleFilter(true);
+    dataset.setUseDirectChunkWrite(false);
+    dataset.writeToNcFile(testDirectory + "/netcdf.nc");
+    dataset.setUseDirectChunkWrite(true);
+    dataset.writeToNcFile(testDirectory + "/direct.nc");
+
+    for (const std::string& fieldName : dataset.getFieldNames()) {
+        ncconv_test::checkNcVariablesEqual(testDirectory + "/netcdf.nc", testDirectory + "/direct.nc", fieldName);
+        int ncid = -1, varid = -1;
+        NCCONV_CHECK(nc_open((testDirectory + "/direct.nc").c_str(), NC_NOWRITE, &ncid) == NC_NOERR);
+        NCCONV_CHECK(nc_inq_varid(ncid, fieldName.c_str(), &varid) == NC_NOERR);
+        int shuffle = 0, deflate = 0, deflateLevel = 0;
+        nc_inq_var_deflate(ncid, varid, &shuffle, &deflate, &deflateLevel);
+        nc_close(ncid);
+        NCCONV_CHECK(shuffle != 0 && deflate != 0);
+        NCCONV_CHECK_EQUAL(deflateLevel, 6);
+    }
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/direct.nc"));
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/direct.nc", true));
+}
@@ -0,0 +1,193 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "Volume/EnsembleStatistics.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the ensemble statistics (see EnsembleAccumulator). The variables <name>_ens_<statistic> need to match the
+ * sample mean, the sample standard deviation and the quantiles of numpy.quantile (linear interpolation between the
+ * closest ranks) of the valid member values at each grid point and time step.
+ */
+
+const size_t ES_XS = 3, ES_YS = 2, ES_ZS = 2, ES_TS = 2, ES_ES = 5;
+
+/// Writes an ensemble data set with five members, two time steps and the variables "t" (3 x 2 x 2) and "ps".
+static std::string writeEnsembleDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/ens.ctl",
+            "dset ^ens.dat\n"
+            "undef -9999\n"
+            "xdef 3 linear 0 1.0\n"
+            "ydef 2 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "edef 5 names 1 2 3 4 5\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    const size_t numEntriesPerRecord = ES_XS * ES_YS * (ES_ZS + 1);
+    for (size_t record = 0; record < ES_ES * ES_TS; record++) {
+        size_t m = record / ES_TS;
+        for (size_t i = 0; i < numEntriesPerRecord; i++) {
+            // Entry 0 is missing in all members, entry 1 is valid in one member only, and others in some members.
+            bool isMissing = i == 0 || (i == 1 && m != 2) || (i * 5 + record * 3) % 11 == 7;
+            float value = std::cos(float(i) * 1.3f + float(m * m)) * 4.0f + float(record % ES_TS) * 2.0f;
+            ncconv_test::appendValue(data, isMissing ? -9999.0f : value, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/ens.dat", data);
+    return directory + "/ens.ctl";
+}
+
+static void checkIsClose(double value, double expectedValue, double tolerance) {
+    if (std::isnan(expectedValue)) {
+        NCCONV_CHECK(std::isnan(value));
+    } else {
+        NCCONV_CHECK(std::abs(value - expectedValue) <= tolerance * std::max(std::abs(expectedValue), 1.0));
+    }
+}
+
+/// Checks the ensemble statistics of a variable against the statistics of the members written to membersFilePath.
+static void checkEnsembleStatistics(
+        const std::string& membersFilePath, const std::string& statisticsFilePath, const std::string& varName,
+        size_t numLevels) {
+    const size_t numRecordEntries = ES_TS * numLevels * ES_YS * ES_XS;
+    std::vector<double> members = ncconv_test::readNcVariable(membersFilePath, varName);
+    NCCONV_CHECK_EQUAL(members.size(), ES_ES * numRecordEntries);
+    std::vector<double> means = ncconv_test::readNcVariable(statisticsFilePath, varName + "_ens_mean");
+    std::vector<double> deviations = ncconv_test::readNcVariable(statisticsFilePath, varName + "_ens_std");
+    const std::vector<std::pair<std::string, double>> quantiles = { { "p10", 0.1 }, { "median", 0.5 }, { "p90", 0.9 } };
+    std::vector<std::vector<double>> quantileValues;
+    for (const auto& quantile : quantiles) {
+        quantileValues.push_back(ncconv_test::readNcVariable(statisticsFilePath, varName + "_ens_" + quantile.first));
+        NCCONV_CHECK_EQUAL(quantileValues.back().size(), numRecordEntries);
+    }
+    NCCONV_CHECK_EQUAL(means.size(), numRecordEntries);
+    NCCONV_CHECK_EQUAL(deviations.size(), numRecordEntries);
+
+    for (size_t i = 0; i < numRecordEntries; i++) {
+        std::vector<double> values;
+        for (size_t m = 0; m < ES_ES; m++) {
+            double value = members.at(m * numRecordEntries + i);
+            if (!std::isnan(value)) {
+                values.push_back(value);
+            }
+        }
+        std::sort(values.begin(), values.end());
+        double n = double(values.size());
+        double mean = std::nan(""), deviation = std::nan("");
+        if (!values.empty()) {
+            mean = 0.0;
+            for (double value : values) {
+                mean += value / n;
+            }
+        }
+        if (values.size() > 1) {
+            double sumOfSquares = 0.0;
+            for (double value : values) {
+                sumOfSquares += (value - mean) * (value - mean);
+            }
+            deviation = std::sqrt(sumOfSquares / (n - 1.0));
+        }
+        checkIsClose(means.at(i), mean, 1e-5);
+        checkIsClose(deviations.at(i), deviation, 1e-4);
+        for (size_t q = 0; q < quantiles.size(); q++) {
+            double expectedValue = std::nan("");
+            if (!values.empty()) {
+                double position = quantiles.at(q).second * (n - 1.0);
+                auto lower = size_t(position);
+                size_t upper = std::min(lower + 1, values.size() - 1);
+                expectedValue = values.at(lower) + (position - double(lower)) * (values.at(upper) - values.at(lower));
+            }
+            checkIsClose(quantileValues.at(q).at(i), expectedValue, 1e-5);
+        }
+    }
+}
+
+static bool getNcHasVariable(const std::string& filePath, const std::string& varName) {
+    int ncid = -1, varid = -1;
+    NCCONV_CHECK_EQUAL(nc_open(filePath.c_str(), NC_NOWRITE, &ncid), NC_NOERR);
+    bool hasVariable = nc_inq_varid(ncid, varName.c_str(), &varid) == NC_NOERR;
+    nc_close(ncid);
+    return hasVariable;
+}
+
+NCCONV_TEST(ensembleStatisticsMatchMembers) {
+    ncconv::Dataset dataset(writeEnsembleDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setEnsembleStatistics(parseEnsembleStatistics("mean,std,p10,median,p90"));
+    std::string filePath = testDirectory + "/ens.nc";
+    dataset.writeToNcFile(filePath);
+    checkEnsembleStatistics(filePath, filePath, "t", ES_ZS);
+    checkEnsembleStatistics(filePath, filePath, "ps", 1);
+
+    // The statistics do not depend on the slabs the members are read in.
+    dataset.setMaxMemory(256);
+    dataset.writeToNcFile(testDirectory + "/ens_slabs.nc");
+    for (const char* varName : { "t_ens_mean", "t_ens_std", "t_ens_p90", "ps_ens_median" }) {
+        ncconv_test::checkNcVariablesEqual(filePath, testDirectory + "/ens_slabs.nc", varName);
+    }
+}
+
+NCCONV_TEST(ensembleStatisticsWithoutMembers) {
+    ncconv::Dataset dataset(writeEnsembleDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setEnsembleStatistics(parseEnsembleStatistics("mean,std,p10,median,p90"));
+    std::string membersFilePath = testDirectory + "/ens.nc";
+    dataset.writeToNcFile(membersFilePath);
+    dataset.setWriteEnsembleMembers(false);
+    std::string filePath = testDirectory + "/ens_stats.nc";
+    dataset.writeToNcFile(filePath);
+
+    NCCONV_CHECK(!getNcHasVariable(filePath, "t"));
+    NCCONV_CHECK(!getNcHasVariable(filePath, "ps"));
+    checkEnsembleStatistics(membersFilePath, filePath, "t", ES_ZS);
+    checkEnsembleStatistics(membersFilePath, filePath, "ps", 1);
+
+    // Dropping the members needs ensemble statistics.
+    dataset.setEnsembleStatistics({});
+    bool hasThrown = false;
+    try {
+        dataset.writeToNcFile(testDirectory + "/empty.nc");
+    } catch (const std::runtime_error& exception) {
+        hasThrown = std::string(exception.what()).find("ensemble statistics") != std::string::npos;
+    }
+    NCCONV_CHECK(hasThrown);
+}
@@ -0,0 +1,124 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the float16 and bfloat16 output types (encodeHalfFloats). The entries need to be rounded to nearest even,
+ * and the range statistics need to count overflows, underflows and subnormal results.
+ */
+
+/// Encodes float32 values to a 16-bit float type and returns the bit patterns.
+static std::vector<uint16_t> encode(
+        const std::vector<float>& values, OutputFloatType outputFloatType, HalfFloatStats& stats) {
+    std::vector<uint16_t> encoded(values.size());
+    encodeHalfFloats(values.data(), FieldDataType::FLOAT32, encoded.data(), values.size(), outputFloatType, stats);
+    return encoded;
+}
+
+NCCONV_TEST(halfFloatEncodingRoundsToNearestEven) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    HalfFloatStats stats;
+    // 1 + 2^-11 lies halfway between 1 and the next float16 value and is rounded to the even mantissa, while
+    // 1 + 3 * 2^-11 is rounded up to the even mantissa 1 + 2^-9.
+    std::vector<uint16_t> encoded = encode(
+            { 1.0f, -2.0f, 1.0f + std::ldexp(1.0f, -11), 1.0f + 3.0f * std::ldexp(1.0f, -11), 65504.0f, 70000.0f,
+              1e-8f, 1e-6f, nan }, OutputFloatType::FLOAT16, stats);
+    const std::vector<uint16_t> expectedFloat16 = {
+            0x3C00, 0xC000, 0x3C00, 0x3C02, 0x7BFF, 0x7C00, 0x0000, 0x0011, 0x7E00 };
+    NCCONV_CHECK(encoded == expectedFloat16);
+    NCCONV_CHECK_EQUAL(stats.numEntries, size_t(9));
+    NCCONV_CHECK_EQUAL(stats.numMissing, size_t(1));
+    NCCONV_CHECK_EQUAL(stats.numOverflows, size_t(1));
+    NCCONV_CHECK_EQUAL(stats.numUnderflows, size_t(1));
+    NCCONV_CHECK_EQUAL(stats.numSubnormals, size_t(1));
+    NCCONV_CHECK_EQUAL(stats.minValue, -2.0);
+    NCCONV_CHECK_EQUAL(stats.maxValue, 70000.0);
+
+    // bfloat16 keeps the exponent range of float32 and has 7 mantissa bits.
+    stats = {};
+    encoded = encode(
+            { 1.0f, -2.0f, 1.0f + std::ldexp(1.0f, -8), 1.0f + 3.0f * std::ldexp(1.0f, -8), 70000.0f, nan },
+            OutputFloatType::BFLOAT16, stats);
+    const std::vector<uint16_t> expectedBfloat16 = { 0x3F80, 0xC000, 0x3F80, 0x3F82, 0x4789, 0x7FC0 };
+    NCCONV_CHECK(encoded == expectedBfloat16);
+    NCCONV_CHECK_EQUAL(stats.numOverflows, size_t(0));
+
+    // float64 entries are rounded to float32 first.
+    const double doubles[] = { 1.0, 0.1 };
+    uint16_t encodedDoubles[2] = {};
+    encodeHalfFloats(doubles, FieldDataType::FLOAT64, encodedDoubles, 2, OutputFloatType::FLOAT16, stats);
+    NCCONV_CHECK_EQUAL(encodedDoubles[0], uint16_t(0x3C00));
+    NCCONV_CHECK_EQUAL(encodedDoubles[1], uint16_t(0x2E66));
+}
+
+NCCONV_TEST(halfFloatOutputKeepsIntegerFields) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/native.nc");
+    for (OutputFloatType outputFloatType : { OutputFloatType::FLOAT16, OutputFloatType::BFLOAT16 }) {
+        std::string typeName = getOutputFloatTypeName(outputFloatType);
+        std::string filePath = testDirectory + "/" + typeName + ".nc";
+        dataset.setOutputFloatType(outputFloatType);
+        dataset.writeToNcFile(filePath);
+
+        // Floating point fields are stored as the bit patterns of the 16-bit type with the canonical NaN as fill value.
+        for (const char* fieldName : { "f32", "f64" }) {
+            NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(filePath, fieldName), NC_USHORT);
+            double fillValue = 0.0;
+            NCCONV_CHECK(ncconv_test::getNcFillValue(filePath, fieldName, fillValue));
+            NCCONV_CHECK_EQUAL(fillValue, double(getOutputFloatTypeNaN(outputFloatType)));
+            NCCONV_CHECK(ncconv_test::getNcHasAttribute(filePath, fieldName, "ncconv_dtype"));
+        }
+        std::vector<double> nativeValues = ncconv_test::readNcVariable(testDirectory + "/native.nc", "f32");
+        std::vector<double> halfValues = ncconv_test::readNcVariable(filePath, "f32");
+        NCCONV_CHECK_EQUAL(halfValues.size(), nativeValues.size());
+        for (size_t i = 0; i < nativeValues.size(); i++) {
+            float nativeValue = float(nativeValues.at(i));
+            uint16_t expectedValue = 0;
+            HalfFloatStats stats;
+            encodeHalfFloats(&nativeValue, FieldDataType::FLOAT32, &expectedValue, 1, outputFloatType, stats);
+            NCCONV_CHECK_EQUAL(halfValues.at(i), double(expectedValue));
+        }
+
+        // Integer fields keep their data type and entries.
+        for (const char* fieldName : { "i8", "cnt", "i16", "u16", "i32" }) {
+            ncconv_test::checkNcVariablesEqual(testDirectory + "/native.nc", filePath, fieldName);
+        }
+        NCCONV_CHECK(dataset.verifyNcFile(filePath));
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Test of fields with more than 2^31 entries, whose byte offsets do not fit into 32-bit integers. The data file is
+ * created sparse (only the sentinel bytes are allocated), so the test needs neither 2 GiB of memory nor of disk space.
+ */
+
+NCCONV_TEST(largeFieldKeepsEntriesBeyond2GiB) {
+    const uint64_t xs = 65536, ys = 32769;
+    const uint64_t numEntries = xs * ys;
+    NCCONV_CHECK_EQUAL(numEntries, uint64_t(2147549184));
+    ncconv_test::writeTextFile(testDirectory + "/large.ctl",
+            "dset ^large.dat\n"
+            "undef -9999\n"
+            "xdef 65536 linear 0 0.0054931640625\n"
+            "ydef 32769 linear -90 0.0054931640625\n"
+            "zdef 1 linear 0 1\n"
+            "tdef 1 linear 00Z01JAN2000 1hr\n"
+            "vars 1\n"
+            "mask 0 -1,40,1 uint8\n"
+            "endvars\n");
+    std::string dataFilePath = testDirectory + "/large.dat";
+    ncconv_test::writeBinaryFile(dataFilePath, {});
+    boost::filesystem::resize_file(dataFilePath, numEntries);
+    const uint64_t sentinelOffsets[] = {
+            (uint64_t(1) << 31) - 1, uint64_t(1) << 31, (uint64_t(1) << 31) + 5, numEntries - 1 };
+    const uint8_t sentinelValues[] = { 11, 22, 33, 44 };
+    {
+        std::fstream file(dataFilePath, std::ios::in | std::ios::out | std::ios::binary);
+        for (int i = 0; i < 4; i++) {
+            file.seekp(std::streamoff(sentinelOffsets[i]));
+            file.put(char(sentinelValues[i]));
+        }
+        NCCONV_CHECK(file.good());
+    }
+
+    ncconv::Dataset dataset(testDirectory + "/large.ctl");
+    dataset.setIsVerbose(false);
+    NCCONV_CHECK_EQUAL(dataset.getVolumeData()->getGridSizeX(), size_t(xs));
+    NCCONV_CHECK_EQUAL(dataset.getVolumeData()->getGridSizeY(), size_t(ys));
+
+    // The last two rows contain all sentinels (2^31 - 1 is the last entry of row 32767).
+    FieldSlab slab;
+    slab.yOffset = size_t(ys) - 2;
+    slab.yCount = 2;
+    std::vector<uint8_t> slabData(2 * xs, 0xFF);
+    NCCONV_CHECK(dataset.getLoader()->getFieldSlabNative(dataset.getVolumeData(), "mask", 0, 0, slab, slabData.data()));
+    uint64_t slabOffset = uint64_t(slab.yOffset) * xs;
+    for (int i = 0; i < 4; i++) {
+        NCCONV_CHECK_EQUAL(slabData.at(sentinelOffsets[i] - slabOffset), sentinelValues[i]);
+    }
+    NCCONV_CHECK_EQUAL(slabData.at(0), uint8_t(0));
+    NCCONV_CHECK_EQUAL(slabData.at(sentinelOffsets[1] + 1 - slabOffset), uint8_t(0));
+
+    // The reference index points at the whole field with a 64-bit size.
+    dataset.writeToReferenceIndex(testDirectory + "/large.json");
+    std::string indexText = ncconv_test::readFile(testDirectory + "/large.json");
+    NCCONV_CHECK(indexText.find("large.dat\", 0, 2147549184]") != std::string::npos);
+    NCCONV_CHECK(indexText.find("\\\"shape\\\": [32769, 65536]") != std::string::npos);
+}
@@ -0,0 +1,132 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the library API (src/Api/Dataset.hpp). The slab iterator needs to deliver the decoded entries of all
+ * members, time steps and slabs, and writing to a caller-owned NetCDF handle or to memory needs to produce the same
+ * variables as writing to a file.
+ */
+
+/// Number of entries of the variable "t" in each (member, time step) record of @see writeApiDataSet.
+const int API_RECORD_NUM_ENTRIES = 4 * 3 * 2;
+
+/// Writes an ensemble data set with two members, two time steps and the variables "t" (4 x 3 x 2) and "ps".
+static std::string writeApiDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/api.ctl",
+            "dset ^api.dat\n"
+            "undef -9999\n"
+            "xdef 4 linear 0 1.0\n"
+            "ydef 3 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "edef 2 names 1 2\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int record = 0; record < 2 * 2; record++) {
+        for (int i = 0; i < API_RECORD_NUM_ENTRIES; i++) {
+            ncconv_test::appendValue(data, float(record * 1000 + i), false);
+        }
+        for (int i = 0; i < 4 * 3; i++) {
+            ncconv_test::appendValue(data, i == 5 ? -9999.0f : float(-record * 1000 - i), false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/api.dat", data);
+    return directory + "/api.ctl";
+}
+
+NCCONV_TEST(slabIteratorVisitsMembersAndTimeSteps) {
+    ncconv::Dataset dataset(writeApiDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    // Two rows of a z-level fit into the budget, so each z-level is split into two slabs.
+    dataset.setMaxMemory(2 * 4 * sizeof(float));
+
+    size_t numSlabs = 0;
+    std::vector<int> visitedEntries(2 * 2 * API_RECORD_NUM_ENTRIES, 0);
+    ncconv::SlabIterator iterator = dataset.iterateSlabs("t");
+    while (iterator.next()) {
+        const ncconv::SlabView& view = iterator.get();
+        NCCONV_CHECK_EQUAL(view.xs, size_t(4));
+        NCCONV_CHECK(view.dataType == FieldDataType::FLOAT32);
+        // The slabs of one time step are visited before the next time step, and members are the outermost loop.
+        NCCONV_CHECK_EQUAL(view.memberIdx, numSlabs / (2 * 4));
+        NCCONV_CHECK_EQUAL(view.timestepIdx, (numSlabs / 4) % 2);
+        size_t record = view.memberIdx * 2 + view.timestepIdx;
+        size_t entryOffset = (view.slab.zOffset * 3 + view.slab.yOffset) * 4;
+        const auto* values = view.getData<float>();
+        for (size_t i = 0; i < view.getNumEntries(); i++) {
+            NCCONV_CHECK_EQUAL(values[i], float(record * 1000 + entryOffset + i));
+            visitedEntries.at(record * API_RECORD_NUM_ENTRIES + entryOffset + i)++;
+        }
+        numSlabs++;
+    }
+    NCCONV_CHECK_EQUAL(numSlabs, size_t(2 * 2 * 2 * 2));
+    NCCONV_CHECK(visitedEntries == std::vector<int>(visitedEntries.size(), 1));
+}
+
+NCCONV_TEST(ncHandleAndMemoryMatchNcFile) {
+    ncconv::Dataset dataset(writeApiDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/file.nc");
+
+    // The caller creates and closes the file, and may add its own attributes.
+    int ncid = -1;
+    NCCONV_CHECK(nc_create((testDirectory + "/handle.nc").c_str(), NC_NETCDF4 | NC_CLOBBER, &ncid) == NC_NOERR);
+    const std::string title = "written by the caller";
+    nc_put_att_text(ncid, NC_GLOBAL, "title", title.size(), title.c_str());
+    dataset.writeToNcHandle(ncid);
+    NCCONV_CHECK(nc_close(ncid) == NC_NOERR);
+
+    ncconv::NcMemoryBuffer buffer = dataset.writeToNcMemory();
+    NCCONV_CHECK(buffer.getData() != nullptr && buffer.getSize() > 0);
+    ncconv_test::writeBinaryFile(
+            testDirectory + "/memory.nc",
+            std::vector<uint8_t>(buffer.getData(), buffer.getData() + buffer.getSize()));
+
+    for (const char* filePath : { "/handle.nc", "/memory.nc" }) {
+        for (const char* varName : { "t", "ps", "lon", "lat", "z" }) {
+            ncconv_test::checkNcVariablesEqual(testDirectory + "/file.nc", testDirectory + filePath, varName);
+        }
+        NCCONV_CHECK(dataset.verifyNcFile(testDirectory + filePath));
+    }
+    NCCONV_CHECK(nc_open((testDirectory + "/handle.nc").c_str(), NC_NOWRITE, &ncid) == NC_NOERR);
+    size_t titleLength = 0;
+    NCCONV_CHECK(nc_inq_attlen(ncid, NC_GLOBAL, "title", &titleLength) == NC_NOERR);
+    NCCONV_CHECK_EQUAL(titleLength, title.size());
+    nc_close(ncid);
+}
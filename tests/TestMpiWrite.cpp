@@ -0,0 +1,99 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Test of writing collectively with multiple MPI ranks. The (time step, slab) items of each variable are distributed
+ * round-robin over the ranks, so with four ranks some ranks have no item in the last round and need to issue an empty
+ * collective write. The test is only built with USE_MPI and run with mpiexec (see tests/CMakeLists.txt).
+ */
+
+#ifdef USE_MPI
+
+NCCONV_TEST(mpiRanksWriteRoundRobin) {
+    int mpiRank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    const int xs = 6, ys = 5, zs = 2, ts = 3;
+    std::vector<float> expectedT, expectedPs;
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int t = 0; t < ts; t++) {
+        for (int i = 0; i < xs * ys * (zs + 1); i++, entryIdx++) {
+            float value = entryIdx % 7 == 3 ? -9999.0f : float(entryIdx) * 0.5f;
+            ncconv_test::appendValue(data, value, false);
+            (i < xs * ys * zs ? expectedT : expectedPs).push_back(value == -9999.0f ? NAN : value);
+        }
+    }
+    if (mpiRank == 0) {
+        ncconv_test::writeTextFile(testDirectory + "/mpi.ctl",
+                "dset ^mpi.dat\n"
+                "undef -9999\n"
+                "xdef 6 linear 0 1.0\n"
+                "ydef 5 linear 0 1.0\n"
+                "zdef 2 levels 1000 500\n"
+                "tdef 3 linear 00Z01JAN2000 6hr\n"
+                "vars 2\n"
+                "t 2 99 temperature\n"
+                "ps 0 99 surface pressure\n"
+                "endvars\n");
+        ncconv_test::writeBinaryFile(testDirectory + "/mpi.dat", data);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // Slabs of two rows yield 18 items of "t" and 9 items of "ps".
+    ncconv::Dataset dataset(testDirectory + "/mpi.ctl");
+    dataset.setIsVerbose(false);
+    dataset.setMaxMemory(2 * xs * sizeof(float));
+    dataset.writeToNcFile(testDirectory + "/mpi.nc");
+    bool isValid = dataset.verifyNcFile(testDirectory + "/mpi.nc");
+    NCCONV_CHECK(isValid);
+    if (mpiRank != 0) {
+        return;
+    }
+    for (const auto& field : { std::make_pair("t", &expectedT), std::make_pair("ps", &expectedPs) }) {
+        std::vector<double> values = ncconv_test::readNcVariable(testDirectory + "/mpi.nc", field.first);
+        NCCONV_CHECK_EQUAL(values.size(), field.second->size());
+        for (size_t i = 0; i < values.size(); i++) {
+            float expectedValue = field.second->at(i);
+            NCCONV_CHECK(std::isnan(expectedValue) ? std::isnan(values.at(i)) : values.at(i) == expectedValue);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of reading NetCDF files (NetCdfLoader), e.g., for rechunking and recompressing files written by ncconv. Reading
+ * a written file needs to reproduce the grid, data types and entries of the original data set.
+ */
+
+/// Writes an ensemble data set with two members, three time steps and a 3D and a 2D variable.
+static std::string writeEnsembleDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/ens.ctl",
+            "dset ^ens.dat\n"
+            "undef -9999\n"
+            "xdef 6 linear 10 0.5\n"
+            "ydef 4 linear 40 0.5\n"
+            "zdef 3 levels 1000 850 500\n"
+            "tdef 3 linear 00Z01JAN2000 6hr\n"
+            "edef 2 names 1 2\n"
+            "vars 2\n"
+            "t 3 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int record = 0; record < 2 * 3; record++) {
+        for (int i = 0; i < 6 * 4 * 4; i++, entryIdx++) {
+            ncconv_test::appendValue(data, entryIdx % 19 == 2 ? -9999.0f : float(entryIdx) * 0.5f, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/ens.dat", data);
+    return directory + "/ens.ctl";
+}
+
+NCCONV_TEST(netCdfLoaderReadsTypedVariables) {
+    ncconv::Dataset input(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    input.setIsVerbose(false);
+    input.writeToNcFile(testDirectory + "/typed.nc");
+    NCCONV_CHECK(ncconv::Dataset::getIsFileSupported(testDirectory + "/typed.nc"));
+    ncconv::Dataset output(testDirectory + "/typed.nc");
+    output.setIsVerbose(false);
+    ncconv_test::checkDataSetsEqual(input, output);
+}
+
+NCCONV_TEST(netCdfLoaderRechunksAndRecompresses) {
+    ncconv::Dataset input(writeEnsembleDataSet(testDirectory));
+    input.setIsVerbose(false);
+    input.writeToNcFile(testDirectory + "/ens.nc");
+
+    // The members and time steps are read from the NetCDF file, also slab by slab with a small memory budget.
+    ncconv::Dataset ncInput(testDirectory + "/ens.nc");
+    ncInput.setIsVerbose(false);
+    ncconv_test::checkDataSetsEqual(input, ncInput);
+    ncInput.setMaxMemory(2 * 6 * sizeof(float));
+    ncconv_test::checkDataSetsEqual(input, ncInput);
+
+    ncInput.setChunkShape({ 1, 2, 3 });
+    ncInput.setDeflateLevel(5);
+    ncInput.setUseShuffleFilter(true);
+    ncInput.writeToNcFile(testDirectory + "/rechunked.nc");
+    for (const char* varName : { "t", "ps" }) {
+        ncconv_test::checkNcVariablesEqual(testDirectory + "/ens.nc", testDirectory + "/rechunked.nc", varName);
+    }
+    NCCONV_CHECK(input.verifyNcFile(testDirectory + "/rechunked.nc"));
+
+    int ncid = -1, varid = -1;
+    NCCONV_CHECK(nc_open((testDirectory + "/rechunked.nc").c_str(), NC_NOWRITE, &ncid) == NC_NOERR);
+    NCCONV_CHECK(nc_inq_varid(ncid, "t", &varid) == NC_NOERR);
+    int storage = 0, shuffle = 0, deflate = 0, deflateLevel = 0;
+    size_t chunkSizes[5] = {};
+    nc_inq_var_chunking(ncid, varid, &storage, chunkSizes);
+    nc_inq_var_deflate(ncid, varid, &shuffle, &deflate, &deflateLevel);
+    nc_close(ncid);
+    NCCONV_CHECK_EQUAL(storage, NC_CHUNKED);
+    // The variable has the dimensions (member, time, lev, lat, lon).
+    NCCONV_CHECK_EQUAL(chunkSizes[2], size_t(1));
+    NCCONV_CHECK_EQUAL(chunkSizes[3], size_t(2));
+    NCCONV_CHECK_EQUAL(chunkSizes[4], size_t(3));
+    NCCONV_CHECK(shuffle != 0 && deflate != 0);
+    NCCONV_CHECK_EQUAL(deflateLevel, 5);
+}
@@ -0,0 +1,86 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdio>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the kerchunk reference index writer (ReferenceIndexWriter). The index is checked as text, as it contains
+ * one key per line.
+ */
+
+/// Returns the line of the reference with the passed key (without the key itself), or an empty string.
+static std::string getReferenceValue(const std::string& indexText, const std::string& key) {
+    std::string keyString = "\n\"" + key + "\": ";
+    size_t startPos = indexText.find(keyString);
+    if (startPos == std::string::npos) {
+        return "";
+    }
+    startPos += keyString.size();
+    return indexText.substr(startPos, indexText.find('\n', startPos) - startPos);
+}
+
+NCCONV_TEST(referenceIndexOmitsUnrepresentableFillValue) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    std::string indexFilePath = testDirectory + "/typed.json";
+    dataset.writeToReferenceIndex(indexFilePath);
+    std::string indexText = ncconv_test::readFile(indexFilePath);
+
+    // The undef value -9999 cannot be stored in uint8, so "cnt" has no fill value (and 241 stays a valid entry).
+    std::string cntMetadata = getReferenceValue(indexText, "cnt/.zarray");
+    NCCONV_CHECK(cntMetadata.find("\\\"dtype\\\": \\\"|u1\\\", \\\"fill_value\\\": null") != std::string::npos);
+    std::string i8Metadata = getReferenceValue(indexText, "i8/.zarray");
+    NCCONV_CHECK(i8Metadata.find("\\\"dtype\\\": \\\"|i1\\\", \\\"fill_value\\\": null") != std::string::npos);
+    std::string i16Metadata = getReferenceValue(indexText, "i16/.zarray");
+    NCCONV_CHECK(i16Metadata.find("\\\"dtype\\\": \\\">i2\\\", \\\"fill_value\\\": -9999") != std::string::npos);
+    std::string f32Metadata = getReferenceValue(indexText, "f32/.zarray");
+    NCCONV_CHECK(f32Metadata.find("\\\"dtype\\\": \\\">f4\\\", \\\"fill_value\\\": -9999") != std::string::npos);
+
+    // The chunk references need to point at the unmodified entries in the data file.
+    std::string dataFileContent = ncconv_test::readFile(testDirectory + "/typed.dat");
+    const char* fieldNames[] = { "i8", "cnt", "i16", "u16", "i32", "f32", "f64" };
+    const size_t entrySizes[] = { 1, 1, 2, 2, 4, 4, 8 };
+    size_t expectedOffset = 0;
+    for (size_t fieldIdx = 0; fieldIdx < 7; fieldIdx++) {
+        std::string chunkReference = getReferenceValue(indexText, std::string(fieldNames[fieldIdx]) + "/0.0");
+        size_t pathEnd = chunkReference.rfind("\", ");
+        NCCONV_CHECK(pathEnd != std::string::npos);
+        NCCONV_CHECK_EQUAL(chunkReference.substr(2, pathEnd - 2), testDirectory + "/typed.dat");
+        unsigned long long offset = 0, size = 0;
+        NCCONV_CHECK(sscanf(chunkReference.c_str() + pathEnd, "\", %llu, %llu]", &offset, &size) == 2);
+        size_t expectedSize = entrySizes[fieldIdx] * size_t(ncconv_test::TYPED_DATA_SET_NUM_ENTRIES);
+        NCCONV_CHECK_EQUAL(offset, expectedOffset);
+        NCCONV_CHECK_EQUAL(size, expectedSize);
+        NCCONV_CHECK(offset + size <= dataFileContent.size());
+        expectedOffset += expectedSize;
+    }
+    NCCONV_CHECK_EQUAL(uint8_t(dataFileContent.at(8)), uint8_t(241));
+}
@@ -0,0 +1,145 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Api/Dataset.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of skipping chunks without valid entries. These chunks are never allocated in the output file, so reading them
+ * yields the fill value of the variable.
+ */
+
+/// Returns whether the entry (y, x) of the sparse variables is valid at time step t (a 3 x 3 block in one chunk).
+static bool getIsSparseEntryValid(int t, int y, int x) {
+    return t == 0 && y >= 20 && y < 23 && x >= 20 && x < 23;
+}
+
+/**
+ * Writes a data set with two time steps on a 64 x 64 grid with the variables "sparse" (float) and "i16" (int16), which
+ * are missing apart from one 3 x 3 block in the first time step, and the variable "dense" without missing entries.
+ */
+static std::string writeSparseDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/sparse.ctl",
+            "dset ^sparse.dat\n"
+            "undef -9999\n"
+            "xdef 64 linear 0 1.0\n"
+            "ydef 64 linear 0 1.0\n"
+            "zdef 1 levels 1000\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "vars 3\n"
+            "sparse 0 99 sparse\n"
+            "i16 0 -1,40,2,-1 int16\n"
+            "dense 0 99 dense\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 64 * 64; i++) {
+            ncconv_test::appendValue(data, getIsSparseEntryValid(t, i / 64, i % 64) ? float(i) : -9999.0f, false);
+        }
+        for (int i = 0; i < 64 * 64; i++) {
+            ncconv_test::appendValue(data, int16_t(getIsSparseEntryValid(t, i / 64, i % 64) ? i : -9999), false);
+        }
+        for (int i = 0; i < 64 * 64; i++) {
+            ncconv_test::appendValue(data, float(t * 10000 + i), false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/sparse.dat", data);
+    return directory + "/sparse.ctl";
+}
+
+/// Writes the data set with the progress output redirected and returns the output.
+static std::string writeCapturingOutput(ncconv::Dataset& dataset, const std::string& filePath) {
+    std::ostringstream output;
+    std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+    try {
+        dataset.writeToNcFile(filePath);
+    } catch (...) {
+        std::cout.rdbuf(coutBuffer);
+        throw;
+    }
+    std::cout.rdbuf(coutBuffer);
+    return output.str();
+}
+
+NCCONV_TEST(missingEntriesAreDetected) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float floats[] = { nan, nan, 1.0f };
+    NCCONV_CHECK(getAreEntriesMissing(floats, FieldDataType::FLOAT32, 2, false, 0.0));
+    NCCONV_CHECK(!getAreEntriesMissing(floats, FieldDataType::FLOAT32, 3, false, 0.0));
+    const int16_t shorts[] = { -9999, -9999 };
+    NCCONV_CHECK(getAreEntriesMissing(shorts, FieldDataType::INT16, 2, true, -9999.0));
+    // Integer entries are never missing without a fill value.
+    NCCONV_CHECK(!getAreEntriesMissing(shorts, FieldDataType::INT16, 2, false, 0.0));
+}
+
+NCCONV_TEST(missingChunksAreSkipped) {
+    ncconv::Dataset dataset(writeSparseDataSet(testDirectory));
+    dataset.setChunkShape({ 1, 16, 16 });
+    std::string filePath = testDirectory + "/sparse.nc";
+    std::string output = writeCapturingOutput(dataset, filePath);
+    // Of the 16 chunks per time step, only one chunk of the first time step has valid entries.
+    NCCONV_CHECK(output.find("Skipped 31 chunk(s) of variable 'sparse'") != std::string::npos);
+    NCCONV_CHECK(output.find("Skipped 31 chunk(s) of variable 'i16'") != std::string::npos);
+    NCCONV_CHECK(output.find("chunk(s) of variable 'dense'") == std::string::npos);
+    // The variables have 80 KiB of entries in total, but only one chunk of each sparse variable is stored.
+    NCCONV_CHECK(boost::filesystem::file_size(filePath) < 80 * 1024);
+
+    std::vector<double> sparseValues = ncconv_test::readNcVariable(filePath, "sparse");
+    std::vector<double> i16Values = ncconv_test::readNcVariable(filePath, "i16");
+    NCCONV_CHECK_EQUAL(sparseValues.size(), size_t(2 * 64 * 64));
+    for (int i = 0; i < 2 * 64 * 64; i++) {
+        int t = i / (64 * 64), y = (i / 64) % 64, x = i % 64;
+        if (getIsSparseEntryValid(t, y, x)) {
+            NCCONV_CHECK_EQUAL(sparseValues.at(i), double(y * 64 + x));
+            NCCONV_CHECK_EQUAL(i16Values.at(i), double(y * 64 + x));
+        } else {
+            NCCONV_CHECK(std::isnan(sparseValues.at(i)));
+            NCCONV_CHECK_EQUAL(i16Values.at(i), -9999.0);
+        }
+    }
+    dataset.setIsVerbose(false);
+    NCCONV_CHECK(dataset.verifyNcFile(filePath, true));
+
+    // Compressed chunks are skipped, too (also by the direct chunk writer, if available).
+    dataset.setIsVerbose(true);
+    dataset.setDeflateLevel(4);
+    output = writeCapturingOutput(dataset, testDirectory + "/sparse_deflate.nc");
+    NCCONV_CHECK(output.find("Skipped 31 chunk(s) of variable 'sparse'") != std::string::npos);
+    for (const char* varName : { "sparse", "i16", "dense" }) {
+        ncconv_test::checkNcVariablesEqual(filePath, testDirectory + "/sparse_deflate.nc", varName);
+    }
+}
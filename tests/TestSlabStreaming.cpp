@@ -0,0 +1,127 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of streaming fields in slabs fitting into the memory budget (VolumeData::setMaxMemory). The output needs to
+ * be identical for every budget, and no slab may be larger than the budget unless a single row does not fit.
+ */
+
+/// Writes a data set with a 3D variable "t" (6 x 5 x 3) and a 2D variable "ps" with two time steps.
+static std::string writeSlabDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/slabs.ctl",
+            "dset ^slabs.dat\n"
+            "undef -9999\n"
+            "xdef 6 linear 0 1.0\n"
+            "ydef 5 linear 0 1.0\n"
+            "zdef 3 levels 1000 850 500\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "t 3 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 6 * 5 * 4; i++, entryIdx++) {
+            ncconv_test::appendValue(data, entryIdx % 13 == 7 ? -9999.0f : float(entryIdx) * 0.25f, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/slabs.dat", data);
+    return directory + "/slabs.ctl";
+}
+
+NCCONV_TEST(maxMemorySlabsMatchUnlimitedOutput) {
+    ncconv::Dataset dataset(writeSlabDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/unlimited.nc");
+
+    // 250 bytes hold two z-levels of 120 bytes and 50 bytes two rows of 24 bytes. With 1 byte, single rows are read.
+    for (size_t maxMemory : { size_t(250), size_t(50), size_t(1) }) {
+        std::string filePath = testDirectory + "/budget_" + std::to_string(maxMemory) + ".nc";
+        dataset.setMaxMemory(maxMemory);
+        dataset.writeToNcFile(filePath);
+        for (const char* fieldName : { "t", "ps" }) {
+            ncconv_test::checkNcVariablesEqual(testDirectory + "/unlimited.nc", filePath, fieldName);
+        }
+        NCCONV_CHECK(dataset.verifyNcFile(filePath));
+    }
+}
+
+NCCONV_TEST(maxMemorySlabsFitIntoBudget) {
+    ncconv::Dataset dataset(writeSlabDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    VolumeData* volumeData = dataset.getVolumeData();
+    const size_t rowSize = 6 * sizeof(float), levelSize = 5 * rowSize;
+
+    // Without a budget, the whole field is one slab.
+    std::vector<FieldSlab> slabs = volumeData->computeFieldSlabs(6, 5, 3, sizeof(float), 1, 1);
+    NCCONV_CHECK_EQUAL(slabs.size(), size_t(1));
+    NCCONV_CHECK_EQUAL(slabs.at(0).zCount, size_t(3));
+    NCCONV_CHECK_EQUAL(slabs.at(0).yCount, size_t(5));
+
+    // Whole z-levels are streamed if one fits, rounded down to a multiple of the chunk depth.
+    dataset.setMaxMemory(2 * levelSize + 10);
+    slabs = volumeData->computeFieldSlabs(6, 5, 3, sizeof(float), 1, 1);
+    NCCONV_CHECK_EQUAL(slabs.size(), size_t(2));
+    NCCONV_CHECK_EQUAL(slabs.at(1).zOffset, size_t(2));
+    NCCONV_CHECK_EQUAL(slabs.at(1).zCount, size_t(1));
+    dataset.setMaxMemory(3 * levelSize + 10);
+    NCCONV_CHECK_EQUAL(volumeData->computeFieldSlabs(6, 5, 4, sizeof(float), 1, 1).at(0).zCount, size_t(3));
+    NCCONV_CHECK_EQUAL(volumeData->computeFieldSlabs(6, 5, 4, sizeof(float), 2, 1).at(0).zCount, size_t(2));
+
+    // Otherwise, bands of rows within one z-level are streamed.
+    dataset.setMaxMemory(3 * rowSize);
+    slabs = volumeData->computeFieldSlabs(6, 5, 3, sizeof(float), 1, 2);
+    NCCONV_CHECK_EQUAL(slabs.size(), size_t(3 * 3));
+    size_t numRows = 0;
+    for (const FieldSlab& slab : slabs) {
+        NCCONV_CHECK_EQUAL(slab.zCount, size_t(1));
+        NCCONV_CHECK(slab.yCount * rowSize <= 3 * rowSize);
+        NCCONV_CHECK_EQUAL(slab.yOffset % 2, size_t(0));
+        numRows += slab.yCount;
+    }
+    NCCONV_CHECK_EQUAL(numRows, size_t(3 * 5));
+
+    // The slab iterator visits all slabs of all time steps with the same budget.
+    size_t numIteratedEntries = 0, numIteratedSlabs = 0;
+    ncconv::SlabIterator iterator = dataset.iterateSlabs("t");
+    while (iterator.next()) {
+        const ncconv::SlabView& view = iterator.get();
+        NCCONV_CHECK(view.getNumEntries() * sizeof(float) <= 3 * rowSize);
+        numIteratedEntries += view.getNumEntries();
+        numIteratedSlabs++;
+    }
+    NCCONV_CHECK_EQUAL(numIteratedEntries, size_t(2 * 6 * 5 * 3));
+    NCCONV_CHECK_EQUAL(numIteratedSlabs, size_t(2 * 3 * 2));
+}
@@ -0,0 +1,208 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#ifndef _WIN32
+#include <csignal>
+#include <cstdio>
+#include <sys/stat.h>
+#endif
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of reading GrADS data from a named pipe (ForwardStreamReader). The data of all variables of each (member, time
+ * step) record arrives in file order, so the writers need to write the variables record by record. The output needs
+ * to be identical to the output of the same data read from a regular file.
+ */
+
+#ifndef _WIN32
+
+/// Writes an ensemble data set with two members, three time steps and a 2D, a 3D and a uint8 variable.
+static std::string writeStreamDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/stream.ctl",
+            "dset ^stream.dat\n"
+            "undef -9999\n"
+            "xdef 5 linear 0 1.0\n"
+            "ydef 3 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 3 linear 00Z01JAN2000 6hr\n"
+            "edef 2 names 1 2\n"
+            "vars 3\n"
+            "ps 0 99 surface pressure\n"
+            "t 2 99 temperature\n"
+            "cnt 0 -1,40,1 uint8\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int record = 0; record < 2 * 3; record++) {
+        for (int i = 0; i < 15 + 30; i++, entryIdx++) {
+            ncconv_test::appendValue(data, entryIdx % 11 == 4 ? -9999.0f : float(entryIdx) * 0.5f, false);
+        }
+        for (int i = 0; i < 15; i++, entryIdx++) {
+            data.push_back(uint8_t(entryIdx * 7));
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/stream.dat", data);
+    return directory + "/stream.ctl";
+}
+
+/**
+ * Opens the data set with its data file passed through a named pipe, which is fed by another thread, and calls
+ * writeFunction on it.
+ */
+static void convertFromPipe(
+        const std::string& directory, const std::string& ctlFilePath,
+        const std::function<void(ncconv::Dataset&)>& writeFunction) {
+    std::string pipePath = directory + "/stream.pipe";
+    boost::filesystem::remove(pipePath);
+    NCCONV_CHECK(mkfifo(pipePath.c_str(), 0600) == 0);
+    std::string data = ncconv_test::readFile(directory + "/stream.dat");
+    // The data set may close the pipe before all data was written (e.g., if writing fails).
+    signal(SIGPIPE, SIG_IGN);
+    // Opening the pipe blocks until the data set opens it for reading.
+    std::thread writerThread([pipePath, data]() {
+        FILE* pipe = fopen(pipePath.c_str(), "wb");
+        if (pipe) {
+            fwrite(data.data(), 1, data.size(), pipe);
+            fclose(pipe);
+        }
+    });
+    try {
+        DataSetInformation dataSetInformation;
+        dataSetInformation.dataFilePath = pipePath;
+        ncconv::Dataset dataset(ctlFilePath, dataSetInformation);
+        dataset.setIsVerbose(false);
+        dataset.setMaxMemory(40);
+        NCCONV_CHECK(dataset.getLoader()->getRequiresSequentialReads());
+        writeFunction(dataset);
+    } catch (...) {
+        // The writer thread may still wait for the pipe to be opened; it ends with the process.
+        writerThread.detach();
+        throw;
+    }
+    writerThread.join();
+}
+
+static void checkNcFilesEqual(const std::string& expectedFilePath, const std::string& actualFilePath) {
+    for (const char* fieldName : { "ps", "t", "cnt" }) {
+        ncconv_test::checkNcVariablesEqual(expectedFilePath, actualFilePath, fieldName);
+    }
+}
+
+NCCONV_TEST(streamedInputMatchesFileInput) {
+    std::string ctlFilePath = writeStreamDataSet(testDirectory);
+    ncconv::Dataset fileDataset(ctlFilePath);
+    fileDataset.setIsVerbose(false);
+    fileDataset.setMaxMemory(40);
+    fileDataset.writeToNcFile(testDirectory + "/file.nc");
+    fileDataset.writeToCdf5File(testDirectory + "/file_cdf5.nc");
+    fileDataset.writeToZarrStore(testDirectory + "/file.zarr");
+
+    convertFromPipe(testDirectory, ctlFilePath, [&](ncconv::Dataset& dataset) {
+        dataset.writeToNcFile(testDirectory + "/stream.nc");
+    });
+    checkNcFilesEqual(testDirectory + "/file.nc", testDirectory + "/stream.nc");
+    NCCONV_CHECK(fileDataset.verifyNcFile(testDirectory + "/stream.nc"));
+
+    convertFromPipe(testDirectory, ctlFilePath, [&](ncconv::Dataset& dataset) {
+        dataset.writeToCdf5File(testDirectory + "/stream_cdf5.nc");
+    });
+    checkNcFilesEqual(testDirectory + "/file_cdf5.nc", testDirectory + "/stream_cdf5.nc");
+
+    // The Zarr stores need to consist of the same files with the same content.
+    convertFromPipe(testDirectory, ctlFilePath, [&](ncconv::Dataset& dataset) {
+        dataset.writeToZarrStore(testDirectory + "/stream.zarr");
+    });
+    size_t numFiles = 0;
+    boost::filesystem::recursive_directory_iterator it(testDirectory + "/file.zarr"), end;
+    for (; it != end; ++it) {
+        if (!boost::filesystem::is_regular_file(it->path())) {
+            continue;
+        }
+        std::string relativePath = boost::filesystem::relative(it->path(), testDirectory + "/file.zarr").string();
+        NCCONV_CHECK(boost::filesystem::exists(testDirectory + "/stream.zarr/" + relativePath));
+        NCCONV_CHECK(
+                ncconv_test::readFile(it->path().string())
+                == ncconv_test::readFile(testDirectory + "/stream.zarr/" + relativePath));
+        numFiles++;
+    }
+    NCCONV_CHECK(numFiles > 3 * 2 * 3);
+}
+
+NCCONV_TEST(streamedInputRejectsRandomAccess) {
+    std::string ctlFilePath = writeStreamDataSet(testDirectory);
+    bool hasThrown = false;
+    convertFromPipe(testDirectory, ctlFilePath, [&](ncconv::Dataset& dataset) {
+        TimeAggregation timeAggregation;
+        timeAggregation.type = TimeAggregationType::STEPS;
+        timeAggregation.numSteps = 2;
+        dataset.setTimeAggregation(timeAggregation);
+        try {
+            dataset.writeToNcFile(testDirectory + "/aggregated.nc");
+        } catch (const std::runtime_error& exception) {
+            hasThrown = std::string(exception.what()).find("stream") != std::string::npos;
+        }
+    });
+    NCCONV_CHECK(hasThrown);
+
+    // Derived fields read their input fields again, so they are rejected before any output file is created.
+    std::vector<std::pair<std::string, std::function<void(ncconv::Dataset&, const std::string&)>>> writers = {
+            { "derived.nc", [](ncconv::Dataset& dataset, const std::string& path) { dataset.writeToNcFile(path); } },
+            { "derived_cdf5.nc", [](ncconv::Dataset& dataset, const std::string& path) {
+                dataset.writeToCdf5File(path); } },
+            { "derived.zarr", [](ncconv::Dataset& dataset, const std::string& path) {
+                dataset.writeToZarrStore(path); } },
+            { "derived.ctl", [](ncconv::Dataset& dataset, const std::string& path) {
+                dataset.writeToCtlFile(path); } },
+    };
+    for (const auto& writer : writers) {
+        std::string outputPath = testDirectory + "/" + writer.first;
+        hasThrown = false;
+        convertFromPipe(testDirectory, ctlFilePath, [&](ncconv::Dataset& dataset) {
+            dataset.setDerivedFields({ "ps2=ps*2" });
+            try {
+                writer.second(dataset, outputPath);
+            } catch (const std::runtime_error& exception) {
+                hasThrown = std::string(exception.what()).find("derived variables") != std::string::npos;
+            }
+        });
+        NCCONV_CHECK(hasThrown);
+        NCCONV_CHECK(!boost::filesystem::exists(outputPath));
+        NCCONV_CHECK(!boost::filesystem::exists(testDirectory + "/derived.dat"));
+    }
+}
+
+#endif
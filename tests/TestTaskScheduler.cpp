@@ -0,0 +1,144 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utils/TaskScheduler.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the work-stealing task pools. Tasks may submit and wait for nested tasks, and waiting threads run pending
+ * tasks, so nested parallel loops complete even if all workers are busy waiting themselves.
+ */
+
+NCCONV_TEST(nestedParallelForVisitsEachIndexOnce) {
+    sgl::setNumThreads(4, 1);
+    const size_t numOuter = 64, numInner = 257;
+    std::vector<std::atomic<int>> visitCounts(numOuter * numInner);
+    sgl::parallelFor(0, numOuter, 1, [&](size_t outerBegin, size_t outerEnd) {
+        for (size_t i = outerBegin; i < outerEnd; i++) {
+            sgl::parallelFor(0, numInner, 16, [&](size_t innerBegin, size_t innerEnd) {
+                for (size_t j = innerBegin; j < innerEnd; j++) {
+                    visitCounts.at(i * numInner + j)++;
+                }
+            });
+        }
+    });
+    for (const std::atomic<int>& visitCount : visitCounts) {
+        NCCONV_CHECK_EQUAL(visitCount.load(), 1);
+    }
+
+    // A pool without workers runs all loops on the calling thread.
+    sgl::setNumThreads(1, 1);
+    NCCONV_CHECK_EQUAL(sgl::getNumComputeThreads(), size_t(1));
+    std::thread::id callerId = std::this_thread::get_id();
+    std::atomic<bool> isOnCaller{true};
+    size_t sum = 0;
+    sgl::parallelFor(0, 100, 1, [&](size_t begin, size_t end) {
+        isOnCaller = isOnCaller && std::this_thread::get_id() == callerId;
+        for (size_t i = begin; i < end; i++) {
+            sum += i;
+        }
+    });
+    NCCONV_CHECK(isOnCaller);
+    NCCONV_CHECK_EQUAL(sum, size_t(4950));
+    sgl::setNumThreads(0, 1);
+}
+
+NCCONV_TEST(nestedTaskGroupsWaitAndRethrow) {
+    sgl::setNumThreads(3, 1);
+    sgl::TaskPool& pool = sgl::getComputeTaskPool();
+
+    // Each task waits for a nested group, which needs the waiting threads to run the nested tasks.
+    std::atomic<int> numLeafTasks{0};
+    {
+        sgl::TaskGroup group(pool);
+        for (int i = 0; i < 16; i++) {
+            group.run([&]() {
+                sgl::TaskGroup nestedGroup(pool);
+                for (int j = 0; j < 8; j++) {
+                    nestedGroup.run([&]() { numLeafTasks++; });
+                }
+                nestedGroup.wait();
+            });
+        }
+        group.wait();
+    }
+    NCCONV_CHECK_EQUAL(numLeafTasks.load(), 16 * 8);
+
+    // A waiting thread wakes up when the last task, running on another thread, finishes.
+    {
+        sgl::TaskGroup group(pool);
+        std::atomic<bool> isFinished{false};
+        group.run([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            isFinished = true;
+        });
+        group.wait();
+        NCCONV_CHECK(isFinished);
+    }
+
+    // The first exception of a task is rethrown by wait, after all tasks finished.
+    std::atomic<int> numFinishedTasks{0};
+    bool hasThrown = false;
+    {
+        sgl::TaskGroup group(pool);
+        for (int i = 0; i < 8; i++) {
+            group.run([&, i]() {
+                if (i == 3) {
+                    throw std::runtime_error("task 3");
+                }
+                numFinishedTasks++;
+            });
+        }
+        try {
+            group.wait();
+        } catch (const std::runtime_error& exception) {
+            hasThrown = std::string(exception.what()) == "task 3";
+        }
+    }
+    NCCONV_CHECK(hasThrown);
+    NCCONV_CHECK_EQUAL(numFinishedTasks.load(), 7);
+
+    // The I/O pool runs tasks while the submitting thread continues.
+    {
+        sgl::TaskGroup ioGroup(sgl::getIoTaskPool());
+        std::atomic<int> numIoTasks{0};
+        for (int i = 0; i < 4; i++) {
+            ioGroup.run([&]() { numIoTasks++; });
+        }
+        ioGroup.wait();
+        NCCONV_CHECK_EQUAL(numIoTasks.load(), 4);
+    }
+    sgl::setNumThreads(0, 1);
+}
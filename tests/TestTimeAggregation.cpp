@@ -0,0 +1,156 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the temporal aggregates (see TimeAggregator). The variables <name>_mean, <name>_min, <name>_max and
+ * <name>_count need to match the statistics computed from the written time steps, with missing entries skipped.
+ */
+
+const size_t TA_XS = 5, TA_YS = 2, TA_ZS = 2, TA_TS = 10;
+
+/// Writes a data set with a 3D variable "t" (5 x 2 x 2) and a 2D variable "ps" with ten 6-hourly time steps.
+static std::string writeAggregationDataSet(const std::string& directory) {
+    // The first time step is the only one of January 1 and the last one the only one of January 4.
+    ncconv_test::writeTextFile(directory + "/agg.ctl",
+            "dset ^agg.dat\n"
+            "undef -9999\n"
+            "xdef 5 linear 0 1.0\n"
+            "ydef 2 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 10 linear 18Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    const size_t numEntriesPerStep = TA_XS * TA_YS * (TA_ZS + 1);
+    for (size_t t = 0; t < TA_TS; t++) {
+        for (size_t i = 0; i < numEntriesPerStep; i++) {
+            // The first entry is missing in all time steps, and the others in some of them.
+            bool isMissing = i == 0 || (i * 3 + t * 7) % 13 == 4;
+            float value = std::sin(float(i) * 0.7f + float(t)) * 20.0f + float(t);
+            ncconv_test::appendValue(data, isMissing ? -9999.0f : value, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/agg.dat", data);
+    return directory + "/agg.ctl";
+}
+
+/// Checks the temporal aggregates of a variable against the statistics of its time steps in each period.
+static void checkAggregates(
+        const std::string& filePath, const std::string& varName, size_t numLevels,
+        const std::vector<size_t>& periodIndices) {
+    const size_t numPeriods = periodIndices.back() + 1;
+    const size_t numMapEntries = numLevels * TA_YS * TA_XS;
+    std::vector<double> values = ncconv_test::readNcVariable(filePath, varName);
+    std::vector<double> means = ncconv_test::readNcVariable(filePath, varName + "_mean");
+    std::vector<double> minima = ncconv_test::readNcVariable(filePath, varName + "_min");
+    std::vector<double> maxima = ncconv_test::readNcVariable(filePath, varName + "_max");
+    std::vector<double> counts = ncconv_test::readNcVariable(filePath, varName + "_count");
+    NCCONV_CHECK_EQUAL(values.size(), numMapEntries * TA_TS);
+    NCCONV_CHECK_EQUAL(means.size(), numMapEntries * numPeriods);
+    NCCONV_CHECK_EQUAL(minima.size(), means.size());
+    NCCONV_CHECK_EQUAL(maxima.size(), means.size());
+    NCCONV_CHECK_EQUAL(counts.size(), means.size());
+    NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(filePath, varName + "_count"), NC_INT);
+
+    for (size_t period = 0; period < numPeriods; period++) {
+        for (size_t i = 0; i < numMapEntries; i++) {
+            double sum = 0.0;
+            double minimum = std::numeric_limits<double>::infinity();
+            double maximum = -std::numeric_limits<double>::infinity();
+            size_t count = 0;
+            for (size_t t = 0; t < TA_TS; t++) {
+                double value = values.at(t * numMapEntries + i);
+                if (periodIndices.at(t) == period && !std::isnan(value)) {
+                    sum += value;
+                    minimum = std::min(minimum, value);
+                    maximum = std::max(maximum, value);
+                    count++;
+                }
+            }
+            size_t idx = period * numMapEntries + i;
+            NCCONV_CHECK_EQUAL(counts.at(idx), double(count));
+            if (count == 0) {
+                NCCONV_CHECK(std::isnan(means.at(idx)) && std::isnan(minima.at(idx)) && std::isnan(maxima.at(idx)));
+            } else {
+                double mean = sum / double(count);
+                NCCONV_CHECK(std::abs(means.at(idx) - mean) <= 1e-5 * std::max(std::abs(mean), 1.0));
+                NCCONV_CHECK_EQUAL(minima.at(idx), minimum);
+                NCCONV_CHECK_EQUAL(maxima.at(idx), maximum);
+            }
+        }
+    }
+}
+
+NCCONV_TEST(timeAggregationOverSteps) {
+    ncconv::Dataset dataset(writeAggregationDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    TimeAggregation timeAggregation;
+    timeAggregation.type = TimeAggregationType::STEPS;
+    timeAggregation.numSteps = 4;
+    dataset.setTimeAggregation(timeAggregation);
+    std::string filePath = testDirectory + "/agg.nc";
+    dataset.writeToNcFile(filePath);
+    // The last period only has two time steps.
+    const std::vector<size_t> periodIndices = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2 };
+    checkAggregates(filePath, "t", TA_ZS, periodIndices);
+    checkAggregates(filePath, "ps", 1, periodIndices);
+
+    // The aggregates do not depend on the slabs the fields are streamed in.
+    dataset.setMaxMemory(64);
+    dataset.writeToNcFile(testDirectory + "/agg_slabs.nc");
+    for (const char* varName : { "t_mean", "t_min", "t_max", "t_count", "ps_mean" }) {
+        ncconv_test::checkNcVariablesEqual(filePath, testDirectory + "/agg_slabs.nc", varName);
+    }
+}
+
+NCCONV_TEST(timeAggregationDaily) {
+    ncconv::Dataset dataset(writeAggregationDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    TimeAggregation timeAggregation;
+    timeAggregation.type = TimeAggregationType::DAILY;
+    dataset.setTimeAggregation(timeAggregation);
+    std::string filePath = testDirectory + "/agg.nc";
+    dataset.writeToNcFile(filePath);
+    // Days start at midnight, so the first and last day are incomplete.
+    const std::vector<size_t> periodIndices = { 0, 1, 1, 1, 1, 2, 2, 2, 2, 3 };
+    checkAggregates(filePath, "t", TA_ZS, periodIndices);
+    checkAggregates(filePath, "ps", 1, periodIndices);
+}
@@ -0,0 +1,138 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of detecting identical slabs (VolumeData::setCollapseTimeInvariantFields). Variables identical in all time
+ * steps are written once without the time dimension, while variables differing in any slab keep it. Repeated slabs
+ * written via the direct chunk writer reuse their compressed chunks, which needs to yield the same output.
+ */
+
+/**
+ * Writes a data set with four time steps and the variables "orog" (identical in all time steps), "t" (3D, differs
+ * only in the last row of the last time step) and "ps" (differs in every time step) on a 6 x 4 grid.
+ */
+static std::string writeStaticDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/static.ctl",
+            "dset ^static.dat\n"
+            "undef -9999\n"
+            "xdef 6 linear 0 1.0\n"
+            "ydef 4 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 4 linear 00Z01JAN2000 6hr\n"
+            "vars 3\n"
+            "orog 0 99 orography\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < 6 * 4; i++) {
+            ncconv_test::appendValue(data, i == 7 ? -9999.0f : float(i) * 10.0f, false);
+        }
+        for (int i = 0; i < 2 * 6 * 4; i++) {
+            ncconv_test::appendValue(data, t == 3 && i >= 2 * 6 * 4 - 6 ? 1.0f : float(i), false);
+        }
+        for (int i = 0; i < 6 * 4; i++) {
+            ncconv_test::appendValue(data, float(t * 100 + i), false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/static.dat", data);
+    return directory + "/static.ctl";
+}
+
+/// Returns the names of the dimensions of a variable.
+static std::vector<std::string> getNcDimensionNames(const std::string& filePath, const std::string& varName) {
+    int ncid = -1, varid = -1, numDims = 0;
+    NCCONV_CHECK(nc_open(filePath.c_str(), NC_NOWRITE, &ncid) == NC_NOERR);
+    NCCONV_CHECK(nc_inq_varid(ncid, varName.c_str(), &varid) == NC_NOERR);
+    nc_inq_varndims(ncid, varid, &numDims);
+    std::vector<int> dimIds(numDims);
+    nc_inq_vardimid(ncid, varid, dimIds.data());
+    std::vector<std::string> dimNames;
+    for (int dimId : dimIds) {
+        char dimName[NC_MAX_NAME + 1] = {};
+        nc_inq_dimname(ncid, dimId, dimName);
+        dimNames.emplace_back(dimName);
+    }
+    nc_close(ncid);
+    return dimNames;
+}
+
+NCCONV_TEST(collapseStaticWritesTimeInvariantFieldsOnce) {
+    ncconv::Dataset dataset(writeStaticDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/full.nc");
+    std::vector<std::string> timeDimNames = getNcDimensionNames(testDirectory + "/full.nc", "orog");
+    NCCONV_CHECK_EQUAL(timeDimNames.size(), size_t(3));
+
+    // Slabs of one row, so the last slab of "t" is the only one that differs.
+    dataset.setMaxMemory(6 * sizeof(float));
+    dataset.setCollapseTimeInvariantFields(true);
+    std::string filePath = testDirectory + "/collapsed.nc";
+    dataset.writeToNcFile(filePath);
+    NCCONV_CHECK((getNcDimensionNames(filePath, "orog") == std::vector<std::string>(
+            timeDimNames.begin() + 1, timeDimNames.end())));
+    NCCONV_CHECK_EQUAL(getNcDimensionNames(filePath, "t").size(), size_t(4));
+    NCCONV_CHECK_EQUAL(getNcDimensionNames(filePath, "ps").size(), size_t(3));
+
+    std::vector<double> fullValues = ncconv_test::readNcVariable(testDirectory + "/full.nc", "orog");
+    std::vector<double> collapsedValues = ncconv_test::readNcVariable(filePath, "orog");
+    NCCONV_CHECK_EQUAL(collapsedValues.size(), size_t(6 * 4));
+    for (size_t i = 0; i < collapsedValues.size(); i++) {
+        NCCONV_CHECK(i == 7 ? std::isnan(collapsedValues.at(i)) : collapsedValues.at(i) == fullValues.at(i));
+    }
+    ncconv_test::checkNcVariablesEqual(testDirectory + "/full.nc", filePath, "t");
+    ncconv_test::checkNcVariablesEqual(testDirectory + "/full.nc", filePath, "ps");
+    // Each input time step is compared against the single output time step of collapsed variables.
+    NCCONV_CHECK(dataset.verifyNcFile(filePath));
+    NCCONV_CHECK(dataset.verifyNcFile(filePath, true));
+}
+
+NCCONV_TEST(repeatedSlabsReuseCompressedChunks) {
+    ncconv::Dataset dataset(writeStaticDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setChunkShape({ 1, 2, 6 });
+    dataset.setDeflateLevel(4);
+    dataset.setUseDirectChunkWrite(false);
+    dataset.writeToNcFile(testDirectory + "/netcdf.nc");
+    dataset.setUseDirectChunkWrite(true);
+    dataset.writeToNcFile(testDirectory + "/direct.nc");
+    for (const char* varName : { "orog", "t", "ps" }) {
+        ncconv_test::checkNcVariablesEqual(testDirectory + "/netcdf.nc", testDirectory + "/direct.nc", varName);
+    }
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/direct.nc", true));
+}
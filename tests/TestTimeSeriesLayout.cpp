@@ -0,0 +1,125 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of OutputLayout::TIME_SERIES. The variables need to contain the transposed maps of OutputLayout::MAPS, both
+ * when the transpose fits into memory and when it is done out-of-core with a spill file.
+ */
+
+const size_t TS_XS = 5, TS_YS = 4, TS_ZS = 2, TS_TS = 6;
+
+/// Writes a data set with a 3D variable "t" (5 x 4 x 2) and a 2D variable "ps" with six time steps.
+static std::string writeTimeSeriesDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/ts.ctl",
+            "dset ^ts.dat\n"
+            "undef -9999\n"
+            "xdef 5 linear 0 1.0\n"
+            "ydef 4 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 6 linear 00Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (size_t t = 0; t < TS_TS; t++) {
+        for (size_t i = 0; i < TS_XS * TS_YS * (TS_ZS + 1); i++, entryIdx++) {
+            ncconv_test::appendValue(data, entryIdx % 17 == 9 ? -9999.0f : float(entryIdx) * 0.125f, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/ts.dat", data);
+    return directory + "/ts.ctl";
+}
+
+/// Checks that a (z, y, x, t) variable of timeSeriesFilePath is the transposed (t, z, y, x) variable of mapsFilePath.
+static void checkIsTransposed(
+        const std::string& mapsFilePath, const std::string& timeSeriesFilePath, const std::string& varName,
+        size_t numLevels) {
+    std::vector<double> mapValues = ncconv_test::readNcVariable(mapsFilePath, varName);
+    std::vector<double> timeSeriesValues = ncconv_test::readNcVariable(timeSeriesFilePath, varName);
+    const size_t numMapEntries = numLevels * TS_YS * TS_XS;
+    NCCONV_CHECK_EQUAL(mapValues.size(), numMapEntries * TS_TS);
+    NCCONV_CHECK_EQUAL(timeSeriesValues.size(), mapValues.size());
+    for (size_t t = 0; t < TS_TS; t++) {
+        for (size_t i = 0; i < numMapEntries; i++) {
+            double mapValue = mapValues.at(t * numMapEntries + i);
+            double timeSeriesValue = timeSeriesValues.at(i * TS_TS + t);
+            NCCONV_CHECK(std::isnan(mapValue) ? std::isnan(timeSeriesValue) : timeSeriesValue == mapValue);
+        }
+    }
+}
+
+NCCONV_TEST(timeSeriesLayoutTransposesMaps) {
+    ncconv::Dataset dataset(writeTimeSeriesDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/maps.nc");
+    dataset.setOutputLayout(OutputLayout::TIME_SERIES);
+    dataset.writeToNcFile(testDirectory + "/ts.nc");
+    checkIsTransposed(testDirectory + "/maps.nc", testDirectory + "/ts.nc", "t", TS_ZS);
+    checkIsTransposed(testDirectory + "/maps.nc", testDirectory + "/ts.nc", "ps", 1);
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/ts.nc"));
+}
+
+NCCONV_TEST(timeSeriesLayoutSpillsUnderSmallBudget) {
+    ncconv::Dataset dataset(writeTimeSeriesDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(testDirectory + "/maps.nc");
+    dataset.setOutputLayout(OutputLayout::TIME_SERIES);
+    // All six maps of a level need 480 bytes, so the transpose is done in bands of one row via the spill file.
+    dataset.setMaxMemory(200);
+
+    // The spill file is created in the spill directory, so a missing directory makes the transpose fail.
+    dataset.setSpillDirectory(testDirectory + "/missing");
+    bool hasThrown = false;
+    try {
+        dataset.writeToNcFile(testDirectory + "/ts_missing.nc");
+    } catch (const std::runtime_error& exception) {
+        hasThrown = std::string(exception.what()).find("spill file") != std::string::npos;
+    }
+    NCCONV_CHECK(hasThrown);
+
+    std::string spillDirectory = testDirectory + "/spill";
+    boost::filesystem::create_directories(spillDirectory);
+    dataset.setSpillDirectory(spillDirectory);
+    dataset.writeToNcFile(testDirectory + "/ts.nc");
+    checkIsTransposed(testDirectory + "/maps.nc", testDirectory + "/ts.nc", "t", TS_ZS);
+    checkIsTransposed(testDirectory + "/maps.nc", testDirectory + "/ts.nc", "ps", 1);
+    NCCONV_CHECK(dataset.verifyNcFile(testDirectory + "/ts.nc"));
+    // The spill files are removed after writing each variable.
+    NCCONV_CHECK(boost::filesystem::is_empty(spillDirectory));
+}
@@ -0,0 +1,137 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the typed decoding of GrADS variables and of the handling of the undef value, which is only a fill value of
+ * integer variables if it can be stored in their data type.
+ */
+
+static const int NUM_ENTRIES = ncconv_test::TYPED_DATA_SET_NUM_ENTRIES;
+
+template<class T>
+static std::vector<T> readSlabs(ncconv::Dataset& dataset, const std::string& fieldName) {
+    std::vector<T> values;
+    ncconv::SlabIterator iterator = dataset.iterateSlabs(fieldName);
+    while (iterator.next()) {
+        const ncconv::SlabView& view = iterator.get();
+        const T* data = view.getData<T>();
+        values.insert(values.end(), data, data + view.getNumEntries());
+    }
+    return values;
+}
+
+NCCONV_TEST(typedVariablesKeepTheirDataType) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    VolumeLoader* loader = dataset.getLoader();
+    NCCONV_CHECK(loader->getFieldDataType("i8") == FieldDataType::INT8);
+    NCCONV_CHECK(loader->getFieldDataType("cnt") == FieldDataType::UINT8);
+    NCCONV_CHECK(loader->getFieldDataType("i16") == FieldDataType::INT16);
+    NCCONV_CHECK(loader->getFieldDataType("u16") == FieldDataType::UINT16);
+    NCCONV_CHECK(loader->getFieldDataType("i32") == FieldDataType::INT32);
+    NCCONV_CHECK(loader->getFieldDataType("f32") == FieldDataType::FLOAT32);
+    NCCONV_CHECK(loader->getFieldDataType("f64") == FieldDataType::FLOAT64);
+
+    auto i8 = readSlabs<int8_t>(dataset, "i8");
+    auto cnt = readSlabs<uint8_t>(dataset, "cnt");
+    auto i16 = readSlabs<int16_t>(dataset, "i16");
+    auto u16 = readSlabs<uint16_t>(dataset, "u16");
+    auto i32 = readSlabs<int32_t>(dataset, "i32");
+    auto f32 = readSlabs<float>(dataset, "f32");
+    auto f64 = readSlabs<double>(dataset, "f64");
+    NCCONV_CHECK_EQUAL(cnt.size(), size_t(NUM_ENTRIES));
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        NCCONV_CHECK_EQUAL(i8.at(i), int8_t(i == 1 ? -128 : i - 4));
+        NCCONV_CHECK_EQUAL(cnt.at(i), uint8_t(i == 0 ? 241 : i));
+        // Integer fields keep their fill value; only floating point fields map it to NaN.
+        NCCONV_CHECK_EQUAL(i16.at(i), int16_t(i == 2 ? -9999 : -1000 * i));
+        NCCONV_CHECK_EQUAL(u16.at(i), uint16_t(60000 + i));
+        NCCONV_CHECK_EQUAL(i32.at(i), int32_t(i == 3 ? -9999 : 100000 * i));
+        if (i == 4) {
+            NCCONV_CHECK(std::isnan(f32.at(i)));
+        } else {
+            NCCONV_CHECK_EQUAL(f32.at(i), 0.5f * float(i));
+        }
+        if (i == 5) {
+            NCCONV_CHECK(std::isnan(f64.at(i)));
+        } else {
+            NCCONV_CHECK_EQUAL(f64.at(i), 1e300 * double(i));
+        }
+    }
+}
+
+NCCONV_TEST(undefOutOfIntegerRangeIsNoFillValue) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999.0"));
+    VolumeLoader* loader = dataset.getLoader();
+    double fillValue = 0.0;
+    NCCONV_CHECK(!loader->getFieldFillValue("i8", fillValue));
+    NCCONV_CHECK(!loader->getFieldFillValue("cnt", fillValue));
+    NCCONV_CHECK(!loader->getFieldFillValue("u16", fillValue));
+    NCCONV_CHECK(loader->getFieldFillValue("i16", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, -9999.0);
+    NCCONV_CHECK(loader->getFieldFillValue("i32", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, -9999.0);
+
+    std::string ncFilePath = testDirectory + "/typed.nc";
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(ncFilePath);
+    NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(ncFilePath, "cnt"), NC_UBYTE);
+    NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(ncFilePath, "i16"), NC_SHORT);
+    NCCONV_CHECK_EQUAL(ncconv_test::getNcVariableType(ncFilePath, "f64"), NC_DOUBLE);
+    NCCONV_CHECK(!ncconv_test::getNcFillValue(ncFilePath, "cnt", fillValue));
+    NCCONV_CHECK(!ncconv_test::getNcFillValue(ncFilePath, "i8", fillValue));
+    NCCONV_CHECK(ncconv_test::getNcFillValue(ncFilePath, "i16", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, -9999.0);
+    auto cnt = ncconv_test::readNcVariable(ncFilePath, "cnt");
+    NCCONV_CHECK_EQUAL(cnt.at(0), 241.0);
+    auto i16 = ncconv_test::readNcVariable(ncFilePath, "i16");
+    NCCONV_CHECK_EQUAL(i16.at(2), -9999.0);
+    NCCONV_CHECK_EQUAL(i16.at(3), -3000.0);
+    NCCONV_CHECK(dataset.verifyNcFile(ncFilePath));
+}
+
+NCCONV_TEST(undefInIntegerRangeIsFillValue) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "241"));
+    double fillValue = 0.0;
+    NCCONV_CHECK(dataset.getLoader()->getFieldFillValue("cnt", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, 241.0);
+    NCCONV_CHECK(!dataset.getLoader()->getFieldFillValue("i8", fillValue));
+
+    std::string ncFilePath = testDirectory + "/typed.nc";
+    dataset.setIsVerbose(false);
+    dataset.writeToNcFile(ncFilePath);
+    NCCONV_CHECK(ncconv_test::getNcFillValue(ncFilePath, "cnt", fillValue));
+    NCCONV_CHECK_EQUAL(fillValue, 241.0);
+}
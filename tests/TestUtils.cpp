@@ -0,0 +1,284 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+#include <netcdf.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Api/Dataset.hpp"
+#include "Loaders/VolumeLoader.hpp"
+#include "Loaders/DecodeKernels.hpp"
+#include "TestUtils.hpp"
+
+namespace ncconv_test {
+
+static std::map<std::string, TestFunction>& getTestFunctions() {
+    static std::map<std::string, TestFunction> testFunctions;
+    return testFunctions;
+}
+
+TestRegistrar::TestRegistrar(const char* testName, TestFunction testFunction) {
+    getTestFunctions()[testName] = testFunction;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    throw std::runtime_error(std::string(file) + ":" + std::to_string(line) + ": " + message);
+}
+
+void writeTextFile(const std::string& filePath, const std::string& text) {
+    std::ofstream file(filePath, std::ios::binary);
+    file << text;
+    if (!file) {
+        throw std::runtime_error("Error in writeTextFile: Could not write \"" + filePath + "\".");
+    }
+}
+
+std::string readFile(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Error in readFile: Could not open \"" + filePath + "\".");
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+void writeBinaryFile(const std::string& filePath, const std::vector<uint8_t>& data) {
+    std::ofstream file(filePath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+    if (!file) {
+        throw std::runtime_error("Error in writeBinaryFile: Could not write \"" + filePath + "\".");
+    }
+}
+
+std::string writeTypedDataSet(const std::string& directory, const std::string& undef) {
+    writeTextFile(directory + "/typed.ctl",
+            "dset ^typed.dat\n"
+            "options big_endian\n"
+            "undef " + undef + "\n"
+            "xdef 4 linear 0 1.0\n"
+            "ydef 2 linear -10 2.0\n"
+            "zdef 1 linear 0 1\n"
+            "tdef 1 linear 00Z01JAN2000 6hr\n"
+            "vars 7\n"
+            "i8 0 -1,40,1,-1 int8\n"
+            "cnt 0 -1,40,1 uint8\n"
+            "i16 0 -1,40,2,-1 int16\n"
+            "u16 0 -1,40,2 uint16\n"
+            "i32 0 -1,40,4 int32\n"
+            "f32 0 99 float32\n"
+            "f64 0 -1,40,8 float64\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, int8_t(i == 1 ? -128 : i - 4), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, uint8_t(i == 0 ? 241 : i), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, int16_t(i == 2 ? -9999 : -1000 * i), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, uint16_t(60000 + i), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, int32_t(i == 3 ? -9999 : 100000 * i), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, i == 4 ? -9999.0f : 0.5f * float(i), true);
+    }
+    for (int i = 0; i < TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        appendValue(data, i == 5 ? -9999.0 : 1e300 * double(i), true);
+    }
+    writeBinaryFile(directory + "/typed.dat", data);
+    return directory + "/typed.ctl";
+}
+
+static void checkNcStatus(int status, const std::string& filePath) {
+    if (status != NC_NOERR) {
+        throw std::runtime_error("NetCDF error for \"" + filePath + "\": " + nc_strerror(status));
+    }
+}
+
+/// Opens a NetCDF file and looks up a variable. The file is closed by the destructor.
+struct NcVariableHandle {
+    NcVariableHandle(const std::string& filePath, const std::string& varName) {
+        checkNcStatus(nc_open(filePath.c_str(), NC_NOWRITE, &ncid), filePath);
+        checkNcStatus(nc_inq_varid(ncid, varName.c_str(), &varid), filePath + ":" + varName);
+    }
+    ~NcVariableHandle() {
+        nc_close(ncid);
+    }
+    int ncid = -1, varid = -1;
+};
+
+std::vector<double> readNcVariable(const std::string& filePath, const std::string& varName) {
+    NcVariableHandle handle(filePath, varName);
+    int numDims = 0;
+    nc_inq_varndims(handle.ncid, handle.varid, &numDims);
+    std::vector<int> dimIds(numDims);
+    nc_inq_vardimid(handle.ncid, handle.varid, dimIds.data());
+    size_t numEntries = 1;
+    for (int dimId : dimIds) {
+        size_t dimLength = 0;
+        nc_inq_dimlen(handle.ncid, dimId, &dimLength);
+        numEntries *= dimLength;
+    }
+    std::vector<double> values(numEntries);
+    checkNcStatus(nc_get_var_double(handle.ncid, handle.varid, values.data()), filePath + ":" + varName);
+    return values;
+}
+
+int getNcVariableType(const std::string& filePath, const std::string& varName) {
+    NcVariableHandle handle(filePath, varName);
+    nc_type type = NC_NAT;
+    nc_inq_vartype(handle.ncid, handle.varid, &type);
+    return type;
+}
+
+bool getNcFillValue(const std::string& filePath, const std::string& varName, double& fillValue) {
+    NcVariableHandle handle(filePath, varName);
+    return nc_get_att_double(handle.ncid, handle.varid, "_FillValue", &fillValue) == NC_NOERR;
+}
+
+bool getNcHasAttribute(const std::string& filePath, const std::string& varName, const std::string& attributeName) {
+    NcVariableHandle handle(filePath, varName);
+    size_t length = 0;
+    return nc_inq_attlen(handle.ncid, handle.varid, attributeName.c_str(), &length) == NC_NOERR;
+}
+
+void checkNcVariablesEqual(
+        const std::string& expectedFilePath, const std::string& actualFilePath, const std::string& varName) {
+    NCCONV_CHECK_EQUAL(getNcVariableType(actualFilePath, varName), getNcVariableType(expectedFilePath, varName));
+    auto expectedValues = readNcVariable(expectedFilePath, varName);
+    auto actualValues = readNcVariable(actualFilePath, varName);
+    NCCONV_CHECK_EQUAL(actualValues.size(), expectedValues.size());
+    for (size_t i = 0; i < expectedValues.size(); i++) {
+        bool isNaN = std::isnan(expectedValues.at(i)) && std::isnan(actualValues.at(i));
+        if (!isNaN && actualValues.at(i) != expectedValues.at(i)) {
+            fail(__FILE__, __LINE__, "Entry " + std::to_string(i) + " of variable \"" + varName + "\" differs.");
+        }
+    }
+}
+
+/// Reads all slabs of a field with NaN entries canonicalized, so that equal fields have equal bytes.
+static std::vector<uint8_t> readFieldBytes(ncconv::Dataset& dataset, const std::string& fieldName) {
+    std::vector<uint8_t> bytes;
+    ncconv::SlabIterator iterator = dataset.iterateSlabs(fieldName);
+    while (iterator.next()) {
+        const ncconv::SlabView& view = iterator.get();
+        size_t offset = bytes.size();
+        bytes.insert(bytes.end(), view.data, view.data + view.getNumEntries() * getFieldDataTypeSize(view.dataType));
+        canonicalizeNaNs(bytes.data() + offset, view.dataType, view.getNumEntries());
+    }
+    return bytes;
+}
+
+void checkDataSetsEqual(ncconv::Dataset& expected, ncconv::Dataset& actual) {
+    VolumeData* expectedData = expected.getVolumeData();
+    VolumeData* actualData = actual.getVolumeData();
+    NCCONV_CHECK(expected.getFieldNames() == actual.getFieldNames());
+    NCCONV_CHECK_EQUAL(actualData->getGridSizeX(), expectedData->getGridSizeX());
+    NCCONV_CHECK_EQUAL(actualData->getGridSizeY(), expectedData->getGridSizeY());
+    NCCONV_CHECK_EQUAL(actualData->getGridSizeZ(), expectedData->getGridSizeZ());
+    NCCONV_CHECK_EQUAL(actualData->getNumTimeSteps(), expectedData->getNumTimeSteps());
+    NCCONV_CHECK_EQUAL(actualData->getEnsembleMemberCount(), expectedData->getEnsembleMemberCount());
+    for (const std::string& fieldName : expected.getFieldNames()) {
+        FieldDataType dataType = expected.getLoader()->getFieldDataType(fieldName);
+        if (actual.getLoader()->getFieldDataType(fieldName) != dataType) {
+            fail(__FILE__, __LINE__, "The data type of variable \"" + fieldName + "\" differs.");
+        }
+        if (readFieldBytes(expected, fieldName) != readFieldBytes(actual, fieldName)) {
+            fail(__FILE__, __LINE__, "The entries of variable \"" + fieldName + "\" differ.");
+        }
+    }
+}
+}
+
+/// Runs a test in an empty directory. With MPI, all ranks run the test, and rank 0 prepares the directory.
+static int runTest(const std::string& testName, const std::string& workDirectory, int mpiRank) {
+    const auto& testFunctions = ncconv_test::getTestFunctions();
+    auto it = testFunctions.find(testName);
+    if (it == testFunctions.end()) {
+        std::cerr << "Error: Unknown test \"" << testName << "\"." << std::endl;
+        return 1;
+    }
+    try {
+        boost::filesystem::path testDirectory = boost::filesystem::path(workDirectory) / testName;
+        if (mpiRank == 0) {
+            boost::filesystem::remove_all(testDirectory);
+            boost::filesystem::create_directories(testDirectory);
+        }
+#ifdef USE_MPI
+        MPI_Barrier(MPI_COMM_WORLD);
+#endif
+        it->second(testDirectory.string());
+    } catch (const std::exception& e) {
+        std::cerr << testName << " failed: " << e.what() << std::endl;
+        return 1;
+    }
+    if (mpiRank == 0) {
+        std::cout << testName << " passed." << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--list") {
+        for (const auto& testFunction : ncconv_test::getTestFunctions()) {
+            std::cout << testFunction.first << std::endl;
+        }
+        return 0;
+    }
+    if (argc != 3) {
+        std::cerr << "Usage: ncconv_tests <test-name> <work-directory>" << std::endl;
+        std::cerr << "       ncconv_tests --list" << std::endl;
+        return 1;
+    }
+
+    // The conversion code queries the MPI rank, so MPI needs to be initialized for all tests.
+    int mpiRank = 0;
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+#endif
+    int exitCode = runTest(argv[1], argv[2], mpiRank);
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+    return exitCode;
+}
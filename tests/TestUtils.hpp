@@ -0,0 +1,126 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef NCCONV_TESTUTILS_HPP
+#define NCCONV_TESTUTILS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+
+/**
+ * Minimal test harness of the ncconv tests. Each test is a function registered with NCCONV_TEST, which is run by
+ * "ncconv_tests <test-name> <work-directory>" (see tests/CMakeLists.txt). The fixtures are generated by the tests
+ * themselves in an empty directory inside of the work directory, so no data files are stored in the repository.
+ */
+namespace ncconv {
+class Dataset;
+}
+
+namespace ncconv_test {
+
+using TestFunction = void (*)(const std::string& testDirectory);
+
+struct TestRegistrar {
+    TestRegistrar(const char* testName, TestFunction testFunction);
+};
+
+[[noreturn]] void fail(const char* file, int line, const std::string& message);
+
+template<class T>
+std::string toCheckString(const T& value) {
+    std::ostringstream stream;
+    stream.precision(17);
+    stream << value;
+    return stream.str();
+}
+inline std::string toCheckString(int8_t value) { return std::to_string(int(value)); }
+inline std::string toCheckString(uint8_t value) { return std::to_string(int(value)); }
+
+/// Number of entries per variable of the data set written by @see writeTypedDataSet (xs = 4, ys = 2).
+const int TYPED_DATA_SET_NUM_ENTRIES = 8;
+/**
+ * Writes the big endian GrADS data set "typed.ctl" with one variable per supported data type and returns the path of
+ * its descriptor. Each variable has one entry equal to -9999 (if representable) and the uint8 variable "cnt" has the
+ * entry 241, which must not be mistaken for the undef value -9999 cast to uint8.
+ */
+std::string writeTypedDataSet(const std::string& directory, const std::string& undef);
+
+/// Checks that two data sets have the same grid, variables, data types and entries (NaN compares equal to NaN).
+void checkDataSetsEqual(ncconv::Dataset& expected, ncconv::Dataset& actual);
+
+/// Writes a text file, e.g., a GrADS descriptor.
+void writeTextFile(const std::string& filePath, const std::string& text);
+/// Reads a whole file into a string (also used for binary files).
+std::string readFile(const std::string& filePath);
+void writeBinaryFile(const std::string& filePath, const std::vector<uint8_t>& data);
+
+/// Appends the bytes of a value in big or little endian byte order to a GrADS data file buffer.
+template<class T>
+void appendValue(std::vector<uint8_t>& data, T value, bool isBigEndian) {
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); i++) {
+        data.push_back(bytes[isBigEndian ? sizeof(T) - i - 1 : i]);
+    }
+}
+
+/// Reads a whole NetCDF variable converted to double, e.g., for comparing it against the input entries.
+std::vector<double> readNcVariable(const std::string& filePath, const std::string& varName);
+/// Returns the NetCDF type of a variable (nc_type).
+int getNcVariableType(const std::string& filePath, const std::string& varName);
+/// Returns whether the variable has a _FillValue attribute, and its value converted to double.
+bool getNcFillValue(const std::string& filePath, const std::string& varName, double& fillValue);
+/// Returns whether the variable has an attribute of the passed name.
+bool getNcHasAttribute(const std::string& filePath, const std::string& varName, const std::string& attributeName);
+/// Checks that a variable has the same type and entries in two NetCDF files (NaN compares equal to NaN).
+void checkNcVariablesEqual(
+        const std::string& expectedFilePath, const std::string& actualFilePath, const std::string& varName);
+
+}
+
+#define NCCONV_TEST(testName) \
+    static void testName(const std::string& testDirectory); \
+    static ncconv_test::TestRegistrar testName##Registrar(#testName, testName); \
+    static void testName([[maybe_unused]] const std::string& testDirectory)
+
+#define NCCONV_CHECK(condition) \
+    if (!(condition)) { \
+        ncconv_test::fail(__FILE__, __LINE__, "Check failed: " #condition); \
+    }
+
+#define NCCONV_CHECK_EQUAL(actual, expected) \
+    if (!((actual) == (expected))) { \
+        ncconv_test::fail( \
+                __FILE__, __LINE__, "Check failed: " #actual " == " #expected " (" \
+                + ncconv_test::toCheckString(actual) + " != " + ncconv_test::toCheckString(expected) + ")"); \
+    }
+
+#endif //NCCONV_TESTUTILS_HPP
@@ -0,0 +1,114 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netcdf.h>
+
+#include "Api/Dataset.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the verification of written files (VolumeData::verifyNcFile). Changing a single entry of the output needs
+ * to be detected both against the input data and against the slab hashes recorded at write time.
+ */
+
+/// Writes a data set with a 3D variable "t" (6 x 5 x 2) and a 2D variable "ps" with two time steps.
+static std::string writeVerifyDataSet(const std::string& directory) {
+    ncconv_test::writeTextFile(directory + "/verify.ctl",
+            "dset ^verify.dat\n"
+            "undef -9999\n"
+            "xdef 6 linear 0 1.0\n"
+            "ydef 5 linear 0 1.0\n"
+            "zdef 2 levels 1000 500\n"
+            "tdef 2 linear 00Z01JAN2000 6hr\n"
+            "vars 2\n"
+            "t 2 99 temperature\n"
+            "ps 0 99 surface pressure\n"
+            "endvars\n");
+    std::vector<uint8_t> data;
+    int entryIdx = 0;
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 6 * 5 * 3; i++, entryIdx++) {
+            ncconv_test::appendValue(data, entryIdx % 11 == 6 ? -9999.0f : float(entryIdx) * 0.75f, false);
+        }
+    }
+    ncconv_test::writeBinaryFile(directory + "/verify.dat", data);
+    return directory + "/verify.ctl";
+}
+
+/// Overwrites the entry (t, z, y, x) = (1, 1, 2, 3) of the variable "t".
+static void modifyEntry(const std::string& filePath) {
+    int ncid = -1, varid = -1;
+    NCCONV_CHECK(nc_open(filePath.c_str(), NC_WRITE, &ncid) == NC_NOERR);
+    NCCONV_CHECK(nc_inq_varid(ncid, "t", &varid) == NC_NOERR);
+    const size_t index[] = { 1, 1, 2, 3 };
+    const float value = 12345.0f;
+    NCCONV_CHECK(nc_put_var1_float(ncid, varid, index, &value) == NC_NOERR);
+    nc_close(ncid);
+}
+
+NCCONV_TEST(verifyDetectsModifiedEntries) {
+    ncconv::Dataset dataset(writeVerifyDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    // Slabs of two rows, so the hashes are recorded and compared per slab.
+    dataset.setMaxMemory(2 * 6 * sizeof(float));
+    std::string filePath = testDirectory + "/verify.nc";
+    dataset.writeToNcFile(filePath);
+    NCCONV_CHECK(ncconv_test::getNcHasAttribute(filePath, "t", "ncconv_xxh64"));
+    NCCONV_CHECK(dataset.verifyNcFile(filePath));
+    NCCONV_CHECK(dataset.verifyNcFile(filePath, true));
+
+    modifyEntry(filePath);
+    NCCONV_CHECK(!dataset.verifyNcFile(filePath));
+    NCCONV_CHECK(!dataset.verifyNcFile(filePath, true));
+}
+
+NCCONV_TEST(verifyWithoutRecordedHashes) {
+    ncconv::Dataset dataset(writeVerifyDataSet(testDirectory));
+    dataset.setIsVerbose(false);
+    dataset.setRecordSlabHashes(false);
+    std::string filePath = testDirectory + "/verify.nc";
+    dataset.writeToNcFile(filePath);
+    NCCONV_CHECK(!ncconv_test::getNcHasAttribute(filePath, "t", "ncconv_xxh64"));
+    NCCONV_CHECK(dataset.verifyNcFile(filePath));
+
+    // Without recorded hashes, the output can only be compared against the input data.
+    bool hasThrown = false;
+    try {
+        dataset.verifyNcFile(filePath, true);
+    } catch (const std::runtime_error& exception) {
+        hasThrown = std::string(exception.what()).find("no recorded slab hashes") != std::string::npos;
+    }
+    NCCONV_CHECK(hasThrown);
+
+    modifyEntry(filePath);
+    NCCONV_CHECK(!dataset.verifyNcFile(filePath));
+}
@@ -0,0 +1,86 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "Api/Dataset.hpp"
+#include "Volume/ZarrMetadata.hpp"
+#include "TestUtils.hpp"
+
+/*
+ * Tests of the Zarr v2 store writer (ZarrWriter). The chunks are written uncompressed, so they can be compared against
+ * the input entries directly.
+ */
+
+NCCONV_TEST(zarrStoreOmitsUnrepresentableFillValue) {
+    ncconv::Dataset dataset(ncconv_test::writeTypedDataSet(testDirectory, "-9999"));
+    dataset.setIsVerbose(false);
+    dataset.setDeflateLevel(0);
+    dataset.setUseShuffleFilter(false);
+    std::string storePath = testDirectory + "/typed.zarr";
+    dataset.writeToZarrStore(storePath);
+
+    // The undef value -9999 cannot be stored in uint8, so "cnt" has no fill value (and 241 stays a valid entry).
+    std::string cntMetadata = ncconv_test::readFile(storePath + "/cnt/.zarray");
+    NCCONV_CHECK(cntMetadata.find("\"dtype\": \"|u1\", \"fill_value\": null") != std::string::npos);
+    std::string i16Metadata = ncconv_test::readFile(storePath + "/i16/.zarray");
+    NCCONV_CHECK(i16Metadata.find("\"dtype\": \"<i2\", \"fill_value\": -9999") != std::string::npos);
+    // Missing floating point entries are stored as NaN.
+    std::string f64Metadata = ncconv_test::readFile(storePath + "/f64/.zarray");
+    NCCONV_CHECK(f64Metadata.find("\"dtype\": \"<f8\", \"fill_value\": \"NaN\"") != std::string::npos);
+
+    std::string cntChunk = ncconv_test::readFile(storePath + "/cnt/0.0");
+    NCCONV_CHECK_EQUAL(cntChunk.size(), size_t(ncconv_test::TYPED_DATA_SET_NUM_ENTRIES));
+    NCCONV_CHECK_EQUAL(uint8_t(cntChunk.at(0)), uint8_t(241));
+    for (int i = 1; i < ncconv_test::TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        NCCONV_CHECK_EQUAL(uint8_t(cntChunk.at(i)), uint8_t(i));
+    }
+    std::string i16Chunk = ncconv_test::readFile(storePath + "/i16/0.0");
+    NCCONV_CHECK_EQUAL(i16Chunk.size(), size_t(ncconv_test::TYPED_DATA_SET_NUM_ENTRIES) * sizeof(int16_t));
+    for (int i = 0; i < ncconv_test::TYPED_DATA_SET_NUM_ENTRIES; i++) {
+        std::vector<uint8_t> expectedBytes;
+        ncconv_test::appendValue(expectedBytes, int16_t(i == 2 ? -9999 : -1000 * i), false);
+        NCCONV_CHECK(memcmp(i16Chunk.data() + i * sizeof(int16_t), expectedBytes.data(), sizeof(int16_t)) == 0);
+    }
+    std::string f64Chunk = ncconv_test::readFile(storePath + "/f64/0.0");
+    NCCONV_CHECK_EQUAL(f64Chunk.size(), size_t(ncconv_test::TYPED_DATA_SET_NUM_ENTRIES) * sizeof(double));
+    double f64Entry = 0.0;
+    memcpy(&f64Entry, f64Chunk.data() + 5 * sizeof(double), sizeof(double));
+    NCCONV_CHECK(std::isnan(f64Entry));
+}
+
+NCCONV_TEST(zarrFillValueFitsDataType) {
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::UINT8, true, -9999.0), std::string("null"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::INT8, true, 128.0), std::string("null"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::INT16, true, 0.5), std::string("null"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::INT16, true, -9999.0), std::string("-9999"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::UINT8, true, 255.0), std::string("255"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::FLOAT32, true, -9.99e8), std::string("-999000000"));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::FLOAT32, true, 1e300), std::string("\"NaN\""));
+    NCCONV_CHECK_EQUAL(formatZarrFillValue(FieldDataType::FLOAT64, true, std::nan("")), std::string("\"NaN\""));
+}